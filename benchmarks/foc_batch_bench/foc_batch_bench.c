@@ -0,0 +1,490 @@
+/****************************************************************************
+ * apps/benchmarks/foc_batch_bench/foc_batch_bench.c
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <errno.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <nuttx/clock.h>
+
+#include "industry/foc/foc_common.h"
+
+#ifdef CONFIG_INDUSTRY_FOC_FLOAT
+#  include "industry/foc/float/foc_handler.h"
+#  include "industry/foc/float/foc_batch.h"
+#endif
+
+#ifdef CONFIG_INDUSTRY_FOC_FIXED16
+#  include "industry/foc/fixed16/foc_handler.h"
+#  include "industry/foc/fixed16/foc_batch.h"
+#endif
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#define BENCH_MOTORS_DEFAULT    (4)
+#define BENCH_CYCLES_DEFAULT    (10000)
+
+/* Synthetic motor input */
+
+#define BENCH_VBUS              (24.0f)
+#define BENCH_IAMP              (1.0f)
+#define BENCH_IQREF             (0.5f)
+#define BENCH_ANGLE_STEP        (0.01f)
+#define BENCH_KP                (0.2f)
+#define BENCH_KI                (0.01f)
+#define BENCH_DUTY_MAX          (0.95f)
+
+#define BENCH_2PI               (6.2831853f)
+#define BENCH_2PI_3             (2.0943951f)
+
+/****************************************************************************
+ * Private Types
+ ****************************************************************************/
+
+struct bench_result_s
+{
+  uint64_t handler_ns;              /* Time in the per-motor handlers */
+  uint64_t batch_ns;                /* Time in the batched handler */
+  float    diff;                    /* Maximum duty cycle difference */
+};
+
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+#ifdef CONFIG_INDUSTRY_FOC_FLOAT
+static foc_handler_f32_t                   g_handler_f32[FOC_BATCH_MAX];
+static struct foc_batch_f32_s              g_batch_f32;
+static struct foc_batch_input_f32_s        g_batch_in_f32;
+static struct foc_batch_output_f32_s       g_batch_out_f32;
+#endif
+
+#ifdef CONFIG_INDUSTRY_FOC_FIXED16
+static foc_handler_b16_t                   g_handler_b16[FOC_BATCH_MAX];
+static struct foc_batch_b16_s              g_batch_b16;
+static struct foc_batch_input_b16_s        g_batch_in_b16;
+static struct foc_batch_output_b16_s       g_batch_out_b16;
+#endif
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: bench_ns
+ ****************************************************************************/
+
+static uint64_t bench_ns(clock_t elapsed)
+{
+  struct timespec ts;
+
+  perf_convert(elapsed, &ts);
+
+  return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+/****************************************************************************
+ * Name: bench_input
+ *
+ * Description:
+ *   Get the phase angle and the phase currents of a synthetic motor that
+ *   rotates with a speed proportional to its index.
+ *
+ ****************************************************************************/
+
+static void bench_input(int motor, int cycle, FAR float *angle,
+                        FAR float *current)
+{
+  float x;
+
+  x = fmodf(BENCH_ANGLE_STEP * (motor + 1) * cycle + motor, BENCH_2PI);
+
+  current[0] = BENCH_IAMP * cosf(x);
+  current[1] = BENCH_IAMP * cosf(x - BENCH_2PI_3);
+  current[2] = -current[0] - current[1];
+
+  *angle = x - BENCH_2PI / 2.0f;
+}
+
+#ifdef CONFIG_INDUSTRY_FOC_FLOAT
+/****************************************************************************
+ * Name: bench_run_f32
+ ****************************************************************************/
+
+static int bench_run_f32(int motors, int cycles,
+                         FAR struct bench_result_s *res)
+{
+  struct foc_handler_input_f32_s  in;
+  struct foc_handler_output_f32_s out;
+  struct foc_initdata_f32_s       ctrl_cfg;
+  struct foc_mod_cfg_f32_s        mod_cfg;
+  dq_frame_f32_t                  dq_ref[FOC_BATCH_MAX];
+  dq_frame_f32_t                  vdq_comp;
+  float                           current[FOC_BATCH_MAX][3];
+  float                           duty[FOC_BATCH_MAX][3];
+  float                           angle[FOC_BATCH_MAX];
+  float                           diff;
+  clock_t                         start;
+  int                             ret;
+  int                             k;
+  int                             m;
+  int                             p;
+
+  memset(res, 0, sizeof(struct bench_result_s));
+  memset(&vdq_comp, 0, sizeof(vdq_comp));
+
+  ctrl_cfg.id_kp        = BENCH_KP;
+  ctrl_cfg.id_ki        = BENCH_KI;
+  ctrl_cfg.iq_kp        = BENCH_KP;
+  ctrl_cfg.iq_ki        = BENCH_KI;
+  mod_cfg.pwm_duty_max  = BENCH_DUTY_MAX;
+
+  ret = foc_batch_init_f32(&g_batch_f32, motors);
+  if (ret < 0)
+    {
+      return ret;
+    }
+
+  for (m = 0; m < motors; m++)
+    {
+      ret = foc_handler_init_f32(&g_handler_f32[m],
+                                 &g_foc_control_pi_f32,
+                                 &g_foc_mod_svm3_f32);
+      if (ret < 0)
+        {
+          return ret;
+        }
+
+      foc_handler_cfg_f32(&g_handler_f32[m], &ctrl_cfg, &mod_cfg);
+      foc_batch_cfg_f32(&g_batch_f32, m, &ctrl_cfg, &mod_cfg);
+
+      dq_ref[m].d = 0.0f;
+      dq_ref[m].q = BENCH_IQREF * (m + 1) / motors;
+
+      g_batch_in_f32.ref_d[m]  = dq_ref[m].d;
+      g_batch_in_f32.ref_q[m]  = dq_ref[m].q;
+      g_batch_in_f32.comp_d[m] = 0.0f;
+      g_batch_in_f32.comp_q[m] = 0.0f;
+      g_batch_in_f32.vbus[m]   = BENCH_VBUS;
+      g_batch_in_f32.mode[m]   = FOC_HANDLER_MODE_CURRENT;
+    }
+
+  for (k = 0; k < cycles; k++)
+    {
+      for (m = 0; m < motors; m++)
+        {
+          bench_input(m, k, &angle[m], current[m]);
+
+          for (p = 0; p < 3; p++)
+            {
+              g_batch_in_f32.current[p][m] = current[m][p];
+            }
+
+          g_batch_in_f32.angle[m] = angle[m];
+        }
+
+      /* Per-motor handlers */
+
+      start = perf_gettime();
+
+      for (m = 0; m < motors; m++)
+        {
+          in.current  = current[m];
+          in.dq_ref   = &dq_ref[m];
+          in.vdq_comp = &vdq_comp;
+          in.angle    = angle[m];
+          in.vbus     = BENCH_VBUS;
+          in.mode     = FOC_HANDLER_MODE_CURRENT;
+
+          foc_handler_run_f32(&g_handler_f32[m], &in, &out);
+
+          memcpy(duty[m], out.duty, sizeof(duty[m]));
+        }
+
+      res->handler_ns += bench_ns(perf_gettime() - start);
+
+      /* Batched handler */
+
+      start = perf_gettime();
+
+      foc_batch_run_f32(&g_batch_f32, &g_batch_in_f32, &g_batch_out_f32);
+
+      res->batch_ns += bench_ns(perf_gettime() - start);
+
+      for (m = 0; m < motors; m++)
+        {
+          for (p = 0; p < 3; p++)
+            {
+              diff = fabsf(duty[m][p] - g_batch_out_f32.duty[p][m]);
+              if (diff > res->diff)
+                {
+                  res->diff = diff;
+                }
+            }
+        }
+    }
+
+  for (m = 0; m < motors; m++)
+    {
+      foc_handler_deinit_f32(&g_handler_f32[m]);
+    }
+
+  return OK;
+}
+#endif
+
+#ifdef CONFIG_INDUSTRY_FOC_FIXED16
+/****************************************************************************
+ * Name: bench_run_b16
+ ****************************************************************************/
+
+static int bench_run_b16(int motors, int cycles,
+                         FAR struct bench_result_s *res)
+{
+  struct foc_handler_input_b16_s  in;
+  struct foc_handler_output_b16_s out;
+  struct foc_initdata_b16_s       ctrl_cfg;
+  struct foc_mod_cfg_b16_s        mod_cfg;
+  dq_frame_b16_t                  dq_ref[FOC_BATCH_MAX];
+  dq_frame_b16_t                  vdq_comp;
+  b16_t                           current[FOC_BATCH_MAX][3];
+  b16_t                           duty[FOC_BATCH_MAX][3];
+  b16_t                           angle[FOC_BATCH_MAX];
+  float                           tmp[3];
+  float                           x;
+  float                           diff;
+  clock_t                         start;
+  int                             ret;
+  int                             k;
+  int                             m;
+  int                             p;
+
+  memset(res, 0, sizeof(struct bench_result_s));
+  memset(&vdq_comp, 0, sizeof(vdq_comp));
+
+  ctrl_cfg.id_kp        = ftob16(BENCH_KP);
+  ctrl_cfg.id_ki        = ftob16(BENCH_KI);
+  ctrl_cfg.iq_kp        = ftob16(BENCH_KP);
+  ctrl_cfg.iq_ki        = ftob16(BENCH_KI);
+  mod_cfg.pwm_duty_max  = ftob16(BENCH_DUTY_MAX);
+
+  ret = foc_batch_init_b16(&g_batch_b16, motors);
+  if (ret < 0)
+    {
+      return ret;
+    }
+
+  for (m = 0; m < motors; m++)
+    {
+      ret = foc_handler_init_b16(&g_handler_b16[m],
+                                 &g_foc_control_pi_b16,
+                                 &g_foc_mod_svm3_b16);
+      if (ret < 0)
+        {
+          return ret;
+        }
+
+      foc_handler_cfg_b16(&g_handler_b16[m], &ctrl_cfg, &mod_cfg);
+      foc_batch_cfg_b16(&g_batch_b16, m, &ctrl_cfg, &mod_cfg);
+
+      dq_ref[m].d = 0;
+      dq_ref[m].q = ftob16(BENCH_IQREF * (m + 1) / motors);
+
+      g_batch_in_b16.ref_d[m]  = dq_ref[m].d;
+      g_batch_in_b16.ref_q[m]  = dq_ref[m].q;
+      g_batch_in_b16.comp_d[m] = 0;
+      g_batch_in_b16.comp_q[m] = 0;
+      g_batch_in_b16.vbus[m]   = ftob16(BENCH_VBUS);
+      g_batch_in_b16.mode[m]   = FOC_HANDLER_MODE_CURRENT;
+    }
+
+  for (k = 0; k < cycles; k++)
+    {
+      for (m = 0; m < motors; m++)
+        {
+          bench_input(m, k, &x, tmp);
+
+          angle[m] = ftob16(x);
+          for (p = 0; p < 3; p++)
+            {
+              current[m][p] = ftob16(tmp[p]);
+              g_batch_in_b16.current[p][m] = current[m][p];
+            }
+
+          g_batch_in_b16.angle[m] = angle[m];
+        }
+
+      /* Per-motor handlers */
+
+      start = perf_gettime();
+
+      for (m = 0; m < motors; m++)
+        {
+          in.current  = current[m];
+          in.dq_ref   = &dq_ref[m];
+          in.vdq_comp = &vdq_comp;
+          in.angle    = angle[m];
+          in.vbus     = ftob16(BENCH_VBUS);
+          in.mode     = FOC_HANDLER_MODE_CURRENT;
+
+          foc_handler_run_b16(&g_handler_b16[m], &in, &out);
+
+          memcpy(duty[m], out.duty, sizeof(duty[m]));
+        }
+
+      res->handler_ns += bench_ns(perf_gettime() - start);
+
+      /* Batched handler */
+
+      start = perf_gettime();
+
+      foc_batch_run_b16(&g_batch_b16, &g_batch_in_b16, &g_batch_out_b16);
+
+      res->batch_ns += bench_ns(perf_gettime() - start);
+
+      for (m = 0; m < motors; m++)
+        {
+          for (p = 0; p < 3; p++)
+            {
+              diff = fabsf(b16tof(duty[m][p] -
+                                  g_batch_out_b16.duty[p][m]));
+              if (diff > res->diff)
+                {
+                  res->diff = diff;
+                }
+            }
+        }
+    }
+
+  for (m = 0; m < motors; m++)
+    {
+      foc_handler_deinit_b16(&g_handler_b16[m]);
+    }
+
+  return OK;
+}
+#endif
+
+/****************************************************************************
+ * Name: bench_print
+ ****************************************************************************/
+
+static void bench_print(FAR const char *name,
+                        FAR struct bench_result_s *res, int cycles)
+{
+  float handler = (float)res->handler_ns / cycles;
+  float batch   = (float)res->batch_ns / cycles;
+
+  printf("%-7s %12.1f %12.1f %8.2f %10.6f\n",
+         name, handler, batch, batch > 0.0f ? handler / batch : 0.0f,
+         res->diff);
+}
+
+/****************************************************************************
+ * Name: bench_help
+ ****************************************************************************/
+
+static void bench_help(FAR const char *progname)
+{
+  printf("Usage: %s [-m motors] [-n cycles]\n", progname);
+  printf("  -m: number of motors, default %d, max %d\n",
+         BENCH_MOTORS_DEFAULT, FOC_BATCH_MAX);
+  printf("  -n: number of control cycles, default %d\n",
+         BENCH_CYCLES_DEFAULT);
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: main
+ ****************************************************************************/
+
+int main(int argc, FAR char *argv[])
+{
+  struct bench_result_s res;
+  int                   motors = BENCH_MOTORS_DEFAULT;
+  int                   cycles = BENCH_CYCLES_DEFAULT;
+  int                   opt;
+
+  while ((opt = getopt(argc, argv, "m:n:h")) != ERROR)
+    {
+      switch (opt)
+        {
+          case 'm':
+            motors = atoi(optarg);
+            break;
+
+          case 'n':
+            cycles = atoi(optarg);
+            break;
+
+          case 'h':
+          default:
+            bench_help(argv[0]);
+            return opt == 'h' ? EXIT_SUCCESS : EXIT_FAILURE;
+        }
+    }
+
+  if (motors < 1 || motors > FOC_BATCH_MAX || cycles < 1)
+    {
+      bench_help(argv[0]);
+      return EXIT_FAILURE;
+    }
+
+  printf("foc_batch_bench: %d motors, %d cycles\n", motors, cycles);
+  printf("%-7s %12s %12s %8s %10s\n",
+         "type", "handler ns", "batch ns", "speedup", "max diff");
+
+#ifdef CONFIG_INDUSTRY_FOC_FLOAT
+  if (bench_run_f32(motors, cycles, &res) < 0)
+    {
+      printf("ERROR: bench_run_f32 failed\n");
+      return EXIT_FAILURE;
+    }
+
+  bench_print("float", &res, cycles);
+#endif
+
+#ifdef CONFIG_INDUSTRY_FOC_FIXED16
+  if (bench_run_b16(motors, cycles, &res) < 0)
+    {
+      printf("ERROR: bench_run_b16 failed\n");
+      return EXIT_FAILURE;
+    }
+
+  bench_print("fixed16", &res, cycles);
+#endif
+
+  return EXIT_SUCCESS;
+}
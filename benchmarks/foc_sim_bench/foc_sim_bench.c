@@ -0,0 +1,697 @@
+/****************************************************************************
+ * apps/benchmarks/foc_sim_bench/foc_sim_bench.c
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <sys/param.h>
+
+#include <errno.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <nuttx/clock.h>
+
+#include "industry/foc/foc_common.h"
+
+#ifdef CONFIG_INDUSTRY_FOC_FLOAT
+#  include "industry/foc/float/foc_handler.h"
+#  include "industry/foc/float/foc_model.h"
+#endif
+
+#ifdef CONFIG_INDUSTRY_FOC_FIXED16
+#  include "industry/foc/fixed16/foc_handler.h"
+#  include "industry/foc/fixed16/foc_model.h"
+#endif
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#define BENCH_ITER_DEFAULT      (5000)
+
+/* Default bound of the q current tracking error in permille of the
+ * reference, a run above it fails
+ */
+
+#define BENCH_IQERR_DEFAULT     (CONFIG_BENCHMARK_FOC_SIM_IQERR_MAX)
+
+/* PMSM model parameters, the same as the examples/foc model */
+
+#define BENCH_MODEL_POLES       (7)
+#define BENCH_MODEL_RES         (0.11f)
+#define BENCH_MODEL_IND         (0.0002f)
+#define BENCH_MODEL_INER        (0.1f)
+#define BENCH_MODEL_FLUX        (0.001f)
+#define BENCH_MODEL_LOAD        (0.0f)
+#define BENCH_MODEL_IPHASE_ADC  (0.001f)
+
+#define BENCH_VBUS              (12.0f)
+#define BENCH_IQREF             (1.0f)
+#define BENCH_DUTY_MAX          (0.95f)
+
+#define BENCH_2PI               (6.2831853f)
+
+/* Time stages */
+
+#define BENCH_STAGE_INPUT       (0)  /* Current correction and input */
+#define BENCH_STAGE_CONTROL     (1)  /* Current controller */
+#define BENCH_STAGE_MOD         (2)  /* Modulation */
+#define BENCH_STAGE_MODEL       (3)  /* PMSM model */
+#define BENCH_STAGE_NUM         (4)
+
+/****************************************************************************
+ * Private Types
+ ****************************************************************************/
+
+/* Controller configuration for the sweep */
+
+struct bench_cfg_s
+{
+  uint32_t pwm_freq;                /* Control loop frequency [Hz] */
+  uint32_t bw;                      /* Current loop bandwidth [Hz] */
+};
+
+/* Benchmark result */
+
+struct bench_result_s
+{
+  uint32_t p50_ns;                  /* Handler latency - median */
+  uint32_t p99_ns;                  /* Handler latency - 99th percentile */
+  uint32_t max_ns;                  /* Handler latency - maximum */
+  uint32_t stage[BENCH_STAGE_NUM];  /* Mean cycles per stage */
+  float    iq_rms;                  /* RMS of the q current error */
+};
+
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+static const struct bench_cfg_s g_bench_cfg[] =
+{
+  {10000, 500},
+  {10000, 1000},
+  {10000, 2000},
+  {20000, 500},
+  {20000, 1000},
+  {20000, 2000},
+};
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: bench_ns
+ ****************************************************************************/
+
+static uint32_t bench_ns(clock_t elapsed)
+{
+  struct timespec ts;
+
+  perf_convert(elapsed, &ts);
+
+  return (uint32_t)(ts.tv_sec * 1000000000ull + ts.tv_nsec);
+}
+
+/****************************************************************************
+ * Name: bench_cmp
+ ****************************************************************************/
+
+static int bench_cmp(FAR const void *a, FAR const void *b)
+{
+  clock_t x = *(FAR const clock_t *)a;
+  clock_t y = *(FAR const clock_t *)b;
+
+  return (x > y) - (x < y);
+}
+
+/****************************************************************************
+ * Name: bench_latency
+ *
+ * Description:
+ *   Get the latency percentiles from the handler time samples.
+ *   The samples are sorted in place.
+ *
+ ****************************************************************************/
+
+static void bench_latency(FAR clock_t *lat, int iter,
+                          FAR struct bench_result_s *res)
+{
+  qsort(lat, iter, sizeof(clock_t), bench_cmp);
+
+  res->p50_ns = bench_ns(lat[iter / 2]);
+  res->p99_ns = bench_ns(lat[(iter * 99) / 100]);
+  res->max_ns = bench_ns(lat[iter - 1]);
+}
+
+/****************************************************************************
+ * Name: bench_pi_get
+ *
+ * Description:
+ *   Get the current controller gains for the given bandwidth.
+ *   The PI zero cancels the motor electrical pole.
+ *
+ ****************************************************************************/
+
+static void bench_pi_get(FAR const struct bench_cfg_s *cfg,
+                         FAR float *kp, FAR float *ki)
+{
+  float wc = BENCH_2PI * cfg->bw;
+
+  *kp = BENCH_MODEL_IND * wc;
+  *ki = BENCH_MODEL_RES * wc / cfg->pwm_freq;
+}
+
+#ifdef CONFIG_INDUSTRY_FOC_FLOAT
+/****************************************************************************
+ * Name: bench_run_f32
+ *
+ * Description:
+ *   Run the closed loop between the FOC handler and the PMSM model twice.
+ *   The first pass times foc_handler_run_f32() as a whole, the second pass
+ *   calls the handler stages one by one and times each of them.
+ *
+ ****************************************************************************/
+
+static int bench_run_f32(FAR const struct bench_cfg_s *cfg, int iter,
+                         FAR clock_t *lat, FAR struct bench_result_s *res)
+{
+  struct foc_handler_input_f32_s  in;
+  struct foc_handler_output_f32_s out;
+  struct foc_initdata_f32_s       ctrl_cfg;
+  struct foc_mod_cfg_f32_s        mod_cfg;
+  struct foc_model_pmsm_cfg_f32_s pmsm_cfg;
+  struct foc_model_state_f32_s    model_state;
+  struct foc_state_f32_s          foc_state;
+  foc_handler_f32_t               handler;
+  foc_model_f32_t                 model;
+  dq_frame_f32_t                  dq_ref;
+  dq_frame_f32_t                  vdq_comp;
+  ab_frame_f32_t                  v_ab_mod;
+  float                           current[CONFIG_MOTOR_FOC_PHASES];
+  float                           per;
+  float                           angle;
+  float                           vbase;
+  float                           err;
+  double                          err2;
+  uint64_t                        stage[BENCH_STAGE_NUM];
+  clock_t                         t0;
+  clock_t                         t1;
+  int                             ret;
+  int                             pass;
+  int                             i;
+  int                             j;
+
+  memset(res, 0, sizeof(struct bench_result_s));
+  memset(stage, 0, sizeof(stage));
+  err2 = 0.0;
+  per  = 1.0f / cfg->pwm_freq;
+
+  bench_pi_get(cfg, &ctrl_cfg.id_kp, &ctrl_cfg.id_ki);
+  bench_pi_get(cfg, &ctrl_cfg.iq_kp, &ctrl_cfg.iq_ki);
+  mod_cfg.pwm_duty_max = BENCH_DUTY_MAX;
+
+  pmsm_cfg.poles      = BENCH_MODEL_POLES;
+  pmsm_cfg.res        = BENCH_MODEL_RES;
+  pmsm_cfg.ind        = BENCH_MODEL_IND;
+  pmsm_cfg.iner       = BENCH_MODEL_INER;
+  pmsm_cfg.flux_link  = BENCH_MODEL_FLUX;
+  pmsm_cfg.ind_d      = BENCH_MODEL_IND;
+  pmsm_cfg.ind_q      = BENCH_MODEL_IND;
+  pmsm_cfg.per        = per;
+  pmsm_cfg.iphase_adc = BENCH_MODEL_IPHASE_ADC;
+
+  dq_ref.d   = 0.0f;
+  dq_ref.q   = BENCH_IQREF;
+  vdq_comp.d = 0.0f;
+  vdq_comp.q = 0.0f;
+
+  for (pass = 0; pass < 2; pass++)
+    {
+      ret = foc_handler_init_f32(&handler, &g_foc_control_pi_f32,
+                                 &g_foc_mod_svm3_f32);
+      if (ret < 0)
+        {
+          return ret;
+        }
+
+      ret = foc_model_init_f32(&model, &g_foc_model_pmsm_ops_f32);
+      if (ret < 0)
+        {
+          foc_handler_deinit_f32(&handler);
+          return ret;
+        }
+
+      foc_handler_cfg_f32(&handler, &ctrl_cfg, &mod_cfg);
+      foc_model_cfg_f32(&model, &pmsm_cfg);
+
+      angle = 0.0f;
+
+      for (i = 0; i < iter; i++)
+        {
+          /* Feed the handler with the model currents */
+
+          foc_model_state_f32(&model, &model_state);
+
+          for (j = 0; j < CONFIG_MOTOR_FOC_PHASES; j++)
+            {
+              current[j] = model_state.curr[j];
+            }
+
+          in.current  = current;
+          in.dq_ref   = &dq_ref;
+          in.vdq_comp = &vdq_comp;
+          in.angle    = angle;
+          in.vbus     = BENCH_VBUS;
+          in.mode     = FOC_HANDLER_MODE_CURRENT;
+
+          if (pass == 0)
+            {
+              t0 = perf_gettime();
+              foc_handler_run_f32(&handler, &in, &out);
+              lat[i] = perf_gettime() - t0;
+
+              /* q current error in the second half of the run */
+
+              if (i >= iter / 2)
+                {
+                  err   = dq_ref.q - model_state.idq.q;
+                  err2 += err * err;
+                }
+            }
+          else
+            {
+              /* The same as foc_handler_run_f32() in current mode */
+
+              t0 = perf_gettime();
+              handler.ops.mod->current(&handler, in.current);
+              handler.ops.mod->vbase_get(&handler, in.vbus, &vbase);
+              handler.ops.ctrl->input_set(&handler, in.current, vbase,
+                                          in.angle);
+              t1 = perf_gettime();
+              stage[BENCH_STAGE_INPUT] += t1 - t0;
+
+              t0 = t1;
+              handler.ops.ctrl->current_run(&handler, in.dq_ref,
+                                            in.vdq_comp, &v_ab_mod);
+              t1 = perf_gettime();
+              stage[BENCH_STAGE_CONTROL] += t1 - t0;
+
+              t0 = t1;
+              handler.ops.mod->run(&handler, &v_ab_mod, out.duty);
+              t1 = perf_gettime();
+              stage[BENCH_STAGE_MOD] += t1 - t0;
+            }
+
+          /* Close the loop with an ideal inverter */
+
+          foc_handler_state_f32(&handler, &foc_state, NULL);
+
+          t0 = perf_gettime();
+          foc_model_run_f32(&model, BENCH_MODEL_LOAD, &foc_state.vab);
+          stage[BENCH_STAGE_MODEL] += perf_gettime() - t0;
+
+          /* Rotor electrical angle */
+
+          angle += model_state.omega_e * per;
+          angle_norm_2pi(&angle, -M_PI_F, M_PI_F);
+        }
+
+      foc_model_deinit_f32(&model);
+      foc_handler_deinit_f32(&handler);
+    }
+
+  /* The model runs in both passes */
+
+  stage[BENCH_STAGE_MODEL] /= 2;
+
+  for (j = 0; j < BENCH_STAGE_NUM; j++)
+    {
+      res->stage[j] = (uint32_t)(stage[j] / iter);
+    }
+
+  res->iq_rms = sqrtf((float)(err2 / (iter - iter / 2)));
+
+  bench_latency(lat, iter, res);
+
+  return OK;
+}
+#endif
+
+#ifdef CONFIG_INDUSTRY_FOC_FIXED16
+/****************************************************************************
+ * Name: bench_run_b16
+ *
+ * Description:
+ *   Run the closed loop between the FOC handler and the PMSM model twice.
+ *   The first pass times foc_handler_run_b16() as a whole, the second pass
+ *   calls the handler stages one by one and times each of them.
+ *
+ ****************************************************************************/
+
+static int bench_run_b16(FAR const struct bench_cfg_s *cfg, int iter,
+                         FAR clock_t *lat, FAR struct bench_result_s *res)
+{
+  struct foc_handler_input_b16_s  in;
+  struct foc_handler_output_b16_s out;
+  struct foc_initdata_b16_s       ctrl_cfg;
+  struct foc_mod_cfg_b16_s        mod_cfg;
+  struct foc_model_pmsm_cfg_b16_s pmsm_cfg;
+  struct foc_model_state_b16_s    model_state;
+  struct foc_state_b16_s          foc_state;
+  foc_handler_b16_t               handler;
+  foc_model_b16_t                 model;
+  dq_frame_b16_t                  dq_ref;
+  dq_frame_b16_t                  vdq_comp;
+  ab_frame_b16_t                  v_ab_mod;
+  b16_t                           current[CONFIG_MOTOR_FOC_PHASES];
+  b16_t                           per;
+  b16_t                           angle;
+  b16_t                           vbase;
+  float                           kp;
+  float                           ki;
+  float                           err;
+  double                          err2;
+  uint64_t                        stage[BENCH_STAGE_NUM];
+  clock_t                         t0;
+  clock_t                         t1;
+  int                             ret;
+  int                             pass;
+  int                             i;
+  int                             j;
+
+  memset(res, 0, sizeof(struct bench_result_s));
+  memset(stage, 0, sizeof(stage));
+  err2 = 0.0;
+  per  = ftob16(1.0f / cfg->pwm_freq);
+
+  bench_pi_get(cfg, &kp, &ki);
+  ctrl_cfg.id_kp       = ftob16(kp);
+  ctrl_cfg.id_ki       = ftob16(ki);
+  ctrl_cfg.iq_kp       = ftob16(kp);
+  ctrl_cfg.iq_ki       = ftob16(ki);
+  mod_cfg.pwm_duty_max = ftob16(BENCH_DUTY_MAX);
+
+  pmsm_cfg.poles      = BENCH_MODEL_POLES;
+  pmsm_cfg.res        = ftob16(BENCH_MODEL_RES);
+  pmsm_cfg.ind        = ftob16(BENCH_MODEL_IND);
+  pmsm_cfg.iner       = ftob16(BENCH_MODEL_INER);
+  pmsm_cfg.flux_link  = ftob16(BENCH_MODEL_FLUX);
+  pmsm_cfg.ind_d      = ftob16(BENCH_MODEL_IND);
+  pmsm_cfg.ind_q      = ftob16(BENCH_MODEL_IND);
+  pmsm_cfg.per        = per;
+  pmsm_cfg.iphase_adc = ftob16(BENCH_MODEL_IPHASE_ADC);
+
+  dq_ref.d   = 0;
+  dq_ref.q   = ftob16(BENCH_IQREF);
+  vdq_comp.d = 0;
+  vdq_comp.q = 0;
+
+  for (pass = 0; pass < 2; pass++)
+    {
+      ret = foc_handler_init_b16(&handler, &g_foc_control_pi_b16,
+                                 &g_foc_mod_svm3_b16);
+      if (ret < 0)
+        {
+          return ret;
+        }
+
+      ret = foc_model_init_b16(&model, &g_foc_model_pmsm_ops_b16);
+      if (ret < 0)
+        {
+          foc_handler_deinit_b16(&handler);
+          return ret;
+        }
+
+      foc_handler_cfg_b16(&handler, &ctrl_cfg, &mod_cfg);
+      foc_model_cfg_b16(&model, &pmsm_cfg);
+
+      angle = 0;
+
+      for (i = 0; i < iter; i++)
+        {
+          /* Feed the handler with the model currents */
+
+          foc_model_state_b16(&model, &model_state);
+
+          for (j = 0; j < CONFIG_MOTOR_FOC_PHASES; j++)
+            {
+              current[j] = model_state.curr[j];
+            }
+
+          in.current  = current;
+          in.dq_ref   = &dq_ref;
+          in.vdq_comp = &vdq_comp;
+          in.angle    = angle;
+          in.vbus     = ftob16(BENCH_VBUS);
+          in.mode     = FOC_HANDLER_MODE_CURRENT;
+
+          if (pass == 0)
+            {
+              t0 = perf_gettime();
+              foc_handler_run_b16(&handler, &in, &out);
+              lat[i] = perf_gettime() - t0;
+
+              /* q current error in the second half of the run */
+
+              if (i >= iter / 2)
+                {
+                  err   = b16tof(dq_ref.q - model_state.idq.q);
+                  err2 += err * err;
+                }
+            }
+          else
+            {
+              /* The same as foc_handler_run_b16() in current mode */
+
+              t0 = perf_gettime();
+              handler.ops.mod->current(&handler, in.current);
+              handler.ops.mod->vbase_get(&handler, in.vbus, &vbase);
+              handler.ops.ctrl->input_set(&handler, in.current, vbase,
+                                          in.angle);
+              t1 = perf_gettime();
+              stage[BENCH_STAGE_INPUT] += t1 - t0;
+
+              t0 = t1;
+              handler.ops.ctrl->current_run(&handler, in.dq_ref,
+                                            in.vdq_comp, &v_ab_mod);
+              t1 = perf_gettime();
+              stage[BENCH_STAGE_CONTROL] += t1 - t0;
+
+              t0 = t1;
+              handler.ops.mod->run(&handler, &v_ab_mod, out.duty);
+              t1 = perf_gettime();
+              stage[BENCH_STAGE_MOD] += t1 - t0;
+            }
+
+          /* Close the loop with an ideal inverter */
+
+          foc_handler_state_b16(&handler, &foc_state, NULL);
+
+          t0 = perf_gettime();
+          foc_model_run_b16(&model, ftob16(BENCH_MODEL_LOAD),
+                            &foc_state.vab);
+          stage[BENCH_STAGE_MODEL] += perf_gettime() - t0;
+
+          /* Rotor electrical angle */
+
+          angle += b16mulb16(model_state.omega_e, per);
+          angle_norm_2pi_b16(&angle, -b16PI, b16PI);
+        }
+
+      foc_model_deinit_b16(&model);
+      foc_handler_deinit_b16(&handler);
+    }
+
+  /* The model runs in both passes */
+
+  stage[BENCH_STAGE_MODEL] /= 2;
+
+  for (j = 0; j < BENCH_STAGE_NUM; j++)
+    {
+      res->stage[j] = (uint32_t)(stage[j] / iter);
+    }
+
+  res->iq_rms = sqrtf((float)(err2 / (iter - iter / 2)));
+
+  bench_latency(lat, iter, res);
+
+  return OK;
+}
+#endif
+
+/****************************************************************************
+ * Name: bench_print
+ ****************************************************************************/
+
+static void bench_print(FAR const char *name,
+                        FAR const struct bench_cfg_s *cfg,
+                        FAR struct bench_result_s *res)
+{
+  printf("%-7s %6lu %5lu %7lu %7lu %7lu %7lu %7lu %7lu %7lu %8.4f\n",
+         name, (unsigned long)cfg->pwm_freq, (unsigned long)cfg->bw,
+         (unsigned long)res->p50_ns, (unsigned long)res->p99_ns,
+         (unsigned long)res->max_ns,
+         (unsigned long)res->stage[BENCH_STAGE_INPUT],
+         (unsigned long)res->stage[BENCH_STAGE_CONTROL],
+         (unsigned long)res->stage[BENCH_STAGE_MOD],
+         (unsigned long)res->stage[BENCH_STAGE_MODEL],
+         res->iq_rms);
+}
+
+/****************************************************************************
+ * Name: bench_check
+ *
+ * Description:
+ *   Check that the loop tracked the reference. A diverging or saturated
+ *   loop ends up with a q current error far above the bound, and NaN
+ *   fails the comparison as well.
+ *
+ ****************************************************************************/
+
+static bool bench_check(FAR const char *name,
+                        FAR const struct bench_result_s *res,
+                        float iq_max)
+{
+  if (!(res->iq_rms <= iq_max))
+    {
+      printf("ERROR: %s iq rms %.4f above %.4f\n", name, res->iq_rms,
+             iq_max);
+      return false;
+    }
+
+  return true;
+}
+
+/****************************************************************************
+ * Name: bench_help
+ ****************************************************************************/
+
+static void bench_help(FAR const char *progname)
+{
+  printf("Usage: %s [-n iterations] [-e permille]\n", progname);
+  printf("  -n: control loop iterations per configuration, default %d\n",
+         BENCH_ITER_DEFAULT);
+  printf("  -e: maximum q current RMS error in permille of the reference,"
+         " default %d\n", BENCH_IQERR_DEFAULT);
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: main
+ ****************************************************************************/
+
+int main(int argc, FAR char *argv[])
+{
+  struct bench_result_s res;
+  FAR clock_t          *lat  = NULL;
+  int                   iter = BENCH_ITER_DEFAULT;
+  int                   err  = BENCH_IQERR_DEFAULT;
+  int                   ret  = EXIT_SUCCESS;
+  float                 iq_max;
+  int                   opt;
+  int                   i;
+
+  while ((opt = getopt(argc, argv, "n:e:h")) != ERROR)
+    {
+      switch (opt)
+        {
+          case 'n':
+            iter = atoi(optarg);
+            break;
+
+          case 'e':
+            err = atoi(optarg);
+            break;
+
+          case 'h':
+          default:
+            bench_help(argv[0]);
+            return opt == 'h' ? EXIT_SUCCESS : EXIT_FAILURE;
+        }
+    }
+
+  if (iter < 2 || err <= 0)
+    {
+      bench_help(argv[0]);
+      return EXIT_FAILURE;
+    }
+
+  iq_max = BENCH_IQREF * err / 1000.0f;
+
+  lat = malloc(sizeof(clock_t) * iter);
+  if (lat == NULL)
+    {
+      printf("ERROR: failed to allocate %d samples\n", iter);
+      return EXIT_FAILURE;
+    }
+
+  printf("foc_sim_bench: %d iterations, perf freq %lu Hz\n",
+         iter, perf_getfreq());
+  printf("%-7s %6s %5s %7s %7s %7s %7s %7s %7s %7s %8s\n",
+         "type", "fpwm", "bw", "p50 ns", "p99 ns", "max ns",
+         "in cyc", "pi cyc", "mod cyc", "mdl cyc", "iq rms");
+
+  for (i = 0; i < nitems(g_bench_cfg); i++)
+    {
+#ifdef CONFIG_INDUSTRY_FOC_FLOAT
+      if (bench_run_f32(&g_bench_cfg[i], iter, lat, &res) < 0)
+        {
+          printf("ERROR: bench_run_f32 failed\n");
+          ret = EXIT_FAILURE;
+        }
+
+      bench_print("float", &g_bench_cfg[i], &res);
+      if (!bench_check("float", &res, iq_max))
+        {
+          ret = EXIT_FAILURE;
+        }
+#endif
+
+#ifdef CONFIG_INDUSTRY_FOC_FIXED16
+      if (bench_run_b16(&g_bench_cfg[i], iter, lat, &res) < 0)
+        {
+          printf("ERROR: bench_run_b16 failed\n");
+          ret = EXIT_FAILURE;
+        }
+
+      bench_print("fixed16", &g_bench_cfg[i], &res);
+      if (!bench_check("fixed16", &res, iq_max))
+        {
+          ret = EXIT_FAILURE;
+        }
+#endif
+    }
+
+  free(lat);
+  return ret;
+}
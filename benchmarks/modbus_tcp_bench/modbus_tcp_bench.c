@@ -0,0 +1,590 @@
+/****************************************************************************
+ * apps/benchmarks/modbus_tcp_bench/modbus_tcp_bench.c
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <sys/param.h>
+#include <sys/socket.h>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+
+#include <errno.h>
+#include <inttypes.h>
+#include <poll.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#define BENCH_ADDR_DEFAULT      "127.0.0.1"
+#define BENCH_PORT_DEFAULT      (502)
+#define BENCH_CONNS_DEFAULT     (64)
+#define BENCH_STEP_DEFAULT      (16)
+#define BENCH_REQUESTS_DEFAULT  (100)
+#define BENCH_REG_DEFAULT       (2000)
+#define BENCH_NREGS_DEFAULT     (10)
+#define BENCH_CONNS_MAX         (256)
+#define BENCH_NREGS_MAX         (125)
+#define BENCH_TIMEOUT_MS        (2000)
+
+#define MB_FUNC_READ_HOLDING    0x03
+#define MB_FUNC_ERROR           0x80
+#define MB_TCP_FUNC             7
+#define MB_TCP_BUF_SIZE         260
+
+/****************************************************************************
+ * Private Types
+ ****************************************************************************/
+
+struct bench_cfg_s
+{
+  struct sockaddr_in addr;          /* Server address */
+  int                conns;         /* Maximum number of masters */
+  int                step;          /* Masters added per step */
+  int                requests;      /* Requests per master and step */
+  int                reg;           /* First holding register */
+  int                nregs;         /* Registers per request */
+};
+
+/* One master.  It has one request outstanding at a time, so the number of
+ * masters is the number of requests the server has to serve at once.
+ */
+
+struct bench_conn_s
+{
+  int      sd;
+  uint16_t tid;                     /* Transaction id of the request */
+  uint64_t start;                   /* Time the request was sent */
+  int      sent;                    /* Requests sent in this step */
+  bool     resync;                  /* Reconnect before the next step */
+  size_t   rxlen;                   /* Bytes in rxbuf */
+  uint8_t  rxbuf[MB_TCP_BUF_SIZE];
+};
+
+struct bench_result_s
+{
+  FAR uint32_t *lat_us;             /* Latency of every request */
+  int           nlat;
+  uint64_t      elapsed_ns;         /* Time of the whole step */
+  int           errors;             /* Failed requests */
+};
+
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+static struct bench_conn_s g_conns[BENCH_CONNS_MAX];
+static struct pollfd g_pfds[BENCH_CONNS_MAX];
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: bench_now
+ ****************************************************************************/
+
+static uint64_t bench_now(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+
+  return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+/****************************************************************************
+ * Name: bench_connect
+ ****************************************************************************/
+
+static int bench_connect(FAR const struct bench_cfg_s *cfg)
+{
+  int sd;
+
+  sd = socket(AF_INET, SOCK_STREAM, 0);
+  if (sd < 0)
+    {
+      return -errno;
+    }
+
+  if (connect(sd, (FAR const struct sockaddr *)&cfg->addr,
+              sizeof(cfg->addr)) < 0)
+    {
+      int errcode = errno;
+
+      close(sd);
+      return -errcode;
+    }
+
+  return sd;
+}
+
+/****************************************************************************
+ * Name: bench_send
+ *
+ * Description:
+ *   Send a Read Holding Registers request with the next transaction id of
+ *   the master.
+ *
+ ****************************************************************************/
+
+static int bench_send(FAR const struct bench_cfg_s *cfg,
+                      FAR struct bench_conn_s *conn)
+{
+  uint8_t req[12];
+
+  conn->tid++;
+  req[0]  = conn->tid >> 8;
+  req[1]  = conn->tid & 0xff;
+  req[2]  = 0;                      /* Protocol id */
+  req[3]  = 0;
+  req[4]  = 0;                      /* Length of unit id and PDU */
+  req[5]  = 6;
+  req[6]  = 1;                      /* Unit id */
+  req[7]  = MB_FUNC_READ_HOLDING;
+  req[8]  = cfg->reg >> 8;
+  req[9]  = cfg->reg & 0xff;
+  req[10] = cfg->nregs >> 8;
+  req[11] = cfg->nregs & 0xff;
+
+  conn->rxlen = 0;
+  conn->start = bench_now();
+  conn->sent++;
+
+  if (send(conn->sd, req, sizeof(req), 0) != sizeof(req))
+    {
+      return -errno;
+    }
+
+  return 0;
+}
+
+/****************************************************************************
+ * Name: bench_recv
+ *
+ * Description:
+ *   Receive the response of the outstanding request.
+ *
+ * Returned Value:
+ *   1 when the response is complete and correct, 0 if it is not complete
+ *   yet or a negated errno value.
+ *
+ ****************************************************************************/
+
+static int bench_recv(FAR const struct bench_cfg_s *cfg,
+                      FAR struct bench_conn_s *conn)
+{
+  size_t  len;
+  ssize_t n;
+
+  n = recv(conn->sd, &conn->rxbuf[conn->rxlen],
+           sizeof(conn->rxbuf) - conn->rxlen, 0);
+  if (n <= 0)
+    {
+      return n == 0 ? -ECONNRESET : -errno;
+    }
+
+  conn->rxlen += n;
+  if (conn->rxlen < MB_TCP_FUNC)
+    {
+      return 0;
+    }
+
+  len = 6 + ((conn->rxbuf[4] << 8) | conn->rxbuf[5]);
+  if (len > sizeof(conn->rxbuf))
+    {
+      return -EPROTO;
+    }
+
+  if (conn->rxlen < len)
+    {
+      return 0;
+    }
+
+  /* The response must answer this request: same transaction id, no
+   * exception and all registers.
+   */
+
+  if (((conn->rxbuf[0] << 8) | conn->rxbuf[1]) != conn->tid ||
+      (conn->rxbuf[MB_TCP_FUNC] & MB_FUNC_ERROR) != 0 ||
+      len != (size_t)(MB_TCP_FUNC + 2 + 2 * cfg->nregs))
+    {
+      return -EPROTO;
+    }
+
+  return 1;
+}
+
+/****************************************************************************
+ * Name: bench_step
+ *
+ * Description:
+ *   Let nconns masters each send cfg->requests requests, one at a time.
+ *   A master that failed or timed out may still get a late response, it
+ *   is reconnected so that the next step does not read that response as
+ *   a transaction id mismatch.
+ *
+ * Returned Value:
+ *   0 on success, a negated errno value if a master can not reconnect.
+ *
+ ****************************************************************************/
+
+static int bench_step(FAR const struct bench_cfg_s *cfg, int nconns,
+                      FAR struct bench_result_s *res)
+{
+  FAR struct bench_conn_s *conn;
+  uint64_t start;
+  int active = 0;
+  int ret;
+  int i;
+
+  res->nlat   = 0;
+  res->errors = 0;
+
+  start = bench_now();
+  for (i = 0; i < nconns; i++)
+    {
+      conn = &g_conns[i];
+      conn->sent = 0;
+      if (bench_send(cfg, conn) < 0)
+        {
+          res->errors++;
+          conn->resync = true;
+          g_pfds[i].fd = -1;
+          continue;
+        }
+
+      g_pfds[i].fd     = conn->sd;
+      g_pfds[i].events = POLLIN;
+      active++;
+    }
+
+  while (active > 0)
+    {
+      ret = poll(g_pfds, nconns, BENCH_TIMEOUT_MS);
+      if (ret <= 0)
+        {
+          /* No answer, count the outstanding requests as failed */
+
+          for (i = 0; i < nconns; i++)
+            {
+              if (g_pfds[i].fd >= 0)
+                {
+                  g_conns[i].resync = true;
+                }
+            }
+
+          res->errors += active;
+          break;
+        }
+
+      for (i = 0; i < nconns; i++)
+        {
+          if (g_pfds[i].fd < 0 || g_pfds[i].revents == 0)
+            {
+              continue;
+            }
+
+          conn = &g_conns[i];
+          ret = bench_recv(cfg, conn);
+          if (ret == 0)
+            {
+              continue;
+            }
+
+          if (ret > 0)
+            {
+              res->lat_us[res->nlat++] =
+                (uint32_t)((bench_now() - conn->start) / 1000);
+            }
+          else
+            {
+              res->errors++;
+              conn->resync = true;
+            }
+
+          if (ret < 0 || conn->sent == cfg->requests)
+            {
+              g_pfds[i].fd = -1;
+              active--;
+            }
+          else if (bench_send(cfg, conn) < 0)
+            {
+              res->errors++;
+              conn->resync = true;
+              g_pfds[i].fd = -1;
+              active--;
+            }
+        }
+    }
+
+  res->elapsed_ns = bench_now() - start;
+
+  for (i = 0; i < nconns; i++)
+    {
+      conn = &g_conns[i];
+      if (!conn->resync)
+        {
+          continue;
+        }
+
+      close(conn->sd);
+      conn->sd = bench_connect(cfg);
+      if (conn->sd < 0)
+        {
+          return conn->sd;
+        }
+
+      conn->resync = false;
+    }
+
+  return 0;
+}
+
+/****************************************************************************
+ * Name: bench_compare
+ ****************************************************************************/
+
+static int bench_compare(FAR const void *a, FAR const void *b)
+{
+  uint32_t x = *(FAR const uint32_t *)a;
+  uint32_t y = *(FAR const uint32_t *)b;
+
+  return x < y ? -1 : x > y;
+}
+
+/****************************************************************************
+ * Name: bench_print
+ ****************************************************************************/
+
+static void bench_print(int nconns, FAR struct bench_result_s *res)
+{
+  uint64_t sum = 0;
+  int n = res->nlat;
+  int i;
+
+  if (n == 0)
+    {
+      printf("%6d %10s %8s %8s %8s %8s %8s %8d\n",
+             nconns, "-", "-", "-", "-", "-", "-", res->errors);
+      return;
+    }
+
+  qsort(res->lat_us, n, sizeof(uint32_t), bench_compare);
+  for (i = 0; i < n; i++)
+    {
+      sum += res->lat_us[i];
+    }
+
+  printf("%6d %10.1f %8" PRIu32 " %8" PRIu32 " %8" PRIu32 " %8" PRIu32
+         " %8" PRIu32 " %8d\n", nconns,
+         (float)n * 1e9f / res->elapsed_ns,
+         (uint32_t)(sum / n),
+         res->lat_us[0],
+         res->lat_us[n / 2],
+         res->lat_us[(n * 99) / 100],
+         res->lat_us[n - 1],
+         res->errors);
+}
+
+/****************************************************************************
+ * Name: bench_help
+ ****************************************************************************/
+
+static void bench_help(FAR const char *progname)
+{
+  printf("Usage: %s [-a addr] [-p port] [-c conns] [-s step] "
+         "[-n requests] [-r reg] [-q nregs]\n", progname);
+  printf("  -a: server IPv4 address, default %s\n", BENCH_ADDR_DEFAULT);
+  printf("  -p: server port, default %d\n", BENCH_PORT_DEFAULT);
+  printf("  -c: maximum concurrent masters, default %d, max %d\n",
+         BENCH_CONNS_DEFAULT, BENCH_CONNS_MAX);
+  printf("  -s: masters added per step, default %d\n", BENCH_STEP_DEFAULT);
+  printf("  -n: requests per master and step, default %d\n",
+         BENCH_REQUESTS_DEFAULT);
+  printf("  -r: first holding register address, default %d\n",
+         BENCH_REG_DEFAULT);
+  printf("  -q: registers per request, default %d, max %d\n",
+         BENCH_NREGS_DEFAULT, BENCH_NREGS_MAX);
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: main
+ ****************************************************************************/
+
+int main(int argc, FAR char *argv[])
+{
+  struct bench_result_s res;
+  struct bench_cfg_s    cfg;
+  FAR const char       *addr   = BENCH_ADDR_DEFAULT;
+  int                   port   = BENCH_PORT_DEFAULT;
+  int                   nconns = 0;
+  int                   level;
+  int                   ret;
+  int                   opt;
+  int                   sd;
+  int                   i;
+
+  memset(&cfg, 0, sizeof(cfg));
+  cfg.conns    = BENCH_CONNS_DEFAULT;
+  cfg.step     = BENCH_STEP_DEFAULT;
+  cfg.requests = BENCH_REQUESTS_DEFAULT;
+  cfg.reg      = BENCH_REG_DEFAULT;
+  cfg.nregs    = BENCH_NREGS_DEFAULT;
+
+  while ((opt = getopt(argc, argv, "a:p:c:s:n:r:q:h")) != ERROR)
+    {
+      switch (opt)
+        {
+          case 'a':
+            addr = optarg;
+            break;
+
+          case 'p':
+            port = atoi(optarg);
+            break;
+
+          case 'c':
+            cfg.conns = atoi(optarg);
+            break;
+
+          case 's':
+            cfg.step = atoi(optarg);
+            break;
+
+          case 'n':
+            cfg.requests = atoi(optarg);
+            break;
+
+          case 'r':
+            cfg.reg = atoi(optarg);
+            break;
+
+          case 'q':
+            cfg.nregs = atoi(optarg);
+            break;
+
+          case 'h':
+          default:
+            bench_help(argv[0]);
+            return opt == 'h' ? EXIT_SUCCESS : EXIT_FAILURE;
+        }
+    }
+
+  cfg.addr.sin_family = AF_INET;
+  cfg.addr.sin_port   = htons(port);
+
+  if (inet_pton(AF_INET, addr, &cfg.addr.sin_addr) != 1 ||
+      cfg.conns < 1 || cfg.conns > BENCH_CONNS_MAX || cfg.step < 1 ||
+      cfg.requests < 1 || cfg.reg < 0 || cfg.reg > UINT16_MAX ||
+      cfg.nregs < 1 || cfg.nregs > BENCH_NREGS_MAX)
+    {
+      bench_help(argv[0]);
+      return EXIT_FAILURE;
+    }
+
+#ifdef CONFIG_MB_TCP_ENABLED
+  /* A server of this build refuses the masters beyond its pool, which
+   * would only show up as errors.
+   */
+
+  if ((ntohl(cfg.addr.sin_addr.s_addr) & 0xff000000) ==
+      (INADDR_LOOPBACK & 0xff000000) &&
+      cfg.conns > CONFIG_MB_TCP_MAX_CLIENTS)
+    {
+      printf("ERROR: %d masters, but the local server accepts only "
+             "CONFIG_MB_TCP_MAX_CLIENTS=%d, raise it or use -c\n",
+             cfg.conns, CONFIG_MB_TCP_MAX_CLIENTS);
+      return EXIT_FAILURE;
+    }
+#endif
+
+  res.lat_us = malloc(cfg.conns * cfg.requests * sizeof(uint32_t));
+  if (res.lat_us == NULL)
+    {
+      printf("ERROR: no memory for %d latencies\n",
+             cfg.conns * cfg.requests);
+      return EXIT_FAILURE;
+    }
+
+  printf("modbus_tcp_bench: %s:%d, %d requests of %d registers "
+         "per master\n", addr, port, cfg.requests, cfg.nregs);
+  printf("%6s %10s %8s %8s %8s %8s %8s %8s\n", "conns", "req/s",
+         "avg us", "min us", "p50 us", "p99 us", "max us", "errors");
+
+  /* Add masters step by step.  The connections stay open, so every step
+   * measures the server with all of them sending requests at once.
+   */
+
+  for (level = MIN(cfg.step, cfg.conns); level <= cfg.conns;
+       level += cfg.step)
+    {
+      while (nconns < level)
+        {
+          sd = bench_connect(&cfg);
+          if (sd < 0)
+            {
+              printf("ERROR: connection %d failed: %d\n", nconns, sd);
+              goto out;
+            }
+
+          memset(&g_conns[nconns], 0, sizeof(g_conns[nconns]));
+          g_conns[nconns++].sd = sd;
+        }
+
+      ret = bench_step(&cfg, nconns, &res);
+      bench_print(nconns, &res);
+      if (ret < 0)
+        {
+          printf("ERROR: reconnecting a master failed: %d\n", ret);
+          goto out;
+        }
+
+      if (level < cfg.conns && level + cfg.step > cfg.conns)
+        {
+          level = cfg.conns - cfg.step;
+        }
+    }
+
+out:
+  for (i = 0; i < nconns; i++)
+    {
+      close(g_conns[i].sd);
+    }
+
+  free(res.lat_us);
+  return EXIT_SUCCESS;
+}
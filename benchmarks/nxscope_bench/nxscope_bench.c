@@ -0,0 +1,414 @@
+/****************************************************************************
+ * apps/benchmarks/nxscope_bench/nxscope_bench.c
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <sys/param.h>
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <logging/nxscope/nxscope.h>
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#define BENCH_CHANNELS_DEFAULT  (16)
+#define BENCH_CHANNELS_MAX      (64)
+#define BENCH_SAMPLES_DEFAULT   (2000)
+#define BENCH_BAUD_DEFAULT      (921600)
+
+/* Sine oscillator step: 2 * pi / 1000 samples per period */
+
+#define BENCH_OSC_COS           (0.99998026f)
+#define BENCH_OSC_SIN           (0.00628314f)
+
+/****************************************************************************
+ * Private Types
+ ****************************************************************************/
+
+struct bench_type_s
+{
+  FAR const char *name;
+  uint8_t         type;
+};
+
+struct bench_result_s
+{
+  size_t   bytes;                   /* Bytes send over interface */
+  uint32_t samples;                 /* Samples accepted */
+  uint32_t dropped;                 /* Samples rejected */
+  uint64_t stream_ns;               /* Time spent in nxscope_stream() */
+  uint32_t frames;                  /* Frames send */
+};
+
+/****************************************************************************
+ * Private Function Prototypes
+ ****************************************************************************/
+
+static int bench_intf_send(FAR struct nxscope_intf_s *intf,
+                           FAR uint8_t *buff, int len);
+static int bench_intf_recv(FAR struct nxscope_intf_s *intf,
+                           FAR uint8_t *buff, int len);
+
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+static const struct bench_type_s g_bench_types[] =
+{
+  {"float", NXSCOPE_TYPE_FLOAT},
+  {"int16", NXSCOPE_TYPE_INT16},
+  {"b16",   NXSCOPE_TYPE_B16},
+#ifdef CONFIG_HAVE_LONG_LONG
+  {"b32",   NXSCOPE_TYPE_B32},
+#endif
+};
+
+static struct nxscope_intf_ops_s g_bench_intf_ops =
+{
+  bench_intf_send,
+  bench_intf_recv
+};
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: bench_intf_send
+ *
+ * Description:
+ *   Count the stream bytes instead of sending them
+ *
+ ****************************************************************************/
+
+static int bench_intf_send(FAR struct nxscope_intf_s *intf,
+                           FAR uint8_t *buff, int len)
+{
+  FAR struct bench_result_s *res = intf->priv;
+
+  UNUSED(buff);
+
+  res->bytes  += len;
+  res->frames += 1;
+
+  return len;
+}
+
+/****************************************************************************
+ * Name: bench_intf_recv
+ ****************************************************************************/
+
+static int bench_intf_recv(FAR struct nxscope_intf_s *intf,
+                           FAR uint8_t *buff, int len)
+{
+  UNUSED(intf);
+  UNUSED(buff);
+  UNUSED(len);
+
+  return 0;
+}
+
+/****************************************************************************
+ * Name: bench_now
+ ****************************************************************************/
+
+static uint64_t bench_now(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+
+  return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+/****************************************************************************
+ * Name: bench_put
+ ****************************************************************************/
+
+static int bench_put(FAR struct nxscope_s *nxs, uint8_t type, uint8_t ch,
+                     float val)
+{
+  switch (type)
+    {
+      case NXSCOPE_TYPE_FLOAT:
+        {
+          return nxscope_put_float(nxs, ch, val);
+        }
+
+      case NXSCOPE_TYPE_INT16:
+        {
+          return nxscope_put_int16(nxs, ch, (int16_t)(val * 1000.0f));
+        }
+
+      case NXSCOPE_TYPE_B16:
+        {
+          return nxscope_put_b16(nxs, ch, ftob16(val));
+        }
+
+#ifdef CONFIG_HAVE_LONG_LONG
+      case NXSCOPE_TYPE_B32:
+        {
+          return nxscope_put_b32(nxs, ch, ftob32(val));
+        }
+#endif
+
+      default:
+        {
+          return -EINVAL;
+        }
+    }
+}
+
+/****************************************************************************
+ * Name: bench_run
+ ****************************************************************************/
+
+static int bench_run(uint8_t type, int channels, int samples, bool packed,
+                     FAR struct bench_result_s *res)
+{
+  struct nxscope_proto_s proto;
+  struct nxscope_intf_s  intf;
+  struct nxscope_cfg_s   cfg;
+  struct nxscope_s       nxs;
+  float                  x[BENCH_CHANNELS_MAX];
+  float                  y[BENCH_CHANNELS_MAX];
+  float                  tmp;
+  uint64_t               start;
+  int                    ret;
+  int                    i;
+  int                    j;
+
+  memset(res, 0, sizeof(*res));
+  memset(&cfg, 0, sizeof(cfg));
+
+  ret = nxscope_proto_ser_init(&proto, NULL);
+  if (ret < 0)
+    {
+      return ret;
+    }
+
+  intf.initialized = true;
+  intf.priv        = res;
+  intf.ops         = &g_bench_intf_ops;
+
+  cfg.intf_cmd      = &intf;
+  cfg.intf_stream   = &intf;
+  cfg.proto_cmd     = &proto;
+  cfg.proto_stream  = &proto;
+  cfg.channels      = channels;
+  cfg.streambuf_len = CONFIG_BENCHMARK_NXSCOPE_STREAMBUF_LEN;
+  cfg.rxbuf_len     = 32;
+#ifdef CONFIG_LOGGING_NXSCOPE_CRICHANNELS
+  cfg.cribuf_len    = 32;
+#endif
+
+  ret = nxscope_init(&nxs, &cfg);
+  if (ret < 0)
+    {
+      nxscope_proto_ser_deinit(&proto);
+      return ret;
+    }
+
+  for (i = 0; i < channels; i++)
+    {
+      nxscope_chan_init(&nxs, i, "bench", type, 1, 0);
+
+      /* Different phase for each channel */
+
+      x[i] = (float)(i % 8) / 8.0f - 0.5f;
+      y[i] = 0.5f;
+    }
+
+  nxscope_chan_all_en(&nxs, true);
+#ifdef CONFIG_LOGGING_NXSCOPE_PACKED
+  nxscope_stream_packed(&nxs, packed);
+#endif
+  nxscope_stream_start(&nxs, true);
+
+  for (i = 0; i < samples; i++)
+    {
+      for (j = 0; j < channels; j++)
+        {
+          if (bench_put(&nxs, type, j, x[j]) == OK)
+            {
+              res->samples++;
+            }
+          else
+            {
+              /* Flush the full stream buffer and retry once */
+
+              start = bench_now();
+              nxscope_stream(&nxs);
+              res->stream_ns += bench_now() - start;
+
+              if (bench_put(&nxs, type, j, x[j]) == OK)
+                {
+                  res->samples++;
+                }
+              else
+                {
+                  res->dropped++;
+                }
+            }
+
+          tmp  = x[j] * BENCH_OSC_COS - y[j] * BENCH_OSC_SIN;
+          y[j] = x[j] * BENCH_OSC_SIN + y[j] * BENCH_OSC_COS;
+          x[j] = tmp;
+        }
+    }
+
+  start = bench_now();
+  nxscope_stream(&nxs);
+  res->stream_ns += bench_now() - start;
+
+  nxscope_deinit(&nxs);
+  nxscope_proto_ser_deinit(&proto);
+
+  return OK;
+}
+
+/****************************************************************************
+ * Name: bench_print
+ ****************************************************************************/
+
+static void bench_print(FAR const char *name, FAR const char *mode,
+                        FAR struct bench_result_s *res, int channels,
+                        uint32_t baud)
+{
+  float bps;
+  float rate;
+
+  if (res->samples == 0)
+    {
+      return;
+    }
+
+  /* 8N1 serial: 10 bits on the wire per byte */
+
+  bps  = (float)res->bytes / res->samples;
+  rate = (float)baud / 10.0f / bps / channels;
+
+  printf("%-6s %-7s %8.2f %10.0f %10lu %10.2f\n",
+         name, mode, bps, rate, (unsigned long)res->dropped,
+         res->frames ? (float)res->stream_ns / res->frames / 1000.0f : 0.f);
+}
+
+/****************************************************************************
+ * Name: bench_help
+ ****************************************************************************/
+
+static void bench_help(FAR const char *progname)
+{
+  printf("Usage: %s [-c channels] [-n samples] [-b baud]\n", progname);
+  printf("  -c: number of channels, default %d, max %d\n",
+         BENCH_CHANNELS_DEFAULT, BENCH_CHANNELS_MAX);
+  printf("  -n: samples per channel, default %d\n", BENCH_SAMPLES_DEFAULT);
+  printf("  -b: serial baud rate, default %d\n", BENCH_BAUD_DEFAULT);
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: main
+ ****************************************************************************/
+
+int main(int argc, FAR char *argv[])
+{
+  struct bench_result_s res;
+  uint32_t              baud     = BENCH_BAUD_DEFAULT;
+  int                   channels = BENCH_CHANNELS_DEFAULT;
+  int                   samples  = BENCH_SAMPLES_DEFAULT;
+  int                   opt;
+  int                   i;
+
+  while ((opt = getopt(argc, argv, "c:n:b:h")) != ERROR)
+    {
+      switch (opt)
+        {
+          case 'c':
+            channels = atoi(optarg);
+            break;
+
+          case 'n':
+            samples = atoi(optarg);
+            break;
+
+          case 'b':
+            baud = strtoul(optarg, NULL, 0);
+            break;
+
+          case 'h':
+          default:
+            bench_help(argv[0]);
+            return opt == 'h' ? EXIT_SUCCESS : EXIT_FAILURE;
+        }
+    }
+
+  if (channels < 1 || channels > BENCH_CHANNELS_MAX || samples < 1 ||
+      baud == 0)
+    {
+      bench_help(argv[0]);
+      return EXIT_FAILURE;
+    }
+
+  printf("nxscope_bench: %d channels, %d samples, %lu baud, "
+         "streambuf %d\n", channels, samples, (unsigned long)baud,
+         CONFIG_BENCHMARK_NXSCOPE_STREAMBUF_LEN);
+  printf("%-6s %-7s %8s %10s %10s %10s\n",
+         "type", "frames", "B/sample", "Hz/chan", "dropped", "us/frame");
+
+  for (i = 0; i < nitems(g_bench_types); i++)
+    {
+      if (bench_run(g_bench_types[i].type, channels, samples, false,
+                    &res) < 0)
+        {
+          printf("ERROR: bench_run failed\n");
+          return EXIT_FAILURE;
+        }
+
+      bench_print(g_bench_types[i].name, "raw", &res, channels, baud);
+
+#ifdef CONFIG_LOGGING_NXSCOPE_PACKED
+      if (bench_run(g_bench_types[i].type, channels, samples, true,
+                    &res) < 0)
+        {
+          printf("ERROR: bench_run failed\n");
+          return EXIT_FAILURE;
+        }
+
+      bench_print(g_bench_types[i].name, "packed", &res, channels, baud);
+#endif
+    }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,355 @@
+/****************************************************************************
+ * apps/benchmarks/thttpd_bench/thttpd_bench.c
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <sys/param.h>
+#include <sys/socket.h>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+
+#include <errno.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#define BENCH_ADDR_DEFAULT      "127.0.0.1"
+#define BENCH_PORT_DEFAULT      (80)
+#define BENCH_URL_DEFAULT       "/"
+#define BENCH_CONNS_DEFAULT     (48)
+#define BENCH_STEP_DEFAULT      (8)
+#define BENCH_REQUESTS_DEFAULT  (100)
+#define BENCH_CONNS_MAX         (256)
+
+/****************************************************************************
+ * Private Types
+ ****************************************************************************/
+
+struct bench_cfg_s
+{
+  struct sockaddr_in addr;          /* Server address */
+  FAR const char    *url;           /* URL to request */
+  int                conns;         /* Maximum number of idle connections */
+  int                step;          /* Idle connections added per step */
+  int                requests;      /* Requests per step */
+};
+
+struct bench_result_s
+{
+  uint64_t total_ns;                /* Time of all requests */
+  uint64_t min_ns;                  /* Fastest request */
+  uint64_t max_ns;                  /* Slowest request */
+  size_t   bytes;                   /* Response bytes received */
+  int      errors;                  /* Failed requests */
+};
+
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+static int g_idle[BENCH_CONNS_MAX];
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: bench_now
+ ****************************************************************************/
+
+static uint64_t bench_now(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+
+  return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+/****************************************************************************
+ * Name: bench_connect
+ ****************************************************************************/
+
+static int bench_connect(FAR const struct bench_cfg_s *cfg)
+{
+  int sd;
+
+  sd = socket(AF_INET, SOCK_STREAM, 0);
+  if (sd < 0)
+    {
+      return -errno;
+    }
+
+  if (connect(sd, (FAR const struct sockaddr *)&cfg->addr,
+              sizeof(cfg->addr)) < 0)
+    {
+      int errcode = errno;
+
+      close(sd);
+      return -errcode;
+    }
+
+  return sd;
+}
+
+/****************************************************************************
+ * Name: bench_request
+ *
+ * Description:
+ *   Send one HTTP/1.0 request on a new connection and read the response
+ *   until the server closes the connection.
+ *
+ * Returned Value:
+ *   The number of response bytes or a negated errno value.
+ *
+ ****************************************************************************/
+
+static ssize_t bench_request(FAR const struct bench_cfg_s *cfg)
+{
+  char    buf[256];
+  ssize_t total = 0;
+  ssize_t n;
+  int     len;
+  int     sd;
+
+  sd = bench_connect(cfg);
+  if (sd < 0)
+    {
+      return sd;
+    }
+
+  len = snprintf(buf, sizeof(buf), "GET %s HTTP/1.0\r\n\r\n", cfg->url);
+  if (send(sd, buf, len, 0) != len)
+    {
+      total = -errno;
+      goto out;
+    }
+
+  while ((n = recv(sd, buf, sizeof(buf), 0)) > 0)
+    {
+      total += n;
+    }
+
+  if (n < 0)
+    {
+      total = -errno;
+    }
+
+out:
+  close(sd);
+  return total;
+}
+
+/****************************************************************************
+ * Name: bench_step
+ ****************************************************************************/
+
+static void bench_step(FAR const struct bench_cfg_s *cfg,
+                       FAR struct bench_result_s *res)
+{
+  uint64_t start;
+  uint64_t dt;
+  ssize_t  n;
+  int      i;
+
+  memset(res, 0, sizeof(*res));
+  res->min_ns = UINT64_MAX;
+
+  for (i = 0; i < cfg->requests; i++)
+    {
+      start = bench_now();
+      n     = bench_request(cfg);
+      dt    = bench_now() - start;
+
+      if (n <= 0)
+        {
+          res->errors++;
+          continue;
+        }
+
+      res->bytes    += n;
+      res->total_ns += dt;
+      res->min_ns    = MIN(res->min_ns, dt);
+      res->max_ns    = MAX(res->max_ns, dt);
+    }
+}
+
+/****************************************************************************
+ * Name: bench_print
+ ****************************************************************************/
+
+static void bench_print(int idle, FAR const struct bench_cfg_s *cfg,
+                        FAR const struct bench_result_s *res)
+{
+  int ok = cfg->requests - res->errors;
+
+  if (ok == 0)
+    {
+      printf("%6d %10s %10s %10s %10s %8d\n",
+             idle, "-", "-", "-", "-", res->errors);
+      return;
+    }
+
+  printf("%6d %10.1f %10.1f %10.1f %10.1f %8d\n", idle,
+         (float)ok * 1e9f / res->total_ns,
+         (float)res->total_ns / ok / 1000.0f,
+         (float)res->min_ns / 1000.0f,
+         (float)res->max_ns / 1000.0f,
+         res->errors);
+}
+
+/****************************************************************************
+ * Name: bench_help
+ ****************************************************************************/
+
+static void bench_help(FAR const char *progname)
+{
+  printf("Usage: %s [-a addr] [-p port] [-u url] [-c conns] [-s step] "
+         "[-n requests]\n", progname);
+  printf("  -a: server IPv4 address, default %s\n", BENCH_ADDR_DEFAULT);
+  printf("  -p: server port, default %d\n", BENCH_PORT_DEFAULT);
+  printf("  -u: URL to request, default %s\n", BENCH_URL_DEFAULT);
+  printf("  -c: maximum idle connections, default %d, max %d\n",
+         BENCH_CONNS_DEFAULT, BENCH_CONNS_MAX);
+  printf("  -s: idle connections added per step, default %d\n",
+         BENCH_STEP_DEFAULT);
+  printf("  -n: requests per step, default %d\n", BENCH_REQUESTS_DEFAULT);
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: main
+ ****************************************************************************/
+
+int main(int argc, FAR char *argv[])
+{
+  struct bench_result_s res;
+  struct bench_cfg_s    cfg;
+  FAR const char       *addr  = BENCH_ADDR_DEFAULT;
+  int                   port  = BENCH_PORT_DEFAULT;
+  int                   nidle = 0;
+  int                   idle;
+  int                   opt;
+  int                   sd;
+  int                   i;
+
+  memset(&cfg, 0, sizeof(cfg));
+  cfg.url      = BENCH_URL_DEFAULT;
+  cfg.conns    = BENCH_CONNS_DEFAULT;
+  cfg.step     = BENCH_STEP_DEFAULT;
+  cfg.requests = BENCH_REQUESTS_DEFAULT;
+
+  while ((opt = getopt(argc, argv, "a:p:u:c:s:n:h")) != ERROR)
+    {
+      switch (opt)
+        {
+          case 'a':
+            addr = optarg;
+            break;
+
+          case 'p':
+            port = atoi(optarg);
+            break;
+
+          case 'u':
+            cfg.url = optarg;
+            break;
+
+          case 'c':
+            cfg.conns = atoi(optarg);
+            break;
+
+          case 's':
+            cfg.step = atoi(optarg);
+            break;
+
+          case 'n':
+            cfg.requests = atoi(optarg);
+            break;
+
+          case 'h':
+          default:
+            bench_help(argv[0]);
+            return opt == 'h' ? EXIT_SUCCESS : EXIT_FAILURE;
+        }
+    }
+
+  cfg.addr.sin_family = AF_INET;
+  cfg.addr.sin_port   = htons(port);
+
+  if (inet_pton(AF_INET, addr, &cfg.addr.sin_addr) != 1 ||
+      cfg.conns < 0 || cfg.conns > BENCH_CONNS_MAX || cfg.step < 1 ||
+      cfg.requests < 1)
+    {
+      bench_help(argv[0]);
+      return EXIT_FAILURE;
+    }
+
+  printf("thttpd_bench: %s:%d%s, %d requests per step\n",
+         addr, port, cfg.url, cfg.requests);
+  printf("%6s %10s %10s %10s %10s %8s\n",
+         "idle", "req/s", "avg us", "min us", "max us", "errors");
+
+  /* Add idle connections step by step and measure the requests at each
+   * step.  The idle connections never send a request, the server keeps
+   * watching them until its read timeout.
+   */
+
+  for (idle = 0; idle <= cfg.conns; idle += cfg.step)
+    {
+      while (nidle < idle)
+        {
+          sd = bench_connect(&cfg);
+          if (sd < 0)
+            {
+              printf("ERROR: idle connection %d failed: %d\n", nidle, sd);
+              goto out;
+            }
+
+          g_idle[nidle++] = sd;
+        }
+
+      bench_step(&cfg, &res);
+      bench_print(nidle, &cfg, &res);
+    }
+
+out:
+  for (i = 0; i < nidle; i++)
+    {
+      close(g_idle[i]);
+    }
+
+  return EXIT_SUCCESS;
+}
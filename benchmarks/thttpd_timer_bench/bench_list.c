@@ -0,0 +1,54 @@
+/****************************************************************************
+ * apps/benchmarks/thttpd_timer_bench/bench_list.c
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+/* Build the sorted list timers of thttpd with a list_ prefix */
+
+#define tmr_init        list_tmr_init
+#define tmr_create      list_tmr_create
+#define tmr_mstimeout   list_tmr_mstimeout
+#define tmr_run         list_tmr_run
+#define tmr_cancel      list_tmr_cancel
+#define tmr_cleanup     list_tmr_cleanup
+#define tmr_destroy     list_tmr_destroy
+#define JunkClientData  list_JunkClientData
+
+#include <nuttx/config.h>
+
+#include "timers.c"
+#include "thttpd_timer_bench.h"
+
+/****************************************************************************
+ * Public Data
+ ****************************************************************************/
+
+const struct timer_ops_s g_list_ops =
+{
+  "list",
+  tmr_init,
+  tmr_create,
+  tmr_mstimeout,
+  tmr_run,
+  tmr_cancel,
+  tmr_destroy
+};
@@ -0,0 +1,323 @@
+/****************************************************************************
+ * apps/benchmarks/thttpd_timer_bench/thttpd_timer_bench.c
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <sys/param.h>
+#include <sys/time.h>
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "thttpd_timer_bench.h"
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#define BENCH_TIMERS_MAX        (1000)
+#define BENCH_CHURN_DEFAULT     (10000)
+#define BENCH_SPAN_MSECS        (300000)  /* Spread of the timeouts */
+#define BENCH_EXPIRE_MSECS      (1000)    /* Spread of the expiry test */
+#define BENCH_STEP_MSECS        (10)      /* Clock step of the expiry test */
+
+/****************************************************************************
+ * Private Types
+ ****************************************************************************/
+
+struct bench_result_s
+{
+  uint32_t add_ns;                  /* Per tmr_create() */
+  uint32_t churn_ns;                /* Per cancel, create, timeout and run */
+  uint32_t expire_ns;               /* Per expired timer */
+};
+
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+static const int g_sizes[] =
+{
+  10, 100, 1000
+};
+
+static FAR Timer *g_timers[BENCH_TIMERS_MAX];
+static struct timeval g_now;
+static uint32_t g_seed;
+static int g_fired;
+static int g_early;
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: bench_now
+ ****************************************************************************/
+
+static uint64_t bench_now(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+
+  return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+/****************************************************************************
+ * Name: bench_rand
+ *
+ * Description:
+ *   Simple LCG, so that both implementations see the same workload.
+ *
+ ****************************************************************************/
+
+static long bench_rand(long range)
+{
+  g_seed = g_seed * 1103515245u + 12345u;
+  return 1 + (long)((g_seed >> 8) % (uint32_t)range);
+}
+
+/****************************************************************************
+ * Name: bench_advance
+ ****************************************************************************/
+
+static void bench_advance(long msecs)
+{
+  g_now.tv_usec += msecs * 1000L;
+  g_now.tv_sec  += g_now.tv_usec / 1000000L;
+  g_now.tv_usec %= 1000000L;
+}
+
+/****************************************************************************
+ * Name: bench_expired
+ ****************************************************************************/
+
+static void bench_expired(ClientData client_data, FAR struct timeval *nowp)
+{
+  FAR Timer *tmr = g_timers[client_data.i];
+
+  if (tmr->time.tv_sec > nowp->tv_sec ||
+      (tmr->time.tv_sec == nowp->tv_sec &&
+       tmr->time.tv_usec > nowp->tv_usec))
+    {
+      g_early++;
+    }
+
+  /* One-shot timers are freed after the callback */
+
+  g_timers[client_data.i] = NULL;
+  g_fired++;
+}
+
+/****************************************************************************
+ * Name: bench_create
+ ****************************************************************************/
+
+static int bench_create(FAR const struct timer_ops_s *ops, int i,
+                        long span)
+{
+  ClientData cd;
+
+  cd.i = i;
+  g_timers[i] = ops->create(&g_now, bench_expired, cd, bench_rand(span), 0);
+  return g_timers[i] != NULL ? 0 : -1;
+}
+
+/****************************************************************************
+ * Name: bench_run
+ *
+ * Description:
+ *   Run the workload with ntimers timers on one implementation.
+ *
+ ****************************************************************************/
+
+static int bench_run(FAR const struct timer_ops_s *ops, int ntimers,
+                     int nchurn, FAR struct bench_result_s *res)
+{
+  uint64_t start;
+  int i;
+
+  g_seed  = 1;
+  g_fired = 0;
+  g_early = 0;
+  gettimeofday(&g_now, NULL);
+  ops->init();
+
+  /* Add the timers, like new connections do */
+
+  start = bench_now();
+  for (i = 0; i < ntimers; i++)
+    {
+      if (bench_create(ops, i, BENCH_SPAN_MSECS) < 0)
+        {
+          goto errout;
+        }
+    }
+
+  res->add_ns = (bench_now() - start) / ntimers;
+
+  /* Replace random timers while the clock moves on, like the server loop
+   * does when connections change state.
+   */
+
+  start = bench_now();
+  for (i = 0; i < nchurn; i++)
+    {
+      int n = bench_rand(ntimers) - 1;
+
+      if (g_timers[n] != NULL)
+        {
+          ops->cancel(g_timers[n]);
+        }
+
+      if (bench_create(ops, n, BENCH_SPAN_MSECS) < 0)
+        {
+          goto errout;
+        }
+
+      ops->mstimeout(&g_now);
+      bench_advance(1);
+      ops->run(&g_now);
+    }
+
+  res->churn_ns = (bench_now() - start) / nchurn;
+  ops->destroy();
+
+  /* Let timers that expire close together run out */
+
+  ops->init();
+  g_fired = 0;
+  for (i = 0; i < ntimers; i++)
+    {
+      if (bench_create(ops, i, BENCH_EXPIRE_MSECS) < 0)
+        {
+          goto errout;
+        }
+    }
+
+  start = bench_now();
+  while (ops->mstimeout(&g_now) >= 0)
+    {
+      bench_advance(BENCH_STEP_MSECS);
+      ops->run(&g_now);
+    }
+
+  res->expire_ns = (bench_now() - start) / ntimers;
+  ops->destroy();
+
+  if (g_fired != ntimers || g_early > 0)
+    {
+      printf("ERROR: %s: %d of %d timers expired, %d early\n",
+             ops->name, g_fired, ntimers, g_early);
+      return -1;
+    }
+
+  return 0;
+
+errout:
+  printf("ERROR: %s: failed to create a timer\n", ops->name);
+  ops->destroy();
+  return -1;
+}
+
+/****************************************************************************
+ * Name: bench_help
+ ****************************************************************************/
+
+static void bench_help(FAR const char *progname)
+{
+  printf("Usage: %s [-c churn]\n", progname);
+  printf("  -c: timer replacements per size, default %d\n",
+         BENCH_CHURN_DEFAULT);
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: main
+ ****************************************************************************/
+
+int main(int argc, FAR char *argv[])
+{
+  FAR const struct timer_ops_s *ops[2];
+  struct bench_result_s res;
+  int nchurn = BENCH_CHURN_DEFAULT;
+  int ret = EXIT_SUCCESS;
+  int opt;
+  int i;
+  int j;
+
+  while ((opt = getopt(argc, argv, "c:h")) != ERROR)
+    {
+      switch (opt)
+        {
+          case 'c':
+            nchurn = atoi(optarg);
+            break;
+
+          case 'h':
+          default:
+            bench_help(argv[0]);
+            return opt == 'h' ? EXIT_SUCCESS : EXIT_FAILURE;
+        }
+    }
+
+  if (nchurn < 1)
+    {
+      bench_help(argv[0]);
+      return EXIT_FAILURE;
+    }
+
+  ops[0] = &g_list_ops;
+  ops[1] = &g_wheel_ops;
+
+  printf("%6s %6s %10s %10s %10s\n",
+         "timers", "method", "add ns", "churn ns", "expire ns");
+
+  for (i = 0; i < nitems(g_sizes); i++)
+    {
+      for (j = 0; j < 2; j++)
+        {
+          if (bench_run(ops[j], g_sizes[i], nchurn, &res) < 0)
+            {
+              ret = EXIT_FAILURE;
+              continue;
+            }
+
+          printf("%6d %6s %10" PRIu32 " %10" PRIu32 " %10" PRIu32 "\n",
+                 g_sizes[i], ops[j]->name, res.add_ns, res.churn_ns,
+                 res.expire_ns);
+        }
+    }
+
+  return ret;
+}
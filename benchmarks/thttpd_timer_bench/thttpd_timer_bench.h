@@ -0,0 +1,62 @@
+/****************************************************************************
+ * apps/benchmarks/thttpd_timer_bench/thttpd_timer_bench.h
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+#ifndef __APPS_BENCHMARKS_THTTPD_TIMER_BENCH_THTTPD_TIMER_BENCH_H
+#define __APPS_BENCHMARKS_THTTPD_TIMER_BENCH_THTTPD_TIMER_BENCH_H
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <sys/time.h>
+
+#include "timers.h"
+
+/****************************************************************************
+ * Public Types
+ ****************************************************************************/
+
+/* One timer implementation of thttpd.  Both implementations export the
+ * same tmr_*() functions, so they are built with renamed symbols and
+ * reached through this table.
+ */
+
+struct timer_ops_s
+{
+  FAR const char *name;
+  CODE void (*init)(void);
+  CODE Timer *(*create)(FAR struct timeval *nowp, FAR TimerProc *timer_proc,
+                        ClientData client_data, long msecs, int periodic);
+  CODE long (*mstimeout)(FAR struct timeval *nowp);
+  CODE void (*run)(FAR struct timeval *nowp);
+  CODE void (*cancel)(FAR Timer *timer);
+  CODE void (*destroy)(void);
+};
+
+/****************************************************************************
+ * Public Data
+ ****************************************************************************/
+
+extern const struct timer_ops_s g_list_ops;
+extern const struct timer_ops_s g_wheel_ops;
+
+#endif /* __APPS_BENCHMARKS_THTTPD_TIMER_BENCH_THTTPD_TIMER_BENCH_H */
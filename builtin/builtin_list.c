@@ -29,6 +29,12 @@
 
 #include <sys/stat.h>
 
+#include <stdbool.h>
+#include <errno.h>
+#include <string.h>
+
+#include "builtin/builtin.h"
+
 /****************************************************************************
  * Private Types
  ****************************************************************************/
@@ -59,10 +65,101 @@ const int g_builtin_count = nitems(g_builtins);
  * Private Data
  ****************************************************************************/
 
+/* 0: not checked yet, 1: g_builtins is sorted, -1: it is not */
+
+static int g_builtin_sorted;
+
 /****************************************************************************
  * Private Functions
  ****************************************************************************/
 
+/****************************************************************************
+ * Name: builtin_sorted
+ *
+ * Description:
+ *   The build sorts builtin_list.h by name, but not every host does that
+ *   (e.g. native Windows builds), so check it once before relying on it.
+ *
+ ****************************************************************************/
+
+static bool builtin_sorted(void)
+{
+  int i;
+
+  if (g_builtin_sorted == 0)
+    {
+      g_builtin_sorted = 1;
+
+      for (i = 1; i < g_builtin_count - 1; i++)
+        {
+          if (strcmp(g_builtins[i - 1].name, g_builtins[i].name) > 0)
+            {
+              g_builtin_sorted = -1;
+              break;
+            }
+        }
+    }
+
+  return g_builtin_sorted > 0;
+}
+
 /****************************************************************************
  * Public Functions
  ****************************************************************************/
+
+/****************************************************************************
+ * Name: builtin_find
+ *
+ * Description:
+ *   Find a builtin application by name.  The table is searched with a
+ *   binary search if it is sorted, otherwise linearly.
+ *
+ * Input Parameter:
+ *   appname - Name of the builtin application.
+ *
+ * Returned Value:
+ *   The index of the application in the builtin table on success, usable
+ *   with builtin_for_index().  -ENOENT if there is no such application.
+ *
+ ****************************************************************************/
+
+int builtin_find(FAR const char *appname)
+{
+  int lower = 0;
+  int upper = g_builtin_count - 1;
+  int mid;
+  int cmp;
+
+  if (!builtin_sorted())
+    {
+      for (mid = 0; mid < upper; mid++)
+        {
+          if (strcmp(g_builtins[mid].name, appname) == 0)
+            {
+              return mid;
+            }
+        }
+
+      return -ENOENT;
+    }
+
+  while (lower < upper)
+    {
+      mid = (lower + upper) >> 1;
+      cmp = strcmp(g_builtins[mid].name, appname);
+      if (cmp == 0)
+        {
+          return mid;
+        }
+      else if (cmp < 0)
+        {
+          lower = mid + 1;
+        }
+      else
+        {
+          upper = mid;
+        }
+    }
+
+  return -ENOENT;
+}
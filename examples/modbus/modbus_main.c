@@ -115,6 +115,7 @@ enum modbus_threadstate_e
 struct modbus_state_s
 {
   enum modbus_threadstate_e threadstate;
+  xMBInstance mb;
   uint16_t reginput[CONFIG_EXAMPLES_MODBUS_REG_INPUT_NREGS];
   uint16_t regholding[CONFIG_EXAMPLES_MODBUS_REG_HOLDING_NREGS];
   uint16_t regcoils[CONFIG_EXAMPLES_MODBUS_REG_COILS_NREGS];
@@ -183,6 +184,14 @@ static inline int modbus_initialize(void)
 
   status = ENODEV;
 
+#ifdef CONFIG_EXAMPLES_MODBUS_TCP
+  /* Initialize the FreeModBus library for Modbus TCP.
+   *
+   * CONFIG_EXAMPLES_MODBUS_TCP_PORT = TCP port, default=502
+   */
+
+  mberr = eMBTCPInit(&g_modbus.mb, CONFIG_EXAMPLES_MODBUS_TCP_PORT);
+#else
   /* Initialize the FreeModBus library.
    *
    * MB_RTU                        = RTU mode
@@ -192,9 +201,10 @@ static inline int modbus_initialize(void)
    * CONFIG_EXAMPLES_MODBUS_PARITY = parity, default=MB_PAR_EVEN
    */
 
-  mberr = eMBInit(MB_RTU, 0x0a, CONFIG_EXAMPLES_MODBUS_PORT,
+  mberr = eMBInit(&g_modbus.mb, MB_RTU, 0x0a, CONFIG_EXAMPLES_MODBUS_PORT,
                   CONFIG_EXAMPLES_MODBUS_BAUD,
                   CONFIG_EXAMPLES_MODBUS_PARITY);
+#endif
   if (mberr != MB_ENOERR)
     {
       fprintf(stderr, "modbus_main: "
@@ -210,7 +220,7 @@ static inline int modbus_initialize(void)
    * 3           = Length of additional values (in bytes)
    */
 
-  mberr = eMBSetSlaveID(0x34, true, g_slaveid, 3);
+  mberr = eMBSetSlaveID(&g_modbus.mb, 0x34, true, g_slaveid, 3);
   if (mberr != MB_ENOERR)
     {
       fprintf(stderr, "modbus_main: "
@@ -220,7 +230,7 @@ static inline int modbus_initialize(void)
 
   /* Enable FreeModBus */
 
-  mberr = eMBEnable();
+  mberr = eMBEnable(&g_modbus.mb);
   if (mberr != MB_ENOERR)
     {
       fprintf(stderr, "modbus_main: "
@@ -237,7 +247,7 @@ errout_with_modbus:
 
   /* Release hardware resources. */
 
-  eMBClose();
+  eMBClose(&g_modbus.mb);
 
 errout_with_mutex:
 
@@ -313,7 +323,7 @@ static void *modbus_pollthread(void *pvarg)
     {
       /* Poll */
 
-      mberr = eMBPoll();
+      mberr = eMBPoll(&g_modbus.mb);
       if (mberr != MB_ENOERR)
         {
            break;
@@ -353,11 +363,11 @@ stop_modbus_exit:
 
   /* Disable */
 
-  eMBDisable();
+  eMBDisable(&g_modbus.mb);
 
   /* Release hardware resources. */
 
-  eMBClose();
+  eMBClose(&g_modbus.mb);
 
   /* Free/uninitialize data structures */
 
@@ -514,7 +524,8 @@ int main(int argc, FAR char *argv[])
  *
  ****************************************************************************/
 
-eMBErrorCode eMBRegInputCB(uint8_t *buffer, uint16_t address, uint16_t nregs)
+eMBErrorCode eMBRegInputCB(FAR xMBInstance *inst, uint8_t *buffer,
+                           uint16_t address, uint16_t nregs)
 {
   eMBErrorCode mberr = MB_ENOERR;
   int          index;
@@ -549,8 +560,9 @@ eMBErrorCode eMBRegInputCB(uint8_t *buffer, uint16_t address, uint16_t nregs)
  *
  ****************************************************************************/
 
-eMBErrorCode eMBRegHoldingCB(uint8_t *buffer, uint16_t address,
-                             uint16_t nregs, eMBRegisterMode mode)
+eMBErrorCode eMBRegHoldingCB(FAR xMBInstance *inst, uint8_t *buffer,
+                             uint16_t address, uint16_t nregs,
+                             eMBRegisterMode mode)
 {
   eMBErrorCode    mberr = MB_ENOERR;
   int             index;
@@ -606,8 +618,9 @@ eMBErrorCode eMBRegHoldingCB(uint8_t *buffer, uint16_t address,
  *
  ****************************************************************************/
 
-eMBErrorCode eMBRegCoilsCB(uint8_t *buffer, uint16_t address,
-                           uint16_t ncoils, eMBRegisterMode mode)
+eMBErrorCode eMBRegCoilsCB(FAR xMBInstance *inst, uint8_t *buffer,
+                           uint16_t address, uint16_t ncoils,
+                           eMBRegisterMode mode)
 {
   eMBErrorCode    mberr = MB_ENOERR;
   int             index;
@@ -663,8 +676,8 @@ eMBErrorCode eMBRegCoilsCB(uint8_t *buffer, uint16_t address,
  *
  ****************************************************************************/
 
-eMBErrorCode eMBRegDiscreteCB(uint8_t *buffer, uint16_t address,
-                              uint16_t ndiscrete)
+eMBErrorCode eMBRegDiscreteCB(FAR xMBInstance *inst, uint8_t *buffer,
+                              uint16_t address, uint16_t ndiscrete)
 {
   return MB_ENOREG;
 }
@@ -56,6 +56,25 @@ extern "C"
  * Public Functions Prototypes
  ****************************************************************************/
 
+/****************************************************************************
+ * Name: builtin_find
+ *
+ * Description:
+ *   Find a builtin application registered during 'make context' time.
+ *   Faster than builtin_isavail() since the list of builtin applications
+ *   is sorted by name at build time.
+ *
+ * Input Parameter:
+ *   appname - Name of the builtin application.
+ *
+ * Returned Value:
+ *   The index of the application, to be used with builtin_for_index(),
+ *   on success.  -ENOENT if there is no such application.
+ *
+ ****************************************************************************/
+
+int builtin_find(FAR const char *appname);
+
 /****************************************************************************
  * Name: exec_builtin
  *
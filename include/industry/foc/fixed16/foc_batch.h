@@ -0,0 +1,151 @@
+/****************************************************************************
+ * apps/include/industry/foc/fixed16/foc_batch.h
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+#ifndef __INDUSTRY_FOC_FIXED16_FOC_BATCH_H
+#define __INDUSTRY_FOC_FIXED16_FOC_BATCH_H
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <stdint.h>
+
+#include <dspb16.h>
+
+#include "industry/foc/fixed16/foc_handler.h"
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#define FOC_BATCH_MAX CONFIG_INDUSTRY_FOC_BATCH_MAX
+
+/****************************************************************************
+ * Public Type Definition
+ ****************************************************************************/
+
+/* Input to the batched FOC controller.
+ *
+ * All data is kept as one array per quantity, indexed by the motor number
+ * (structure of arrays), so the handler can process all motors with
+ * the same instruction stream.
+ */
+
+struct foc_batch_input_b16_s
+{
+  b16_t   current[CONFIG_MOTOR_FOC_PHASES][FOC_BATCH_MAX]; /* Phase current
+                                                            * samples */
+  b16_t   ref_d[FOC_BATCH_MAX];  /* DQ reference frame - d */
+  b16_t   ref_q[FOC_BATCH_MAX];  /* DQ reference frame - q */
+  b16_t   comp_d[FOC_BATCH_MAX]; /* DQ voltage compensation - d */
+  b16_t   comp_q[FOC_BATCH_MAX]; /* DQ voltage compensation - q */
+  b16_t   angle[FOC_BATCH_MAX];  /* Phase angle */
+  b16_t   vbus[FOC_BATCH_MAX];   /* Bus voltage */
+  uint8_t mode[FOC_BATCH_MAX];   /* Controller mode
+                                  * (enum foc_handler_mode_e) */
+};
+
+/* Output from the batched FOC controller */
+
+struct foc_batch_output_b16_s
+{
+  b16_t duty[CONFIG_MOTOR_FOC_PHASES][FOC_BATCH_MAX];  /* New duty cycle */
+};
+
+/* Batched FOC handler data (PI current controller + SVM3 modulation) */
+
+struct foc_batch_b16_s
+{
+  int   n;                        /* Number of motors */
+
+  /* Configuration */
+
+  b16_t id_kp[FOC_BATCH_MAX];
+  b16_t id_ki[FOC_BATCH_MAX];
+  b16_t iq_kp[FOC_BATCH_MAX];
+  b16_t iq_ki[FOC_BATCH_MAX];
+  b16_t duty_max[FOC_BATCH_MAX];
+
+  /* Base voltage dependent data */
+
+  b16_t vbase_last[FOC_BATCH_MAX];
+  b16_t mod_scale[FOC_BATCH_MAX]; /* 1 / VBASE */
+  b16_t mag_max[FOC_BATCH_MAX];   /* Maximum DQ voltage magnitude */
+
+  /* Controller state */
+
+  b16_t sin[FOC_BATCH_MAX];
+  b16_t cos[FOC_BATCH_MAX];
+  b16_t i_a[FOC_BATCH_MAX];       /* Alpha-beta current */
+  b16_t i_b[FOC_BATCH_MAX];
+  b16_t i_d[FOC_BATCH_MAX];       /* DQ current */
+  b16_t i_q[FOC_BATCH_MAX];
+  b16_t id_int[FOC_BATCH_MAX];    /* PI integral parts */
+  b16_t iq_int[FOC_BATCH_MAX];
+  b16_t v_d[FOC_BATCH_MAX];       /* DQ voltage */
+  b16_t v_q[FOC_BATCH_MAX];
+  b16_t v_a[FOC_BATCH_MAX];       /* Alpha-beta voltage */
+  b16_t v_b[FOC_BATCH_MAX];
+  b16_t run[FOC_BATCH_MAX];       /* Non-zero if motor is modulated */
+  b16_t curr[FOC_BATCH_MAX];      /* Non-zero if in current mode */
+
+  /* Modulation state, non-zero for the phase current to be reconstructed
+   * from the others.
+   */
+
+  b16_t corr[CONFIG_MOTOR_FOC_PHASES][FOC_BATCH_MAX];
+};
+
+/****************************************************************************
+ * Public Function Prototypes
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: foc_batch_init_b16
+ ****************************************************************************/
+
+int foc_batch_init_b16(FAR struct foc_batch_b16_s *b, int n);
+
+/****************************************************************************
+ * Name: foc_batch_cfg_b16
+ ****************************************************************************/
+
+void foc_batch_cfg_b16(FAR struct foc_batch_b16_s *b, int motor,
+                       FAR struct foc_initdata_b16_s *ctrl_cfg,
+                       FAR struct foc_mod_cfg_b16_s *mod_cfg);
+
+/****************************************************************************
+ * Name: foc_batch_run_b16
+ ****************************************************************************/
+
+int foc_batch_run_b16(FAR struct foc_batch_b16_s *b,
+                      FAR struct foc_batch_input_b16_s *in,
+                      FAR struct foc_batch_output_b16_s *out);
+
+/****************************************************************************
+ * Name: foc_batch_state_b16
+ ****************************************************************************/
+
+void foc_batch_state_b16(FAR struct foc_batch_b16_s *b, int motor,
+                         FAR struct foc_state_b16_s *state);
+
+#endif /* __INDUSTRY_FOC_FIXED16_FOC_BATCH_H */
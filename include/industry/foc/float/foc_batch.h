@@ -0,0 +1,151 @@
+/****************************************************************************
+ * apps/include/industry/foc/float/foc_batch.h
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+#ifndef __INDUSTRY_FOC_FLOAT_FOC_BATCH_H
+#define __INDUSTRY_FOC_FLOAT_FOC_BATCH_H
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <stdint.h>
+
+#include <dsp.h>
+
+#include "industry/foc/float/foc_handler.h"
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#define FOC_BATCH_MAX CONFIG_INDUSTRY_FOC_BATCH_MAX
+
+/****************************************************************************
+ * Public Type Definition
+ ****************************************************************************/
+
+/* Input to the batched FOC controller.
+ *
+ * All data is kept as one array per quantity, indexed by the motor number
+ * (structure of arrays), so the handler can process all motors with
+ * the same instruction stream.
+ */
+
+struct foc_batch_input_f32_s
+{
+  float   current[CONFIG_MOTOR_FOC_PHASES][FOC_BATCH_MAX]; /* Phase current
+                                                            * samples */
+  float   ref_d[FOC_BATCH_MAX];  /* DQ reference frame - d */
+  float   ref_q[FOC_BATCH_MAX];  /* DQ reference frame - q */
+  float   comp_d[FOC_BATCH_MAX]; /* DQ voltage compensation - d */
+  float   comp_q[FOC_BATCH_MAX]; /* DQ voltage compensation - q */
+  float   angle[FOC_BATCH_MAX];  /* Phase angle */
+  float   vbus[FOC_BATCH_MAX];   /* Bus voltage */
+  uint8_t mode[FOC_BATCH_MAX];   /* Controller mode
+                                  * (enum foc_handler_mode_e) */
+};
+
+/* Output from the batched FOC controller */
+
+struct foc_batch_output_f32_s
+{
+  float duty[CONFIG_MOTOR_FOC_PHASES][FOC_BATCH_MAX];  /* New duty cycle */
+};
+
+/* Batched FOC handler data (PI current controller + SVM3 modulation) */
+
+struct foc_batch_f32_s
+{
+  int   n;                        /* Number of motors */
+
+  /* Configuration */
+
+  float id_kp[FOC_BATCH_MAX];
+  float id_ki[FOC_BATCH_MAX];
+  float iq_kp[FOC_BATCH_MAX];
+  float iq_ki[FOC_BATCH_MAX];
+  float duty_max[FOC_BATCH_MAX];
+
+  /* Base voltage dependent data */
+
+  float vbase_last[FOC_BATCH_MAX];
+  float mod_scale[FOC_BATCH_MAX]; /* 1 / VBASE */
+  float mag_max[FOC_BATCH_MAX];   /* Maximum DQ voltage magnitude */
+
+  /* Controller state */
+
+  float sin[FOC_BATCH_MAX];
+  float cos[FOC_BATCH_MAX];
+  float i_a[FOC_BATCH_MAX];       /* Alpha-beta current */
+  float i_b[FOC_BATCH_MAX];
+  float i_d[FOC_BATCH_MAX];       /* DQ current */
+  float i_q[FOC_BATCH_MAX];
+  float id_int[FOC_BATCH_MAX];    /* PI integral parts */
+  float iq_int[FOC_BATCH_MAX];
+  float v_d[FOC_BATCH_MAX];       /* DQ voltage */
+  float v_q[FOC_BATCH_MAX];
+  float v_a[FOC_BATCH_MAX];       /* Alpha-beta voltage */
+  float v_b[FOC_BATCH_MAX];
+  float run[FOC_BATCH_MAX];       /* 1.0 if motor is modulated */
+  float curr[FOC_BATCH_MAX];      /* 1.0 if in current mode */
+
+  /* Modulation state, 1.0 for the phase current to be reconstructed
+   * from the others.
+   */
+
+  float corr[CONFIG_MOTOR_FOC_PHASES][FOC_BATCH_MAX];
+};
+
+/****************************************************************************
+ * Public Function Prototypes
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: foc_batch_init_f32
+ ****************************************************************************/
+
+int foc_batch_init_f32(FAR struct foc_batch_f32_s *b, int n);
+
+/****************************************************************************
+ * Name: foc_batch_cfg_f32
+ ****************************************************************************/
+
+void foc_batch_cfg_f32(FAR struct foc_batch_f32_s *b, int motor,
+                       FAR struct foc_initdata_f32_s *ctrl_cfg,
+                       FAR struct foc_mod_cfg_f32_s *mod_cfg);
+
+/****************************************************************************
+ * Name: foc_batch_run_f32
+ ****************************************************************************/
+
+int foc_batch_run_f32(FAR struct foc_batch_f32_s *b,
+                      FAR struct foc_batch_input_f32_s *in,
+                      FAR struct foc_batch_output_f32_s *out);
+
+/****************************************************************************
+ * Name: foc_batch_state_f32
+ ****************************************************************************/
+
+void foc_batch_state_f32(FAR struct foc_batch_f32_s *b, int motor,
+                         FAR struct foc_state_f32_s *state);
+
+#endif /* __INDUSTRY_FOC_FLOAT_FOC_BATCH_H */
@@ -31,6 +31,10 @@
 #include <pthread.h>
 #include <stdint.h>
 
+#ifdef CONFIG_LOGGING_NXSCOPE_LOCKFREE
+#  include <stdatomic.h>
+#endif
+
 #include <logging/nxscope/nxscope_chan.h>
 #include <logging/nxscope/nxscope_intf.h>
 #include <logging/nxscope/nxscope_proto.h>
@@ -96,7 +100,7 @@ enum nxscope_info_flags_e
 {
   NXSCOPE_FLAGS_DIVIDER_SUPPORT   = (1 << 0),
   NXSCOPE_FLAGS_ACK_SUPPORT       = (1 << 1),
-  NXSCOPE_FLAGS_RES2              = (1 << 2),
+  NXSCOPE_FLAGS_PACKED_SUPPORT    = (1 << 2),
   NXSCOPE_FLAGS_RES3              = (1 << 3),
   NXSCOPE_FLAGS_RES4              = (1 << 4),
   NXSCOPE_FLAGS_RES5              = (1 << 5),
@@ -108,14 +112,24 @@ enum nxscope_info_flags_e
 
 enum nxscope_stream_flags_s
 {
-  NXSCOPE_STREAM_FLAGS_OVERFLOW = (1 << 0)
+  NXSCOPE_STREAM_FLAGS_OVERFLOW = (1 << 0),
+  NXSCOPE_STREAM_FLAGS_PACKED   = (1 << 1)
+};
+
+/* Nxscope start flags */
+
+enum nxscope_start_flags_e
+{
+  NXSCOPE_START_FLAGS_START  = (1 << 0), /* Start stream */
+  NXSCOPE_START_FLAGS_PACKED = (1 << 1)  /* Packed stream frames */
 };
 
 /* Nxscope start frame data */
 
 begin_packed_struct struct nxscope_start_data_s
 {
-  uint8_t  start;                        /* Start/stop flag */
+  uint8_t  start;                        /* Start flags
+                                          * (enum nxscope_start_flags_e) */
 } end_packed_struct;
 
 /* Nxscope enable channel data */
@@ -238,6 +252,40 @@ struct nxscope_stream_s
   struct nxscope_sample_s samples[1];        /* stream samples */
 };
 
+/* Nxscope packed stream data (NXSCOPE_STREAM_FLAGS_PACKED set):
+ *
+ *   +----------+--------------+-----+--------------+
+ *   | flags    | block 0      | ... | block n      |
+ *   +----------+--------------+-----+--------------+
+ *   | 1B       | n bytes      |     | n bytes      |
+ *   +----------+--------------+-----+--------------+
+ *
+ * Packed block - consecutive samples of one channel:
+ *
+ *   +----------+----------+----------+-----+----------+
+ *   | channel  | nsamples | sample 0 | ... | sample n |
+ *   +----------+----------+----------+-----+----------+
+ *   | 1B       | 1B       | n bytes  |     | n bytes  |
+ *   +----------+----------+----------+-----+----------+
+ *
+ * Packed sample:
+ *
+ *   +-------------+----------+
+ *   | sample data | metadata |
+ *   +-------------+----------+
+ *   | n bytes [1] | m bytes  |
+ *   +-------------+----------+
+ *
+ *   [1] - integer and fixed-point types: each vector element is encoded
+ *         as a zig-zag varint (LEB128) of the difference to the same
+ *         element of the previous sample in the block, wrapped to the type
+ *         width. The first sample of a block is a difference to 0.
+ *         Other types: the same as in the not packed stream.
+ *
+ * Samples of one channel keep their order, but samples of different
+ * channels are no longer interleaved in a packed frame.
+ */
+
 /* Nxscope callbacks */
 
 struct nxscope_callbacks_s
@@ -321,6 +369,24 @@ struct nxscope_cfg_s
   uint8_t rx_padding;
 };
 
+#ifdef CONFIG_LOGGING_NXSCOPE_LOCKFREE
+/* Nxscope channel sample ring.
+ *
+ * Single producer (the thread putting samples on the channel), single
+ * consumer (nxscope_stream()).
+ */
+
+struct nxscope_chring_s
+{
+  FAR uint8_t *buf;                      /* Ring data */
+  atomic_uint  head;                     /* Producer index */
+  atomic_uint  tail;                     /* Consumer index */
+  uint32_t     reserved;                 /* Head after the reserved sample */
+  atomic_uint  overflow;                 /* Samples dropped, ring full */
+  uint32_t     overflow_seen;            /* Overflows reported in stream */
+};
+#endif
+
 /* Nxscope data */
 
 struct nxscope_s
@@ -362,6 +428,20 @@ struct nxscope_s
   size_t                       stream_i;
   bool                         stream_retry;
 
+#ifdef CONFIG_LOGGING_NXSCOPE_PACKED
+  /* Packed stream data */
+
+  FAR uint8_t                 *packbuf;
+  size_t                       pack_i;
+  bool                         packed;
+#endif
+
+#ifdef CONFIG_LOGGING_NXSCOPE_LOCKFREE
+  /* Channels sample rings, chmax elements */
+
+  FAR struct nxscope_chring_s *chring;
+#endif
+
 #ifdef CONFIG_LOGGING_NXSCOPE_CRICHANNELS
   /* Critical buffer data */
 
@@ -486,4 +566,21 @@ int nxscope_recv(FAR struct nxscope_s *s);
 
 int nxscope_stream_start(FAR struct nxscope_s *s, bool start);
 
+#ifdef CONFIG_LOGGING_NXSCOPE_PACKED
+/****************************************************************************
+ * Name: nxscope_stream_packed
+ *
+ * Description:
+ *   Enable/disable packed stream frames. Normally the client requests
+ *   packed frames with the start frame.
+ *
+ * Input Parameters:
+ *   s      - a pointer to a nxscope instance
+ *   packed - packed frames enable
+ *
+ ****************************************************************************/
+
+int nxscope_stream_packed(FAR struct nxscope_s *s, bool packed);
+#endif
+
 #endif  /* __APPS_INCLUDE_LOGGING_NXSCOPE_NXSCOPE_H */
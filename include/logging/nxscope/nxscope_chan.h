@@ -146,6 +146,25 @@ int nxscope_chan_en(FAR struct nxscope_s *s, uint8_t chan, bool en);
 int nxscope_chan_div(FAR struct nxscope_s *s, uint8_t chan, uint8_t div);
 #endif
 
+#ifdef CONFIG_LOGGING_NXSCOPE_LOCKFREE
+/****************************************************************************
+ * Name: nxscope_chan_ovf
+ *
+ * Description:
+ *   Get the number of samples dropped for a given channel because its
+ *   sample ring was full
+ *
+ * Input Parameters:
+ *   s   - a pointer to a nxscope instance
+ *   ch  - a channel id
+ *   ovf - a pointer to the returned overflow counter
+ *
+ ****************************************************************************/
+
+int nxscope_chan_ovf(FAR struct nxscope_s *s, uint8_t ch,
+                     FAR uint32_t *ovf);
+#endif
+
 /****************************************************************************
  * Name: nxscope_chan_all_en
  *
@@ -398,4 +417,57 @@ int nxscope_put_ub32(FAR struct nxscope_s *s, uint8_t ch, ub32_t val);
 int nxscope_put_b32(FAR struct nxscope_s *s, uint8_t ch, b32_t val);
 int nxscope_put_char(FAR struct nxscope_s *s, uint8_t ch, char val);
 
+/****************************************************************************
+ * Name: nxscope_put_block_XXXX
+ *
+ * Description:
+ *   Put a block of vectors on the stream buffer.
+ *
+ *   The channel is validated once for the whole block and the channel
+ *   divider is applied to the block as if each sample was put separately.
+ *   If the stream buffer can't hold all samples, the samples that fit are
+ *   put and -ENOBUFS is returned. Only for channels without metadata.
+ *
+ * Input Parameters:
+ *   s   - a pointer to a nxscope instance
+ *   ch  - a channel id
+ *   val - a pointer to n sample data vectors (n * d elements)
+ *   d   - a dimmention of sample data vector
+ *   n   - a number of samples
+ *
+ ****************************************************************************/
+
+int nxscope_put_block_uint8(FAR struct nxscope_s *s, uint8_t ch,
+                            FAR uint8_t *val, uint8_t d, size_t n);
+int nxscope_put_block_int8(FAR struct nxscope_s *s, uint8_t ch,
+                           FAR int8_t *val, uint8_t d, size_t n);
+int nxscope_put_block_uint16(FAR struct nxscope_s *s, uint8_t ch,
+                             FAR uint16_t *val, uint8_t d, size_t n);
+int nxscope_put_block_int16(FAR struct nxscope_s *s, uint8_t ch,
+                            FAR int16_t *val, uint8_t d, size_t n);
+int nxscope_put_block_uint32(FAR struct nxscope_s *s, uint8_t ch,
+                             FAR uint32_t *val, uint8_t d, size_t n);
+int nxscope_put_block_int32(FAR struct nxscope_s *s, uint8_t ch,
+                            FAR int32_t *val, uint8_t d, size_t n);
+int nxscope_put_block_uint64(FAR struct nxscope_s *s, uint8_t ch,
+                             FAR uint64_t *val, uint8_t d, size_t n);
+int nxscope_put_block_int64(FAR struct nxscope_s *s, uint8_t ch,
+                            FAR int64_t *val, uint8_t d, size_t n);
+int nxscope_put_block_float(FAR struct nxscope_s *s, uint8_t ch,
+                            FAR float *val, uint8_t d, size_t n);
+int nxscope_put_block_double(FAR struct nxscope_s *s, uint8_t ch,
+                             FAR double *val, uint8_t d, size_t n);
+int nxscope_put_block_ub8(FAR struct nxscope_s *s, uint8_t ch,
+                          FAR ub8_t *val, uint8_t d, size_t n);
+int nxscope_put_block_b8(FAR struct nxscope_s *s, uint8_t ch,
+                         FAR b8_t *val, uint8_t d, size_t n);
+int nxscope_put_block_ub16(FAR struct nxscope_s *s, uint8_t ch,
+                           FAR ub16_t *val, uint8_t d, size_t n);
+int nxscope_put_block_b16(FAR struct nxscope_s *s, uint8_t ch,
+                          FAR b16_t *val, uint8_t d, size_t n);
+int nxscope_put_block_ub32(FAR struct nxscope_s *s, uint8_t ch,
+                           FAR ub32_t *val, uint8_t d, size_t n);
+int nxscope_put_block_b32(FAR struct nxscope_s *s, uint8_t ch,
+                          FAR b32_t *val, uint8_t d, size_t n);
+
 #endif  /* __APPS_INCLUDE_LOGGING_NXSCOPE_NXSCOPE_CHAN_H */
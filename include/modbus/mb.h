@@ -34,26 +34,36 @@
 
 /* This module defines the interface for the application. It contains
  * the basic functions and types required to use the Modbus protocol stack.
+ * All state of the stack is kept in an instance, xMBInstance, which the
+ * application allocates, so one task can serve several buses.
  * A typical application will want to call eMBInit() first. If the device
  * is ready to answer network requests it must then call eMBEnable() to activate
  * the protocol stack. In the main loop the function eMBPoll() must be called
  * periodically. The time interval between pooling depends on the configured
  * Modbus timeout. If an RTOS is available a separate task should be created
  * and the task should always call the function eMBPoll().
+ * Instances do not share state except for the pool of Modbus TCP
+ * connections, which is locked, so each instance may be polled by its own
+ * task. An instance itself must only be used from one task at a time.
+ *
+ *   static xMBInstance xBus;
  *
  *   // Initialize protocol stack in RTU mode for a slave with address 10 = 0x0A
  *
- *   eMBInit(MB_RTU, 0x0A, 38400, MB_PAR_EVEN);
+ *   eMBInit(&xBus, MB_RTU, 0x0A, 0, 38400, MB_PAR_EVEN);
  *
  *   // Enable the Modbus Protocol Stack.
  *
- *   eMBEnable();
+ *   eMBEnable(&xBus);
  *   for(;;)
  *     {
  *       // Call the main polling loop of the Modbus protocol stack.
- *       eMBPoll();
+ *       eMBPoll(&xBus);
  *       ...
  *     }
+ *
+ * Several instances are served from one loop with eMBPollInstances(),
+ * which waits for all of them at once.
  */
 
 /****************************************************************************
@@ -130,6 +140,9 @@ typedef enum
   MB_ETIMEDOUT                /* timeout error occurred. */
 } eMBErrorCode;
 
+#include "mbframe.h"
+#include "mbinst.h"
+
 /****************************************************************************
  * Public Function Prototypes
  ****************************************************************************/
@@ -142,6 +155,7 @@ typedef enum
  * processed until eMBEnable() has been called.
  *
  * Input Parameters:
+ *   pxInst The instance to initialize.
  *   eMode If ASCII or RTU mode should be used.
  *   ucSlaveAddress The slave address. Only frames sent to this
  *     address or to the broadcast address are processed.
@@ -161,8 +175,9 @@ typedef enum
  *    - eMBErrorCode::MB_EPORTERR IF the porting layer returned an error.
  */
 
-eMBErrorCode eMBInit(eMBMode eMode, uint8_t ucSlaveAddress,
-                     uint8_t ucPort, speed_t ulBaudRate, eMBParity eParity);
+eMBErrorCode eMBInit(xMBInstance *pxInst, eMBMode eMode,
+                     uint8_t ucSlaveAddress, uint8_t ucPort,
+                     speed_t ulBaudRate, eMBParity eParity);
 
 /* Initialize the Modbus protocol stack for Modbus TCP.
  *
@@ -170,6 +185,7 @@ eMBErrorCode eMBInit(eMBMode eMode, uint8_t ucSlaveAddress,
  * frame processing is still disabled until eMBEnable() is called.
  *
  * Input Parameters:
+ *   pxInst The instance to initialize.
  *   usTCPPort The TCP port to listen on.
  *
  * Returned Value:
@@ -181,7 +197,7 @@ eMBErrorCode eMBInit(eMBMode eMode, uint8_t ucSlaveAddress,
  *    - eMBErrorCode::MB_EPORTERR IF the porting layer returned an error.
  */
 
-eMBErrorCode eMBTCPInit(uint16_t usTCPPort);
+eMBErrorCode eMBTCPInit(xMBInstance *pxInst, uint16_t usTCPPort);
 
 /* Release resources used by the protocol stack.
  *
@@ -198,7 +214,7 @@ eMBErrorCode eMBTCPInit(uint16_t usTCPPort);
  *   eMBErrorCode::MB_EILLSTATE.
  */
 
-eMBErrorCode eMBClose(void);
+eMBErrorCode eMBClose(xMBInstance *pxInst);
 
 /* Enable the Modbus protocol stack.
  *
@@ -211,7 +227,7 @@ eMBErrorCode eMBClose(void);
  *   return eMBErrorCode::MB_EILLSTATE.
  */
 
-eMBErrorCode eMBEnable(void);
+eMBErrorCode eMBEnable(xMBInstance *pxInst);
 
 /* Disable the Modbus protocol stack.
  *
@@ -223,7 +239,7 @@ eMBErrorCode eMBEnable(void);
  *  eMBErrorCode::MB_EILLSTATE.
  */
 
-eMBErrorCode eMBDisable(void);
+eMBErrorCode eMBDisable(xMBInstance *pxInst);
 
 /* The main pooling loop of the Modbus protocol stack.
  *
@@ -238,7 +254,26 @@ eMBErrorCode eMBDisable(void);
  *   eMBErrorCode::MB_ENOERR.
  */
 
-eMBErrorCode eMBPoll(void);
+eMBErrorCode eMBPoll(xMBInstance *pxInst);
+
+/* The main polling loop for several instances.
+ *
+ * This function waits for events on all the instances at once, for up to
+ * CONFIG_MB_POLL_TIMEOUT_MS, and then handles the events of each of them
+ * like eMBPoll(). It lets one task serve several buses.
+ *
+ * Input Parameters:
+ *   apxInst The instances to poll.
+ *   iCount Number of instances, at most CONFIG_MB_MAX_INSTANCES.
+ *
+ * Returned Value:
+ *   If one of the instances is not in the enabled state the function
+ *   returns eMBErrorCode::MB_EILLSTATE. If there are too many instances it
+ *   returns eMBErrorCode::MB_EINVAL. Otherwise it returns
+ *   eMBErrorCode::MB_ENOERR.
+ */
+
+eMBErrorCode eMBPollInstances(xMBInstance *apxInst[], int iCount);
 
 /* Configure the slave id of the device.
  *
@@ -246,6 +281,7 @@ eMBErrorCode eMBPoll(void);
  * is enabled (By defining CONFIG_MB_FUNC_OTHER_REP_SLAVEID_ENABLED in .config).
  *
  * Input Parameters:
+ *   pxInst The instance whose slave id is set.
  *   ucSlaveID Values is returned in the Slave ID byte of the
  *     Report Slave ID response.
  *   xIsRunning If true the Run Indicator Status byte is set to 0xFF.
@@ -260,19 +296,21 @@ eMBErrorCode eMBPoll(void);
  *   it returns eMBErrorCode::MB_ENOERR.
  */
 
-eMBErrorCode eMBSetSlaveID(uint8_t ucSlaveID, bool xIsRunning,
-                           uint8_t const *pucAdditional,
+eMBErrorCode eMBSetSlaveID(xMBInstance *pxInst, uint8_t ucSlaveID,
+                           bool xIsRunning, uint8_t const *pucAdditional,
                            uint16_t usAdditionalLen);
 
 /* Registers a callback handler for a given function code.
  *
- * This function registers a new callback handler for a given function code.
+ * This function registers a new callback handler for a given function code
+ * of an instance.
  * The callback handler supplied is responsible for interpreting the Modbus PDU and
  * the creation of an appropriate response. In case of an error it should return
  * one of the possible Modbus exceptions which results in a Modbus exception frame
  * sent by the protocol stack.
  *
  * Input Parameters:
+ *   pxInst The instance the handler is registered with.
  *   ucFunctionCode The Modbus function code for which this handler should
  *     be registers. Valid function codes are in the range 1 to 127.
  *   pxHandler The function handler which should be called in case
@@ -286,7 +324,7 @@ eMBErrorCode eMBSetSlaveID(uint8_t ucSlaveID, bool xIsRunning,
  *   valid it returns eMBErrorCode::MB_EINVAL.
  */
 
-eMBErrorCode eMBRegisterCB(uint8_t ucFunctionCode,
+eMBErrorCode eMBRegisterCB(xMBInstance *pxInst, uint8_t ucFunctionCode,
                            pxMBFunctionHandler pxHandler);
 
 /* The protocol stack does not internally allocate any memory for the
@@ -301,7 +339,9 @@ eMBErrorCode eMBRegisterCB(uint8_t ucFunctionCode,
  * If the protocol stack wants to update a register value because a write
  * register function was received a buffer with the new register values is
  * passed to the callback function. The function should then use these values
- * to update the application register values.
+ * to update the application register values.<br>
+ * The callbacks get the instance that received the request. Its member
+ * pvUserData can be used to find the registers of the bus.
  */
 
 /* Callback function used if the value of a Input Register is required by
@@ -309,6 +349,7 @@ eMBErrorCode eMBRegisterCB(uint8_t ucFunctionCode,
  * usAddress and the last register is given by usAddress + usNRegs - 1.
  *
  * Input Parameters:
+ *   pxInst The instance that received the request.
  *   pucRegBuffer A buffer where the callback function should write
  *     the current value of the modbus registers to.
  *   usAddress The starting address of the register. Input registers
@@ -330,14 +371,15 @@ eMBErrorCode eMBRegisterCB(uint8_t ucFunctionCode,
  *       a  SLAVE DEVICE FAILURE  exception is sent as a response.
  */
 
-eMBErrorCode eMBRegInputCB(uint8_t * pucRegBuffer, uint16_t usAddress,
-                           uint16_t usNRegs);
+eMBErrorCode eMBRegInputCB(xMBInstance *pxInst, uint8_t *pucRegBuffer,
+                           uint16_t usAddress, uint16_t usNRegs);
 
 /* Callback function used if a Holding Register value is read or written by
  * the protocol stack. The starting register address is given by \c usAddress
  * and the last register is given by usAddress + usNRegs - 1.
  *
  * Input Parameters:
+ *   pxInst The instance that received the request.
  *   pucRegBuffer If the application registers values should be updated the
  *     buffer points to the new registers values. If the protocol stack needs
  *     to now the current values the callback function should write them into
@@ -366,8 +408,9 @@ eMBErrorCode eMBRegInputCB(uint8_t * pucRegBuffer, uint16_t usAddress,
  *       a  SLAVE DEVICE FAILURE  exception is sent as a response.
  */
 
-eMBErrorCode eMBRegHoldingCB(uint8_t * pucRegBuffer, uint16_t usAddress,
-                             uint16_t usNRegs, eMBRegisterMode eMode);
+eMBErrorCode eMBRegHoldingCB(xMBInstance *pxInst, uint8_t *pucRegBuffer,
+                             uint16_t usAddress, uint16_t usNRegs,
+                             eMBRegisterMode eMode);
 
 /* Callback function used if a Coil Register value is read or written by the
  * protocol stack. If you are going to use this function you might use the
@@ -375,6 +418,7 @@ eMBErrorCode eMBRegHoldingCB(uint8_t * pucRegBuffer, uint16_t usAddress,
  * bitfields.
  *
  * Input Parameters:
+ *   pxInst The instance that received the request.
  *   pucRegBuffer The bits are packed in bytes where the first coil
  *     starting at address \c usAddress is stored in the LSB of the
  *     first byte in the buffer <code>pucRegBuffer</code>.
@@ -403,8 +447,9 @@ eMBErrorCode eMBRegHoldingCB(uint8_t * pucRegBuffer, uint16_t usAddress,
  *       a  SLAVE DEVICE FAILURE  exception is sent as a response.
  */
 
-eMBErrorCode eMBRegCoilsCB(uint8_t *pucRegBuffer, uint16_t usAddress,
-                           uint16_t usNCoils, eMBRegisterMode eMode);
+eMBErrorCode eMBRegCoilsCB(xMBInstance *pxInst, uint8_t *pucRegBuffer,
+                           uint16_t usAddress, uint16_t usNCoils,
+                           eMBRegisterMode eMode);
 
 /* Callback function used if a Input Discrete Register value is read by
  * the protocol stack.
@@ -413,6 +458,7 @@ eMBErrorCode eMBRegCoilsCB(uint8_t *pucRegBuffer, uint16_t usAddress,
  * xMBUtilSetBits() and xMBUtilGetBits() for working with bitfields.
  *
  * Input Parameters:
+ *   pxInst The instance that received the request.
  *   pucRegBuffer The buffer should be updated with the current
  *     coil values. The first discrete input starting at \c usAddress must be
  *     stored at the LSB of the first byte in the buffer. If the requested number
@@ -435,8 +481,8 @@ eMBErrorCode eMBRegCoilsCB(uint8_t *pucRegBuffer, uint16_t usAddress,
  *       a  SLAVE DEVICE FAILURE  exception is sent as a response.
  */
 
-eMBErrorCode eMBRegDiscreteCB(uint8_t *pucRegBuffer, uint16_t usAddress,
-                              uint16_t usNDiscrete);
+eMBErrorCode eMBRegDiscreteCB(xMBInstance *pxInst, uint8_t *pucRegBuffer,
+                              uint16_t usAddress, uint16_t usNDiscrete);
 
 #ifdef __cplusplus
 }
@@ -107,6 +107,23 @@ typedef enum
     MB_TMODE_CONVERT_DELAY          /* Master sent broadcast ,then delay sometime.*/
 }eMBMasterTimerMode;
 
+/* Round-trip statistics of one slave, see eMBMasterSchedGetStats().  The
+ * round-trip times are in microseconds and cover the requests that got a
+ * response, exceptions included.
+ */
+
+typedef struct
+{
+    uint32_t ulRequests;            /* Requests sent. */
+    uint32_t ulResponses;           /* Requests answered. */
+    uint32_t ulErrors;              /* Exceptions and bad responses. */
+    uint32_t ulTimeouts;            /* Requests without a response. */
+    uint32_t ulRttLastUs;
+    uint32_t ulRttMinUs;
+    uint32_t ulRttMaxUs;
+    uint64_t ullRttSumUs;           /* Divide by ulResponses for the mean. */
+} xMBMasterSlaveStats;
+
 /****************************************************************************
  * Public Function Prototypes
  ****************************************************************************/
@@ -257,7 +274,7 @@ eMBErrorCode eMBMasterPoll(void);
  ****************************************************************************/
 
 eMBErrorCode eMBMasterRegisterCB(uint8_t ucFunctionCode,
-                                 pxMBFunctionHandler pxHandler);
+                                 pxMBMasterFunctionHandler pxHandler);
 
 /****************************************************************************
  * Description:
@@ -427,6 +444,52 @@ eMBMasterReqErrCode eMBMasterReqWriteMultipleCoils(uint8_t ucSndAddr,
 eMBMasterReqErrCode eMBMasterReqReadDiscreteInputs(uint8_t ucSndAddr,
   uint16_t usDiscreteAddr, uint16_t usNDiscreteIn, uint32_t lTimeOut);
 
+#ifdef CONFIG_MB_MASTER_SCHED
+/****************************************************************************
+ * Description:
+ *   Request scheduler for cyclic reads.
+ *
+ *   eMBMasterSchedAddRead() registers a read of usCount registers, coils
+ *   or discrete inputs starting at usAddr.  ucFunctionCode is one of
+ *   MB_FUNC_READ_COILS, MB_FUNC_READ_DISCRETE_INPUTS,
+ *   MB_FUNC_READ_HOLDING_REGISTER or MB_FUNC_READ_INPUT_REGISTER.
+ *
+ *   eMBMasterSchedStart() merges the reads of the same slave and function
+ *   that are adjacent, or at most CONFIG_MB_MASTER_SCHED_MAX_GAP apart,
+ *   into single requests.  Then eMBMasterPoll() sends them one after the
+ *   other, each as soon as the previous one is finished, and starts over
+ *   every ulPeriodMs milliseconds (0 to run the cycles back to back).  The
+ *   results are passed to the eMBMasterReg*CB() callbacks, where
+ *   ucMBMasterGetDestAddress() returns the slave.  Requests made with the
+ *   blocking eMBMasterReq*() functions are sent in between.
+ *
+ *   Reads can only be added or cleared while the scheduler is stopped.
+ *
+ * Returned Value:
+ *   eMBErrorCode::MB_ENOERR on success, MB_EINVAL for a bad slave, function
+ *   or range, MB_ENORES if CONFIG_MB_MASTER_SCHED_MAX_READS reads were
+ *   added already and MB_EILLSTATE if the scheduler is running.
+ *
+ ****************************************************************************/
+
+eMBErrorCode eMBMasterSchedAddRead(uint8_t ucSndAddr, uint8_t ucFunctionCode,
+                                   uint16_t usAddr, uint16_t usCount);
+eMBErrorCode eMBMasterSchedClear(void);
+eMBErrorCode eMBMasterSchedStart(uint32_t ulPeriodMs);
+void vMBMasterSchedStop(void);
+
+/* Number of requests per cycle after merging */
+
+int iMBMasterSchedGetRequests(void);
+
+/* Statistics of the scheduled requests per slave and of the cycles */
+
+eMBErrorCode eMBMasterSchedGetStats(uint8_t ucSlave,
+                                    xMBMasterSlaveStats *pxStats);
+void vMBMasterSchedGetCycle(uint32_t *pulCycles, uint32_t *pulLastCycleUs);
+void vMBMasterSchedResetStats(void);
+#endif
+
 eMBException eMBMasterFuncReportSlaveID(uint8_t *pucFrame, uint16_t *usLen);
 eMBException eMBMasterFuncReadInputRegister(uint8_t *pucFrame,
   uint16_t *usLen);
@@ -460,6 +523,11 @@ eMBMasterErrorEventType eMBMasterGetErrorType(void);
 void vMBMasterSetErrorType(eMBMasterErrorEventType errorType);
 eMBMasterReqErrCode eMBMasterWaitRequestFinish(void);
 
+#ifdef CONFIG_MB_MASTER_SCHED
+void vMBMasterSchedPoll(void);
+bool xMBMasterSchedDone(eMBMasterReqErrCode eErrStatus);
+#endif
+
 #ifdef __cplusplus
 }
 #endif
@@ -74,15 +74,29 @@ extern "C"
  * Public Types
  ****************************************************************************/
 
-typedef void (*pvMBFrameStart)(void);
-typedef void (*pvMBFrameStop)(void);
-typedef eMBErrorCode (*peMBFrameReceive)(uint8_t *pucRcvAddress,
+typedef void (*pvMBFrameStart)(xMBInstance *pxInst);
+typedef void (*pvMBFrameStop)(xMBInstance *pxInst);
+typedef eMBErrorCode (*peMBFrameReceive)(xMBInstance *pxInst,
+                                         uint8_t *pucRcvAddress,
                                          uint8_t **pucFrame,
                                          uint16_t *pusLength);
-typedef eMBErrorCode (*peMBFrameSend)(uint8_t slaveAddress,
+typedef eMBErrorCode (*peMBFrameSend)(xMBInstance *pxInst,
+                                      uint8_t slaveAddress,
                                       const uint8_t *pucFrame,
                                       uint16_t usLength);
-typedef void (*pvMBFrameClose)(void);
+typedef void (*pvMBFrameClose)(xMBInstance *pxInst);
+
+/* The master stack has a single instance */
+
+typedef void (*pvMBMasterFrameStart)(void);
+typedef void (*pvMBMasterFrameStop)(void);
+typedef eMBErrorCode (*peMBMasterFrameReceive)(uint8_t *pucRcvAddress,
+                                               uint8_t **pucFrame,
+                                               uint16_t *pusLength);
+typedef eMBErrorCode (*peMBMasterFrameSend)(uint8_t slaveAddress,
+                                            const uint8_t *pucFrame,
+                                            uint16_t usLength);
+typedef void (*pvMBMasterFrameClose)(void);
 
 #ifdef __cplusplus
 }
@@ -42,43 +42,57 @@ extern "C"
  ****************************************************************************/
 
 #ifdef CONFIG_MB_FUNC_OTHER_REP_SLAVEID_BUF
-eMBException eMBFuncReportSlaveID(uint8_t *pucFrame, uint16_t *usLen);
+eMBException eMBFuncReportSlaveID(xMBInstance *pxInst, uint8_t *pucFrame,
+                                  uint16_t *usLen);
 #endif
 
 #ifdef CONFIG_MB_FUNC_READ_INPUT_ENABLED
-eMBException eMBFuncReadInputRegister(uint8_t *pucFrame, uint16_t *usLen);
+eMBException eMBFuncReadInputRegister(xMBInstance *pxInst, uint8_t *pucFrame,
+                                      uint16_t *usLen);
 #endif
 
 #ifdef CONFIG_MB_FUNC_READ_HOLDING_ENABLED
-eMBException eMBFuncReadHoldingRegister(uint8_t *pucFrame, uint16_t *usLen);
+eMBException eMBFuncReadHoldingRegister(xMBInstance *pxInst,
+                                        uint8_t *pucFrame,
+                                        uint16_t *usLen);
 #endif
 
 #ifdef CONFIG_MB_FUNC_WRITE_HOLDING_ENABLED
-eMBException eMBFuncWriteHoldingRegister(uint8_t *pucFrame, uint16_t *usLen);
+eMBException eMBFuncWriteHoldingRegister(xMBInstance *pxInst,
+                                         uint8_t *pucFrame,
+                                         uint16_t *usLen);
 #endif
 
 #ifdef CONFIG_MB_FUNC_WRITE_MULTIPLE_HOLDING_ENABLED
-eMBException eMBFuncWriteMultipleHoldingRegister(uint8_t *pucFrame, uint16_t *usLen);
+eMBException eMBFuncWriteMultipleHoldingRegister(xMBInstance *pxInst,
+                                                 uint8_t *pucFrame,
+                                                 uint16_t *usLen);
 #endif
 
 #ifdef CONFIG_MB_FUNC_READ_COILS_ENABLED
-eMBException eMBFuncReadCoils(uint8_t *pucFrame, uint16_t *usLen);
+eMBException eMBFuncReadCoils(xMBInstance *pxInst, uint8_t *pucFrame,
+                              uint16_t *usLen);
 #endif
 
 #ifdef CONFIG_MB_FUNC_WRITE_COIL_ENABLED
-eMBException eMBFuncWriteCoil(uint8_t *pucFrame, uint16_t *usLen);
+eMBException eMBFuncWriteCoil(xMBInstance *pxInst, uint8_t *pucFrame,
+                              uint16_t *usLen);
 #endif
 
 #ifdef CONFIG_MB_FUNC_WRITE_MULTIPLE_COILS_ENABLED
-eMBException eMBFuncWriteMultipleCoils(uint8_t *pucFrame, uint16_t *usLen);
+eMBException eMBFuncWriteMultipleCoils(xMBInstance *pxInst, uint8_t *pucFrame,
+                                       uint16_t *usLen);
 #endif
 
 #ifdef CONFIG_MB_FUNC_READ_DISCRETE_INPUTS_ENABLED
-eMBException eMBFuncReadDiscreteInputs(uint8_t *pucFrame, uint16_t *usLen);
+eMBException eMBFuncReadDiscreteInputs(xMBInstance *pxInst, uint8_t *pucFrame,
+                                       uint16_t *usLen);
 #endif
 
 #ifdef CONFIG_MB_FUNC_READWRITE_HOLDING_ENABLED
-eMBException eMBFuncReadWriteMultipleHoldingRegister(uint8_t *pucFrame, uint16_t *usLen);
+eMBException eMBFuncReadWriteMultipleHoldingRegister(xMBInstance *pxInst,
+                                                     uint8_t *pucFrame,
+                                                     uint16_t *usLen);
 #endif
 
 #ifdef __cplusplus
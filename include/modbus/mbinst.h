@@ -0,0 +1,177 @@
+/****************************************************************************
+ * apps/include/modbus/mbinst.h
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+#ifndef __APPS_INCLUDE_MODBUS_MBINST_H
+#define __APPS_INCLUDE_MODBUS_MBINST_H
+
+/* The state of one slave protocol stack instance.  The application
+ * allocates one instance per bus, e.g. statically, and passes it to all
+ * functions of the stack.  Apart from pvUserData the members belong to the
+ * stack and must not be touched by the application.
+ */
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <termios.h>
+#include <time.h>
+
+#include "mbframe.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#define MB_SER_PDU_SIZE_MAX     256  /* Maximum size of a serial frame */
+
+#ifdef CONFIG_MB_ASCII_ENABLED
+#  define MB_SER_BUF_SIZE       513  /* Must hold a complete ASCII frame */
+#else
+#  define MB_SER_BUF_SIZE       256  /* Must hold a complete RTU frame */
+#endif
+
+#define MB_TCP_BUF_SIZE         260  /* MBAP header and the largest PDU */
+
+/****************************************************************************
+ * Public Types
+ ****************************************************************************/
+
+#if defined(CONFIG_MB_RTU_ENABLED) || defined(CONFIG_MB_ASCII_ENABLED)
+/* Serial line state, shared by the RTU and ASCII framing */
+
+typedef struct
+{
+  /* Serial port, see nuttx/portserial.c */
+
+  int              iSerialFd;
+  bool             bRxEnabled;
+  bool             bTxEnabled;
+  int              uiRxBufferPos;
+  int              uiTxBufferPos;
+  uint8_t          ucBuffer[MB_SER_BUF_SIZE];
+  struct termios   xOldTIO;
+
+  /* Timer, see nuttx/porttimer.c */
+
+  uint32_t         ulTimeOut;
+  bool             bTimeoutEnable;
+  struct timespec  xTimeLast;
+
+  /* Framing, see rtu/mbrtu.c and ascii/mbascii.c.  ASCII frames are
+   * decoded into the same buffer as RTU frames.
+   */
+
+  uint8_t          eSndState;
+  uint8_t          eRcvState;
+  uint8_t          eBytePos;
+  uint8_t          ucMBLFCharacter;
+  uint8_t         *pucSndBufferCur;
+  uint16_t         usSndBufferCount;
+  uint16_t         usRcvBufferPos;
+  uint8_t          ucBuf[MB_SER_PDU_SIZE_MAX];
+} xMBSerialState;
+#endif
+
+#ifdef CONFIG_MB_TCP_ENABLED
+/* Modbus TCP state, see nuttx/porttcp.c.  The connections come from a
+ * pool shared by all TCP instances.
+ */
+
+typedef struct
+{
+  int              iListenSocket;
+  int              iCurClient;         /* Client of the request, or -1 */
+  int              iNextClient;        /* Round-robin start */
+  uint16_t         usTCPFrameLen;
+  uint8_t          ucTCPFrame[MB_TCP_BUF_SIZE];
+} xMBTCPState;
+#endif
+
+struct xMBInstance
+{
+  void              *pvUserData;       /* For the application */
+
+  /* Protocol stack, see mb.c */
+
+  uint8_t            ucMBAddress;
+  uint8_t            eMBState;
+  eMBMode            eMBCurrentMode;
+
+  pvMBFrameStart     pvMBFrameStartCur;
+  pvMBFrameStop      pvMBFrameStopCur;
+  peMBFrameReceive   peMBFrameReceiveCur;
+  peMBFrameSend      peMBFrameSendCur;
+  pvMBFrameClose     pvMBFrameCloseCur;
+
+  /* Called by the port layer when a character has been received, the
+   * transmitter is ready for the next one or the timer expired.
+   */
+
+  bool             (*pxMBFrameCBByteReceived)(xMBInstance *pxInst);
+  bool             (*pxMBFrameCBTransmitterEmpty)(xMBInstance *pxInst);
+  bool             (*pxMBPortCBTimerExpired)(xMBInstance *pxInst);
+
+  xMBFunctionHandler xFuncHandlers[CONFIG_MB_FUNC_HANDLERS_MAX];
+
+  /* Request being processed */
+
+  uint8_t           *pucMBFrame;
+  uint8_t            ucRcvAddress;
+  uint16_t           usLength;
+
+  /* Event queue, see nuttx/portevent.c */
+
+  eMBEventType       eQueuedEvent;
+  bool               xEventInQueue;
+
+#ifdef CONFIG_MB_FUNC_OTHER_REP_SLAVEID_ENABLED
+  /* Report Slave ID response, see functions/mbfuncother.c */
+
+  uint16_t           usMBSlaveIDLen;
+  uint8_t            ucMBSlaveID[CONFIG_MB_FUNC_OTHER_REP_SLAVEID_BUF];
+#endif
+
+  union
+  {
+#if defined(CONFIG_MB_RTU_ENABLED) || defined(CONFIG_MB_ASCII_ENABLED)
+    xMBSerialState   xSerial;
+#endif
+#ifdef CONFIG_MB_TCP_ENABLED
+    xMBTCPState      xTCP;
+#endif
+    uint8_t          ucUnused;
+  } u;
+};
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __APPS_INCLUDE_MODBUS_MBINST_H */
@@ -40,6 +40,8 @@
 #include <stdbool.h>
 #include <termios.h>
 
+#include "mbproto.h"
+
 /****************************************************************************
  * Public Types
  ****************************************************************************/
@@ -95,21 +97,10 @@ typedef enum
  * Public Data
  ****************************************************************************/
 
-/* Callback function for the porting layer when a new byte is available.
- *
- * Depending upon the mode this callback function is used by the RTU or
- * ASCII transmission layers. In any case a call to xMBPortSerialGetByte()
- * must immediately return a new character.
- *
- * Return true if a event was posted to the queue because a new byte was
- * received. The port implementation should wake up the tasks which are
- * currently blocked on the eventqueue.
+/* The callbacks of the slave stack for the porting layer are members of
+ * the instance, see mbinst.h.
  */
 
-extern bool(*pxMBFrameCBByteReceived)(void);
-extern bool(*pxMBFrameCBTransmitterEmpty)(void);
-extern bool(*pxMBPortCBTimerExpired)(void);
-
 extern bool(*pxMBMasterFrameCBByteReceived)(void);
 extern bool(*pxMBMasterFrameCBTransmitterEmpty)(void);
 extern bool(*pxMBMasterPortCBTimerExpired)(void);
@@ -120,9 +111,10 @@ extern bool(*pxMBMasterPortCBTimerExpired)(void);
 
 /* Supporting functions */
 
-bool xMBPortEventInit(void);
-bool xMBPortEventPost(eMBEventType eEvent);
-bool xMBPortEventGet(eMBEventType *eEvent);
+bool xMBPortEventInit(xMBInstance *pxInst);
+bool xMBPortEventPost(xMBInstance *pxInst, eMBEventType eEvent);
+bool xMBPortEventGet(xMBInstance *pxInst, eMBEventType *eEvent);
+bool xMBPortPoll(xMBInstance *apxInst[], int iCount);
 
 bool xMBMasterPortEventInit(void);
 bool xMBMasterPortEventPost(eMBMasterEventType eEvent);
@@ -133,13 +125,14 @@ void vMBMasterRunResRelease(void);
 
 /* Serial port functions */
 
-bool xMBPortSerialInit(uint8_t ucPort, speed_t ulBaudRate,
-                       uint8_t ucDataBits, eMBParity eParity);
-void vMBPortClose(void);
-void xMBPortSerialClose(void);
-void vMBPortSerialEnable(bool xRxEnable, bool xTxEnable);
-bool xMBPortSerialGetByte(int8_t * pucByte);
-bool xMBPortSerialPutByte(int8_t ucByte);
+bool xMBPortSerialInit(xMBInstance *pxInst, uint8_t ucPort,
+                       speed_t ulBaudRate, uint8_t ucDataBits,
+                       eMBParity eParity);
+void vMBPortClose(xMBInstance *pxInst);
+void vMBPortSerialEnable(xMBInstance *pxInst, bool xRxEnable,
+                         bool xTxEnable);
+bool xMBPortSerialGetByte(xMBInstance *pxInst, int8_t *pucByte);
+bool xMBPortSerialPutByte(xMBInstance *pxInst, int8_t ucByte);
 
 bool xMBMasterPortSerialInit(uint8_t ucPort, speed_t ulBaudRate,
                              uint8_t ucDataBits, eMBParity eParity);
@@ -151,10 +144,9 @@ bool xMBMasterPortSerialPutByte(int8_t ucByte);
 
 /* Timers functions */
 
-bool xMBPortTimersInit(uint16_t usTimeOut50us);
-void xMBPortTimersClose(void);
-void vMBPortTimersEnable(void);
-void vMBPortTimersDisable(void);
+bool xMBPortTimersInit(xMBInstance *pxInst, uint16_t usTimeOut50us);
+void vMBPortTimersEnable(xMBInstance *pxInst);
+void vMBPortTimersDisable(xMBInstance *pxInst);
 void vMBPortTimersDelay(uint16_t usTimeOutMS);
 
 bool xMBMasterPortTimersInit(uint16_t usTimeOut50us);
@@ -177,13 +169,16 @@ void vMBMasterCBRequestSuccess(void);
 #ifdef CONFIG_MB_TCP_ENABLED
 /* TCP port function */
 
-bool xMBTCPPortInit(uint16_t usTCPPort);
+bool xMBTCPPortInit(xMBInstance *pxInst, uint16_t usTCPPort);
 #ifdef CONFIG_MB_HAVE_CLOSE
-void vMBTCPPortClose(void);
+void vMBTCPPortClose(xMBInstance *pxInst);
 #endif
-void vMBTCPPortDisable(void);
-bool xMBTCPPortGetRequest(uint8_t **ppucMBTCPFrame, uint16_t * usTCPLength);
-bool xMBTCPPortSendResponse(const uint8_t *pucMBTCPFrame, uint16_t usTCPLength);
+void vMBTCPPortDisable(xMBInstance *pxInst);
+bool xMBTCPPortGetRequest(xMBInstance *pxInst, uint8_t **ppucMBTCPFrame,
+                          uint16_t *usTCPLength);
+bool xMBTCPPortSendResponse(xMBInstance *pxInst,
+                            const uint8_t *pucMBTCPFrame,
+                            uint16_t usTCPLength);
 #endif
 
 #ifdef __cplusplus
@@ -79,7 +79,13 @@ typedef enum
   MB_EX_GATEWAY_TGT_FAILED = 0x0b
 } eMBException;
 
-typedef eMBException(*pxMBFunctionHandler)(uint8_t *pucFrame, uint16_t *pusLength);
+/* A slave protocol stack instance, see mbinst.h */
+
+typedef struct xMBInstance xMBInstance;
+
+typedef eMBException(*pxMBFunctionHandler)(xMBInstance *pxInst,
+                                           uint8_t *pucFrame,
+                                           uint16_t *pusLength);
 
 typedef struct
 {
@@ -87,6 +93,15 @@ typedef struct
   pxMBFunctionHandler pxHandler;
 } xMBFunctionHandler;
 
+typedef eMBException(*pxMBMasterFunctionHandler)(uint8_t *pucFrame,
+                                                 uint16_t *pusLength);
+
+typedef struct
+{
+  uint8_t                   ucFunctionCode;
+  pxMBMasterFunctionHandler pxHandler;
+} xMBMasterFunctionHandler;
+
 #ifdef __cplusplus
 }
 #endif
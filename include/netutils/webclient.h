@@ -78,6 +78,10 @@
 #  endif
 #endif
 
+#if defined(CONFIG_WEBCLIENT_KEEPALIVE) || defined(CONFIG_WEBCLIENT_DNS_CACHE)
+#  define WGET_USE_STATS 1
+#endif
+
 /* The following WEBCLIENT_FLAG_xxx constants are for
  * webclient_context::flags.
  */
@@ -120,6 +124,23 @@
  */
 #define WEBCLIENT_FLAG_TUNNEL 2U
 
+/* WEBCLIENT_FLAG_KEEP_ALIVE: Reuse the connection
+ *
+ * If this flag is set for an HTTP/1.1 request which uses neither a proxy
+ * nor an AF_LOCAL socket, the connection is not closed after the response.
+ * It's kept in a pool shared by all contexts and a later request with this
+ * flag to the same scheme, host and port is sent on it instead of on a new
+ * connection.
+ *
+ * The connection is only kept if the end of the response can be told
+ * without the server closing the connection, that is, if the response
+ * has a Content-Length or uses the chunked transfer coding, and the
+ * server didn't ask to close it.
+ *
+ * This flag is ignored unless CONFIG_WEBCLIENT_KEEPALIVE is enabled.
+ */
+#define WEBCLIENT_FLAG_KEEP_ALIVE 4U
+
 /* The following WEBCLIENT_FLAG_xxx constants are for
  * webclient_poll_info::flags.
  */
@@ -233,6 +254,41 @@ typedef CODE int (*webclient_body_callback_t)(
     size_t reqsize,
     FAR void *ctx);
 
+/* webclient_recv_buffer_callback_t: a callback to provide the buffer to
+ * receive the response body into
+ *
+ * If this callback is set, the response body is received directly into
+ * the buffers it provides rather than into webclient_context::buffer,
+ * which then only holds the status line, the headers and the chunk
+ * headers.  The part of the body which arrives together with those is
+ * still passed in webclient_context::buffer.
+ *
+ * The received data is passed to the sink callback as usual, with
+ * *buffer set to the buffer provided by this callback and offset 0.
+ * Changing the buffer in the sink callback has no effect then.
+ *
+ * The data received into the buffer never goes past the end of the body
+ * or of the current chunk.  So, e.g., if the callback always returns the
+ * unused part of a flash page, the body is received page by page with
+ * no copy at all.
+ *
+ * With WEBCLIENT_FLAG_NON_BLOCKING, the callback is called again if the
+ * receive would block.
+ *
+ * Input Parameters:
+ *   bufp  - The location to return the buffer.
+ *   sizep - The location to return the size of the buffer in bytes.
+ *   arg   - The value of webclient_context::sink_callback_arg.
+ *
+ * Return value:
+ *   0 on success.
+ *   A negative errno on error.
+ */
+
+typedef CODE int (*webclient_recv_buffer_callback_t)(FAR char **bufp,
+                                                     FAR size_t *sizep,
+                                                     FAR void *arg);
+
 struct webclient_tls_connection;
 struct webclient_poll_info;
 struct webclient_conn_s;
@@ -431,6 +487,8 @@ struct webclient_context
    *                       received.
    *   callback          - a compat version of sink_callback.
    *   sink_callback_arg - User argument passed to callback.
+   *   recv_buffer_callback - If not NULL, a callback to provide the
+   *                       buffers to receive the response body into.
    *   body_callback     - A callback function to provide the request body.
    *   body_callback_arg - User argument passed to body_callback.
    *   tls_ops           - A vector to implement TLS operations.
@@ -444,6 +502,7 @@ struct webclient_context
   wget_callback_t callback;
   webclient_sink_callback_t sink_callback;
   FAR void *sink_callback_arg;
+  webclient_recv_buffer_callback_t recv_buffer_callback;
   webclient_header_callback_t header_callback;
   FAR void *header_callback_arg;
   webclient_body_callback_t body_callback;
@@ -508,6 +567,22 @@ struct webclient_conn_s
   FAR void *tls_ctx;
 };
 
+#ifdef WGET_USE_STATS
+/* Counters of webclient_get_stats().
+ * reused / requests is the connection reuse rate.
+ */
+
+struct webclient_stats_s
+{
+  uint32_t requests;   /* Requests sent */
+  uint32_t connects;   /* Connections established */
+  uint32_t reused;     /* Requests sent on a kept-alive connection */
+  uint32_t pipelined;  /* Requests sent before the previous response */
+  uint32_t dns_hits;   /* Host names found in the DNS cache */
+  uint32_t dns_misses; /* Host names resolved with getaddrinfo() */
+};
+#endif
+
 /****************************************************************************
  * Public Function Prototypes
  ****************************************************************************/
@@ -576,6 +651,17 @@ ssize_t webclient_conn_recv(FAR struct webclient_conn_s *conn,
 void webclient_conn_close(FAR struct webclient_conn_s *conn);
 void webclient_conn_free(FAR struct webclient_conn_s *conn);
 
+#ifdef CONFIG_WEBCLIENT_KEEPALIVE
+void webclient_pool_flush(void);
+#endif
+#ifdef CONFIG_WEBCLIENT_PIPELINE
+int webclient_perform_pipeline(FAR struct webclient_context * FAR *ctxs,
+                               unsigned int nctxs);
+#endif
+#ifdef WGET_USE_STATS
+void webclient_get_stats(FAR struct webclient_stats_s *stats);
+#endif
+
 #undef EXTERN
 #ifdef __cplusplus
 }
@@ -0,0 +1,515 @@
+/****************************************************************************
+ * apps/industry/foc/fixed16/foc_batch.c
+ * This file implements batched multi-motor FOC handler for fixed16
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <assert.h>
+#include <errno.h>
+#include <string.h>
+
+#include "industry/foc/foc_common.h"
+#include "industry/foc/fixed16/foc_batch.h"
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#if CONFIG_MOTOR_FOC_PHASES != 3
+#  error
+#endif
+
+/* Enable current samples correction if 3-shunts */
+
+#if CONFIG_MOTOR_FOC_SHUNTS == 3
+#  define FOC_CORRECT_CURRENT_SAMPLES 1
+#endif
+
+#define FOC_BATCH_PI         (205887)   /* PI */
+#define FOC_BATCH_2PI        (411775)   /* 2 * PI */
+#define FOC_BATCH_3PI        (617662)   /* 3 * PI */
+#define FOC_BATCH_PI_2       (102944)   /* PI / 2 */
+#define FOC_BATCH_1_2PI      (10430)    /* 1 / (2 * PI) */
+#define FOC_BATCH_ONE_SQRT3  (37837)    /* 1 / sqrt(3) */
+#define FOC_BATCH_TWO_SQRT3  (75674)    /* 2 / sqrt(3) */
+#define FOC_BATCH_SQRT3_2    (56756)    /* sqrt(3) / 2 */
+
+/* Parabolic sine approximation with one refinement step */
+
+#define FOC_BATCH_SIN_B      (83443)    /* 4 / PI */
+#define FOC_BATCH_SIN_C      (26561)    /* 4 / PI^2 */
+#define FOC_BATCH_SIN_P      (14746)    /* 0.225 */
+
+#define FOC_BATCH_ABS(x)     (((x) < 0) ? -(x) : (x))
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: foc_batch_wrap
+ *
+ * Description:
+ *   Wrap angle not lower than -3*PI to the [-PI, PI) range
+ *
+ ****************************************************************************/
+
+static inline b16_t foc_batch_wrap(b16_t x)
+{
+  int32_t k = b16toi(b16mulb16(x + FOC_BATCH_3PI, FOC_BATCH_1_2PI));
+
+  return x + FOC_BATCH_2PI - b16muli(FOC_BATCH_2PI, k);
+}
+
+/****************************************************************************
+ * Name: foc_batch_sin
+ *
+ * Description:
+ *   Sine approximation for angle in the [-PI, PI) range
+ *
+ ****************************************************************************/
+
+static inline b16_t foc_batch_sin(b16_t x)
+{
+  b16_t y;
+
+  y = b16mulb16(FOC_BATCH_SIN_B, x) -
+      b16mulb16(FOC_BATCH_SIN_C, b16mulb16(x, FOC_BATCH_ABS(x)));
+  y = b16mulb16(FOC_BATCH_SIN_P, b16mulb16(y, FOC_BATCH_ABS(y)) - y) + y;
+
+  return y;
+}
+
+/****************************************************************************
+ * Name: foc_batch_input
+ *
+ * Description:
+ *   Correct the current samples, get the phase angle and transform the
+ *   phase currents to the DQ frame for all motors.
+ *
+ ****************************************************************************/
+
+static void foc_batch_input(FAR struct foc_batch_b16_s *restrict b,
+                            FAR struct foc_batch_input_b16_s *restrict in)
+{
+  b16_t x;
+  b16_t s;
+  b16_t c;
+  b16_t ia;
+  b16_t ib;
+  b16_t ic;
+  int   i;
+
+  for (i = 0; i < b->n; i++)
+    {
+      ia = in->current[0][i];
+      ib = in->current[1][i];
+      ic = in->current[2][i];
+
+#ifdef FOC_CORRECT_CURRENT_SAMPLES
+      /* The phase with the highest duty cycle has the shortest low-side
+       * on-time, so its sample is replaced with -(sum of the others).
+       */
+
+      s  = ia + ib + ic;
+      ia = (b->corr[0][i] != 0) ? ia - s : ia;
+      ib = (b->corr[1][i] != 0) ? ib - s : ib;
+      ic = (b->corr[2][i] != 0) ? ic - s : ic;
+
+      in->current[0][i] = ia;
+      in->current[1][i] = ib;
+      in->current[2][i] = ic;
+#endif
+
+      /* Phase angle */
+
+      x = foc_batch_wrap(in->angle[i]);
+      s = foc_batch_sin(x);
+      c = foc_batch_sin(foc_batch_wrap(x + FOC_BATCH_PI_2));
+
+      b->sin[i] = s;
+      b->cos[i] = c;
+
+      /* Clarke transform */
+
+      b->i_a[i] = ia;
+      b->i_b[i] = b16mulb16(FOC_BATCH_ONE_SQRT3, ia) +
+                  b16mulb16(FOC_BATCH_TWO_SQRT3, ib);
+
+      /* Park transform */
+
+      b->i_d[i] = b16mulb16(c, b->i_a[i]) + b16mulb16(s, b->i_b[i]);
+      b->i_q[i] = b16mulb16(c, b->i_b[i]) - b16mulb16(s, b->i_a[i]);
+    }
+}
+
+/****************************************************************************
+ * Name: foc_batch_control
+ *
+ * Description:
+ *   Run the DQ current PI controllers and saturate the DQ voltage for all
+ *   motors.  In voltage mode the DQ reference is used as the DQ voltage
+ *   and the PI controllers are not updated.
+ *
+ ****************************************************************************/
+
+static void foc_batch_control(FAR struct foc_batch_b16_s *restrict b,
+                              FAR struct foc_batch_input_b16_s *restrict in)
+{
+  b16_t   ed;
+  b16_t   eq;
+  b16_t   id;
+  b16_t   iq;
+  b16_t   vd;
+  b16_t   vq;
+  b16_t   max;
+  b16_t   mag;
+  int64_t mag2;
+  int     i;
+
+  for (i = 0; i < b->n; i++)
+    {
+      max = b->mag_max[i];
+
+      /* DQ current error, zero if not in current mode */
+
+      ed = in->ref_d[i] - b->i_d[i];
+      eq = in->ref_q[i] - b->i_q[i];
+      ed = (b->curr[i] != 0) ? ed : 0;
+      eq = (b->curr[i] != 0) ? eq : 0;
+
+      /* PI controllers with the integral part limited to the output
+       * saturation (anti-windup).
+       */
+
+      id = b->id_int[i] + b16mulb16(b->id_ki[i], ed);
+      id = (id > max) ? max : id;
+      id = (id < -max) ? -max : id;
+
+      iq = b->iq_int[i] + b16mulb16(b->iq_ki[i], eq);
+      iq = (iq > max) ? max : iq;
+      iq = (iq < -max) ? -max : iq;
+
+      b->id_int[i] = id;
+      b->iq_int[i] = iq;
+
+      vd = b16mulb16(b->id_kp[i], ed) + id;
+      vd = (vd > max) ? max : vd;
+      vd = (vd < -max) ? -max : vd;
+
+      vq = b16mulb16(b->iq_kp[i], eq) + iq;
+      vq = (vq > max) ? max : vq;
+      vq = (vq < -max) ? -max : vq;
+
+      /* Voltage compensation is substracted from the PI output,
+       * in voltage mode the output is the DQ reference.
+       */
+
+      b->v_d[i] = (b->curr[i] != 0) ? vd - in->comp_d[i] : in->ref_d[i];
+      b->v_q[i] = (b->curr[i] != 0) ? vq - in->comp_q[i] : in->ref_q[i];
+    }
+
+  /* Saturate DQ voltage vector */
+
+  for (i = 0; i < b->n; i++)
+    {
+      vd   = b->v_d[i];
+      vq   = b->v_q[i];
+      max  = b->mag_max[i];
+      mag2 = (int64_t)vd * vd + (int64_t)vq * vq;
+
+      if (mag2 > (int64_t)max * max)
+        {
+          mag = (b16_t)ub32sqrtub16((ub32_t)mag2);
+
+          b->v_d[i] = b16mulb16(vd, b16divb16(max, mag));
+          b->v_q[i] = b16mulb16(vq, b16divb16(max, mag));
+        }
+    }
+}
+
+/****************************************************************************
+ * Name: foc_batch_modulation
+ *
+ * Description:
+ *   Transform the DQ voltage to the alpha-beta frame and get the SVM3 duty
+ *   cycles for all motors.
+ *
+ *   Centering the zero vectors of the space vector modulation is the same
+ *   as removing the mean of the maximum and the minimum phase voltage, so
+ *   the sector search is not needed.
+ *
+ ****************************************************************************/
+
+static void
+foc_batch_modulation(FAR struct foc_batch_b16_s *restrict b,
+                     FAR struct foc_batch_output_b16_s *restrict out)
+{
+  b16_t u;
+  b16_t v;
+  b16_t w;
+  b16_t hi;
+  b16_t lo;
+  b16_t off;
+  b16_t max;
+  b16_t du;
+  b16_t dv;
+  b16_t dw;
+  int   i;
+
+  for (i = 0; i < b->n; i++)
+    {
+      /* Inverse Park transform */
+
+      b->v_a[i] = b16mulb16(b->cos[i], b->v_d[i]) -
+                  b16mulb16(b->sin[i], b->v_q[i]);
+      b->v_b[i] = b16mulb16(b->cos[i], b->v_q[i]) +
+                  b16mulb16(b->sin[i], b->v_d[i]);
+
+      /* Inverse Clarke transform of the modulation voltage */
+
+      u = b16mulb16(b->v_a[i], b->mod_scale[i]);
+      v = b16mulb16(FOC_BATCH_SQRT3_2,
+                    b16mulb16(b->v_b[i], b->mod_scale[i])) - u / 2;
+      w = -u - v;
+
+      /* Zero-sequence injection */
+
+      hi  = (u > v) ? u : v;
+      hi  = (w > hi) ? w : hi;
+      lo  = (u < v) ? u : v;
+      lo  = (w < lo) ? w : lo;
+      off = (hi + lo) / 2;
+
+      du = b16HALF + b16mulb16(FOC_BATCH_ONE_SQRT3, u - off);
+      dv = b16HALF + b16mulb16(FOC_BATCH_ONE_SQRT3, v - off);
+      dw = b16HALF + b16mulb16(FOC_BATCH_ONE_SQRT3, w - off);
+
+      /* Saturate duty cycle, zero if motor not modulated */
+
+      max = (b->run[i] != 0) ? b->duty_max[i] : 0;
+
+      du = (du > max) ? max : du;
+      du = (du < 0) ? 0 : du;
+      dv = (dv > max) ? max : dv;
+      dv = (dv < 0) ? 0 : dv;
+      dw = (dw > max) ? max : dw;
+      dw = (dw < 0) ? 0 : dw;
+
+      out->duty[0][i] = du;
+      out->duty[1][i] = dv;
+      out->duty[2][i] = dw;
+
+#ifdef FOC_CORRECT_CURRENT_SAMPLES
+      /* Phase with the highest duty for the next current correction */
+
+      b->corr[0][i] = (b->run[i] != 0 && u == hi);
+      b->corr[1][i] = (b->run[i] != 0 && v == hi && u != hi);
+      b->corr[2][i] = (b->run[i] != 0 && w == hi && u != hi && v != hi);
+#endif
+    }
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: foc_batch_init_b16
+ *
+ * Description:
+ *   Initialize the batched FOC handler (fixed16)
+ *
+ * Input Parameter:
+ *   b - pointer to batched FOC handler
+ *   n - number of motors
+ *
+ ****************************************************************************/
+
+int foc_batch_init_b16(FAR struct foc_batch_b16_s *b, int n)
+{
+  DEBUGASSERT(b);
+
+  if (n <= 0 || n > FOC_BATCH_MAX)
+    {
+      return -EINVAL;
+    }
+
+  /* Reset handler */
+
+  memset(b, 0, sizeof(struct foc_batch_b16_s));
+
+  b->n = n;
+
+  return OK;
+}
+
+/****************************************************************************
+ * Name: foc_batch_cfg_b16
+ *
+ * Description:
+ *   Configure one motor of the batched FOC handler and reset its
+ *   controller state (fixed16)
+ *
+ * Input Parameter:
+ *   b        - pointer to batched FOC handler
+ *   motor    - motor index
+ *   ctrl_cfg - pointer to controller configuration data
+ *   mod_cfg  - pointer to modulation configuration data
+ *
+ ****************************************************************************/
+
+void foc_batch_cfg_b16(FAR struct foc_batch_b16_s *b, int motor,
+                       FAR struct foc_initdata_b16_s *ctrl_cfg,
+                       FAR struct foc_mod_cfg_b16_s *mod_cfg)
+{
+  DEBUGASSERT(b);
+  DEBUGASSERT(motor >= 0 && motor < b->n);
+  DEBUGASSERT(ctrl_cfg);
+  DEBUGASSERT(mod_cfg);
+
+  b->id_kp[motor]      = ctrl_cfg->id_kp;
+  b->id_ki[motor]      = ctrl_cfg->id_ki;
+  b->iq_kp[motor]      = ctrl_cfg->iq_kp;
+  b->iq_ki[motor]      = ctrl_cfg->iq_ki;
+  b->duty_max[motor]   = mod_cfg->pwm_duty_max;
+
+  b->vbase_last[motor] = 0;
+  b->mod_scale[motor]  = 0;
+  b->mag_max[motor]    = 0;
+  b->id_int[motor]     = 0;
+  b->iq_int[motor]     = 0;
+  b->corr[0][motor]    = 0;
+  b->corr[1][motor]    = 0;
+  b->corr[2][motor]    = 0;
+}
+
+/****************************************************************************
+ * Name: foc_batch_run_b16
+ *
+ * Description:
+ *   Run the FOC handler for all motors of the batch (fixed16).
+ *
+ *   This does the same as foc_handler_run_b16() with the PI controller
+ *   and the SVM3 modulation for each motor, but each stage is one loop
+ *   over the motors without indirect calls.  Motors in the init or idle
+ *   mode get zero duty cycle.  The phase angles must not be lower than
+ *   -3*PI.
+ *
+ * Input Parameter:
+ *   b   - pointer to batched FOC handler
+ *   in  - pointer to batch input data, the current samples are corrected
+ *         in place
+ *   out - pointer to batch output data
+ *
+ ****************************************************************************/
+
+int foc_batch_run_b16(FAR struct foc_batch_b16_s *b,
+                      FAR struct foc_batch_input_b16_s *in,
+                      FAR struct foc_batch_output_b16_s *out)
+{
+  b16_t   vbase = 0;
+  uint8_t mode  = 0;
+  int     ret   = OK;
+  int     i;
+
+  DEBUGASSERT(b);
+  DEBUGASSERT(in);
+  DEBUGASSERT(out);
+
+  /* Controller modes and base voltage */
+
+  for (i = 0; i < b->n; i++)
+    {
+      mode = in->mode[i];
+      if (mode > FOC_HANDLER_MODE_CURRENT)
+        {
+          mode = FOC_HANDLER_MODE_INIT;
+          ret  = -EINVAL;
+        }
+
+      b->run[i]  = (mode >= FOC_HANDLER_MODE_VOLTAGE);
+      b->curr[i] = (mode == FOC_HANDLER_MODE_CURRENT);
+
+      /* Update base voltage only if changed */
+
+      vbase = b16mulb16(in->vbus[i], FOC_BATCH_ONE_SQRT3);
+      if (b->vbase_last[i] != vbase)
+        {
+          b->mod_scale[i]  = (vbase > 0) ? b16divb16(b16ONE, vbase) : 0;
+          b->mag_max[i]    = (vbase > 0) ? vbase : 0;
+          b->vbase_last[i] = vbase;
+        }
+    }
+
+  foc_batch_input(b, in);
+  foc_batch_control(b, in);
+  foc_batch_modulation(b, out);
+
+  return ret;
+}
+
+/****************************************************************************
+ * Name: foc_batch_state_b16
+ *
+ * Description:
+ *   Get the controller state of one motor (fixed16)
+ *
+ * Input Parameter:
+ *   b     - pointer to batched FOC handler
+ *   motor - motor index
+ *   state - (out) pointer to FOC state data
+ *
+ ****************************************************************************/
+
+void foc_batch_state_b16(FAR struct foc_batch_b16_s *b, int motor,
+                         FAR struct foc_state_b16_s *state)
+{
+  DEBUGASSERT(b);
+  DEBUGASSERT(motor >= 0 && motor < b->n);
+  DEBUGASSERT(state);
+
+  state->idq.d = b->i_d[motor];
+  state->idq.q = b->i_q[motor];
+  state->vdq.d = b->v_d[motor];
+  state->vdq.q = b->v_q[motor];
+  state->iab.a = b->i_a[motor];
+  state->iab.b = b->i_b[motor];
+  state->vab.a = b->v_a[motor];
+  state->vab.b = b->v_b[motor];
+
+  /* Phase current and voltage from the alpha-beta frames */
+
+  state->curr[0] = b->i_a[motor];
+  state->curr[1] = b16mulb16(FOC_BATCH_SQRT3_2, b->i_b[motor]) -
+                   b->i_a[motor] / 2;
+  state->curr[2] = -state->curr[0] - state->curr[1];
+
+  state->volt[0] = b->v_a[motor];
+  state->volt[1] = b16mulb16(FOC_BATCH_SQRT3_2, b->v_b[motor]) -
+                   b->v_a[motor] / 2;
+  state->volt[2] = -state->volt[0] - state->volt[1];
+
+  state->mod_scale = b->mod_scale[motor];
+}
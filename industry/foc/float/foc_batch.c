@@ -0,0 +1,525 @@
+/****************************************************************************
+ * apps/industry/foc/float/foc_batch.c
+ * This file implements batched multi-motor FOC handler for float32
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <assert.h>
+#include <errno.h>
+#include <float.h>
+#include <math.h>
+#include <string.h>
+
+#include "industry/foc/foc_common.h"
+#include "industry/foc/float/foc_batch.h"
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#if CONFIG_MOTOR_FOC_PHASES != 3
+#  error
+#endif
+
+/* Enable current samples correction if 3-shunts */
+
+#if CONFIG_MOTOR_FOC_SHUNTS == 3
+#  define FOC_CORRECT_CURRENT_SAMPLES 1
+#endif
+
+#define FOC_BATCH_PI         (3.14159265f)
+#define FOC_BATCH_2PI        (6.28318531f)
+#define FOC_BATCH_PI_2       (1.57079633f)
+#define FOC_BATCH_1_2PI      (0.15915494f)
+#define FOC_BATCH_ONE_SQRT3  (0.57735027f)
+#define FOC_BATCH_TWO_SQRT3  (1.15470054f)
+#define FOC_BATCH_SQRT3_2    (0.86602540f)
+
+/* Parabolic sine approximation with one refinement step, the maximum
+ * error is about 0.001 for the [-PI, PI] range.
+ */
+
+#define FOC_BATCH_SIN_B      (1.27323954f)   /* 4 / PI */
+#define FOC_BATCH_SIN_C      (0.40528473f)   /* 4 / PI^2 */
+#define FOC_BATCH_SIN_P      (0.225f)
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: foc_batch_wrap
+ *
+ * Description:
+ *   Wrap angle not lower than -3*PI to the [-PI, PI) range
+ *
+ ****************************************************************************/
+
+static inline float foc_batch_wrap(float x)
+{
+  int32_t k = (int32_t)((x + 3.0f * FOC_BATCH_PI) * FOC_BATCH_1_2PI);
+
+  return x + FOC_BATCH_2PI - FOC_BATCH_2PI * (float)k;
+}
+
+/****************************************************************************
+ * Name: foc_batch_sin
+ *
+ * Description:
+ *   Sine approximation for angle in the [-PI, PI) range
+ *
+ ****************************************************************************/
+
+static inline float foc_batch_sin(float x)
+{
+  float y;
+
+  y = FOC_BATCH_SIN_B * x - FOC_BATCH_SIN_C * x * fabsf(x);
+  y = FOC_BATCH_SIN_P * (y * fabsf(y) - y) + y;
+
+  return y;
+}
+
+/****************************************************************************
+ * Name: foc_batch_input
+ *
+ * Description:
+ *   Correct the current samples, get the phase angle and transform the
+ *   phase currents to the DQ frame for all motors.
+ *
+ ****************************************************************************/
+
+static void foc_batch_input(FAR struct foc_batch_f32_s *restrict b,
+                            FAR struct foc_batch_input_f32_s *restrict in)
+{
+  float x;
+  float s;
+  float c;
+  float ia;
+  float ib;
+  float ic;
+  int   i;
+
+  for (i = 0; i < b->n; i++)
+    {
+      ia = in->current[0][i];
+      ib = in->current[1][i];
+      ic = in->current[2][i];
+
+#ifdef FOC_CORRECT_CURRENT_SAMPLES
+      /* The phase with the highest duty cycle has the shortest low-side
+       * on-time, so its sample is replaced with -(sum of the others).
+       */
+
+      s  = ia + ib + ic;
+      ia = ia - b->corr[0][i] * s;
+      ib = ib - b->corr[1][i] * s;
+      ic = ic - b->corr[2][i] * s;
+
+      in->current[0][i] = ia;
+      in->current[1][i] = ib;
+      in->current[2][i] = ic;
+#endif
+
+      /* Phase angle */
+
+      x = foc_batch_wrap(in->angle[i]);
+      s = foc_batch_sin(x);
+      c = foc_batch_sin(foc_batch_wrap(x + FOC_BATCH_PI_2));
+
+      b->sin[i] = s;
+      b->cos[i] = c;
+
+      /* Clarke transform */
+
+      b->i_a[i] = ia;
+      b->i_b[i] = FOC_BATCH_ONE_SQRT3 * ia + FOC_BATCH_TWO_SQRT3 * ib;
+
+      /* Park transform */
+
+      b->i_d[i] = c * b->i_a[i] + s * b->i_b[i];
+      b->i_q[i] = c * b->i_b[i] - s * b->i_a[i];
+    }
+}
+
+/****************************************************************************
+ * Name: foc_batch_control
+ *
+ * Description:
+ *   Run the DQ current PI controllers and saturate the DQ voltage for all
+ *   motors.  In voltage mode the DQ reference is used as the DQ voltage
+ *   and the PI controllers are not updated.
+ *
+ ****************************************************************************/
+
+static void foc_batch_control(FAR struct foc_batch_f32_s *restrict b,
+                              FAR struct foc_batch_input_f32_s *restrict in)
+{
+  float ed;
+  float eq;
+  float id;
+  float iq;
+  float vd;
+  float vq;
+  float max;
+  float mag;
+  float scale;
+  int   i;
+
+  for (i = 0; i < b->n; i++)
+    {
+      max = b->mag_max[i];
+
+      /* DQ current error, zero if not in current mode */
+
+      ed = b->curr[i] * (in->ref_d[i] - b->i_d[i]);
+      eq = b->curr[i] * (in->ref_q[i] - b->i_q[i]);
+
+      /* PI controllers with the integral part limited to the output
+       * saturation (anti-windup).
+       */
+
+      id = b->id_int[i] + b->id_ki[i] * ed;
+      id = (id > max) ? max : id;
+      id = (id < -max) ? -max : id;
+
+      iq = b->iq_int[i] + b->iq_ki[i] * eq;
+      iq = (iq > max) ? max : iq;
+      iq = (iq < -max) ? -max : iq;
+
+      b->id_int[i] = id;
+      b->iq_int[i] = iq;
+
+      vd = b->id_kp[i] * ed + id;
+      vd = (vd > max) ? max : vd;
+      vd = (vd < -max) ? -max : vd;
+
+      vq = b->iq_kp[i] * eq + iq;
+      vq = (vq > max) ? max : vq;
+      vq = (vq < -max) ? -max : vq;
+
+      /* Voltage compensation is substracted from the PI output,
+       * in voltage mode the output is the DQ reference.
+       */
+
+      b->v_d[i] = in->ref_d[i] +
+                  b->curr[i] * (vd - in->comp_d[i] - in->ref_d[i]);
+      b->v_q[i] = in->ref_q[i] +
+                  b->curr[i] * (vq - in->comp_q[i] - in->ref_q[i]);
+    }
+
+  /* Saturate DQ voltage vector.  This loop is vectorized only if sqrtf()
+   * is not required to set errno, the build passes -fno-math-errno for
+   * this file.
+   */
+
+  for (i = 0; i < b->n; i++)
+    {
+      vd    = b->v_d[i];
+      vq    = b->v_q[i];
+      mag   = sqrtf(vd * vd + vq * vq);
+      scale = b->mag_max[i] / (mag + FLT_MIN);
+      max   = (scale < 1.0f) ? 1.0f : 0.0f;
+      scale = 1.0f + max * (scale - 1.0f);
+
+      b->v_d[i] = vd * scale;
+      b->v_q[i] = vq * scale;
+    }
+}
+
+/****************************************************************************
+ * Name: foc_batch_modulation
+ *
+ * Description:
+ *   Transform the DQ voltage to the alpha-beta frame and get the SVM3 duty
+ *   cycles for all motors.
+ *
+ *   Centering the zero vectors of the space vector modulation is the same
+ *   as removing the mean of the maximum and the minimum phase voltage, so
+ *   the sector search is not needed.
+ *
+ ****************************************************************************/
+
+static void
+foc_batch_modulation(FAR struct foc_batch_f32_s *restrict b,
+                     FAR struct foc_batch_output_f32_s *restrict out)
+{
+  float u;
+  float v;
+  float w;
+  float hi;
+  float lo;
+  float off;
+  float max;
+  float du;
+  float dv;
+  float dw;
+  int   i;
+
+  for (i = 0; i < b->n; i++)
+    {
+      /* Inverse Park transform */
+
+      b->v_a[i] = b->cos[i] * b->v_d[i] - b->sin[i] * b->v_q[i];
+      b->v_b[i] = b->cos[i] * b->v_q[i] + b->sin[i] * b->v_d[i];
+
+      /* Inverse Clarke transform of the modulation voltage */
+
+      u = b->v_a[i] * b->mod_scale[i];
+      v = -0.5f * u + FOC_BATCH_SQRT3_2 * b->v_b[i] * b->mod_scale[i];
+      w = -u - v;
+
+      /* Zero-sequence injection */
+
+      hi  = (u > v) ? u : v;
+      hi  = (w > hi) ? w : hi;
+      lo  = (u < v) ? u : v;
+      lo  = (w < lo) ? w : lo;
+      off = 0.5f * (hi + lo);
+
+      du = 0.5f + FOC_BATCH_ONE_SQRT3 * (u - off);
+      dv = 0.5f + FOC_BATCH_ONE_SQRT3 * (v - off);
+      dw = 0.5f + FOC_BATCH_ONE_SQRT3 * (w - off);
+
+      /* Saturate duty cycle, zero if motor not modulated */
+
+      max = b->run[i] * b->duty_max[i];
+
+      du = (du > max) ? max : du;
+      du = (du < 0.0f) ? 0.0f : du;
+      dv = (dv > max) ? max : dv;
+      dv = (dv < 0.0f) ? 0.0f : dv;
+      dw = (dw > max) ? max : dw;
+      dw = (dw < 0.0f) ? 0.0f : dw;
+
+      out->duty[0][i] = du;
+      out->duty[1][i] = dv;
+      out->duty[2][i] = dw;
+    }
+
+#ifdef FOC_CORRECT_CURRENT_SAMPLES
+  /* Phase with the highest duty for the next current correction */
+
+  for (i = 0; i < b->n; i++)
+    {
+      du = out->duty[0][i];
+      dv = out->duty[1][i];
+      dw = out->duty[2][i];
+
+      hi = (du > dv) ? du : dv;
+      hi = (dw > hi) ? dw : hi;
+
+      u = (du == hi) ? 1.0f : 0.0f;
+      v = (dv == hi) ? 1.0f : 0.0f;
+      v = v * (1.0f - u);
+
+      b->corr[0][i] = b->run[i] * u;
+      b->corr[1][i] = b->run[i] * v;
+      b->corr[2][i] = b->run[i] * (1.0f - u - v);
+    }
+#endif
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: foc_batch_init_f32
+ *
+ * Description:
+ *   Initialize the batched FOC handler (float32)
+ *
+ * Input Parameter:
+ *   b - pointer to batched FOC handler
+ *   n - number of motors
+ *
+ ****************************************************************************/
+
+int foc_batch_init_f32(FAR struct foc_batch_f32_s *b, int n)
+{
+  DEBUGASSERT(b);
+
+  if (n <= 0 || n > FOC_BATCH_MAX)
+    {
+      return -EINVAL;
+    }
+
+  /* Reset handler */
+
+  memset(b, 0, sizeof(struct foc_batch_f32_s));
+
+  b->n = n;
+
+  return OK;
+}
+
+/****************************************************************************
+ * Name: foc_batch_cfg_f32
+ *
+ * Description:
+ *   Configure one motor of the batched FOC handler and reset its
+ *   controller state (float32)
+ *
+ * Input Parameter:
+ *   b        - pointer to batched FOC handler
+ *   motor    - motor index
+ *   ctrl_cfg - pointer to controller configuration data
+ *   mod_cfg  - pointer to modulation configuration data
+ *
+ ****************************************************************************/
+
+void foc_batch_cfg_f32(FAR struct foc_batch_f32_s *b, int motor,
+                       FAR struct foc_initdata_f32_s *ctrl_cfg,
+                       FAR struct foc_mod_cfg_f32_s *mod_cfg)
+{
+  DEBUGASSERT(b);
+  DEBUGASSERT(motor >= 0 && motor < b->n);
+  DEBUGASSERT(ctrl_cfg);
+  DEBUGASSERT(mod_cfg);
+
+  b->id_kp[motor]      = ctrl_cfg->id_kp;
+  b->id_ki[motor]      = ctrl_cfg->id_ki;
+  b->iq_kp[motor]      = ctrl_cfg->iq_kp;
+  b->iq_ki[motor]      = ctrl_cfg->iq_ki;
+  b->duty_max[motor]   = mod_cfg->pwm_duty_max;
+
+  b->vbase_last[motor] = 0.0f;
+  b->mod_scale[motor]  = 0.0f;
+  b->mag_max[motor]    = 0.0f;
+  b->id_int[motor]     = 0.0f;
+  b->iq_int[motor]     = 0.0f;
+  b->corr[0][motor]    = 0.0f;
+  b->corr[1][motor]    = 0.0f;
+  b->corr[2][motor]    = 0.0f;
+}
+
+/****************************************************************************
+ * Name: foc_batch_run_f32
+ *
+ * Description:
+ *   Run the FOC handler for all motors of the batch (float32).
+ *
+ *   This does the same as foc_handler_run_f32() with the PI controller
+ *   and the SVM3 modulation for each motor, but each stage is one loop
+ *   over the motors without indirect calls, which the compiler can
+ *   vectorize.  Motors in the init or idle mode get zero duty cycle.
+ *   The phase angles must not be lower than -3*PI.
+ *
+ * Input Parameter:
+ *   b   - pointer to batched FOC handler
+ *   in  - pointer to batch input data, the current samples are corrected
+ *         in place
+ *   out - pointer to batch output data
+ *
+ ****************************************************************************/
+
+int foc_batch_run_f32(FAR struct foc_batch_f32_s *b,
+                      FAR struct foc_batch_input_f32_s *in,
+                      FAR struct foc_batch_output_f32_s *out)
+{
+  float   vbase = 0.0f;
+  uint8_t mode  = 0;
+  int     ret   = OK;
+  int     i;
+
+  DEBUGASSERT(b);
+  DEBUGASSERT(in);
+  DEBUGASSERT(out);
+
+  /* Controller modes and base voltage */
+
+  for (i = 0; i < b->n; i++)
+    {
+      mode = in->mode[i];
+      if (mode > FOC_HANDLER_MODE_CURRENT)
+        {
+          mode = FOC_HANDLER_MODE_INIT;
+          ret  = -EINVAL;
+        }
+
+      b->run[i]  = (mode >= FOC_HANDLER_MODE_VOLTAGE) ? 1.0f : 0.0f;
+      b->curr[i] = (mode == FOC_HANDLER_MODE_CURRENT) ? 1.0f : 0.0f;
+
+      /* Update base voltage only if changed */
+
+      vbase = in->vbus[i] * FOC_BATCH_ONE_SQRT3;
+      if (b->vbase_last[i] != vbase)
+        {
+          b->mod_scale[i]  = (vbase > 0.0f) ? 1.0f / vbase : 0.0f;
+          b->mag_max[i]    = (vbase > 0.0f) ? vbase : 0.0f;
+          b->vbase_last[i] = vbase;
+        }
+    }
+
+  foc_batch_input(b, in);
+  foc_batch_control(b, in);
+  foc_batch_modulation(b, out);
+
+  return ret;
+}
+
+/****************************************************************************
+ * Name: foc_batch_state_f32
+ *
+ * Description:
+ *   Get the controller state of one motor (float32)
+ *
+ * Input Parameter:
+ *   b     - pointer to batched FOC handler
+ *   motor - motor index
+ *   state - (out) pointer to FOC state data
+ *
+ ****************************************************************************/
+
+void foc_batch_state_f32(FAR struct foc_batch_f32_s *b, int motor,
+                         FAR struct foc_state_f32_s *state)
+{
+  DEBUGASSERT(b);
+  DEBUGASSERT(motor >= 0 && motor < b->n);
+  DEBUGASSERT(state);
+
+  state->idq.d = b->i_d[motor];
+  state->idq.q = b->i_q[motor];
+  state->vdq.d = b->v_d[motor];
+  state->vdq.q = b->v_q[motor];
+  state->iab.a = b->i_a[motor];
+  state->iab.b = b->i_b[motor];
+  state->vab.a = b->v_a[motor];
+  state->vab.b = b->v_b[motor];
+
+  /* Phase current and voltage from the alpha-beta frames */
+
+  state->curr[0] = b->i_a[motor];
+  state->curr[1] = -0.5f * b->i_a[motor] +
+                   FOC_BATCH_SQRT3_2 * b->i_b[motor];
+  state->curr[2] = -state->curr[0] - state->curr[1];
+
+  state->volt[0] = b->v_a[motor];
+  state->volt[1] = -0.5f * b->v_a[motor] +
+                   FOC_BATCH_SQRT3_2 * b->v_b[motor];
+  state->volt[2] = -state->volt[0] - state->volt[1];
+
+  state->mod_scale = b->mod_scale[motor];
+}
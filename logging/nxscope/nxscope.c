@@ -445,11 +445,24 @@ static int nxscope_start_req(FAR struct nxscope_s *s,
   DEBUGASSERT(s);
   DEBUGASSERT(data);
 
+#ifdef CONFIG_LOGGING_NXSCOPE_PACKED
+  if ((data->start & ~(NXSCOPE_START_FLAGS_START |
+                       NXSCOPE_START_FLAGS_PACKED)) == 0)
+    {
+      _info("data->start=%d\n", data->start);
+
+      /* Packed frames are used only if the client asks for them */
+
+      s->packed = (data->start & NXSCOPE_START_FLAGS_PACKED) != 0;
+      ret = nxscope_start_set(s, data->start & NXSCOPE_START_FLAGS_START);
+    }
+#else
   if (data->start == 0 || data->start == 1)
     {
       _info("data->start=%d\n", data->start);
       ret = nxscope_start_set(s, data->start);
     }
+#endif
 
   return ret;
 }
@@ -831,6 +844,28 @@ int nxscope_init(FAR struct nxscope_s *s, FAR struct nxscope_cfg_s *cfg)
       goto errout;
     }
 
+#ifdef CONFIG_LOGGING_NXSCOPE_LOCKFREE
+  /* Allocate memory for channels sample rings */
+
+  ret = nxscope_chring_init(s, cfg->channels);
+  if (ret < 0)
+    {
+      _err("ERROR: nxscope_chring_init failed %d\n", ret);
+      goto errout;
+    }
+#endif
+
+#ifdef CONFIG_LOGGING_NXSCOPE_PACKED
+  /* Allocate memory for packed stream buffer */
+
+  ret = nxscope_pack_init(s);
+  if (ret < 0)
+    {
+      _err("ERROR: nxscope_pack_init failed %d\n", ret);
+      goto errout;
+    }
+#endif
+
 #ifdef CONFIG_LOGGING_NXSCOPE_CRICHANNELS
   /* Allocate memory for critical channels buffer */
 
@@ -868,6 +903,9 @@ int nxscope_init(FAR struct nxscope_s *s, FAR struct nxscope_cfg_s *cfg)
 #ifdef CONFIG_LOGGING_NXSCOPE_ACKFRAMES
   s->cmninfo.flags |= NXSCOPE_FLAGS_ACK_SUPPORT;
 #endif
+#ifdef CONFIG_LOGGING_NXSCOPE_PACKED
+  s->cmninfo.flags |= NXSCOPE_FLAGS_PACKED_SUPPORT;
+#endif
 
   s->cmninfo.rx_padding = cfg->rx_padding;
 
@@ -916,6 +954,14 @@ errout:
     }
 #endif
 
+#ifdef CONFIG_LOGGING_NXSCOPE_LOCKFREE
+  nxscope_chring_deinit(s, cfg->channels);
+#endif
+
+#ifdef CONFIG_LOGGING_NXSCOPE_PACKED
+  nxscope_pack_deinit(s);
+#endif
+
   return ret;
 }
 
@@ -968,6 +1014,14 @@ void nxscope_deinit(FAR struct nxscope_s *s)
     {
       free(s->txbuf);
     }
+
+#ifdef CONFIG_LOGGING_NXSCOPE_LOCKFREE
+  nxscope_chring_deinit(s, s->cmninfo.chmax);
+#endif
+
+#ifdef CONFIG_LOGGING_NXSCOPE_PACKED
+  nxscope_pack_deinit(s);
+#endif
 }
 
 /****************************************************************************
@@ -1035,6 +1089,17 @@ int nxscope_stream(FAR struct nxscope_s *s)
       goto errout;
     }
 
+#ifdef CONFIG_LOGGING_NXSCOPE_LOCKFREE
+  /* Collect samples from channels rings, unless we have to resend the
+   * previous frame first.
+   */
+
+  if (!s->stream_retry)
+    {
+      nxscope_chring_drain(s);
+    }
+#endif
+
   /* Do nothing if no data */
 
   if (nxscope_stream_empty(s))
@@ -1042,9 +1107,33 @@ int nxscope_stream(FAR struct nxscope_s *s)
       goto errout;
     }
 
-  /* Send stream data */
+#ifdef CONFIG_LOGGING_NXSCOPE_PACKED
+  /* Pack a new frame if requested. The packed frame is send only if it is
+   * shorter than the raw frame. A failed frame is resend as it is.
+   */
+
+  if (!s->stream_retry)
+    {
+      s->pack_i = 0;
+
+      if (s->packed && nxscope_pack_stream(s) < 0)
+        {
+          s->pack_i = 0;
+        }
+    }
+
+  if (s->pack_i > 0)
+    {
+      ret = nxscope_stream_send(s, s->packbuf, &s->pack_i);
+    }
+  else
+#endif
+    {
+      /* Send stream data */
+
+      ret = nxscope_stream_send(s, s->streambuf, &s->stream_i);
+    }
 
-  ret = nxscope_stream_send(s, s->streambuf, &s->stream_i);
   if (ret < 0)
     {
       _err("ERROR: nxscope_stream_send failed %d\n", ret);
@@ -1166,3 +1255,31 @@ int nxscope_stream_start(FAR struct nxscope_s *s, bool start)
 
   return ret;
 }
+
+#ifdef CONFIG_LOGGING_NXSCOPE_PACKED
+/****************************************************************************
+ * Name: nxscope_stream_packed
+ *
+ * Description:
+ *   Enable/disable packed stream frames
+ *
+ * Input Parameters:
+ *   s      - a pointer to a nxscope instance
+ *   packed - packed frames enable
+ *
+ ****************************************************************************/
+
+int nxscope_stream_packed(FAR struct nxscope_s *s, bool packed)
+{
+  DEBUGASSERT(s);
+
+  nxscope_lock(s);
+
+  _info("force stream_packed=%d\n", packed);
+  s->packed = packed;
+
+  nxscope_unlock(s);
+
+  return OK;
+}
+#endif
@@ -24,6 +24,8 @@
 
 #include <nuttx/config.h>
 
+#include <sys/types.h>
+
 #include <assert.h>
 #include <debug.h>
 #include <endian.h>
@@ -85,6 +87,7 @@ int g_type_size[] =
  * Private Functions
  ****************************************************************************/
 
+#ifndef CONFIG_LOGGING_NXSCOPE_LOCKFREE
 /****************************************************************************
  * Name: nxscope_stream_overflow
  *
@@ -99,18 +102,20 @@ static void nxscope_stream_overflow(FAR struct nxscope_s *s)
 
   s->streambuf[s->proto_stream->hdrlen] |= NXSCOPE_STREAM_FLAGS_OVERFLOW;
 }
+#endif
 
 /****************************************************************************
- * Name: nxscope_ch_validate
+ * Name: nxscope_ch_check
+ *
+ * Description:
+ *   Check if a channel accepts samples of a given format
+ *
  ****************************************************************************/
 
-static int nxscope_ch_validate(FAR struct nxscope_s *s, uint8_t ch,
-                               uint8_t type, uint8_t d, uint8_t mlen)
+static int nxscope_ch_check(FAR struct nxscope_s *s, uint8_t ch,
+                            uint8_t type, uint8_t d, uint8_t mlen)
 {
-  union nxscope_chinfo_type_u utype;
-  size_t                      next_i    = 0;
-  int                         ret       = OK;
-  size_t                      type_size = 0;
+  int ret = OK;
 
   DEBUGASSERT(s);
 
@@ -169,8 +174,36 @@ static int nxscope_ch_validate(FAR struct nxscope_s *s, uint8_t ch,
       ret = -EINVAL;
       goto errout;
     }
+#else
+  UNUSED(type);
+  UNUSED(d);
+  UNUSED(mlen);
 #endif
 
+errout:
+  return ret;
+}
+
+/****************************************************************************
+ * Name: nxscope_ch_validate
+ ****************************************************************************/
+
+static int nxscope_ch_validate(FAR struct nxscope_s *s, uint8_t ch,
+                               uint8_t type, uint8_t d, uint8_t mlen)
+{
+  union nxscope_chinfo_type_u utype;
+  size_t                      next_i    = 0;
+  int                         ret       = OK;
+  size_t                      type_size = 0;
+
+  DEBUGASSERT(s);
+
+  ret = nxscope_ch_check(s, ch, type, d, mlen);
+  if (ret != OK)
+    {
+      goto errout;
+    }
+
 #ifdef CONFIG_LOGGING_NXSCOPE_DIVIDER
   /* Handle sample rate divider */
 
@@ -226,6 +259,7 @@ static int nxscope_ch_validate(FAR struct nxscope_s *s, uint8_t ch,
     }
 #endif
 
+#ifndef CONFIG_LOGGING_NXSCOPE_LOCKFREE
   next_i = (s->stream_i + 1 + type_size * d + mlen +
             s->proto_stream->footlen);
 
@@ -236,6 +270,12 @@ static int nxscope_ch_validate(FAR struct nxscope_s *s, uint8_t ch,
       ret = -ENOBUFS;
       goto errout;
     }
+#else
+  /* With channel rings the space is checked when the sample is put */
+
+  UNUSED(next_i);
+  UNUSED(type_size);
+#endif
 
 errout:
   return ret;
@@ -439,6 +479,65 @@ static void nxscope_put_sample(FAR uint8_t *buff, FAR size_t *buff_i,
   *buff_i += i;
 }
 
+#ifdef CONFIG_LOGGING_NXSCOPE_LOCKFREE
+/****************************************************************************
+ * Name: nxscope_put_common_ring
+ *
+ * Description:
+ *   Put a sample on the channel ring without taking the nxscope lock.
+ *   Only one thread may put samples on a given channel.
+ *
+ ****************************************************************************/
+
+static int nxscope_put_common_ring(FAR struct nxscope_s *s, uint8_t type,
+                                   uint8_t ch, FAR void *val, uint8_t d,
+                                   FAR uint8_t *meta, uint8_t mlen)
+{
+  union nxscope_chinfo_type_u  utype;
+  FAR uint8_t                 *buff   = NULL;
+  size_t                       buff_i = 0;
+  size_t                       len    = 0;
+  int                          ret    = OK;
+
+  /* Validate data */
+
+  ret = nxscope_ch_validate(s, ch, type, d, mlen);
+  if (ret != OK)
+    {
+      return ret;
+    }
+
+  /* Get space on the channel ring */
+
+  utype.u8 = type;
+#ifdef CONFIG_LOGGING_NXSCOPE_USERTYPES
+  if (type >= NXSCOPE_TYPE_USER)
+    {
+      len = 1 + d + mlen;
+    }
+  else
+#endif
+    {
+      len = 1 + g_type_size[utype.s.dtype] * d + mlen;
+    }
+
+  buff = nxscope_chring_reserve(s, ch, len);
+  if (buff == NULL)
+    {
+      return -ENOBUFS;
+    }
+
+  /* Put sample on the ring and make it visible to nxscope_stream() */
+
+  nxscope_put_sample(buff, &buff_i, type, ch, val, d, meta, mlen);
+  DEBUGASSERT(buff_i == len);
+
+  nxscope_chring_commit(s, ch);
+
+  return OK;
+}
+#endif
+
 /****************************************************************************
  * Name: nxscope_put_common_m
  ****************************************************************************/
@@ -457,6 +556,13 @@ static int nxscope_put_common_m(FAR struct nxscope_s *s, uint8_t type,
 
   DEBUGASSERT(s);
 
+#ifdef CONFIG_LOGGING_NXSCOPE_LOCKFREE
+  if (!NXSCOPE_IS_CRICHAN(type))
+    {
+      return nxscope_put_common_ring(s, type, ch, val, d, meta, mlen);
+    }
+#endif
+
 #ifndef CONFIG_LOGGING_NXSCOPE_DISABLE_PUTLOCK
   nxscope_lock(s);
 #endif
@@ -515,6 +621,210 @@ errout:
   return ret;
 }
 
+/****************************************************************************
+ * Name: nxscope_ch_validate_block
+ *
+ * Description:
+ *   Validate a channel for a block of n samples and apply the channel
+ *   divider to the whole block.
+ *
+ * Returned Value:
+ *   Number of samples to put, *first is the index of the first sample and
+ *   *step the distance between samples. A negated errno value on failure.
+ *
+ ****************************************************************************/
+
+static ssize_t nxscope_ch_validate_block(FAR struct nxscope_s *s,
+                                         uint8_t ch, uint8_t type,
+                                         uint8_t d, size_t n,
+                                         FAR size_t *first,
+                                         FAR size_t *step)
+{
+  int ret;
+
+  ret = nxscope_ch_check(s, ch, type, d, 0);
+  if (ret != OK)
+    {
+      return ret;
+    }
+
+  *first = 0;
+  *step  = 1;
+
+#ifdef CONFIG_LOGGING_NXSCOPE_DIVIDER
+  /* The same samples as with n calls to nxscope_ch_validate() */
+
+  *step  = s->chinfo[ch].div + 1;
+  *first = (*step - 1) - (s->cntr[ch] % *step);
+  s->cntr[ch] += n;
+#endif
+
+  if (*first >= n)
+    {
+      return 0;
+    }
+
+  return (n - *first + *step - 1) / *step;
+}
+
+#ifdef CONFIG_LOGGING_NXSCOPE_LOCKFREE
+/****************************************************************************
+ * Name: nxscope_put_block_ring
+ *
+ * Description:
+ *   Put a block of samples on the channel ring without taking the nxscope
+ *   lock. Only one thread may put samples on a given channel.
+ *
+ ****************************************************************************/
+
+static int nxscope_put_block_ring(FAR struct nxscope_s *s, uint8_t type,
+                                  uint8_t ch, FAR const uint8_t *val,
+                                  uint8_t d, size_t n)
+{
+  FAR uint8_t *buff  = NULL;
+  size_t       dlen  = g_type_size[type] * d;
+  size_t       first = 0;
+  size_t       step  = 0;
+  ssize_t      cnt   = 0;
+
+  cnt = nxscope_ch_validate_block(s, ch, type, d, n, &first, &step);
+  if (cnt < 0)
+    {
+      return cnt;
+    }
+
+  for (val += first * dlen; cnt > 0; cnt--, val += step * dlen)
+    {
+      buff = nxscope_chring_reserve(s, ch, 1 + dlen);
+      if (buff == NULL)
+        {
+          return -ENOBUFS;
+        }
+
+      buff[0] = ch;
+      memcpy(&buff[1], val, dlen);
+
+      nxscope_chring_commit(s, ch);
+    }
+
+  return OK;
+}
+#endif
+
+/****************************************************************************
+ * Name: nxscope_put_block_common
+ *
+ * Description:
+ *   Put a block of n vector samples of one channel. val points to n * d
+ *   elements. The channel is validated once and the data of each sample is
+ *   copied with a single memcpy(), samples are already little-endian.
+ *
+ ****************************************************************************/
+
+static int nxscope_put_block_common(FAR struct nxscope_s *s, uint8_t type,
+                                    uint8_t ch, FAR const void *val,
+                                    uint8_t d, size_t n)
+{
+  FAR const uint8_t           *src   = val;
+  size_t                       dlen  = 0;
+  size_t                       first = 0;
+  size_t                       step  = 0;
+  size_t                       space = 0;
+  ssize_t                      cnt   = 0;
+  int                          ret   = OK;
+#ifdef CONFIG_LOGGING_NXSCOPE_CRICHANNELS
+  size_t                       tmp   = 0;
+  union nxscope_chinfo_type_u  utype;
+#endif
+
+  DEBUGASSERT(s);
+  DEBUGASSERT(val != NULL || n == 0);
+  DEBUGASSERT(type > NXSCOPE_TYPE_NONE && type < NXSCOPE_TYPE_CHAR);
+
+#ifdef CONFIG_LOGGING_NXSCOPE_LOCKFREE
+  if (!NXSCOPE_IS_CRICHAN(type))
+    {
+      return nxscope_put_block_ring(s, type, ch, src, d, n);
+    }
+#endif
+
+  dlen = g_type_size[type] * d;
+
+#ifndef CONFIG_LOGGING_NXSCOPE_DISABLE_PUTLOCK
+  nxscope_lock(s);
+#endif
+
+  /* Validate channel once for the whole block */
+
+  cnt = nxscope_ch_validate_block(s, ch, type, d, n, &first, &step);
+  if (cnt <= 0)
+    {
+      ret = cnt;
+      goto errout;
+    }
+
+  src += first * dlen;
+
+#ifdef CONFIG_LOGGING_NXSCOPE_CRICHANNELS
+  utype.u8 = type;
+  if (utype.s.cri)
+    {
+      /* Send each sample without buffering */
+
+      for (; cnt > 0; cnt--, src += step * dlen)
+        {
+          tmp = 0;
+          s->cribuf[tmp++] = ch;
+          memcpy(&s->cribuf[tmp], src, dlen);
+          tmp += dlen;
+
+          ret = nxscope_stream_send(s, s->cribuf, &tmp);
+          if (ret < 0)
+            {
+              _err("ERROR: nxscope_stream_send failed %d\n", ret);
+              goto errout;
+            }
+        }
+
+      goto errout;
+    }
+#endif
+
+#ifndef CONFIG_LOGGING_NXSCOPE_LOCKFREE
+  /* Put as many samples as fit in the stream buffer */
+
+  if (s->stream_i + s->proto_stream->footlen < s->streambuf_len)
+    {
+      space = ((s->streambuf_len - s->proto_stream->footlen - s->stream_i) /
+               (1 + dlen));
+    }
+
+  if (space < (size_t)cnt)
+    {
+      _err("ERROR: no space for data %zu\n", s->stream_i);
+      nxscope_stream_overflow(s);
+      ret = -ENOBUFS;
+      cnt = space;
+    }
+
+  for (; cnt > 0; cnt--, src += step * dlen)
+    {
+      s->streambuf[s->stream_i++] = ch;
+      memcpy(&s->streambuf[s->stream_i], src, dlen);
+      s->stream_i += dlen;
+    }
+#else
+  UNUSED(space);
+#endif
+
+errout:
+#ifndef CONFIG_LOGGING_NXSCOPE_DISABLE_PUTLOCK
+  nxscope_unlock(s);
+#endif
+
+  return ret;
+}
+
 /****************************************************************************
  * Public Functions
  ****************************************************************************/
@@ -667,6 +977,40 @@ errout:
 }
 #endif
 
+#ifdef CONFIG_LOGGING_NXSCOPE_LOCKFREE
+/****************************************************************************
+ * Name: nxscope_chan_ovf
+ *
+ * Description:
+ *   Get the number of samples dropped for a given channel because its
+ *   sample ring was full
+ *
+ * Input Parameters:
+ *   s   - a pointer to a nxscope instance
+ *   ch  - a channel id
+ *   ovf - a pointer to the returned overflow counter
+ *
+ ****************************************************************************/
+
+int nxscope_chan_ovf(FAR struct nxscope_s *s, uint8_t ch,
+                     FAR uint32_t *ovf)
+{
+  DEBUGASSERT(s);
+  DEBUGASSERT(ovf);
+
+  if (ch >= s->cmninfo.chmax)
+    {
+      _err("ERROR: invalid channel %d\n", ch);
+      return -EINVAL;
+    }
+
+  *ovf = atomic_load_explicit(&s->chring[ch].overflow,
+                              memory_order_relaxed);
+
+  return OK;
+}
+#endif
+
 /****************************************************************************
  * Name: nxscope_chan_all_en
  *
@@ -1507,3 +1851,178 @@ int nxscope_put_char(FAR struct nxscope_s *s, uint8_t ch, char val)
 {
   return nxscope_put_vchar(s, ch, &val, 1);
 }
+
+/****************************************************************************
+ * Name: nxscope_put_block_XXXX
+ *
+ * Description:
+ *   Put a block of vectors on the stream buffer
+ *
+ * Input Parameters:
+ *   s   - a pointer to a nxscope instance
+ *   ch  - a channel id
+ *   val - a pointer to n sample data vectors
+ *   d   - a dimmention of sample data vector
+ *   n   - a number of samples
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: nxscope_put_block_uint8
+ ****************************************************************************/
+
+int nxscope_put_block_uint8(FAR struct nxscope_s *s, uint8_t ch,
+                            FAR uint8_t *val, uint8_t d, size_t n)
+{
+  return nxscope_put_block_common(s, NXSCOPE_TYPE_UINT8, ch, val, d, n);
+}
+
+/****************************************************************************
+ * Name: nxscope_put_block_int8
+ ****************************************************************************/
+
+int nxscope_put_block_int8(FAR struct nxscope_s *s, uint8_t ch,
+                           FAR int8_t *val, uint8_t d, size_t n)
+{
+  return nxscope_put_block_common(s, NXSCOPE_TYPE_INT8, ch, val, d, n);
+}
+
+/****************************************************************************
+ * Name: nxscope_put_block_uint16
+ ****************************************************************************/
+
+int nxscope_put_block_uint16(FAR struct nxscope_s *s, uint8_t ch,
+                             FAR uint16_t *val, uint8_t d, size_t n)
+{
+  return nxscope_put_block_common(s, NXSCOPE_TYPE_UINT16, ch, val, d, n);
+}
+
+/****************************************************************************
+ * Name: nxscope_put_block_int16
+ ****************************************************************************/
+
+int nxscope_put_block_int16(FAR struct nxscope_s *s, uint8_t ch,
+                            FAR int16_t *val, uint8_t d, size_t n)
+{
+  return nxscope_put_block_common(s, NXSCOPE_TYPE_INT16, ch, val, d, n);
+}
+
+/****************************************************************************
+ * Name: nxscope_put_block_uint32
+ ****************************************************************************/
+
+int nxscope_put_block_uint32(FAR struct nxscope_s *s, uint8_t ch,
+                             FAR uint32_t *val, uint8_t d, size_t n)
+{
+  return nxscope_put_block_common(s, NXSCOPE_TYPE_UINT32, ch, val, d, n);
+}
+
+/****************************************************************************
+ * Name: nxscope_put_block_int32
+ ****************************************************************************/
+
+int nxscope_put_block_int32(FAR struct nxscope_s *s, uint8_t ch,
+                            FAR int32_t *val, uint8_t d, size_t n)
+{
+  return nxscope_put_block_common(s, NXSCOPE_TYPE_INT32, ch, val, d, n);
+}
+
+/****************************************************************************
+ * Name: nxscope_put_block_uint64
+ ****************************************************************************/
+
+int nxscope_put_block_uint64(FAR struct nxscope_s *s, uint8_t ch,
+                             FAR uint64_t *val, uint8_t d, size_t n)
+{
+  return nxscope_put_block_common(s, NXSCOPE_TYPE_UINT64, ch, val, d, n);
+}
+
+/****************************************************************************
+ * Name: nxscope_put_block_int64
+ ****************************************************************************/
+
+int nxscope_put_block_int64(FAR struct nxscope_s *s, uint8_t ch,
+                            FAR int64_t *val, uint8_t d, size_t n)
+{
+  return nxscope_put_block_common(s, NXSCOPE_TYPE_INT64, ch, val, d, n);
+}
+
+/****************************************************************************
+ * Name: nxscope_put_block_float
+ ****************************************************************************/
+
+int nxscope_put_block_float(FAR struct nxscope_s *s, uint8_t ch,
+                            FAR float *val, uint8_t d, size_t n)
+{
+  return nxscope_put_block_common(s, NXSCOPE_TYPE_FLOAT, ch, val, d, n);
+}
+
+/****************************************************************************
+ * Name: nxscope_put_block_double
+ ****************************************************************************/
+
+int nxscope_put_block_double(FAR struct nxscope_s *s, uint8_t ch,
+                             FAR double *val, uint8_t d, size_t n)
+{
+  return nxscope_put_block_common(s, NXSCOPE_TYPE_DOUBLE, ch, val, d, n);
+}
+
+/****************************************************************************
+ * Name: nxscope_put_block_ub8
+ ****************************************************************************/
+
+int nxscope_put_block_ub8(FAR struct nxscope_s *s, uint8_t ch,
+                          FAR ub8_t *val, uint8_t d, size_t n)
+{
+  return nxscope_put_block_common(s, NXSCOPE_TYPE_UB8, ch, val, d, n);
+}
+
+/****************************************************************************
+ * Name: nxscope_put_block_b8
+ ****************************************************************************/
+
+int nxscope_put_block_b8(FAR struct nxscope_s *s, uint8_t ch,
+                         FAR b8_t *val, uint8_t d, size_t n)
+{
+  return nxscope_put_block_common(s, NXSCOPE_TYPE_B8, ch, val, d, n);
+}
+
+/****************************************************************************
+ * Name: nxscope_put_block_ub16
+ ****************************************************************************/
+
+int nxscope_put_block_ub16(FAR struct nxscope_s *s, uint8_t ch,
+                           FAR ub16_t *val, uint8_t d, size_t n)
+{
+  return nxscope_put_block_common(s, NXSCOPE_TYPE_UB16, ch, val, d, n);
+}
+
+/****************************************************************************
+ * Name: nxscope_put_block_b16
+ ****************************************************************************/
+
+int nxscope_put_block_b16(FAR struct nxscope_s *s, uint8_t ch,
+                          FAR b16_t *val, uint8_t d, size_t n)
+{
+  return nxscope_put_block_common(s, NXSCOPE_TYPE_B16, ch, val, d, n);
+}
+
+/****************************************************************************
+ * Name: nxscope_put_block_ub32
+ ****************************************************************************/
+
+int nxscope_put_block_ub32(FAR struct nxscope_s *s, uint8_t ch,
+                           FAR ub32_t *val, uint8_t d, size_t n)
+{
+  return nxscope_put_block_common(s, NXSCOPE_TYPE_UB32, ch, val, d, n);
+}
+
+/****************************************************************************
+ * Name: nxscope_put_block_b32
+ ****************************************************************************/
+
+int nxscope_put_block_b32(FAR struct nxscope_s *s, uint8_t ch,
+                          FAR b32_t *val, uint8_t d, size_t n)
+{
+  return nxscope_put_block_common(s, NXSCOPE_TYPE_B32, ch, val, d, n);
+}
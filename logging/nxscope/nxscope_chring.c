@@ -0,0 +1,273 @@
+/****************************************************************************
+ * apps/logging/nxscope/nxscope_chring.c
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <assert.h>
+#include <debug.h>
+#include <errno.h>
+#include <string.h>
+#include <stdlib.h>
+
+#include <logging/nxscope/nxscope.h>
+
+#include "nxscope_internals.h"
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+/* Each ring record is a 2 bytes length followed by a sample in the stream
+ * format. A record never wraps around the ring end, the remaining space is
+ * skipped with a padding record instead.
+ */
+
+#define CHRING_LEN           CONFIG_LOGGING_NXSCOPE_CHRING_LEN
+#define CHRING_MASK          (CHRING_LEN - 1)
+#define CHRING_HDR           (sizeof(uint16_t))
+#define CHRING_PAD           (0xffff)
+
+#if (CHRING_LEN & CHRING_MASK) != 0
+#  error CONFIG_LOGGING_NXSCOPE_CHRING_LEN must be a power of two
+#endif
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: nxscope_chring_len
+ ****************************************************************************/
+
+static void nxscope_chring_len(FAR uint8_t *buff, uint16_t len)
+{
+  memcpy(buff, &len, CHRING_HDR);
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: nxscope_chring_init
+ *
+ * Description:
+ *   Allocate the per-channel sample rings
+ *
+ ****************************************************************************/
+
+int nxscope_chring_init(FAR struct nxscope_s *s, uint8_t channels)
+{
+  int i;
+
+  DEBUGASSERT(s);
+
+  s->chring = zalloc(channels * sizeof(struct nxscope_chring_s));
+  if (s->chring == NULL)
+    {
+      return -ENOMEM;
+    }
+
+  for (i = 0; i < channels; i++)
+    {
+      s->chring[i].buf = malloc(CHRING_LEN);
+      if (s->chring[i].buf == NULL)
+        {
+          nxscope_chring_deinit(s, i);
+          return -ENOMEM;
+        }
+    }
+
+  return OK;
+}
+
+/****************************************************************************
+ * Name: nxscope_chring_deinit
+ *
+ * Description:
+ *   Free the per-channel sample rings
+ *
+ ****************************************************************************/
+
+void nxscope_chring_deinit(FAR struct nxscope_s *s, uint8_t channels)
+{
+  int i;
+
+  DEBUGASSERT(s);
+
+  if (s->chring == NULL)
+    {
+      return;
+    }
+
+  for (i = 0; i < channels; i++)
+    {
+      free(s->chring[i].buf);
+    }
+
+  free(s->chring);
+  s->chring = NULL;
+}
+
+/****************************************************************************
+ * Name: nxscope_chring_reserve
+ *
+ * Description:
+ *   Reserve space for one sample in a channel ring. Called only by the
+ *   channel producer, never blocks.
+ *
+ * Returned Value:
+ *   A pointer to len bytes of the ring or NULL if the ring is full, in
+ *   which case the channel overflow counter is incremented.
+ *
+ ****************************************************************************/
+
+FAR uint8_t *nxscope_chring_reserve(FAR struct nxscope_s *s, uint8_t ch,
+                                    size_t len)
+{
+  FAR struct nxscope_chring_s *ring = &s->chring[ch];
+  uint32_t head;
+  uint32_t tail;
+  size_t   contig;
+  size_t   need;
+
+  head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+  tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+
+  need   = CHRING_HDR + len;
+  contig = CHRING_LEN - (head & CHRING_MASK);
+
+  /* Skip the end of the ring if the record does not fit there */
+
+  if (contig < need)
+    {
+      need += contig;
+    }
+
+  if (CHRING_LEN - (head - tail) < need)
+    {
+      atomic_fetch_add_explicit(&ring->overflow, 1, memory_order_relaxed);
+      return NULL;
+    }
+
+  if (contig < CHRING_HDR + len)
+    {
+      if (contig >= CHRING_HDR)
+        {
+          nxscope_chring_len(&ring->buf[head & CHRING_MASK], CHRING_PAD);
+        }
+
+      head += contig;
+    }
+
+  nxscope_chring_len(&ring->buf[head & CHRING_MASK], len);
+  ring->reserved = head + CHRING_HDR + len;
+
+  return &ring->buf[(head + CHRING_HDR) & CHRING_MASK];
+}
+
+/****************************************************************************
+ * Name: nxscope_chring_commit
+ *
+ * Description:
+ *   Publish the sample reserved with nxscope_chring_reserve()
+ *
+ ****************************************************************************/
+
+void nxscope_chring_commit(FAR struct nxscope_s *s, uint8_t ch)
+{
+  FAR struct nxscope_chring_s *ring = &s->chring[ch];
+
+  atomic_store_explicit(&ring->head, ring->reserved, memory_order_release);
+}
+
+/****************************************************************************
+ * Name: nxscope_chring_drain
+ *
+ * Description:
+ *   Move samples from the channel rings to the stream buffer. Samples that
+ *   do not fit stay in their ring until the next call.
+ *
+ * NOTE: This function assumes that we have exclusive access to the nxscope
+ *       instance
+ *
+ ****************************************************************************/
+
+void nxscope_chring_drain(FAR struct nxscope_s *s)
+{
+  FAR struct nxscope_chring_s *ring;
+  uint32_t head;
+  uint32_t tail;
+  uint32_t overflow;
+  uint16_t len;
+  int      ch;
+
+  DEBUGASSERT(s);
+
+  for (ch = 0; ch < s->cmninfo.chmax; ch++)
+    {
+      ring = &s->chring[ch];
+      head = atomic_load_explicit(&ring->head, memory_order_acquire);
+      tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+
+      while (tail != head)
+        {
+          if (CHRING_LEN - (tail & CHRING_MASK) < CHRING_HDR)
+            {
+              tail += CHRING_LEN - (tail & CHRING_MASK);
+              continue;
+            }
+
+          memcpy(&len, &ring->buf[tail & CHRING_MASK], CHRING_HDR);
+          if (len == CHRING_PAD)
+            {
+              tail += CHRING_LEN - (tail & CHRING_MASK);
+              continue;
+            }
+
+          if (s->stream_i + len + s->proto_stream->footlen >
+              s->streambuf_len)
+            {
+              break;
+            }
+
+          memcpy(&s->streambuf[s->stream_i],
+                 &ring->buf[(tail + CHRING_HDR) & CHRING_MASK], len);
+          s->stream_i += len;
+          tail        += CHRING_HDR + len;
+        }
+
+      atomic_store_explicit(&ring->tail, tail, memory_order_release);
+
+      /* Report producer overflows with the stream overflow flag too */
+
+      overflow = atomic_load_explicit(&ring->overflow, memory_order_relaxed);
+      if (overflow != ring->overflow_seen)
+        {
+          ring->overflow_seen = overflow;
+          s->streambuf[s->proto_stream->hdrlen] |=
+            NXSCOPE_STREAM_FLAGS_OVERFLOW;
+        }
+    }
+}
@@ -49,6 +49,14 @@
 #define INTF_RECV(s, intf, buff, i)             \
   (s)->intf_stream->ops->recv(intf, buff, i)
 
+/****************************************************************************
+ * Public Data
+ ****************************************************************************/
+
+/* Size of the channel data types (enum nxscope_sample_dtype_e) */
+
+extern int g_type_size[];
+
 /****************************************************************************
  * Public Function Puttypes
  ****************************************************************************/
@@ -69,4 +77,104 @@
 int nxscope_stream_send(FAR struct nxscope_s *s, FAR uint8_t *buff,
                         FAR size_t *buff_i);
 
+#ifdef CONFIG_LOGGING_NXSCOPE_LOCKFREE
+/****************************************************************************
+ * Name: nxscope_chring_init
+ *
+ * Description:
+ *   Allocate the per-channel sample rings
+ *
+ ****************************************************************************/
+
+int nxscope_chring_init(FAR struct nxscope_s *s, uint8_t channels);
+
+/****************************************************************************
+ * Name: nxscope_chring_deinit
+ *
+ * Description:
+ *   Free the per-channel sample rings
+ *
+ ****************************************************************************/
+
+void nxscope_chring_deinit(FAR struct nxscope_s *s, uint8_t channels);
+
+/****************************************************************************
+ * Name: nxscope_chring_reserve
+ *
+ * Description:
+ *   Reserve space for one sample in a channel ring
+ *
+ * Input Parameters:
+ *   s   - a pointer to a nxscope instance
+ *   ch  - a channel id
+ *   len - a sample length
+ *
+ ****************************************************************************/
+
+FAR uint8_t *nxscope_chring_reserve(FAR struct nxscope_s *s, uint8_t ch,
+                                    size_t len);
+
+/****************************************************************************
+ * Name: nxscope_chring_commit
+ *
+ * Description:
+ *   Publish the sample reserved with nxscope_chring_reserve()
+ *
+ * Input Parameters:
+ *   s  - a pointer to a nxscope instance
+ *   ch - a channel id
+ *
+ ****************************************************************************/
+
+void nxscope_chring_commit(FAR struct nxscope_s *s, uint8_t ch);
+
+/****************************************************************************
+ * Name: nxscope_chring_drain
+ *
+ * Description:
+ *   Move samples from the channel rings to the stream buffer
+ *
+ * Input Parameters:
+ *   s - a pointer to a nxscope instance
+ *
+ ****************************************************************************/
+
+void nxscope_chring_drain(FAR struct nxscope_s *s);
+#endif
+
+#ifdef CONFIG_LOGGING_NXSCOPE_PACKED
+/****************************************************************************
+ * Name: nxscope_pack_init
+ *
+ * Description:
+ *   Allocate the packed stream buffer
+ *
+ ****************************************************************************/
+
+int nxscope_pack_init(FAR struct nxscope_s *s);
+
+/****************************************************************************
+ * Name: nxscope_pack_deinit
+ *
+ * Description:
+ *   Free the packed stream buffer
+ *
+ ****************************************************************************/
+
+void nxscope_pack_deinit(FAR struct nxscope_s *s);
+
+/****************************************************************************
+ * Name: nxscope_pack_stream
+ *
+ * Description:
+ *   Pack the stream buffer into the packed stream buffer
+ *
+ * Input Parameters:
+ *   s - a pointer to a nxscope instance
+ *
+ ****************************************************************************/
+
+int nxscope_pack_stream(FAR struct nxscope_s *s);
+#endif
+
 #endif  /* __APPS_LOGGING_NXSCOPE_NXSCOPE_INTERNALS_H */
@@ -0,0 +1,422 @@
+/****************************************************************************
+ * apps/logging/nxscope/nxscope_pack.c
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <assert.h>
+#include <debug.h>
+#include <errno.h>
+#include <string.h>
+#include <stdlib.h>
+
+#include <logging/nxscope/nxscope.h>
+
+#include "nxscope_internals.h"
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+/* Max samples in a packed block */
+
+#define PACK_BLOCK_MAX       (UINT8_MAX)
+
+/* Packed block header: channel id + number of samples */
+
+#define PACK_BLOCK_HDR       (2)
+
+/****************************************************************************
+ * Private Types
+ ****************************************************************************/
+
+#ifdef CONFIG_HAVE_LONG_LONG
+typedef uint64_t pack_uint_t;
+typedef int64_t  pack_int_t;
+#else
+typedef uint32_t pack_uint_t;
+typedef int32_t  pack_int_t;
+#endif
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: nxscope_pack_delta
+ *
+ * Description:
+ *   Return true if a given type is delta encoded
+ *
+ ****************************************************************************/
+
+static bool nxscope_pack_delta(uint8_t dtype)
+{
+  switch (dtype)
+    {
+      case NXSCOPE_TYPE_UINT8:
+      case NXSCOPE_TYPE_INT8:
+      case NXSCOPE_TYPE_UINT16:
+      case NXSCOPE_TYPE_INT16:
+      case NXSCOPE_TYPE_UINT32:
+      case NXSCOPE_TYPE_INT32:
+      case NXSCOPE_TYPE_UB8:
+      case NXSCOPE_TYPE_B8:
+      case NXSCOPE_TYPE_UB16:
+      case NXSCOPE_TYPE_B16:
+#ifdef CONFIG_HAVE_LONG_LONG
+      case NXSCOPE_TYPE_UINT64:
+      case NXSCOPE_TYPE_INT64:
+      case NXSCOPE_TYPE_UB32:
+      case NXSCOPE_TYPE_B32:
+#endif
+        {
+          return true;
+        }
+
+      default:
+        {
+          return false;
+        }
+    }
+}
+
+/****************************************************************************
+ * Name: nxscope_pack_type_size
+ ****************************************************************************/
+
+static size_t nxscope_pack_type_size(FAR struct nxscope_chinfo_s *chinfo)
+{
+#ifdef CONFIG_LOGGING_NXSCOPE_USERTYPES
+  if (chinfo->type.s.dtype >= NXSCOPE_TYPE_USER)
+    {
+      return 1;
+    }
+#endif
+
+  return g_type_size[chinfo->type.s.dtype];
+}
+
+/****************************************************************************
+ * Name: nxscope_pack_get
+ *
+ * Description:
+ *   Get a little-endian value of a given size
+ *
+ ****************************************************************************/
+
+static pack_uint_t nxscope_pack_get(FAR const uint8_t *buff, size_t size)
+{
+  pack_uint_t val = 0;
+
+  while (size-- > 0)
+    {
+      val = (val << 8) | buff[size];
+    }
+
+  return val;
+}
+
+/****************************************************************************
+ * Name: nxscope_pack_varint
+ *
+ * Description:
+ *   Put a zig-zag varint of the difference between two values of a given
+ *   size.
+ *
+ * Returned Value:
+ *   Number of bytes written or 0 if there is no space left.
+ *
+ ****************************************************************************/
+
+static size_t nxscope_pack_varint(FAR uint8_t *buff, size_t space,
+                                  pack_uint_t cur, pack_uint_t prev,
+                                  size_t size)
+{
+  const int   shift = (sizeof(pack_uint_t) - size) * 8;
+  pack_int_t  delta;
+  pack_uint_t zz;
+  size_t      i = 0;
+
+  /* Wrap the difference to the type width and sign-extend it */
+
+  delta = (pack_int_t)((cur - prev) << shift) >> shift;
+
+  /* Zig-zag: small negative differences give small codes too */
+
+  zz = ((pack_uint_t)delta << 1) ^
+       (pack_uint_t)(delta >> (sizeof(pack_uint_t) * 8 - 1));
+
+  do
+    {
+      if (i >= space)
+        {
+          return 0;
+        }
+
+      buff[i++] = (zz & 0x7f) | (zz > 0x7f ? 0x80 : 0);
+      zz >>= 7;
+    }
+  while (zz != 0);
+
+  return i;
+}
+
+/****************************************************************************
+ * Name: nxscope_pack_sample
+ *
+ * Description:
+ *   Pack one sample, prev points to the previous sample data of the same
+ *   channel in the block or NULL for the first sample in the block.
+ *
+ * Returned Value:
+ *   Number of bytes written or 0 if there is no space left.
+ *
+ ****************************************************************************/
+
+static size_t nxscope_pack_sample(FAR struct nxscope_chinfo_s *chinfo,
+                                  FAR uint8_t *buff, size_t space,
+                                  FAR const uint8_t *cur,
+                                  FAR const uint8_t *prev)
+{
+  size_t size  = nxscope_pack_type_size(chinfo);
+  size_t dlen  = size * chinfo->vdim;
+  size_t j     = 0;
+  size_t n     = 0;
+  int    i     = 0;
+
+  if (!nxscope_pack_delta(chinfo->type.s.dtype))
+    {
+      /* Raw sample data and metadata */
+
+      if (dlen + chinfo->mlen > space)
+        {
+          return 0;
+        }
+
+      memcpy(buff, cur, dlen + chinfo->mlen);
+      return dlen + chinfo->mlen;
+    }
+
+  for (i = 0; i < chinfo->vdim; i++)
+    {
+      n = nxscope_pack_varint(&buff[j], space - j,
+                              nxscope_pack_get(&cur[i * size], size),
+                              prev ? nxscope_pack_get(&prev[i * size],
+                                                      size) : 0,
+                              size);
+      if (n == 0)
+        {
+          return 0;
+        }
+
+      j += n;
+    }
+
+  /* Metadata not encoded */
+
+  if (j + chinfo->mlen > space)
+    {
+      return 0;
+    }
+
+  memcpy(&buff[j], &cur[dlen], chinfo->mlen);
+
+  return j + chinfo->mlen;
+}
+
+/****************************************************************************
+ * Name: nxscope_pack_sample_len
+ ****************************************************************************/
+
+static size_t nxscope_pack_sample_len(FAR struct nxscope_s *s, uint8_t ch)
+{
+  FAR struct nxscope_chinfo_s *chinfo = &s->chinfo[ch];
+
+  return 1 + nxscope_pack_type_size(chinfo) * chinfo->vdim + chinfo->mlen;
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: nxscope_pack_init
+ ****************************************************************************/
+
+int nxscope_pack_init(FAR struct nxscope_s *s)
+{
+  DEBUGASSERT(s);
+
+  s->packbuf = zalloc(s->streambuf_len);
+  if (s->packbuf == NULL)
+    {
+      return -ENOMEM;
+    }
+
+  s->pack_i = 0;
+  s->packed = false;
+
+  return OK;
+}
+
+/****************************************************************************
+ * Name: nxscope_pack_deinit
+ ****************************************************************************/
+
+void nxscope_pack_deinit(FAR struct nxscope_s *s)
+{
+  DEBUGASSERT(s);
+
+  if (s->packbuf != NULL)
+    {
+      free(s->packbuf);
+      s->packbuf = NULL;
+    }
+}
+
+/****************************************************************************
+ * Name: nxscope_pack_stream
+ *
+ * Description:
+ *   Pack the stream buffer into the pack buffer. Samples are grouped in
+ *   blocks of one channel, each channel is collected with one pass over
+ *   the stream buffer starting from its first sample.
+ *
+ * Returned Value:
+ *   OK and s->pack_i set on success, a negated errno value if the packed
+ *   frame would not be shorter than the raw frame or the stream buffer is
+ *   not valid. In that case the raw frame should be send.
+ *
+ * NOTE: This function assumes that we have exclusive access to the nxscope
+ *       instance
+ *
+ ****************************************************************************/
+
+int nxscope_pack_stream(FAR struct nxscope_s *s)
+{
+  FAR struct nxscope_chinfo_s *chinfo;
+  FAR const uint8_t           *prev;
+  FAR uint8_t                 *nsamples;
+  const size_t                 start = s->proto_stream->hdrlen + 1;
+  const size_t                 limit = s->stream_i;
+  size_t                       first = start;
+  size_t                       next  = 0;
+  size_t                       len   = 0;
+  size_t                       i     = 0;
+  size_t                       j     = start;
+  size_t                       n     = 0;
+  uint32_t                     done[256 / 32];
+  uint8_t                      ch    = 0;
+
+  DEBUGASSERT(s);
+  DEBUGASSERT(s->packbuf);
+
+  /* The same flags as the raw frame */
+
+  s->packbuf[s->proto_stream->hdrlen] =
+    s->streambuf[s->proto_stream->hdrlen] | NXSCOPE_STREAM_FLAGS_PACKED;
+
+  /* Samples before 'first' belong to channels already packed */
+
+  memset(done, 0, sizeof(done));
+
+  while (first < limit)
+    {
+      ch = s->streambuf[first];
+      if (ch >= s->cmninfo.chmax)
+        {
+          return -EINVAL;
+        }
+
+      chinfo   = &s->chinfo[ch];
+      prev     = NULL;
+      nsamples = NULL;
+      next     = 0;
+
+      done[ch / 32] |= (1u << (ch % 32));
+
+      for (i = first; i < limit; i += len)
+        {
+          if (s->streambuf[i] >= s->cmninfo.chmax)
+            {
+              return -EINVAL;
+            }
+
+          len = nxscope_pack_sample_len(s, s->streambuf[i]);
+          if (i + len > limit)
+            {
+              return -EINVAL;
+            }
+
+          if (s->streambuf[i] != ch)
+            {
+              /* First sample of another channel not packed yet */
+
+              if (next == 0 &&
+                  (done[s->streambuf[i] / 32] &
+                   (1u << (s->streambuf[i] % 32))) == 0)
+                {
+                  next = i;
+                }
+
+              continue;
+            }
+
+          /* Start a new block */
+
+          if (nsamples == NULL || *nsamples == PACK_BLOCK_MAX)
+            {
+              if (j + PACK_BLOCK_HDR >= limit)
+                {
+                  return -E2BIG;
+                }
+
+              s->packbuf[j++] = ch;
+              nsamples        = &s->packbuf[j++];
+              *nsamples       = 0;
+              prev            = NULL;
+            }
+
+          n = nxscope_pack_sample(chinfo, &s->packbuf[j], limit - j,
+                                  &s->streambuf[i + 1],
+                                  prev != NULL ? prev + 1 : NULL);
+          if (n == 0)
+            {
+              return -E2BIG;
+            }
+
+          j         += n;
+          prev       = &s->streambuf[i];
+          *nsamples += 1;
+        }
+
+      /* Continue with the first channel not packed yet */
+
+      first = next != 0 ? next : limit;
+    }
+
+  s->pack_i = j;
+
+  return OK;
+}
@@ -76,7 +76,8 @@ eMBException prveMBError2Exception(eMBErrorCode eErrorCode);
 
 #ifdef CONFIG_MB_FUNC_READ_COILS_ENABLED
 
-eMBException eMBFuncReadCoils(uint8_t *pucFrame, uint16_t *usLen)
+eMBException eMBFuncReadCoils(xMBInstance *pxInst, uint8_t *pucFrame,
+                              uint16_t *usLen)
 {
   uint16_t usRegAddress;
   uint16_t usCoilCount;
@@ -128,8 +129,8 @@ eMBException eMBFuncReadCoils(uint8_t *pucFrame, uint16_t *usLen)
           *pucFrameCur++ = ucNBytes;
           *usLen += 1;
 
-          eRegStatus = eMBRegCoilsCB(pucFrameCur, usRegAddress, usCoilCount,
-                                     MB_REG_READ);
+          eRegStatus = eMBRegCoilsCB(pxInst, pucFrameCur, usRegAddress,
+                                     usCoilCount, MB_REG_READ);
 
           /* If an error occurred convert it into a Modbus exception. */
 
@@ -165,7 +166,8 @@ eMBException eMBFuncReadCoils(uint8_t *pucFrame, uint16_t *usLen)
 }
 
 #ifdef CONFIG_MB_FUNC_WRITE_COIL_ENABLED
-eMBException eMBFuncWriteCoil(uint8_t *pucFrame, uint16_t *usLen)
+eMBException eMBFuncWriteCoil(xMBInstance *pxInst, uint8_t *pucFrame,
+                              uint16_t *usLen)
 {
   uint16_t usRegAddress;
   uint8_t ucBuf[2];
@@ -193,7 +195,7 @@ eMBException eMBFuncWriteCoil(uint8_t *pucFrame, uint16_t *usLen)
               ucBuf[0] = 0;
             }
 
-          eRegStatus = eMBRegCoilsCB(&ucBuf[0], usRegAddress, 1,
+          eRegStatus = eMBRegCoilsCB(pxInst, &ucBuf[0], usRegAddress, 1,
                                      MB_REG_WRITE);
 
           /* If an error occurred convert it into a Modbus exception. */
@@ -223,7 +225,8 @@ eMBException eMBFuncWriteCoil(uint8_t *pucFrame, uint16_t *usLen)
 #endif
 
 #ifdef CONFIG_MB_FUNC_WRITE_MULTIPLE_COILS_ENABLED
-eMBException eMBFuncWriteMultipleCoils(uint8_t *pucFrame, uint16_t *usLen)
+eMBException eMBFuncWriteMultipleCoils(xMBInstance *pxInst, uint8_t *pucFrame,
+                                       uint16_t *usLen)
 {
   uint16_t usRegAddress;
   uint16_t usCoilCnt;
@@ -260,7 +263,8 @@ eMBException eMBFuncWriteMultipleCoils(uint8_t *pucFrame, uint16_t *usLen)
           (ucByteCountVerify == ucByteCount))
         {
           eRegStatus =
-            eMBRegCoilsCB(&pucFrame[MB_PDU_FUNC_WRITE_MUL_VALUES_OFF],
+            eMBRegCoilsCB(pxInst,
+                          &pucFrame[MB_PDU_FUNC_WRITE_MUL_VALUES_OFF],
                           usRegAddress, usCoilCnt, MB_REG_WRITE);
 
           /* If an error occurred convert it into a Modbus exception. */
@@ -63,7 +63,8 @@ eMBException prveMBError2Exception(eMBErrorCode eErrorCode);
  ****************************************************************************/
 
 #ifdef CONFIG_MB_FUNC_READ_DISCRETE_INPUTS_ENABLED
-eMBException eMBFuncReadDiscreteInputs(uint8_t *pucFrame, uint16_t *usLen)
+eMBException eMBFuncReadDiscreteInputs(xMBInstance *pxInst, uint8_t *pucFrame,
+                                       uint16_t *usLen)
 {
   uint16_t usRegAddress;
   uint16_t usDiscreteCnt;
@@ -115,7 +116,7 @@ eMBException eMBFuncReadDiscreteInputs(uint8_t *pucFrame, uint16_t *usLen)
           *pucFrameCur++ = ucNBytes;
           *usLen += 1;
 
-          eRegStatus = eMBRegDiscreteCB(pucFrameCur, usRegAddress,
+          eRegStatus = eMBRegDiscreteCB(pxInst, pucFrameCur, usRegAddress,
                                         usDiscreteCnt);
 
           /* If an error occurred convert it into a Modbus exception. */
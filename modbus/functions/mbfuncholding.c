@@ -82,7 +82,9 @@ eMBException prveMBError2Exception(eMBErrorCode eErrorCode);
  ****************************************************************************/
 
 #ifdef CONFIG_MB_FUNC_WRITE_HOLDING_ENABLED
-eMBException eMBFuncWriteHoldingRegister(uint8_t *pucFrame, uint16_t *usLen)
+eMBException eMBFuncWriteHoldingRegister(xMBInstance *pxInst,
+                                         uint8_t *pucFrame,
+                                         uint16_t *usLen)
 {
   uint16_t usRegAddress;
   eMBException eStatus = MB_EX_NONE;
@@ -96,7 +98,8 @@ eMBException eMBFuncWriteHoldingRegister(uint8_t *pucFrame, uint16_t *usLen)
 
       /* Make callback to update the value. */
 
-      eRegStatus = eMBRegHoldingCB(&pucFrame[MB_PDU_FUNC_WRITE_VALUE_OFF],
+      eRegStatus = eMBRegHoldingCB(pxInst,
+                                   &pucFrame[MB_PDU_FUNC_WRITE_VALUE_OFF],
                                    usRegAddress, 1, MB_REG_WRITE);
 
       /* If an error occurred convert it into a Modbus exception. */
@@ -118,7 +121,9 @@ eMBException eMBFuncWriteHoldingRegister(uint8_t *pucFrame, uint16_t *usLen)
 #endif
 
 #ifdef CONFIG_MB_FUNC_WRITE_MULTIPLE_HOLDING_ENABLED
-eMBException eMBFuncWriteMultipleHoldingRegister(uint8_t *pucFrame, uint16_t *usLen)
+eMBException eMBFuncWriteMultipleHoldingRegister(xMBInstance *pxInst,
+                                                 uint8_t *pucFrame,
+                                                 uint16_t *usLen)
 {
   uint16_t usRegAddress;
   uint16_t usRegCount;
@@ -145,7 +150,8 @@ eMBException eMBFuncWriteMultipleHoldingRegister(uint8_t *pucFrame, uint16_t *us
           /* Make callback to update the register values. */
 
           eRegStatus =
-            eMBRegHoldingCB(&pucFrame[MB_PDU_FUNC_WRITE_MUL_VALUES_OFF],
+            eMBRegHoldingCB(pxInst,
+                            &pucFrame[MB_PDU_FUNC_WRITE_MUL_VALUES_OFF],
                             usRegAddress, usRegCount, MB_REG_WRITE);
 
           /* If an error occurred convert it into a Modbus exception. */
@@ -181,7 +187,9 @@ eMBException eMBFuncWriteMultipleHoldingRegister(uint8_t *pucFrame, uint16_t *us
 #endif
 
 #ifdef CONFIG_MB_FUNC_READ_HOLDING_ENABLED
-eMBException eMBFuncReadHoldingRegister(uint8_t * pucFrame, uint16_t * usLen)
+eMBException eMBFuncReadHoldingRegister(xMBInstance *pxInst,
+                                        uint8_t *pucFrame,
+                                        uint16_t *usLen)
 {
   uint16_t usRegAddress;
   uint16_t usRegCount;
@@ -222,7 +230,8 @@ eMBException eMBFuncReadHoldingRegister(uint8_t * pucFrame, uint16_t * usLen)
 
           /* Make callback to fill the buffer. */
 
-          eRegStatus = eMBRegHoldingCB(pucFrameCur, usRegAddress, usRegCount, MB_REG_READ);
+          eRegStatus = eMBRegHoldingCB(pxInst, pucFrameCur, usRegAddress,
+                                       usRegCount, MB_REG_READ);
 
           /* If an error occurred convert it into a Modbus exception. */
 
@@ -253,7 +262,9 @@ eMBException eMBFuncReadHoldingRegister(uint8_t * pucFrame, uint16_t * usLen)
 #endif
 
 #ifdef CONFIG_MB_FUNC_READWRITE_HOLDING_ENABLED
-eMBException eMBFuncReadWriteMultipleHoldingRegister(uint8_t *pucFrame, uint16_t *usLen)
+eMBException eMBFuncReadWriteMultipleHoldingRegister(xMBInstance *pxInst,
+                                                     uint8_t *pucFrame,
+                                                     uint16_t *usLen)
 {
   uint16_t usRegReadAddress;
   uint16_t usRegReadCount;
@@ -289,8 +300,11 @@ eMBException eMBFuncReadWriteMultipleHoldingRegister(uint8_t *pucFrame, uint16_t
         {
           /* Make callback to update the register values. */
 
-          eRegStatus = eMBRegHoldingCB(&pucFrame[MB_PDU_FUNC_READWRITE_WRITE_VALUES_OFF],
-                                       usRegWriteAddress, usRegWriteCount, MB_REG_WRITE);
+          eRegStatus =
+            eMBRegHoldingCB(pxInst,
+                            &pucFrame[MB_PDU_FUNC_READWRITE_WRITE_VALUES_OFF],
+                            usRegWriteAddress, usRegWriteCount,
+                            MB_REG_WRITE);
 
           if (eRegStatus == MB_ENOERR)
             {
@@ -311,8 +325,9 @@ eMBException eMBFuncReadWriteMultipleHoldingRegister(uint8_t *pucFrame, uint16_t
 
               /* Make the read callback. */
 
-              eRegStatus = eMBRegHoldingCB(pucFrameCur, usRegReadAddress,
-                                           usRegReadCount, MB_REG_READ);
+              eRegStatus = eMBRegHoldingCB(pxInst, pucFrameCur,
+                                           usRegReadAddress, usRegReadCount,
+                                           MB_REG_READ);
               if (eRegStatus == MB_ENOERR)
                 {
                   *usLen += 2 * usRegReadCount;
@@ -65,7 +65,8 @@ eMBException prveMBError2Exception(eMBErrorCode eErrorCode);
  ****************************************************************************/
 
 #ifdef CONFIG_MB_FUNC_READ_INPUT_ENABLED
-eMBException eMBFuncReadInputRegister(uint8_t *pucFrame, uint16_t *usLen)
+eMBException eMBFuncReadInputRegister(xMBInstance *pxInst, uint8_t *pucFrame,
+                                      uint16_t *usLen)
 {
   uint16_t usRegAddress;
   uint16_t usRegCount;
@@ -105,7 +106,8 @@ eMBException eMBFuncReadInputRegister(uint8_t *pucFrame, uint16_t *usLen)
           *pucFrameCur++ = (uint8_t)(usRegCount * 2);
           *usLen += 1;
 
-          eRegStatus = eMBRegInputCB(pucFrameCur, usRegAddress, usRegCount);
+          eRegStatus = eMBRegInputCB(pxInst, pucFrameCur, usRegAddress,
+                                     usRegCount);
 
           /* If an error occurred convert it into a Modbus exception. */
 
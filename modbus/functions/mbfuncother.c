@@ -45,21 +45,15 @@
 
 #ifdef CONFIG_MB_FUNC_OTHER_REP_SLAVEID_ENABLED
 
-/****************************************************************************
- * Private Data
- ****************************************************************************/
-
-static uint8_t  ucMBSlaveID[CONFIG_MB_FUNC_OTHER_REP_SLAVEID_BUF];
-static uint16_t usMBSlaveIDLen;
-
 /****************************************************************************
  * Public Functions
  ****************************************************************************/
 
-eMBErrorCode eMBSetSlaveID(uint8_t ucSlaveID, bool xIsRunning,
-                           uint8_t const *pucAdditional,
+eMBErrorCode eMBSetSlaveID(xMBInstance *pxInst, uint8_t ucSlaveID,
+                           bool xIsRunning, uint8_t const *pucAdditional,
                            uint16_t usAdditionalLen)
 {
+  uint8_t *ucMBSlaveID = pxInst->ucMBSlaveID;
   eMBErrorCode eStatus = MB_ENOERR;
 
   /* the first byte and second byte in the buffer is reserved for
@@ -69,15 +63,16 @@ eMBErrorCode eMBSetSlaveID(uint8_t ucSlaveID, bool xIsRunning,
 
   if (usAdditionalLen + 2 < CONFIG_MB_FUNC_OTHER_REP_SLAVEID_BUF)
     {
-      usMBSlaveIDLen = 0;
-      ucMBSlaveID[usMBSlaveIDLen++] = ucSlaveID;
-      ucMBSlaveID[usMBSlaveIDLen++] = (uint8_t)(xIsRunning ? 0xFF : 0x00);
+      pxInst->usMBSlaveIDLen = 0;
+      ucMBSlaveID[pxInst->usMBSlaveIDLen++] = ucSlaveID;
+      ucMBSlaveID[pxInst->usMBSlaveIDLen++] =
+        (uint8_t)(xIsRunning ? 0xFF : 0x00);
 
       if (usAdditionalLen > 0)
         {
-          memcpy(&ucMBSlaveID[usMBSlaveIDLen], pucAdditional,
+          memcpy(&ucMBSlaveID[pxInst->usMBSlaveIDLen], pucAdditional,
                   (size_t)usAdditionalLen);
-          usMBSlaveIDLen += usAdditionalLen;
+          pxInst->usMBSlaveIDLen += usAdditionalLen;
         }
     }
   else
@@ -88,10 +83,12 @@ eMBErrorCode eMBSetSlaveID(uint8_t ucSlaveID, bool xIsRunning,
   return eStatus;
 }
 
-eMBException eMBFuncReportSlaveID(uint8_t *pucFrame, uint16_t *usLen)
+eMBException eMBFuncReportSlaveID(xMBInstance *pxInst, uint8_t *pucFrame,
+                                  uint16_t *usLen)
 {
-  memcpy(&pucFrame[MB_PDU_DATA_OFF], &ucMBSlaveID[0], (size_t)usMBSlaveIDLen);
-  *usLen = (uint16_t)(MB_PDU_DATA_OFF + usMBSlaveIDLen);
+  memcpy(&pucFrame[MB_PDU_DATA_OFF], pxInst->ucMBSlaveID,
+         (size_t)pxInst->usMBSlaveIDLen);
+  *usLen = (uint16_t)(MB_PDU_DATA_OFF + pxInst->usMBSlaveIDLen);
   return MB_EX_NONE;
 }
 
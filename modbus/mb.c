@@ -59,46 +59,29 @@
 #endif
 
 /****************************************************************************
- * Private Data
+ * Private Types
  ****************************************************************************/
 
-static uint8_t  ucMBAddress;
-static eMBMode  eMBCurrentMode;
+/* STATE_NOT_INITIALIZED is zero, so a zero-initialized instance that has
+ * not been through eMBInit() is not taken as enabled.
+ */
 
-static enum
+enum
 {
+  STATE_NOT_INITIALIZED,
   STATE_ENABLED,
-  STATE_DISABLED,
-  STATE_NOT_INITIALIZED
-} eMBState = STATE_NOT_INITIALIZED;
-
-/* Functions pointer which are initialized in eMBInit(). Depending on the
- * mode (RTU or ASCII) the are set to the correct implementations.
- */
-
-static peMBFrameSend peMBFrameSendCur;
-static pvMBFrameStart pvMBFrameStartCur;
-static pvMBFrameStop pvMBFrameStopCur;
-static peMBFrameReceive peMBFrameReceiveCur;
-static pvMBFrameClose pvMBFrameCloseCur;
-
-/* Callback functions required by the porting layer. They are called when
- * an external event has happened which includes a timeout or the reception
- * or transmission of a character.
- */
-
-bool(*pxMBFrameCBByteReceived)(void);
-bool(*pxMBFrameCBTransmitterEmpty)(void);
-bool(*pxMBPortCBTimerExpired)(void);
+  STATE_DISABLED
+};
 
-bool(*pxMBFrameCBReceiveFSMCur)(void);
-bool(*pxMBFrameCBTransmitFSMCur)(void);
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
 
-/* An array of Modbus functions handlers which associates Modbus function
- * codes with implementing functions.
+/* The function handlers a new instance starts with.  This array associates
+ * Modbus function codes with implementing functions.
  */
 
-static xMBFunctionHandler xFuncHandlers[CONFIG_MB_FUNC_HANDLERS_MAX] =
+static const xMBFunctionHandler xFuncHandlers[] =
 {
 #ifdef CONFIG_MB_FUNC_OTHER_REP_SLAVEID_ENABLED
   {MB_FUNC_OTHER_REPORT_SLAVEID, eMBFuncReportSlaveID},
@@ -130,17 +113,131 @@ static xMBFunctionHandler xFuncHandlers[CONFIG_MB_FUNC_HANDLERS_MAX] =
 #ifdef CONFIG_MB_FUNC_READ_DISCRETE_INPUTS_ENABLED
   {MB_FUNC_READ_DISCRETE_INPUTS, eMBFuncReadDiscreteInputs},
 #endif
+  {MB_FUNC_NONE, NULL}
 };
 
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+static void prvvMBInstanceInit(xMBInstance *pxInst)
+{
+  void *pvUserData = pxInst->pvUserData;
+
+  /* Everything but the application data starts from scratch */
+
+  memset(pxInst, 0, sizeof(*pxInst));
+  pxInst->pvUserData = pvUserData;
+  pxInst->eMBState = STATE_NOT_INITIALIZED;
+
+  DEBUGASSERT(sizeof(xFuncHandlers) / sizeof(xFuncHandlers[0]) - 1 <=
+              CONFIG_MB_FUNC_HANDLERS_MAX);
+  memcpy(pxInst->xFuncHandlers, xFuncHandlers,
+         sizeof(xFuncHandlers) - sizeof(xFuncHandlers[0]));
+}
+
+/* Handle the events of an instance until its queue is empty */
+
+static void prvvMBHandleEvents(xMBInstance *pxInst)
+{
+  uint8_t         ucFunctionCode;
+  eMBException    eException;
+  eMBErrorCode    eStatus;
+  eMBEventType    eEvent;
+  int             i;
+
+  while (xMBPortEventGet(pxInst, &eEvent) == true)
+    {
+      switch (eEvent)
+        {
+        case EV_READY:
+          break;
+
+        case EV_FRAME_RECEIVED:
+          eStatus = pxInst->peMBFrameReceiveCur(pxInst,
+                                                &pxInst->ucRcvAddress,
+                                                &pxInst->pucMBFrame,
+                                                &pxInst->usLength);
+          if (eStatus == MB_ENOERR)
+            {
+              /* Check if the frame is for us. If not ignore the frame. */
+
+              if ((pxInst->ucRcvAddress == pxInst->ucMBAddress) ||
+                  (pxInst->ucRcvAddress == MB_ADDRESS_BROADCAST))
+                {
+                  xMBPortEventPost(pxInst, EV_EXECUTE);
+                }
+            }
+            break;
+
+        case EV_EXECUTE:
+          ucFunctionCode = pxInst->pucMBFrame[MB_PDU_FUNC_OFF];
+          eException = MB_EX_ILLEGAL_FUNCTION;
+          for( i = 0; i < CONFIG_MB_FUNC_HANDLERS_MAX; i++)
+            {
+              /* No more function handlers registered. Abort. */
+
+              if (pxInst->xFuncHandlers[i].ucFunctionCode == 0)
+                {
+                  break;
+                }
+              else if (pxInst->xFuncHandlers[i].ucFunctionCode ==
+                       ucFunctionCode)
+                {
+                  eException =
+                    pxInst->xFuncHandlers[i].pxHandler(pxInst,
+                                                       pxInst->pucMBFrame,
+                                                       &pxInst->usLength);
+                  break;
+                }
+            }
+
+          /* If the request was not sent to the broadcast address we
+           * return a reply.
+           */
+
+          if (pxInst->ucRcvAddress != MB_ADDRESS_BROADCAST)
+            {
+              if (eException != MB_EX_NONE)
+                {
+                  /* An exception occurred. Build an error frame. */
+
+                  pxInst->usLength = 0;
+                  pxInst->pucMBFrame[pxInst->usLength++] =
+                    (uint8_t)(ucFunctionCode | MB_FUNC_ERROR);
+                  pxInst->pucMBFrame[pxInst->usLength++] = eException;
+                }
+
+#ifdef CONFIG_MB_ASCII_ENABLED
+              if ((pxInst->eMBCurrentMode == MB_ASCII) && CONFIG_MB_ASCII_TIMEOUT_WAIT_BEFORE_SEND_MS)
+                {
+                  vMBPortTimersDelay(CONFIG_MB_ASCII_TIMEOUT_WAIT_BEFORE_SEND_MS);
+                }
+#endif
+              pxInst->peMBFrameSendCur(pxInst, pxInst->ucMBAddress,
+                                       pxInst->pucMBFrame,
+                                       pxInst->usLength);
+            }
+            break;
+
+        case EV_FRAME_SENT:
+            break;
+        }
+    }
+}
+
 /****************************************************************************
  * Public Functions
  ****************************************************************************/
 
-eMBErrorCode eMBInit(eMBMode eMode, uint8_t ucSlaveAddress, uint8_t ucPort,
+eMBErrorCode eMBInit(xMBInstance *pxInst, eMBMode eMode,
+                     uint8_t ucSlaveAddress, uint8_t ucPort,
                      speed_t ulBaudRate, eMBParity eParity)
 {
   eMBErrorCode eStatus = MB_ENOERR;
 
+  prvvMBInstanceInit(pxInst);
+
   /* check preconditions */
 
   if ((ucSlaveAddress == MB_ADDRESS_BROADCAST) ||
@@ -150,36 +247,38 @@ eMBErrorCode eMBInit(eMBMode eMode, uint8_t ucSlaveAddress, uint8_t ucPort,
     }
   else
     {
-      ucMBAddress = ucSlaveAddress;
+      pxInst->ucMBAddress = ucSlaveAddress;
 
       switch (eMode)
         {
 #ifdef CONFIG_MB_RTU_ENABLED
         case MB_RTU:
-          pvMBFrameStartCur = eMBRTUStart;
-          pvMBFrameStopCur = eMBRTUStop;
-          peMBFrameSendCur = eMBRTUSend;
-          peMBFrameReceiveCur = eMBRTUReceive;
-          pvMBFrameCloseCur = vMBPortClose;
-          pxMBFrameCBByteReceived = xMBRTUReceiveFSM;
-          pxMBFrameCBTransmitterEmpty = xMBRTUTransmitFSM;
-          pxMBPortCBTimerExpired = xMBRTUTimerT35Expired;
-
-          eStatus = eMBRTUInit(ucMBAddress, ucPort, ulBaudRate, eParity);
+          pxInst->pvMBFrameStartCur = eMBRTUStart;
+          pxInst->pvMBFrameStopCur = eMBRTUStop;
+          pxInst->peMBFrameSendCur = eMBRTUSend;
+          pxInst->peMBFrameReceiveCur = eMBRTUReceive;
+          pxInst->pvMBFrameCloseCur = vMBPortClose;
+          pxInst->pxMBFrameCBByteReceived = xMBRTUReceiveFSM;
+          pxInst->pxMBFrameCBTransmitterEmpty = xMBRTUTransmitFSM;
+          pxInst->pxMBPortCBTimerExpired = xMBRTUTimerT35Expired;
+
+          eStatus = eMBRTUInit(pxInst, pxInst->ucMBAddress, ucPort,
+                               ulBaudRate, eParity);
           break;
 #endif
 #ifdef CONFIG_MB_ASCII_ENABLED
         case MB_ASCII:
-          pvMBFrameStartCur = eMBASCIIStart;
-          pvMBFrameStopCur = eMBASCIIStop;
-          peMBFrameSendCur = eMBASCIISend;
-          peMBFrameReceiveCur = eMBASCIIReceive;
-          pvMBFrameCloseCur = vMBPortClose;
-          pxMBFrameCBByteReceived = xMBASCIIReceiveFSM;
-          pxMBFrameCBTransmitterEmpty = xMBASCIITransmitFSM;
-          pxMBPortCBTimerExpired = xMBASCIITimerT1SExpired;
-
-          eStatus = eMBASCIIInit(ucMBAddress, ucPort, ulBaudRate, eParity);
+          pxInst->pvMBFrameStartCur = eMBASCIIStart;
+          pxInst->pvMBFrameStopCur = eMBASCIIStop;
+          pxInst->peMBFrameSendCur = eMBASCIISend;
+          pxInst->peMBFrameReceiveCur = eMBASCIIReceive;
+          pxInst->pvMBFrameCloseCur = vMBPortClose;
+          pxInst->pxMBFrameCBByteReceived = xMBASCIIReceiveFSM;
+          pxInst->pxMBFrameCBTransmitterEmpty = xMBASCIITransmitFSM;
+          pxInst->pxMBPortCBTimerExpired = xMBASCIITimerT1SExpired;
+
+          eStatus = eMBASCIIInit(pxInst, pxInst->ucMBAddress, ucPort,
+                                 ulBaudRate, eParity);
           break;
 #endif
         default:
@@ -188,7 +287,7 @@ eMBErrorCode eMBInit(eMBMode eMode, uint8_t ucSlaveAddress, uint8_t ucPort,
 
       if (eStatus == MB_ENOERR)
         {
-          if (!xMBPortEventInit())
+          if (!xMBPortEventInit(pxInst))
             {
               /* port dependent event module initialization failed. */
 
@@ -196,8 +295,8 @@ eMBErrorCode eMBInit(eMBMode eMode, uint8_t ucSlaveAddress, uint8_t ucPort,
             }
           else
             {
-              eMBCurrentMode = eMode;
-              eMBState = STATE_DISABLED;
+              pxInst->eMBCurrentMode = eMode;
+              pxInst->eMBState = STATE_DISABLED;
             }
         }
     }
@@ -206,15 +305,17 @@ eMBErrorCode eMBInit(eMBMode eMode, uint8_t ucSlaveAddress, uint8_t ucPort,
 }
 
 #ifdef CONFIG_MB_TCP_ENABLED
-eMBErrorCode eMBTCPInit(uint16_t ucTCPPort)
+eMBErrorCode eMBTCPInit(xMBInstance *pxInst, uint16_t ucTCPPort)
 {
   eMBErrorCode eStatus = MB_ENOERR;
 
-  if ((eStatus = eMBTCPDoInit(ucTCPPort)) != MB_ENOERR)
+  prvvMBInstanceInit(pxInst);
+
+  if ((eStatus = eMBTCPDoInit(pxInst, ucTCPPort)) != MB_ENOERR)
     {
-      eMBState = STATE_DISABLED;
+      pxInst->eMBState = STATE_DISABLED;
     }
-  else if (!xMBPortEventInit())
+  else if (!xMBPortEventInit(pxInst))
     {
       /* Port dependent event module initialization failed. */
 
@@ -222,28 +323,30 @@ eMBErrorCode eMBTCPInit(uint16_t ucTCPPort)
     }
   else
     {
-      pvMBFrameStartCur = eMBTCPStart;
-      pvMBFrameStopCur = eMBTCPStop;
-      peMBFrameReceiveCur = eMBTCPReceive;
-      peMBFrameSendCur = eMBTCPSend;
+      pxInst->pvMBFrameStartCur = eMBTCPStart;
+      pxInst->pvMBFrameStopCur = eMBTCPStop;
+      pxInst->peMBFrameReceiveCur = eMBTCPReceive;
+      pxInst->peMBFrameSendCur = eMBTCPSend;
 #ifdef CONFIG_MB_HAVE_CLOSE
-      pvMBFrameCloseCur = vMBTCPPortClose;
+      pxInst->pvMBFrameCloseCur = vMBTCPPortClose;
 #else
-      pvMBFrameCloseCur = NULL;
+      pxInst->pvMBFrameCloseCur = NULL;
 #endif
-      ucMBAddress = MB_TCP_PSEUDO_ADDRESS;
-      eMBCurrentMode = MB_TCP;
-      eMBState = STATE_DISABLED;
+      pxInst->ucMBAddress = MB_TCP_PSEUDO_ADDRESS;
+      pxInst->eMBCurrentMode = MB_TCP;
+      pxInst->eMBState = STATE_DISABLED;
     }
 
   return eStatus;
 }
 #endif
 
-eMBErrorCode eMBRegisterCB(uint8_t ucFunctionCode, pxMBFunctionHandler pxHandler)
+eMBErrorCode eMBRegisterCB(xMBInstance *pxInst, uint8_t ucFunctionCode,
+                           pxMBFunctionHandler pxHandler)
 {
-  eMBErrorCode  eStatus;
-  int           i;
+  xMBFunctionHandler *pxHandlers = pxInst->xFuncHandlers;
+  eMBErrorCode        eStatus;
+  int                 i;
 
   if ((0 < ucFunctionCode) && (ucFunctionCode <= 127))
     {
@@ -252,11 +355,11 @@ eMBErrorCode eMBRegisterCB(uint8_t ucFunctionCode, pxMBFunctionHandler pxHandler
         {
           for (i = 0; i < CONFIG_MB_FUNC_HANDLERS_MAX; i++)
             {
-              if ((xFuncHandlers[i].pxHandler == NULL) ||
-                  (xFuncHandlers[i].pxHandler == pxHandler))
+              if ((pxHandlers[i].pxHandler == NULL) ||
+                  (pxHandlers[i].pxHandler == pxHandler))
                 {
-                  xFuncHandlers[i].ucFunctionCode = ucFunctionCode;
-                  xFuncHandlers[i].pxHandler = pxHandler;
+                  pxHandlers[i].ucFunctionCode = ucFunctionCode;
+                  pxHandlers[i].pxHandler = pxHandler;
                   break;
                 }
             }
@@ -266,10 +369,10 @@ eMBErrorCode eMBRegisterCB(uint8_t ucFunctionCode, pxMBFunctionHandler pxHandler
         {
           for (i = 0; i < CONFIG_MB_FUNC_HANDLERS_MAX; i++)
             {
-              if (xFuncHandlers[i].ucFunctionCode == ucFunctionCode)
+              if (pxHandlers[i].ucFunctionCode == ucFunctionCode)
                 {
-                  xFuncHandlers[i].ucFunctionCode = 0;
-                  xFuncHandlers[i].pxHandler = NULL;
+                  pxHandlers[i].ucFunctionCode = 0;
+                  pxHandlers[i].pxHandler = NULL;
                   break;
                 }
             }
@@ -289,15 +392,15 @@ eMBErrorCode eMBRegisterCB(uint8_t ucFunctionCode, pxMBFunctionHandler pxHandler
   return eStatus;
 }
 
-eMBErrorCode eMBClose(void)
+eMBErrorCode eMBClose(xMBInstance *pxInst)
 {
   eMBErrorCode eStatus = MB_ENOERR;
 
-  if (eMBState == STATE_DISABLED)
+  if (pxInst->eMBState == STATE_DISABLED)
     {
-      if (pvMBFrameCloseCur != NULL)
+      if (pxInst->pvMBFrameCloseCur != NULL)
         {
-          pvMBFrameCloseCur();
+          pxInst->pvMBFrameCloseCur(pxInst);
         }
     }
   else
@@ -308,16 +411,16 @@ eMBErrorCode eMBClose(void)
   return eStatus;
 }
 
-eMBErrorCode eMBEnable(void)
+eMBErrorCode eMBEnable(xMBInstance *pxInst)
 {
   eMBErrorCode eStatus = MB_ENOERR;
 
-  if (eMBState == STATE_DISABLED)
+  if (pxInst->eMBState == STATE_DISABLED)
     {
       /* Activate the protocol stack. */
 
-      pvMBFrameStartCur();
-      eMBState = STATE_ENABLED;
+      pxInst->pvMBFrameStartCur(pxInst);
+      pxInst->eMBState = STATE_ENABLED;
     }
   else
     {
@@ -327,17 +430,17 @@ eMBErrorCode eMBEnable(void)
   return eStatus;
 }
 
-eMBErrorCode eMBDisable(void)
+eMBErrorCode eMBDisable(xMBInstance *pxInst)
 {
   eMBErrorCode  eStatus;
 
-  if (eMBState == STATE_ENABLED)
+  if (pxInst->eMBState == STATE_ENABLED)
     {
-      pvMBFrameStopCur();
-      eMBState = STATE_DISABLED;
+      pxInst->pvMBFrameStopCur(pxInst);
+      pxInst->eMBState = STATE_DISABLED;
       eStatus = MB_ENOERR;
     }
-  else if (eMBState == STATE_DISABLED)
+  else if (pxInst->eMBState == STATE_DISABLED)
     {
       eStatus = MB_ENOERR;
     }
@@ -349,95 +452,39 @@ eMBErrorCode eMBDisable(void)
   return eStatus;
 }
 
-eMBErrorCode eMBPoll(void)
+eMBErrorCode eMBPoll(xMBInstance *pxInst)
 {
-  static uint8_t     *ucMBFrame;
-  static uint8_t      ucRcvAddress;
-  static uint8_t      ucFunctionCode;
-  static uint16_t     usLength;
-  static eMBException eException;
-
-  int             i;
-  eMBErrorCode    eStatus = MB_ENOERR;
-  eMBEventType    eEvent;
+  return eMBPollInstances(&pxInst, 1);
+}
 
-  /* Check if the protocol stack is ready. */
+eMBErrorCode eMBPollInstances(xMBInstance *apxInst[], int iCount)
+{
+  int i;
 
-  if (eMBState != STATE_ENABLED)
+  if (iCount < 1 || iCount > CONFIG_MB_MAX_INSTANCES)
     {
-      return MB_EILLSTATE;
+      return MB_EINVAL;
     }
 
-  /* Check if there is a event available. If not return control to caller.
-   * Otherwise we will handle the event.
-   */
+  /* Check if the protocol stacks are ready. */
 
-  if (xMBPortEventGet(&eEvent) == true)
+  for (i = 0; i < iCount; i++)
     {
-      switch (eEvent)
+      if (apxInst[i]->eMBState != STATE_ENABLED)
         {
-        case EV_READY:
-          break;
-
-        case EV_FRAME_RECEIVED:
-          eStatus = peMBFrameReceiveCur(&ucRcvAddress, &ucMBFrame, &usLength);
-          if (eStatus == MB_ENOERR)
-            {
-              /* Check if the frame is for us. If not ignore the frame. */
-
-              if ((ucRcvAddress == ucMBAddress) || (ucRcvAddress == MB_ADDRESS_BROADCAST))
-                {
-                  xMBPortEventPost(EV_EXECUTE);
-                }
-            }
-            break;
-
-        case EV_EXECUTE:
-          ucFunctionCode = ucMBFrame[MB_PDU_FUNC_OFF];
-          eException = MB_EX_ILLEGAL_FUNCTION;
-          for( i = 0; i < CONFIG_MB_FUNC_HANDLERS_MAX; i++)
-            {
-              /* No more function handlers registered. Abort. */
-
-              if (xFuncHandlers[i].ucFunctionCode == 0)
-                {
-                  break;
-                }
-              else if (xFuncHandlers[i].ucFunctionCode == ucFunctionCode)
-                {
-                  eException = xFuncHandlers[i].pxHandler(ucMBFrame, &usLength);
-                  break;
-                }
-            }
-
-          /* If the request was not sent to the broadcast address we
-           * return a reply.
-           */
-
-          if (ucRcvAddress != MB_ADDRESS_BROADCAST)
-            {
-              if (eException != MB_EX_NONE)
-                {
-                  /* An exception occurred. Build an error frame. */
+          return MB_EILLSTATE;
+        }
+    }
 
-                  usLength = 0;
-                  ucMBFrame[usLength++] = (uint8_t)(ucFunctionCode | MB_FUNC_ERROR);
-                  ucMBFrame[usLength++] = eException;
-                }
+  /* Wait until one of the instances has something to do.  This runs the
+   * receiver and transmitter state machines, which post the events.
+   */
 
-#ifdef CONFIG_MB_ASCII_ENABLED
-              if ((eMBCurrentMode == MB_ASCII) && CONFIG_MB_ASCII_TIMEOUT_WAIT_BEFORE_SEND_MS)
-                {
-                  vMBPortTimersDelay(CONFIG_MB_ASCII_TIMEOUT_WAIT_BEFORE_SEND_MS);
-                }
-#endif
-              peMBFrameSendCur(ucMBAddress, ucMBFrame, usLength);
-            }
-            break;
+  xMBPortPoll(apxInst, iCount);
 
-        case EV_FRAME_SENT:
-            break;
-        }
+  for (i = 0; i < iCount; i++)
+    {
+      prvvMBHandleEvents(apxInst[i]);
     }
 
   return MB_ENOERR;
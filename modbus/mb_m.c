@@ -72,6 +72,7 @@
 
 static uint8_t ucMBMasterDestAddress;
 static bool xMBRunInMasterMode = false;
+static bool xMBMasterIsReady;
 static eMBMasterErrorEventType eMBMasterCurErrorType;
 
 static enum
@@ -86,11 +87,11 @@ static enum
  * Using for Modbus Master,Add by Armink 20130813
  */
 
-static peMBFrameSend peMBMasterFrameSendCur;
-static pvMBFrameStart pvMBMasterFrameStartCur;
-static pvMBFrameStop pvMBMasterFrameStopCur;
-static peMBFrameReceive peMBMasterFrameReceiveCur;
-static pvMBFrameClose pvMBMasterFrameCloseCur;
+static peMBMasterFrameSend peMBMasterFrameSendCur;
+static pvMBMasterFrameStart pvMBMasterFrameStartCur;
+static pvMBMasterFrameStop pvMBMasterFrameStopCur;
+static peMBMasterFrameReceive peMBMasterFrameReceiveCur;
+static pvMBMasterFrameClose pvMBMasterFrameCloseCur;
 
 /* Callback functions required by the porting layer. They are called when
  * an external event has happened which includes a timeout or the reception
@@ -109,13 +110,7 @@ bool(*pxMBMasterFrameCBTransmitFSMCur) (void);
  * codes with implementing functions.
  */
 
-static xMBFunctionHandler xMasterFuncHandlers[CONFIG_MB_FUNC_HANDLERS_MAX] = {
-#ifdef CONFIG_MB_FUNC_OTHER_REP_SLAVEID_ENABLED
-
-  /* TODO Add Master function define */
-
-  {MB_FUNC_OTHER_REPORT_SLAVEID, eMBFuncReportSlaveID},
-#endif
+static xMBMasterFunctionHandler xMasterFuncHandlers[CONFIG_MB_FUNC_HANDLERS_MAX] = {
 #ifdef CONFIG_MB_MASTER_FUNC_READ_INPUT_ENABLED
   {MB_FUNC_READ_INPUT_REGISTER, eMBMasterFuncReadInputRegister},
 #endif
@@ -238,6 +233,7 @@ eMBErrorCode eMBMasterEnable(void)
     {
       /* Activate the protocol stack. */
 
+      xMBMasterIsReady = false;
       pvMBMasterFrameStartCur();
       eMBState = STATE_ENABLED;
     }
@@ -284,6 +280,9 @@ eMBErrorCode eMBMasterPoll(void)
   eMBErrorCode eStatus = MB_ENOERR;
   eMBMasterEventType eEvent;
   eMBMasterErrorEventType errorType;
+#ifdef CONFIG_MB_MASTER_SCHED
+  eMBMasterReqErrCode eErrStatus;
+#endif
 
   /* Check if the protocol stack is ready. */
 
@@ -292,6 +291,15 @@ eMBErrorCode eMBMasterPoll(void)
       return MB_EILLSTATE;
     }
 
+#ifdef CONFIG_MB_MASTER_SCHED
+  /* Send the next scheduled request as soon as the bus is free */
+
+  if (xMBMasterIsReady)
+    {
+      vMBMasterSchedPoll();
+    }
+#endif
+
   /* Check if there is a event available. If not return control to caller.
    * Otherwise we will handle the event.
    */
@@ -301,6 +309,7 @@ eMBErrorCode eMBMasterPoll(void)
       switch (eEvent)
         {
         case EV_MASTER_READY:
+          xMBMasterIsReady = true;
           break;
 
         case EV_MASTER_FRAME_RECEIVED:
@@ -387,6 +396,14 @@ eMBErrorCode eMBMasterPoll(void)
             }
           else
             {
+#ifdef CONFIG_MB_MASTER_SCHED
+              if (xMBMasterSchedDone(MB_MRE_NO_ERR))
+                {
+                  vMBMasterRunResRelease();
+                  break;
+                }
+#endif
+
               vMBMasterCBRequestSuccess();
               vMBMasterRunResRelease();
             }
@@ -400,6 +417,16 @@ eMBErrorCode eMBMasterPoll(void)
           eStatus =
             peMBMasterFrameSendCur(ucMBMasterGetDestAddress(), ucMBFrame,
                                    usMBMasterGetPDUSndLength());
+
+          /* Complete the request if it could not be sent, so that its
+           * waiter does not hang.
+           */
+
+          if (eStatus != MB_ENOERR)
+            {
+              vMBMasterSetErrorType(EV_ERROR_RECEIVE_DATA);
+              xMBMasterPortEventPost(EV_MASTER_ERROR_PROCESS);
+            }
           break;
 
         case EV_MASTER_ERROR_PROCESS:
@@ -408,6 +435,19 @@ eMBErrorCode eMBMasterPoll(void)
 
           errorType = eMBMasterGetErrorType();
           vMBMasterGetPDUSndBuf(&ucMBFrame);
+
+#ifdef CONFIG_MB_MASTER_SCHED
+          eErrStatus = errorType == EV_ERROR_RESPOND_TIMEOUT ?
+                       MB_MRE_TIMEDOUT :
+                       errorType == EV_ERROR_RECEIVE_DATA ?
+                       MB_MRE_REV_DATA : MB_MRE_EXE_FUN;
+          if (xMBMasterSchedDone(eErrStatus))
+            {
+              vMBMasterRunResRelease();
+              break;
+            }
+#endif
+
           switch (errorType)
             {
             case EV_ERROR_RESPOND_TIMEOUT:
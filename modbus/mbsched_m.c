@@ -0,0 +1,436 @@
+/****************************************************************************
+ * apps/modbus/mbsched_m.c
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/* Modbus master request scheduler.
+ *
+ * The application registers the register ranges it wants to read from its
+ * slaves once.  The scheduler merges adjacent ranges of the same slave and
+ * function into one request and then runs the requests in a cycle from
+ * eMBMasterPoll(): the next request goes out as soon as the previous one
+ * completed, without a task switch or semaphore handshake per request.
+ * The read data is passed to the usual eMBMasterReg*CB() callbacks.
+ */
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+#include <string.h>
+#include <time.h>
+
+#include "port.h"
+
+#include "modbus/mb.h"
+#include "modbus/mb_m.h"
+#include "modbus/mbframe.h"
+#include "modbus/mbproto.h"
+#include "modbus/mbport.h"
+
+#ifdef CONFIG_MB_MASTER_SCHED
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#define MB_PDU_REQ_READ_ADDR_OFF     (MB_PDU_DATA_OFF + 0)
+#define MB_PDU_REQ_READ_CNT_OFF      (MB_PDU_DATA_OFF + 2)
+#define MB_PDU_REQ_READ_SIZE         (4)
+
+#define MB_SCHED_REGCNT_MAX          (0x007D)  /* Registers per request */
+#define MB_SCHED_BITCNT_MAX          (0x07D0)  /* Bits per request */
+
+/****************************************************************************
+ * Private Types
+ ****************************************************************************/
+
+typedef struct
+{
+  uint8_t  ucSlave;
+  uint8_t  ucFunctionCode;
+  uint16_t usAddr;
+  uint16_t usCount;
+} xMBMasterSchedRead;
+
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+/* The reads as registered and the requests they were merged into */
+
+static xMBMasterSchedRead xReads[CONFIG_MB_MASTER_SCHED_MAX_READS];
+static xMBMasterSchedRead xRequests[CONFIG_MB_MASTER_SCHED_MAX_READS];
+static int                iNReads;
+static int                iNRequests;
+
+static volatile bool      bRunning;
+static bool               bInFlight;     /* A request of ours is on the bus */
+static uint8_t            ucInFlightSlave;
+static bool               bCycleStarted;
+static int                iNext;         /* Next request of the cycle */
+static uint32_t           ulPeriodUs;
+static struct timespec    xCycleStart;
+static struct timespec    xSent;
+
+static uint32_t           ulCycles;
+static uint32_t           ulLastCycleUs;
+static xMBMasterSlaveStats xStats[CONFIG_MB_MASTER_TOTAL_SLAVE_NUM];
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+static uint32_t prvulMBMasterSchedElapsed(const struct timespec *pxSince)
+{
+  struct timespec xNow;
+
+  clock_gettime(CLOCK_MONOTONIC, &xNow);
+  return (xNow.tv_sec - pxSince->tv_sec) * 1000000L +
+         (xNow.tv_nsec - pxSince->tv_nsec) / 1000L;
+}
+
+static uint16_t prvusMBMasterSchedMaxCount(uint8_t ucFunctionCode)
+{
+  switch (ucFunctionCode)
+    {
+#ifdef CONFIG_MB_MASTER_FUNC_READ_COILS_ENABLED
+      case MB_FUNC_READ_COILS:
+        return MB_SCHED_BITCNT_MAX;
+#endif
+#ifdef CONFIG_MB_MASTER_FUNC_READ_DISCRETE_INPUTS_ENABLED
+      case MB_FUNC_READ_DISCRETE_INPUTS:
+        return MB_SCHED_BITCNT_MAX;
+#endif
+#ifdef CONFIG_MB_MASTER_FUNC_READ_HOLDING_ENABLED
+      case MB_FUNC_READ_HOLDING_REGISTER:
+        return MB_SCHED_REGCNT_MAX;
+#endif
+#ifdef CONFIG_MB_MASTER_FUNC_READ_INPUT_ENABLED
+      case MB_FUNC_READ_INPUT_REGISTER:
+        return MB_SCHED_REGCNT_MAX;
+#endif
+      default:
+        return 0;
+    }
+}
+
+static int prviMBMasterSchedCompare(const xMBMasterSchedRead *pxA,
+                                    const xMBMasterSchedRead *pxB)
+{
+  if (pxA->ucSlave != pxB->ucSlave)
+    {
+      return pxA->ucSlave - pxB->ucSlave;
+    }
+
+  if (pxA->ucFunctionCode != pxB->ucFunctionCode)
+    {
+      return pxA->ucFunctionCode - pxB->ucFunctionCode;
+    }
+
+  return (int)pxA->usAddr - (int)pxB->usAddr;
+}
+
+/* Sort the reads by slave, function and address and merge the ones that
+ * overlap or are at most CONFIG_MB_MASTER_SCHED_MAX_GAP apart, as long as
+ * the result fits into one request.
+ */
+
+static void prvvMBMasterSchedCoalesce(void)
+{
+  xMBMasterSchedRead  xTmp;
+  xMBMasterSchedRead *pxCur;
+  xMBMasterSchedRead *pxRead;
+  uint32_t            ulEnd;
+  uint32_t            ulNewEnd;
+  int                 i;
+  int                 j;
+
+  memcpy(xRequests, xReads, iNReads * sizeof(xMBMasterSchedRead));
+
+  /* Insertion sort, the table is small and only sorted on start */
+
+  for (i = 1; i < iNReads; i++)
+    {
+      xTmp = xRequests[i];
+      for (j = i; j > 0 &&
+           prviMBMasterSchedCompare(&xRequests[j - 1], &xTmp) > 0; j--)
+        {
+          xRequests[j] = xRequests[j - 1];
+        }
+
+      xRequests[j] = xTmp;
+    }
+
+  iNRequests = 0;
+  pxCur = NULL;
+  for (i = 0; i < iNReads; i++)
+    {
+      pxRead = &xRequests[i];
+      if (pxCur != NULL && pxCur->ucSlave == pxRead->ucSlave &&
+          pxCur->ucFunctionCode == pxRead->ucFunctionCode)
+        {
+          ulEnd    = (uint32_t)pxCur->usAddr + pxCur->usCount;
+          ulNewEnd = (uint32_t)pxRead->usAddr + pxRead->usCount;
+          if (ulNewEnd < ulEnd)
+            {
+              ulNewEnd = ulEnd;
+            }
+
+          if (pxRead->usAddr <= ulEnd + CONFIG_MB_MASTER_SCHED_MAX_GAP &&
+              ulNewEnd - pxCur->usAddr <=
+              prvusMBMasterSchedMaxCount(pxCur->ucFunctionCode))
+            {
+              pxCur->usCount = ulNewEnd - pxCur->usAddr;
+              continue;
+            }
+        }
+
+      pxCur = &xRequests[iNRequests++];
+      *pxCur = *pxRead;
+    }
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+eMBErrorCode eMBMasterSchedAddRead(uint8_t ucSndAddr, uint8_t ucFunctionCode,
+                                   uint16_t usAddr, uint16_t usCount)
+{
+  xMBMasterSchedRead *pxRead;
+
+  if (bRunning || bInFlight)
+    {
+      return MB_EILLSTATE;
+    }
+
+  if (ucSndAddr == MB_ADDRESS_BROADCAST ||
+      ucSndAddr > CONFIG_MB_MASTER_TOTAL_SLAVE_NUM || usCount == 0 ||
+      usCount > prvusMBMasterSchedMaxCount(ucFunctionCode) ||
+      (uint32_t)usAddr + usCount > 0x10000)
+    {
+      return MB_EINVAL;
+    }
+
+  if (iNReads >= CONFIG_MB_MASTER_SCHED_MAX_READS)
+    {
+      return MB_ENORES;
+    }
+
+  pxRead = &xReads[iNReads++];
+  pxRead->ucSlave        = ucSndAddr;
+  pxRead->ucFunctionCode = ucFunctionCode;
+  pxRead->usAddr         = usAddr;
+  pxRead->usCount        = usCount;
+  return MB_ENOERR;
+}
+
+eMBErrorCode eMBMasterSchedClear(void)
+{
+  if (bRunning || bInFlight)
+    {
+      return MB_EILLSTATE;
+    }
+
+  iNReads = 0;
+  iNRequests = 0;
+  return MB_ENOERR;
+}
+
+eMBErrorCode eMBMasterSchedStart(uint32_t ulPeriodMs)
+{
+  if (bRunning || bInFlight)
+    {
+      return MB_EILLSTATE;
+    }
+
+  prvvMBMasterSchedCoalesce();
+  ulPeriodUs = ulPeriodMs * 1000;
+  iNext = 0;
+  bCycleStarted = false;
+  bRunning = true;
+  return MB_ENOERR;
+}
+
+void vMBMasterSchedStop(void)
+{
+  /* A request on the bus still completes and is accounted for */
+
+  bRunning = false;
+}
+
+int iMBMasterSchedGetRequests(void)
+{
+  return iNRequests;
+}
+
+eMBErrorCode eMBMasterSchedGetStats(uint8_t ucSlave,
+                                    xMBMasterSlaveStats *pxStats)
+{
+  if (ucSlave == MB_ADDRESS_BROADCAST ||
+      ucSlave > CONFIG_MB_MASTER_TOTAL_SLAVE_NUM)
+    {
+      return MB_EINVAL;
+    }
+
+  ENTER_CRITICAL_SECTION();
+  *pxStats = xStats[ucSlave - 1];
+  EXIT_CRITICAL_SECTION();
+  return MB_ENOERR;
+}
+
+void vMBMasterSchedGetCycle(uint32_t *pulCycles, uint32_t *pulLastCycleUs)
+{
+  ENTER_CRITICAL_SECTION();
+  *pulCycles      = ulCycles;
+  *pulLastCycleUs = ulLastCycleUs;
+  EXIT_CRITICAL_SECTION();
+}
+
+void vMBMasterSchedResetStats(void)
+{
+  ENTER_CRITICAL_SECTION();
+  memset(xStats, 0, sizeof(xStats));
+  ulCycles = 0;
+  ulLastCycleUs = 0;
+  EXIT_CRITICAL_SECTION();
+}
+
+/* Called by eMBMasterPoll() while the stack is idle: start the next
+ * request of the cycle if the bus is free.
+ */
+
+void vMBMasterSchedPoll(void)
+{
+  xMBMasterSchedRead *pxReq;
+  uint8_t            *ucMBFrame;
+
+  if (!bRunning || bInFlight || iNRequests == 0)
+    {
+      return;
+    }
+
+  if (iNext == 0)
+    {
+      /* Keep the cycle period, a cycle that took longer starts the next
+       * one right away.
+       */
+
+      if (bCycleStarted && prvulMBMasterSchedElapsed(&xCycleStart) <
+          ulPeriodUs)
+        {
+          return;
+        }
+    }
+
+  /* Requests of other tasks are interleaved with ours */
+
+  if (xMBMasterRunResTake(0) == false)
+    {
+      return;
+    }
+
+  if (iNext == 0)
+    {
+      clock_gettime(CLOCK_MONOTONIC, &xCycleStart);
+      bCycleStarted = true;
+    }
+
+  pxReq = &xRequests[iNext];
+
+  vMBMasterGetPDUSndBuf(&ucMBFrame);
+  vMBMasterSetDestAddress(pxReq->ucSlave);
+  ucMBFrame[MB_PDU_FUNC_OFF]             = pxReq->ucFunctionCode;
+  ucMBFrame[MB_PDU_REQ_READ_ADDR_OFF]    = pxReq->usAddr >> 8;
+  ucMBFrame[MB_PDU_REQ_READ_ADDR_OFF + 1] = pxReq->usAddr;
+  ucMBFrame[MB_PDU_REQ_READ_CNT_OFF]     = pxReq->usCount >> 8;
+  ucMBFrame[MB_PDU_REQ_READ_CNT_OFF + 1] = pxReq->usCount;
+  vMBMasterSetPDUSndLength(MB_PDU_SIZE_MIN + MB_PDU_REQ_READ_SIZE);
+
+  clock_gettime(CLOCK_MONOTONIC, &xSent);
+  ucInFlightSlave = pxReq->ucSlave;
+  bInFlight = true;
+  xMBMasterPortEventPost(EV_MASTER_FRAME_SENT);
+}
+
+/* Called by eMBMasterPoll() when a request completed.  Returns true if it
+ * was one of ours, the waiter of the blocking API is then not notified.
+ */
+
+bool xMBMasterSchedDone(eMBMasterReqErrCode eErrStatus)
+{
+  xMBMasterSlaveStats *pxStats;
+  uint32_t             ulRtt;
+
+  if (!bInFlight)
+    {
+      return false;
+    }
+
+  ulRtt = prvulMBMasterSchedElapsed(&xSent);
+  bInFlight = false;
+
+  ENTER_CRITICAL_SECTION();
+
+  pxStats = &xStats[ucInFlightSlave - 1];
+  pxStats->ulRequests++;
+
+  if (eErrStatus == MB_MRE_TIMEDOUT)
+    {
+      pxStats->ulTimeouts++;
+    }
+  else
+    {
+      if (eErrStatus != MB_MRE_NO_ERR)
+        {
+          pxStats->ulErrors++;
+        }
+
+      /* Round trip: from handing the request to the port until the
+       * response has been processed.
+       */
+
+      if (pxStats->ulResponses == 0 || ulRtt < pxStats->ulRttMinUs)
+        {
+          pxStats->ulRttMinUs = ulRtt;
+        }
+
+      if (ulRtt > pxStats->ulRttMaxUs)
+        {
+          pxStats->ulRttMaxUs = ulRtt;
+        }
+
+      pxStats->ulResponses++;
+      pxStats->ulRttLastUs = ulRtt;
+      pxStats->ullRttSumUs += ulRtt;
+    }
+
+  if (bRunning && ++iNext >= iNRequests)
+    {
+      iNext = 0;
+      ulCycles++;
+      ulLastCycleUs = prvulMBMasterSchedElapsed(&xCycleStart);
+    }
+
+  EXIT_CRITICAL_SECTION();
+  return true;
+}
+
+#endif /* CONFIG_MB_MASTER_SCHED */
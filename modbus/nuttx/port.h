@@ -39,6 +39,9 @@
 #include <stdbool.h>
 #include <stdint.h>
 #include <assert.h>
+#include <poll.h>
+
+#include "modbus/mbproto.h"
 
 /****************************************************************************
  * Pre-processor Definitions
@@ -82,18 +85,35 @@ void vMBPortEnterCritical(void);
 void vMBPortExitCritical(void);
 void vMBPortLog(eMBPortLogLevel eLevel, const char *szModule,
                 const char *szFmt, ...) printf_like(3, 4);
-void vMBPortTimerPoll(void);
-bool xMBPortSerialPoll(void);
-bool xMBPortSerialSetTimeout(uint32_t dwTimeoutMs);
+
+/* Event polling, see xMBPortPoll().  The setup functions add the
+ * descriptors of an instance to the poll set and shorten the timeout if
+ * the instance needs to run sooner.  The poll functions then handle the
+ * returned events.
+ */
+
+#if defined(CONFIG_MB_RTU_ENABLED) || defined(CONFIG_MB_ASCII_ENABLED)
+int  iMBPortSerialPollSetup(xMBInstance *pxInst, struct pollfd *pxFd,
+                            int *piTimeout);
+bool xMBPortSerialPoll(xMBInstance *pxInst, short sRevents);
+void vMBPortTimerPollSetup(xMBInstance *pxInst, int *piTimeout);
+void vMBPortTimerPoll(xMBInstance *pxInst);
+#endif
+
+#ifdef CONFIG_MB_TCP_ENABLED
+int  iMBTCPPortPollSetup(xMBInstance *pxInst, struct pollfd *pxFds,
+                         int *piTimeout);
+bool xMBTCPPortPoll(xMBInstance *pxInst, struct pollfd *pxFds);
+#endif
 
 #if defined(CONFIG_MB_RTU_MASTER) || defined(CONFIG_MB_ASCII_MASTER)
   void vMBMasterPortEnterCritical(void);
   void vMBMasterPortExitCritical(void);
   void vMBMasterPortLog(eMBPortLogLevel eLevel, const char *szModule,
                         const char *szFmt, ...) printf_like(3, 4);
+  void vMBMasterPortTimerPollSetup(int *piTimeout);
   void vMBMasterPortTimerPoll(void);
-  bool xMBMasterPortSerialPoll(void);
-  bool xMBMasterPortSerialSetTimeout(uint32_t dwTimeoutMs);
+  bool xMBMasterPortSerialPoll(int iTimeout);
 #endif
 
 #ifdef __cplusplus
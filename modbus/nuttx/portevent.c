@@ -33,60 +33,175 @@
  * Included Files
  ****************************************************************************/
 
+#include <nuttx/config.h>
+
+#include <errno.h>
+#include <poll.h>
+
 #include "modbus/mb.h"
 #include "modbus/mbport.h"
 
 #include "port.h"
 
 /****************************************************************************
- * Private Data
+ * Pre-processor Definitions
  ****************************************************************************/
 
-static eMBEventType eQueuedEvent;
-static bool xEventInQueue;
+/* One descriptor per instance: the serial port or the listening socket,
+ * plus the Modbus TCP connections.
+ */
+
+#ifdef CONFIG_MB_TCP_ENABLED
+#  define MB_POLL_FDS (CONFIG_MB_MAX_INSTANCES + CONFIG_MB_TCP_MAX_CLIENTS)
+#else
+#  define MB_POLL_FDS CONFIG_MB_MAX_INSTANCES
+#endif
 
 /****************************************************************************
  * Public Functions
  ****************************************************************************/
 
-bool xMBPortEventInit(void)
+bool xMBPortEventInit(xMBInstance *pxInst)
 {
-  xEventInQueue = false;
+  pxInst->xEventInQueue = false;
   return true;
 }
 
-bool xMBPortEventPost(eMBEventType eEvent)
+bool xMBPortEventPost(xMBInstance *pxInst, eMBEventType eEvent)
 {
-  xEventInQueue = true;
-  eQueuedEvent = eEvent;
+  pxInst->xEventInQueue = true;
+  pxInst->eQueuedEvent = eEvent;
   return true;
 }
 
-bool xMBPortEventGet(eMBEventType * eEvent)
+bool xMBPortEventGet(xMBInstance *pxInst, eMBEventType *eEvent)
 {
   bool xEventHappened = false;
 
-  if (xEventInQueue)
+  if (pxInst->xEventInQueue)
     {
-      *eEvent = eQueuedEvent;
-      xEventInQueue = false;
+      *eEvent = pxInst->eQueuedEvent;
+      pxInst->xEventInQueue = false;
       xEventHappened = true;
     }
-  else
+
+  return xEventHappened;
+}
+
+/* Wait until one of the instances has work to do, then run the receiver
+ * and transmitter state machines and the timers of all of them, which
+ * post the events for eMBPoll().  All instances share one poll(), so a
+ * single task can serve several buses.  The wait is at most
+ * CONFIG_MB_POLL_TIMEOUT_MS and is cut short by a running timer or an
+ * event that is already queued.
+ */
+
+bool xMBPortPoll(xMBInstance *apxInst[], int iCount)
+{
+  struct pollfd xFds[MB_POLL_FDS];
+  xMBInstance  *pxInst;
+  bool          bStatus = true;
+  int           aiFirstFd[CONFIG_MB_MAX_INSTANCES];
+  int           aiNumFds[CONFIG_MB_MAX_INSTANCES];
+  int           iTimeout = CONFIG_MB_POLL_TIMEOUT_MS;
+  int           nfds = 0;
+  int           i;
+
+  DEBUGASSERT(iCount <= CONFIG_MB_MAX_INSTANCES);
+
+  for (i = 0; i < iCount; i++)
     {
-      /* Poll the serial device. The serial device timeouts if no
-       * characters have been received within for t3.5 during an
-       * active transmission or if nothing happens within a specified
-       * amount of time. Both timeouts are configured from the timer
-       * init functions.
-       */
+      pxInst = apxInst[i];
+      aiFirstFd[i] = nfds;
+
+      if (pxInst->xEventInQueue)
+        {
+          iTimeout = 0;
+        }
 
-      xMBPortSerialPoll();
+      switch (pxInst->eMBCurrentMode)
+        {
+#if defined(CONFIG_MB_RTU_ENABLED) || defined(CONFIG_MB_ASCII_ENABLED)
+          case MB_RTU:
+          case MB_ASCII:
+            nfds += iMBPortSerialPollSetup(pxInst, &xFds[nfds], &iTimeout);
+            vMBPortTimerPollSetup(pxInst, &iTimeout);
+            break;
+#endif
 
-      /* Check if any of the timers have expired. */
+#ifdef CONFIG_MB_TCP_ENABLED
+          case MB_TCP:
+            nfds += iMBTCPPortPollSetup(pxInst, &xFds[nfds], &iTimeout);
+            break;
+#endif
 
-      vMBPortTimerPoll();
+          default:
+            break;
+        }
+
+      aiNumFds[i] = nfds - aiFirstFd[i];
     }
 
-  return xEventHappened;
+  if (poll(xFds, nfds, iTimeout) < 0)
+    {
+      if (errno != EINTR)
+        {
+          vMBPortLog(MB_LOG_ERROR, "POLL", "poll failed: %d\n", errno);
+          bStatus = false;
+        }
+
+      /* Still run the timers below */
+
+      for (i = 0; i < nfds; i++)
+        {
+          xFds[i].revents = 0;
+        }
+    }
+
+  for (i = 0; i < iCount; i++)
+    {
+      pxInst = apxInst[i];
+
+      switch (pxInst->eMBCurrentMode)
+        {
+#if defined(CONFIG_MB_RTU_ENABLED) || defined(CONFIG_MB_ASCII_ENABLED)
+          case MB_RTU:
+          case MB_ASCII:
+            {
+              short sRevents = 0;
+
+              /* The serial port has a descriptor only while receiving */
+
+              if (aiNumFds[i] > 0)
+                {
+                  sRevents = xFds[aiFirstFd[i]].revents;
+                }
+
+              if (!xMBPortSerialPoll(pxInst, sRevents))
+                {
+                  bStatus = false;
+                }
+
+              /* Check if any of the timers have expired. */
+
+              vMBPortTimerPoll(pxInst);
+            }
+            break;
+#endif
+
+#ifdef CONFIG_MB_TCP_ENABLED
+          case MB_TCP:
+
+            /* Serve the Modbus TCP connections */
+
+            xMBTCPPortPoll(pxInst, &xFds[aiFirstFd[i]]);
+            break;
+#endif
+
+          default:
+            break;
+        }
+    }
+
+  return bStatus;
 }
@@ -37,7 +37,7 @@
 #include "modbus/mb.h"
 #include "modbus/mb_m.h"
 #include "modbus/mbport.h"
-#include <sys/time.h>
+#include <time.h>
 #include <semaphore.h>
 #include <mqueue.h>
 #include <errno.h>
@@ -50,6 +50,10 @@
  * Pre-processor Definitions
  ****************************************************************************/
 
+#ifndef CONFIG_MB_MASTER_POLL_TIMEOUT_MS
+#  define CONFIG_MB_MASTER_POLL_TIMEOUT_MS 5
+#endif
+
 #define WAITER_EVENTS (EV_MASTER_PROCESS_SUCCESS           \
                        | EV_MASTER_ERROR_RESPOND_TIMEOUT   \
                        | EV_MASTER_ERROR_RECEIVE_DATA      \
@@ -97,6 +101,7 @@ bool xMBMasterPortEventPost(eMBMasterEventType eEvent)
 bool xMBMasterPortEventGet(eMBMasterEventType * eEvent)
 {
   bool xEventHappened = false;
+  int  iTimeout;
 
   *eEvent = 0;
 
@@ -135,13 +140,16 @@ bool xMBMasterPortEventGet(eMBMasterEventType * eEvent)
     }
   else
     {
-      /* Poll the serial device. The serial device timeouts if no characters
-       * have been received within for t3.5 during an active transmission or if
-       * nothing happens within a specified amount of time. Both timeouts are
-       * configured from the timer init functions.
+      /* Poll the serial device.  The poll ends when characters arrive,
+       * when the running timer (t3.5, response timeout or convert delay)
+       * expires or, if no timer runs, after
+       * CONFIG_MB_MASTER_POLL_TIMEOUT_MS so that requests posted by other
+       * tasks are picked up.
        */
 
-      xMBMasterPortSerialPoll();
+      iTimeout = CONFIG_MB_MASTER_POLL_TIMEOUT_MS;
+      vMBMasterPortTimerPollSetup(&iTimeout);
+      xMBMasterPortSerialPoll(iTimeout);
 
       /* Check if any of the timers have expired. */
 
@@ -172,7 +180,8 @@ void vMBMasterOsResInit(void)
  *   this function can just return true.
  *
  * Input Parameters:
- *   ulTimeOut the waiting time
+ *   ulTimeOut the waiting time in milliseconds, 0 to only try and -1 to
+ *     wait forever
  *
  * Returned Value:
  *   resource taken result
@@ -190,10 +199,23 @@ bool xMBMasterRunResTake(int32_t lTimeOut)
         }
       return true;
     }
+  else if (lTimeOut == 0)
+    {
+      return sem_trywait(&bussysem) == OK;
+    }
   else
     {
-      time.tv_sec = 0;
-      time.tv_nsec = lTimeOut * 1000;   /* convert to nano seconds */
+      /* sem_timedwait() takes an absolute time */
+
+      clock_gettime(CLOCK_REALTIME, &time);
+      time.tv_sec += lTimeOut / 1000;
+      time.tv_nsec += (lTimeOut % 1000) * 1000000;
+      if (time.tv_nsec >= 1000000000)
+        {
+          time.tv_sec++;
+          time.tv_nsec -= 1000000000;
+        }
+
       if (sem_timedwait(&bussysem, &time) != OK)
         {
           return false;
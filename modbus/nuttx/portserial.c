@@ -40,9 +40,8 @@
 #include <string.h>
 #include <sys/types.h>
 #include <sys/stat.h>
-#include <sys/select.h>
-#include <sys/time.h>
 #include <fcntl.h>
+#include <poll.h>
 #include <unistd.h>
 #include <assert.h>
 #include <termios.h>
@@ -52,93 +51,21 @@
 #include "modbus/mb.h"
 #include "modbus/mbport.h"
 
-/****************************************************************************
- * Pre-processor Definitions
- ****************************************************************************/
-
-#ifdef CONFIG_MB_ASCII_ENABLED
-#define BUF_SIZE    513         /* must hold a complete ASCII frame. */
-#else
-#define BUF_SIZE    256         /* must hold a complete RTU frame. */
-#endif
-
-/****************************************************************************
- * Private Data
- ****************************************************************************/
-
-static int      iSerialFd = -1;
-static bool     bRxEnabled;
-static bool     bTxEnabled;
-
-static uint32_t ulTimeoutMs;
-static uint8_t  ucBuffer[BUF_SIZE];
-static int      uiRxBufferPos;
-static int      uiTxBufferPos;
-
-static struct termios xOldTIO;
+#if defined(CONFIG_MB_RTU_ENABLED) || defined(CONFIG_MB_ASCII_ENABLED)
 
 /****************************************************************************
  * Private Function Prototypes
  ****************************************************************************/
 
-static bool prvbMBPortSerialRead(uint8_t *pucBuffer, uint16_t usNBytes,
-                                 uint16_t *usNBytesRead);
-static bool prvbMBPortSerialWrite(uint8_t *pucBuffer, uint16_t usNBytes);
+static bool prvbMBPortSerialWrite(xMBSerialState *pxSer,
+                                  uint8_t *pucBuffer, uint16_t usNBytes);
 
 /****************************************************************************
  * Private Functions
  ****************************************************************************/
 
-static bool prvbMBPortSerialRead(uint8_t *pucBuffer, uint16_t usNBytes,
-                                 uint16_t *usNBytesRead)
-{
-  bool            bResult = true;
-  ssize_t         res;
-  fd_set          rfds;
-  struct timeval  tv;
-
-  tv.tv_sec = 0;
-  tv.tv_usec = 50000;
-  FD_ZERO(&rfds);
-  FD_SET(iSerialFd, &rfds);
-
-  /* Wait until character received or timeout. Recover in case of an
-   * interrupted read system call.
-   */
-
-  do
-    {
-      if (select(iSerialFd + 1, &rfds, NULL, NULL, &tv) == -1)
-        {
-          if (errno != EINTR)
-            {
-              bResult = false;
-            }
-        }
-      else if (FD_ISSET(iSerialFd, &rfds))
-        {
-          if ((res = read(iSerialFd, pucBuffer, usNBytes)) == -1)
-            {
-              bResult = false;
-            }
-          else
-            {
-              *usNBytesRead = (uint16_t)res;
-              break;
-            }
-        }
-      else
-        {
-          *usNBytesRead = 0;
-          break;
-        }
-    }
-
-  while (bResult == true);
-  return bResult;
-}
-
-static bool prvbMBPortSerialWrite(uint8_t *pucBuffer, uint16_t usNBytes)
+static bool prvbMBPortSerialWrite(xMBSerialState *pxSer,
+                                  uint8_t *pucBuffer, uint16_t usNBytes)
 {
   ssize_t res;
   size_t  left = (size_t) usNBytes;
@@ -146,7 +73,7 @@ static bool prvbMBPortSerialWrite(uint8_t *pucBuffer, uint16_t usNBytes)
 
   while (left > 0)
     {
-      if ((res = write(iSerialFd, pucBuffer + done, left)) == -1)
+      if ((res = write(pxSer->iSerialFd, pucBuffer + done, left)) == -1)
         {
           if (errno != EINTR)
             {
@@ -169,50 +96,55 @@ static bool prvbMBPortSerialWrite(uint8_t *pucBuffer, uint16_t usNBytes)
  * Public Functions
  ****************************************************************************/
 
-void vMBPortSerialEnable(bool bEnableRx, bool bEnableTx)
+void vMBPortSerialEnable(xMBInstance *pxInst, bool bEnableRx,
+                         bool bEnableTx)
 {
+  xMBSerialState *pxSer = &pxInst->u.xSerial;
+
   /* it is not allowed that both receiver and transmitter are enabled. */
 
   DEBUGASSERT(!bEnableRx || !bEnableTx);
 
   if (bEnableRx)
     {
-      tcflush(iSerialFd, TCIFLUSH);
-      uiRxBufferPos = 0;
-      bRxEnabled = true;
+      tcflush(pxSer->iSerialFd, TCIFLUSH);
+      pxSer->uiRxBufferPos = 0;
+      pxSer->bRxEnabled = true;
     }
   else
     {
-      bRxEnabled = false;
+      pxSer->bRxEnabled = false;
     }
 
   if (bEnableTx)
     {
-      bTxEnabled = true;
-      uiTxBufferPos = 0;
+      pxSer->bTxEnabled = true;
+      pxSer->uiTxBufferPos = 0;
     }
   else
     {
-      bTxEnabled = false;
+      pxSer->bTxEnabled = false;
     }
 }
 
-bool xMBPortSerialInit(uint8_t ucPort, speed_t ulBaudRate,
-                       uint8_t ucDataBits, eMBParity eParity)
+bool xMBPortSerialInit(xMBInstance *pxInst, uint8_t ucPort,
+                       speed_t ulBaudRate, uint8_t ucDataBits,
+                       eMBParity eParity)
 {
+  xMBSerialState *pxSer = &pxInst->u.xSerial;
   char szDevice[16];
   bool bStatus = true;
   struct termios xNewTIO;
 
   snprintf(szDevice, 16, "/dev/ttyS%d", ucPort);
 
-  if ((iSerialFd = open(szDevice, O_RDWR | O_NOCTTY)) < 0)
+  if ((pxSer->iSerialFd = open(szDevice, O_RDWR | O_NOCTTY)) < 0)
     {
       vMBPortLog(MB_LOG_ERROR, "SER-INIT", "Can't open serial port %s: %d\n",
                  szDevice, errno);
       bStatus = false;
     }
-  else if (tcgetattr(iSerialFd, &xOldTIO) != 0)
+  else if (tcgetattr(pxSer->iSerialFd, &pxSer->xOldTIO) != 0)
     {
       vMBPortLog(MB_LOG_ERROR,
                  "SER-INIT", "Can't get settings from port %s: %d\n",
@@ -276,7 +208,7 @@ bool xMBPortSerialInit(uint8_t ucPort, speed_t ulBaudRate,
                          "Can't set baud rate %ld for port %s: %d\n",
                          ulBaudRate, szDevice, errno);
             }
-          else if (tcsetattr(iSerialFd, TCSANOW, &xNewTIO) != 0)
+          else if (tcsetattr(pxSer->iSerialFd, TCSANOW, &xNewTIO) != 0)
             {
               vMBPortLog(MB_LOG_ERROR,
                          "SER-INIT", "Can't set settings for port %s: %d\n",
@@ -284,7 +216,7 @@ bool xMBPortSerialInit(uint8_t ucPort, speed_t ulBaudRate,
             }
           else
             {
-              vMBPortSerialEnable(false, false);
+              vMBPortSerialEnable(pxInst, false, false);
               bStatus = true;
             }
         }
@@ -293,77 +225,90 @@ bool xMBPortSerialInit(uint8_t ucPort, speed_t ulBaudRate,
   return bStatus;
 }
 
-bool xMBPortSerialSetTimeout(uint32_t ulNewTimeoutMs)
+void vMBPortClose(xMBInstance *pxInst)
 {
-  if (ulNewTimeoutMs > 0)
-    {
-      ulTimeoutMs = ulNewTimeoutMs;
-    }
-  else
+  xMBSerialState *pxSer = &pxInst->u.xSerial;
+
+  if (pxSer->iSerialFd != -1)
     {
-      ulTimeoutMs = 1;
+      tcsetattr(pxSer->iSerialFd, TCSANOW, &pxSer->xOldTIO);
+      close(pxSer->iSerialFd);
+      pxSer->iSerialFd = -1;
     }
-
-  return true;
 }
 
-void vMBPortClose(void)
+/* Add the serial port to the poll set while the receiver is enabled.  A
+ * pending transmission is handled right away.
+ */
+
+int iMBPortSerialPollSetup(xMBInstance *pxInst, struct pollfd *pxFd,
+                           int *piTimeout)
 {
-  if (iSerialFd != -1)
+  xMBSerialState *pxSer = &pxInst->u.xSerial;
+
+  if (pxSer->bTxEnabled)
+    {
+      *piTimeout = 0;
+    }
+
+  if (!pxSer->bRxEnabled || pxSer->iSerialFd < 0)
     {
-      tcsetattr(iSerialFd, TCSANOW, &xOldTIO);
-      close(iSerialFd);
-      iSerialFd = -1;
+      return 0;
     }
+
+  pxFd->fd      = pxSer->iSerialFd;
+  pxFd->events  = POLLIN;
+  pxFd->revents = 0;
+  return 1;
 }
 
-bool xMBPortSerialPoll(void)
+bool xMBPortSerialPoll(xMBInstance *pxInst, short sRevents)
 {
+  xMBSerialState *pxSer = &pxInst->u.xSerial;
   bool     bStatus = true;
-  uint16_t usBytesRead;
+  ssize_t  nread;
   int      i;
 
-  while (bRxEnabled)
+  if (pxSer->bRxEnabled && (sRevents & (POLLIN | POLLERR | POLLHUP)))
     {
-      if (prvbMBPortSerialRead(&ucBuffer[0], BUF_SIZE, &usBytesRead))
-        {
-          if (usBytesRead == 0)
-            {
-              /* timeout with no bytes. */
+      /* poll() reported data, so a single read does not block */
 
-              break;
-            }
-          else if (usBytesRead > 0)
+      nread = read(pxSer->iSerialFd, pxSer->ucBuffer, MB_SER_BUF_SIZE);
+      if (nread < 0)
+        {
+          if (errno != EINTR && errno != EAGAIN)
             {
-              for (i = 0; i < usBytesRead; i++)
-                {
-                  /* Call the modbus stack and let him fill the buffers. */
-
-                  pxMBFrameCBByteReceived();
-                }
-
-              uiRxBufferPos = 0;
+              vMBPortLog(MB_LOG_ERROR,
+                         "SER-POLL", "read failed on serial device: %d\n",
+                         errno);
+              bStatus = false;
             }
         }
       else
         {
-          vMBPortLog(MB_LOG_ERROR,
-                     "SER-POLL", "read failed on serial device: %d\n",
-                     errno);
-          bStatus = false;
+          pxSer->uiRxBufferPos = 0;
+          for (i = 0; i < nread; i++)
+            {
+              /* Call the modbus stack and let him fill the buffers. */
+
+              pxInst->pxMBFrameCBByteReceived(pxInst);
+            }
+
+          pxSer->uiRxBufferPos = 0;
         }
     }
 
-  if (bTxEnabled)
+  if (pxSer->bTxEnabled)
     {
-      while (bTxEnabled)
+      while (pxSer->bTxEnabled)
         {
-          pxMBFrameCBTransmitterEmpty();
+          pxInst->pxMBFrameCBTransmitterEmpty(pxInst);
 
           /* Call the modbus stack to let him fill the buffer. */
         }
 
-      if (!prvbMBPortSerialWrite(&ucBuffer[0], uiTxBufferPos))
+      if (!prvbMBPortSerialWrite(pxSer, &pxSer->ucBuffer[0],
+                                 pxSer->uiTxBufferPos))
         {
           vMBPortLog(MB_LOG_ERROR,
                      "SER-POLL", "write failed on serial device: %d\n",
@@ -375,18 +320,24 @@ bool xMBPortSerialPoll(void)
   return bStatus;
 }
 
-bool xMBPortSerialPutByte(int8_t ucByte)
+bool xMBPortSerialPutByte(xMBInstance *pxInst, int8_t ucByte)
 {
-  DEBUGASSERT(uiTxBufferPos < BUF_SIZE);
-  ucBuffer[uiTxBufferPos] = ucByte;
-  uiTxBufferPos++;
+  xMBSerialState *pxSer = &pxInst->u.xSerial;
+
+  DEBUGASSERT(pxSer->uiTxBufferPos < MB_SER_BUF_SIZE);
+  pxSer->ucBuffer[pxSer->uiTxBufferPos] = ucByte;
+  pxSer->uiTxBufferPos++;
   return true;
 }
 
-bool xMBPortSerialGetByte(int8_t *pucByte)
+bool xMBPortSerialGetByte(xMBInstance *pxInst, int8_t *pucByte)
 {
-  DEBUGASSERT(uiRxBufferPos < BUF_SIZE);
-  *pucByte = ucBuffer[uiRxBufferPos];
-  uiRxBufferPos++;
+  xMBSerialState *pxSer = &pxInst->u.xSerial;
+
+  DEBUGASSERT(pxSer->uiRxBufferPos < MB_SER_BUF_SIZE);
+  *pucByte = pxSer->ucBuffer[pxSer->uiRxBufferPos];
+  pxSer->uiRxBufferPos++;
   return true;
 }
+
+#endif /* CONFIG_MB_RTU_ENABLED || CONFIG_MB_ASCII_ENABLED */
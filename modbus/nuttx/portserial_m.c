@@ -41,9 +41,8 @@
 #include <string.h>
 #include <sys/types.h>
 #include <sys/stat.h>
-#include <sys/select.h>
-#include <sys/time.h>
 #include <fcntl.h>
+#include <poll.h>
 #include <unistd.h>
 #include <assert.h>
 #include <termios.h>
@@ -74,7 +73,6 @@ static int      iSerialFd = -1;
 static bool     bRxEnabled;
 static bool     bTxEnabled;
 
-static uint32_t ulTimeoutMs;
 static uint8_t  ucBuffer[BUF_SIZE];
 static int      uiRxBufferPos;
 static int      uiTxBufferPos;
@@ -85,8 +83,6 @@ static struct termios xOldTIO;
  * Private Function Prototypes
  ****************************************************************************/
 
-static bool prvbMBMasterPortSerialRead(uint8_t *pucBuffer, uint16_t usNBytes,
-                                       uint16_t *usNBytesRead);
 static bool prvbMBMasterPortSerialWrite(uint8_t *pucBuffer,
                                         uint16_t usNBytes);
 
@@ -94,55 +90,6 @@ static bool prvbMBMasterPortSerialWrite(uint8_t *pucBuffer,
  * Private Functions
  ****************************************************************************/
 
-static bool prvbMBMasterPortSerialRead(uint8_t *pucBuffer, uint16_t usNBytes,
-                                       uint16_t *usNBytesRead)
-{
-  bool            bResult = true;
-  ssize_t         res;
-  fd_set          rfds;
-  struct timeval  tv;
-
-  tv.tv_sec = 0;
-  tv.tv_usec = 5000;
-  FD_ZERO(&rfds);
-  FD_SET(iSerialFd, &rfds);
-
-  /* Wait until character received or timeout. Recover in case of an
-   * interrupted read system call.
-   */
-
-  do
-    {
-      if (select(iSerialFd + 1, &rfds, NULL, NULL, &tv) == -1)
-        {
-          if (errno != EINTR)
-            {
-              bResult = false;
-            }
-        }
-      else if (FD_ISSET(iSerialFd, &rfds))
-        {
-          if ((res = read(iSerialFd, pucBuffer, usNBytes)) == -1)
-            {
-              bResult = false;
-            }
-          else
-            {
-              *usNBytesRead = (uint16_t)res;
-              break;
-            }
-        }
-      else
-        {
-          *usNBytesRead = 0;
-          break;
-        }
-    }
-  while (bResult == true);
-
-  return bResult;
-}
-
 static bool prvbMBMasterPortSerialWrite(uint8_t *pucBuffer,
                                         uint16_t usNBytes)
 {
@@ -301,20 +248,6 @@ bool xMBMasterPortSerialInit(uint8_t ucPort, speed_t ulBaudRate,
   return bStatus;
 }
 
-bool xMBMasterPortSerialSetTimeout(uint32_t ulNewTimeoutMs)
-{
-  if (ulNewTimeoutMs > 0)
-    {
-      ulTimeoutMs = ulNewTimeoutMs;
-    }
-  else
-    {
-      ulTimeoutMs = 1;
-    }
-
-  return true;
-}
-
 void vMBMasterPortClose(void)
 {
   if (iSerialFd != -1)
@@ -325,25 +258,51 @@ void vMBMasterPortClose(void)
     }
 }
 
-bool xMBMasterPortSerialPoll(void)
+/* Wait up to iTimeout milliseconds for input, hand what was received to
+ * the receiver state machine and send a pending frame.  The caller
+ * derives the timeout from the running timer, so the poll ends when t3.5
+ * or the response timeout expires.
+ */
+
+bool xMBMasterPortSerialPoll(int iTimeout)
 {
-  bool     bStatus = true;
-  uint16_t usBytesRead;
-  int      i;
+  struct pollfd xFd;
+  bool          bStatus = true;
+  ssize_t       nread;
+  int           ret;
+  int           i;
 
-  while (bRxEnabled)
+  if (bRxEnabled)
     {
-      if (prvbMBMasterPortSerialRead(&ucBuffer[0], BUF_SIZE, &usBytesRead))
+      xFd.fd      = iSerialFd;
+      xFd.events  = POLLIN;
+      xFd.revents = 0;
+
+      ret = poll(&xFd, 1, bTxEnabled ? 0 : iTimeout);
+      if (ret < 0 && errno != EINTR)
+        {
+          vMBMasterPortLog(MB_LOG_ERROR, "SER-POLL",
+                           "poll failed on serial device: %d\n",
+                           errno);
+          bStatus = false;
+        }
+      else if (ret > 0)
         {
-          if (usBytesRead == 0)
+          nread = read(iSerialFd, &ucBuffer[0], BUF_SIZE);
+          if (nread < 0)
             {
-              /* timeout with no bytes. */
-
-              break;
+              if (errno != EINTR && errno != EAGAIN)
+                {
+                  vMBMasterPortLog(MB_LOG_ERROR, "SER-POLL",
+                                   "read failed on serial device: %d\n",
+                                   errno);
+                  bStatus = false;
+                }
             }
-          else if (usBytesRead > 0)
+          else
             {
-              for (i = 0; i < usBytesRead; i++)
+              uiRxBufferPos = 0;
+              for (i = 0; i < nread; i++)
                 {
                   /* Call the modbus stack and let him fill the buffers. */
 
@@ -353,13 +312,6 @@ bool xMBMasterPortSerialPoll(void)
               uiRxBufferPos = 0;
             }
         }
-      else
-        {
-          vMBMasterPortLog(MB_LOG_ERROR, "SER-POLL",
-                           "read failed on serial device: %d\n",
-                           errno);
-          bStatus = false;
-        }
     }
 
   if (bTxEnabled)
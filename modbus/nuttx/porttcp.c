@@ -0,0 +1,588 @@
+/****************************************************************************
+ * apps/modbus/nuttx/porttcp.c
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "port.h"
+
+#include "modbus/mb.h"
+#include "modbus/mbport.h"
+
+#ifdef CONFIG_MB_TCP_ENABLED
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#define MB_TCP_DEFAULT_PORT   502   /* TCP listening port */
+#define MB_TCP_LISTEN_BACKLOG 8
+
+/* MBAP header: transaction id, protocol id, length and unit id.  The
+ * length counts the bytes that follow it, the unit id included.
+ */
+
+#define MB_TCP_LEN            4
+#define MB_TCP_UID            6
+#define MB_TCP_FUNC           7
+
+/****************************************************************************
+ * Private Types
+ ****************************************************************************/
+
+/* One connected master.  Requests are received into the connection's own
+ * buffer, so a master that sends a frame in pieces does not hold up the
+ * others, and a master may send several requests without waiting for the
+ * responses.  The connections of all instances come from one pool.
+ *
+ * Instances may be polled from different tasks.  Taking a free slot and
+ * giving it back is done with xClientsLock held.  Everything else only
+ * touches the slots owned by the calling instance, which no other
+ * instance can claim or release.
+ */
+
+typedef struct
+{
+  int          iSocket;                    /* -1 if the slot is free */
+  xMBInstance *pxOwner;                    /* Instance that accepted it */
+  time_t       xLastActive;                /* Time of the last request */
+  uint16_t     usRxPos;                    /* Bytes in ucRxBuf */
+  uint16_t     usTxPos;                    /* Bytes of ucTxBuf sent */
+  uint16_t     usTxLen;                    /* Bytes in ucTxBuf */
+  uint8_t      ucRxBuf[MB_TCP_BUF_SIZE];
+  uint8_t      ucTxBuf[MB_TCP_BUF_SIZE];
+} xMBTCPClient;
+
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+static xMBTCPClient    xClients[CONFIG_MB_TCP_MAX_CLIENTS];
+static bool            bClientsInit;
+static pthread_mutex_t xClientsLock = PTHREAD_MUTEX_INITIALIZER;
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+static void prvvMBTCPClientClose(xMBTCPClient *pxClient)
+{
+  xMBTCPState *pxTCP;
+
+  pthread_mutex_lock(&xClientsLock);
+
+  if (pxClient->iSocket != -1)
+    {
+      close(pxClient->iSocket);
+      pxClient->iSocket = -1;
+    }
+
+  if (pxClient->pxOwner != NULL)
+    {
+      pxTCP = &pxClient->pxOwner->u.xTCP;
+      if (pxTCP->iCurClient == pxClient - xClients)
+        {
+          pxTCP->iCurClient = -1;
+        }
+
+      pxClient->pxOwner = NULL;
+    }
+
+  pthread_mutex_unlock(&xClientsLock);
+}
+
+static void prvvMBTCPAccept(xMBInstance *pxInst)
+{
+  xMBTCPClient *pxClient = NULL;
+  int           iSocket;
+  int           i;
+
+  iSocket = accept(pxInst->u.xTCP.iListenSocket, NULL, NULL);
+  if (iSocket < 0)
+    {
+      if (errno != EAGAIN && errno != EWOULDBLOCK)
+        {
+          vMBPortLog(MB_LOG_ERROR, "MBTCP-ACCEPT",
+                     "accept failed: %d\n", errno);
+        }
+
+      return;
+    }
+
+  fcntl(iSocket, F_SETFL, fcntl(iSocket, F_GETFL) | O_NONBLOCK);
+
+  pthread_mutex_lock(&xClientsLock);
+
+  for (i = 0; i < CONFIG_MB_TCP_MAX_CLIENTS; i++)
+    {
+      if (xClients[i].iSocket == -1)
+        {
+          pxClient = &xClients[i];
+          break;
+        }
+    }
+
+  if (pxClient == NULL)
+    {
+      pthread_mutex_unlock(&xClientsLock);
+      vMBPortLog(MB_LOG_WARN, "MBTCP-ACCEPT",
+                 "too many clients, connection refused\n");
+      close(iSocket);
+      return;
+    }
+
+  pxClient->xLastActive = time(NULL);
+  pxClient->usRxPos     = 0;
+  pxClient->usTxPos     = 0;
+  pxClient->usTxLen     = 0;
+  pxClient->pxOwner     = pxInst;
+  pxClient->iSocket     = iSocket;
+
+  pthread_mutex_unlock(&xClientsLock);
+
+  vMBPortLog(MB_LOG_DEBUG, "MBTCP-ACCEPT",
+             "client %d connected\n", (int)(pxClient - xClients));
+}
+
+/* Return the length of the complete frame at the start of the receive
+ * buffer, 0 if the frame is not complete yet or -1 if the header is bad.
+ */
+
+static int prviMBTCPFrameLen(xMBTCPClient *pxClient)
+{
+  uint16_t usLen;
+
+  if (pxClient->usRxPos < MB_TCP_FUNC)
+    {
+      return 0;
+    }
+
+  usLen = pxClient->ucRxBuf[MB_TCP_LEN] << 8U;
+  usLen |= pxClient->ucRxBuf[MB_TCP_LEN + 1];
+
+  /* At least the unit id and the function code */
+
+  if (usLen < 2 || usLen + MB_TCP_UID > MB_TCP_BUF_SIZE)
+    {
+      return -1;
+    }
+
+  if (pxClient->usRxPos < usLen + MB_TCP_UID)
+    {
+      return 0;
+    }
+
+  return usLen + MB_TCP_UID;
+}
+
+static void prvvMBTCPReceive(xMBTCPClient *pxClient)
+{
+  ssize_t res;
+
+  /* Stop reading once a complete frame is buffered, the stack takes the
+   * frames of a connection one at a time.
+   */
+
+  if (pxClient->usRxPos == MB_TCP_BUF_SIZE ||
+      prviMBTCPFrameLen(pxClient) > 0)
+    {
+      return;
+    }
+
+  res = recv(pxClient->iSocket, &pxClient->ucRxBuf[pxClient->usRxPos],
+             MB_TCP_BUF_SIZE - pxClient->usRxPos, 0);
+  if (res == 0)
+    {
+      vMBPortLog(MB_LOG_DEBUG, "MBTCP-RECV", "client %d closed\n",
+                 (int)(pxClient - xClients));
+      prvvMBTCPClientClose(pxClient);
+    }
+  else if (res < 0)
+    {
+      if (errno != EAGAIN && errno != EWOULDBLOCK)
+        {
+          prvvMBTCPClientClose(pxClient);
+        }
+    }
+  else
+    {
+      pxClient->usRxPos += res;
+      pxClient->xLastActive = time(NULL);
+      if (prviMBTCPFrameLen(pxClient) < 0)
+        {
+          vMBPortLog(MB_LOG_WARN, "MBTCP-RECV",
+                     "client %d: bad MBAP header\n",
+                     (int)(pxClient - xClients));
+          prvvMBTCPClientClose(pxClient);
+        }
+    }
+}
+
+static void prvvMBTCPFlush(xMBTCPClient *pxClient)
+{
+  ssize_t res;
+
+  while (pxClient->usTxPos < pxClient->usTxLen)
+    {
+      res = send(pxClient->iSocket, &pxClient->ucTxBuf[pxClient->usTxPos],
+                 pxClient->usTxLen - pxClient->usTxPos, 0);
+      if (res < 0)
+        {
+          if (errno != EAGAIN && errno != EWOULDBLOCK)
+            {
+              prvvMBTCPClientClose(pxClient);
+            }
+
+          return;
+        }
+
+      pxClient->usTxPos += res;
+    }
+
+  pxClient->usTxPos = 0;
+  pxClient->usTxLen = 0;
+}
+
+/* Hand the next buffered request to the stack.  The connections are
+ * served round-robin so that a busy master cannot starve the others.
+ */
+
+static bool prvbMBTCPNextFrame(xMBInstance *pxInst)
+{
+  xMBTCPState  *pxTCP = &pxInst->u.xTCP;
+  xMBTCPClient *pxClient;
+  int           iLen;
+  int           i;
+
+  for (i = 0; i < CONFIG_MB_TCP_MAX_CLIENTS; i++)
+    {
+      pxClient = &xClients[(pxTCP->iNextClient + i) %
+                           CONFIG_MB_TCP_MAX_CLIENTS];
+
+      /* A connection gets its next response only after the previous one
+       * has been sent.
+       */
+
+      if (pxClient->iSocket == -1 || pxClient->pxOwner != pxInst ||
+          pxClient->usTxLen != 0)
+        {
+          continue;
+        }
+
+      iLen = prviMBTCPFrameLen(pxClient);
+      if (iLen <= 0)
+        {
+          continue;
+        }
+
+      /* The request is copied out of the receive buffer because the
+       * stack builds the response in place and a response may be longer
+       * than the request.
+       */
+
+      memcpy(pxTCP->ucTCPFrame, pxClient->ucRxBuf, iLen);
+      pxTCP->usTCPFrameLen = iLen;
+      pxClient->usRxPos -= iLen;
+      memmove(pxClient->ucRxBuf, &pxClient->ucRxBuf[iLen],
+              pxClient->usRxPos);
+
+      pxTCP->iCurClient = pxClient - xClients;
+      pxTCP->iNextClient = (pxTCP->iCurClient + 1) %
+                           CONFIG_MB_TCP_MAX_CLIENTS;
+      return xMBPortEventPost(pxInst, EV_FRAME_RECEIVED);
+    }
+
+  return false;
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+bool xMBTCPPortInit(xMBInstance *pxInst, uint16_t usTCPPort)
+{
+  xMBTCPState       *pxTCP = &pxInst->u.xTCP;
+  struct sockaddr_in xAddr;
+  int                iOpt = 1;
+  int                i;
+
+  pthread_mutex_lock(&xClientsLock);
+
+  if (!bClientsInit)
+    {
+      for (i = 0; i < CONFIG_MB_TCP_MAX_CLIENTS; i++)
+        {
+          xClients[i].iSocket = -1;
+          xClients[i].pxOwner = NULL;
+        }
+
+      bClientsInit = true;
+    }
+
+  pthread_mutex_unlock(&xClientsLock);
+
+  pxTCP->iCurClient = -1;
+  pxTCP->iNextClient = 0;
+
+  pxTCP->iListenSocket = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+  if (pxTCP->iListenSocket < 0)
+    {
+      vMBPortLog(MB_LOG_ERROR, "MBTCP-INIT",
+                 "socket failed: %d\n", errno);
+      return false;
+    }
+
+  setsockopt(pxTCP->iListenSocket, SOL_SOCKET, SO_REUSEADDR, &iOpt,
+             sizeof(iOpt));
+
+  memset(&xAddr, 0, sizeof(xAddr));
+  xAddr.sin_family      = AF_INET;
+  xAddr.sin_addr.s_addr = htonl(INADDR_ANY);
+  xAddr.sin_port        = htons(usTCPPort == MB_TCP_PORT_USE_DEFAULT ?
+                                MB_TCP_DEFAULT_PORT : usTCPPort);
+
+  if (bind(pxTCP->iListenSocket, (struct sockaddr *)&xAddr,
+           sizeof(xAddr)) < 0 ||
+      listen(pxTCP->iListenSocket, MB_TCP_LISTEN_BACKLOG) < 0)
+    {
+      vMBPortLog(MB_LOG_ERROR, "MBTCP-INIT",
+                 "bind/listen failed: %d\n", errno);
+      close(pxTCP->iListenSocket);
+      pxTCP->iListenSocket = -1;
+      return false;
+    }
+
+  fcntl(pxTCP->iListenSocket, F_SETFL,
+        fcntl(pxTCP->iListenSocket, F_GETFL) | O_NONBLOCK);
+
+  return true;
+}
+
+#ifdef CONFIG_MB_HAVE_CLOSE
+void vMBTCPPortClose(xMBInstance *pxInst)
+{
+  xMBTCPState *pxTCP = &pxInst->u.xTCP;
+
+  vMBTCPPortDisable(pxInst);
+
+  if (pxTCP->iListenSocket != -1)
+    {
+      close(pxTCP->iListenSocket);
+      pxTCP->iListenSocket = -1;
+    }
+}
+#endif
+
+void vMBTCPPortDisable(xMBInstance *pxInst)
+{
+  int i;
+
+  for (i = 0; i < CONFIG_MB_TCP_MAX_CLIENTS; i++)
+    {
+      if (xClients[i].pxOwner == pxInst)
+        {
+          prvvMBTCPClientClose(&xClients[i]);
+        }
+    }
+}
+
+/* Add the listening socket and the connections of the instance to the
+ * poll set of xMBPortPoll().
+ */
+
+int iMBTCPPortPollSetup(xMBInstance *pxInst, struct pollfd *pxFds,
+                        int *piTimeout)
+{
+  xMBTCPClient *pxClient;
+  int           nfds = 0;
+  int           i;
+
+  if (pxInst->u.xTCP.iListenSocket == -1)
+    {
+      return 0;
+    }
+
+  pxFds[nfds].fd      = pxInst->u.xTCP.iListenSocket;
+  pxFds[nfds].events  = POLLIN;
+  pxFds[nfds].revents = 0;
+  nfds++;
+
+  for (i = 0; i < CONFIG_MB_TCP_MAX_CLIENTS; i++)
+    {
+      pxClient = &xClients[i];
+      if (pxClient->iSocket == -1 || pxClient->pxOwner != pxInst)
+        {
+          continue;
+        }
+
+      /* Wait for room to send the pending response, or for more data
+       * unless a request is already complete.  Do not wait at all if it
+       * is, the request is served right after the poll.
+       */
+
+      pxFds[nfds].fd      = pxClient->iSocket;
+      pxFds[nfds].revents = 0;
+      if (pxClient->usTxLen != 0)
+        {
+          pxFds[nfds].events = POLLOUT;
+        }
+      else if (prviMBTCPFrameLen(pxClient) > 0)
+        {
+          pxFds[nfds].events = 0;
+          *piTimeout = 0;
+        }
+      else
+        {
+          pxFds[nfds].events = POLLIN;
+        }
+
+      nfds++;
+    }
+
+  return nfds;
+}
+
+/* Serve the network events of the instance, then post a frame received
+ * event if a request is complete.
+ */
+
+bool xMBTCPPortPoll(xMBInstance *pxInst, struct pollfd *pxFds)
+{
+  xMBTCPClient *pxClient;
+  int           nfds;
+  int           i;
+
+  if (pxInst->u.xTCP.iListenSocket == -1)
+    {
+      return false;
+    }
+
+  /* The descriptors are in the order of the client slots */
+
+  nfds = 1;
+  for (i = 0; i < CONFIG_MB_TCP_MAX_CLIENTS; i++)
+    {
+      pxClient = &xClients[i];
+      if (pxClient->iSocket == -1 || pxClient->pxOwner != pxInst)
+        {
+          continue;
+        }
+
+      if (pxFds[nfds].revents & POLLOUT)
+        {
+          prvvMBTCPFlush(pxClient);
+        }
+      else if (pxFds[nfds].revents & (POLLIN | POLLHUP | POLLERR))
+        {
+          prvvMBTCPReceive(pxClient);
+        }
+
+      nfds++;
+    }
+
+  if (pxFds[0].revents & POLLIN)
+    {
+      prvvMBTCPAccept(pxInst);
+    }
+
+#if CONFIG_MB_TCP_CLIENT_TIMEOUT > 0
+  /* Drop the masters that went away without closing their connection */
+
+  for (i = 0; i < CONFIG_MB_TCP_MAX_CLIENTS; i++)
+    {
+      pxClient = &xClients[i];
+      if (pxClient->iSocket != -1 && pxClient->pxOwner == pxInst &&
+          time(NULL) - pxClient->xLastActive > CONFIG_MB_TCP_CLIENT_TIMEOUT)
+        {
+          vMBPortLog(MB_LOG_DEBUG, "MBTCP-POLL", "client %d timed out\n", i);
+          prvvMBTCPClientClose(pxClient);
+        }
+    }
+#endif
+
+  /* The queue holds one event, do not overwrite a pending one */
+
+  if (pxInst->xEventInQueue)
+    {
+      return true;
+    }
+
+  return prvbMBTCPNextFrame(pxInst);
+}
+
+bool xMBTCPPortGetRequest(xMBInstance *pxInst, uint8_t **ppucMBTCPFrame,
+                          uint16_t *usTCPLength)
+{
+  xMBTCPState *pxTCP = &pxInst->u.xTCP;
+
+  if (pxTCP->iCurClient == -1)
+    {
+      return false;
+    }
+
+  *ppucMBTCPFrame = pxTCP->ucTCPFrame;
+  *usTCPLength    = pxTCP->usTCPFrameLen;
+  return true;
+}
+
+bool xMBTCPPortSendResponse(xMBInstance *pxInst,
+                            const uint8_t *pucMBTCPFrame,
+                            uint16_t usTCPLength)
+{
+  xMBTCPState  *pxTCP = &pxInst->u.xTCP;
+  xMBTCPClient *pxClient;
+
+  /* The connection may have been closed while the request was processed */
+
+  if (pxTCP->iCurClient == -1 || usTCPLength > MB_TCP_BUF_SIZE)
+    {
+      pxTCP->iCurClient = -1;
+      return false;
+    }
+
+  pxClient = &xClients[pxTCP->iCurClient];
+  pxTCP->iCurClient = -1;
+
+  /* The response carries the transaction id of its request, which the
+   * stack left in the MBAP header.  Whatever the socket does not take now
+   * is sent when the connection becomes writable.
+   */
+
+  memcpy(pxClient->ucTxBuf, pucMBTCPFrame, usTCPLength);
+  pxClient->usTxPos = 0;
+  pxClient->usTxLen = usTCPLength;
+  prvvMBTCPFlush(pxClient);
+
+  return true;
+}
+
+#endif /* CONFIG_MB_TCP_ENABLED */
@@ -35,7 +35,7 @@
 
 #include <nuttx/config.h>
 
-#include <sys/time.h>
+#include <time.h>
 #include <stdlib.h>
 #include <assert.h>
 
@@ -44,72 +44,99 @@
 #include "modbus/mb.h"
 #include "modbus/mbport.h"
 
+#if defined(CONFIG_MB_RTU_ENABLED) || defined(CONFIG_MB_ASCII_ENABLED)
+
 /****************************************************************************
- * Public Data
+ * Pre-processor Definitions
  ****************************************************************************/
 
-uint32_t ulTimeOut;
-bool     bTimeoutEnable;
+/* The clock advances in system ticks.  A timeout shorter than two ticks
+ * could expire right after it was started and cut a frame in two.
+ */
 
-static struct timeval xTimeLast;
+#define MB_TIMER_MIN_MS  ((2 * CONFIG_USEC_PER_TICK + 999) / 1000)
 
 /****************************************************************************
- * Public Functions
+ * Private Functions
  ****************************************************************************/
 
-bool xMBPortTimersInit(uint16_t usTim1Timerout50us)
+static uint32_t prvulMBPortTimerElapsed(xMBSerialState *pxSer)
 {
-  ulTimeOut = usTim1Timerout50us / 20U;
-  if (ulTimeOut == 0)
+  struct timespec xTimeCur;
+
+  if (clock_gettime(CLOCK_MONOTONIC, &xTimeCur) != 0)
     {
-      ulTimeOut = 1;
+      /* clock_gettime failed - retry next time. */
+
+      return 0;
     }
 
-  return xMBPortSerialSetTimeout(ulTimeOut);
+  return (xTimeCur.tv_sec - pxSer->xTimeLast.tv_sec) * 1000L +
+         (xTimeCur.tv_nsec - pxSer->xTimeLast.tv_nsec) / 1000000L;
 }
 
-void xMBPortTimersClose(void)
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+bool xMBPortTimersInit(xMBInstance *pxInst, uint16_t usTim1Timerout50us)
 {
-  /* Does not use any hardware resources. */
+  xMBSerialState *pxSer = &pxInst->u.xSerial;
+
+  pxSer->ulTimeOut = usTim1Timerout50us / 20U;
+  if (pxSer->ulTimeOut < MB_TIMER_MIN_MS)
+    {
+      pxSer->ulTimeOut = MB_TIMER_MIN_MS;
+    }
+
+  pxSer->bTimeoutEnable = false;
+  return true;
 }
 
-void vMBPortTimerPoll(void)
-{
-  uint32_t       ulDeltaMS;
-  struct timeval xTimeCur;
+/* Shorten the poll timeout so that we wake up when the timer expires */
 
-  /* Timers are called from the serial layer because we have no high
-   * res timer in Win32.
-   */
+void vMBPortTimerPollSetup(xMBInstance *pxInst, int *piTimeout)
+{
+  xMBSerialState *pxSer = &pxInst->u.xSerial;
+  uint32_t ulDeltaMS;
+  int      iRemain;
 
-  if (bTimeoutEnable)
+  if (pxSer->bTimeoutEnable)
     {
-      if (gettimeofday(&xTimeCur, NULL) != 0)
-        {
-          /* gettimeofday failed - retry next time. */
-        }
-      else
+      ulDeltaMS = prvulMBPortTimerElapsed(pxSer);
+      iRemain = ulDeltaMS > pxSer->ulTimeOut ?
+                0 : (int)(pxSer->ulTimeOut - ulDeltaMS) + 1;
+      if (iRemain < *piTimeout)
         {
-          ulDeltaMS = (xTimeCur.tv_sec - xTimeLast.tv_sec) * 1000L +
-                      (xTimeCur.tv_usec - xTimeLast.tv_usec) * 1000L;
-          if (ulDeltaMS > ulTimeOut)
-            {
-              bTimeoutEnable = false;
-              pxMBPortCBTimerExpired();
-            }
+          *piTimeout = iRemain;
         }
     }
 }
 
-void vMBPortTimersEnable(void)
+void vMBPortTimerPoll(xMBInstance *pxInst)
 {
-  int res = gettimeofday(&xTimeLast, NULL);
+  xMBSerialState *pxSer = &pxInst->u.xSerial;
+
+  if (pxSer->bTimeoutEnable &&
+      prvulMBPortTimerElapsed(pxSer) > pxSer->ulTimeOut)
+    {
+      pxSer->bTimeoutEnable = false;
+      pxInst->pxMBPortCBTimerExpired(pxInst);
+    }
+}
+
+void vMBPortTimersEnable(xMBInstance *pxInst)
+{
+  xMBSerialState *pxSer = &pxInst->u.xSerial;
+  int res = clock_gettime(CLOCK_MONOTONIC, &pxSer->xTimeLast);
 
   DEBUGASSERT(res == 0);
-  bTimeoutEnable = true;
+  pxSer->bTimeoutEnable = true;
 }
 
-void vMBPortTimersDisable(void)
+void vMBPortTimersDisable(xMBInstance *pxInst)
 {
-  bTimeoutEnable = false;
+  pxInst->u.xSerial.bTimeoutEnable = false;
 }
+
+#endif /* CONFIG_MB_RTU_ENABLED || CONFIG_MB_ASCII_ENABLED */
@@ -36,7 +36,7 @@
 
 #include <nuttx/config.h>
 
-#include <sys/time.h>
+#include <time.h>
 #include <stdlib.h>
 #include <assert.h>
 
@@ -60,29 +60,56 @@
 #  define MB_MASTER_TIMEOUT_MS_RESPOND CONFIG_MB_MASTER_TIMEOUT_MS_RESPOND
 #endif
 
+/* The clock advances in system ticks.  A timeout shorter than two ticks
+ * could expire right after it was started and cut a response in two.
+ */
+
+#define MB_MASTER_TIMER_MIN_US  (2 * CONFIG_USEC_PER_TICK)
+#define MB_MASTER_TIMER_MIN_MS  ((MB_MASTER_TIMER_MIN_US + 999) / 1000)
+
 /****************************************************************************
- * Public Data
+ * Private Data
  ****************************************************************************/
 
-uint32_t ulTimeOut;                /* current timeout duration        */
-uint32_t ulTimeoutT35;             /* 3.5 byte transmission duration  */
-uint32_t ulTimeoutConvertDelay;    /* timeout after broadcast message */
-uint32_t ulTimeoutResponse;        /* response timeout duration       */
-static struct timeval xTimeLast;
-bool bTimeoutEnable;               /* timeout is active */
+/* All durations are in microseconds.  The inter-frame time t3.5 follows
+ * from the baud rate, so the end of a response is detected as soon as the
+ * line has been quiet for t3.5 and not at the next fixed poll interval.
+ */
+
+static uint32_t ulTimeOut;               /* current timeout duration        */
+static uint32_t ulTimeoutT35;            /* 3.5 byte transmission duration  */
+static uint32_t ulTimeoutConvertDelay;   /* timeout after broadcast message */
+static uint32_t ulTimeoutResponse;       /* response timeout duration       */
+static struct timespec xTimeLast;
+static bool bTimeoutEnable;              /* timeout is active */
 
 /****************************************************************************
  * Private Functions
  ****************************************************************************/
 
-void vMBMasterPortTimersEnable( void )
+static void prvvMBMasterPortTimersEnable(void)
 {
-  int res = gettimeofday(&xTimeLast, NULL);
+  int res = clock_gettime(CLOCK_MONOTONIC, &xTimeLast);
 
   DEBUGASSERT(res == 0);
   bTimeoutEnable = true;
 }
 
+static uint32_t prvulMBMasterPortTimerElapsed(void)
+{
+  struct timespec xTimeCur;
+
+  if (clock_gettime(CLOCK_MONOTONIC, &xTimeCur) != 0)
+    {
+      /* clock_gettime failed - retry next time. */
+
+      return 0;
+    }
+
+  return (xTimeCur.tv_sec - xTimeLast.tv_sec) * 1000000L +
+         (xTimeCur.tv_nsec - xTimeLast.tv_nsec) / 1000L;
+}
+
 /****************************************************************************
  * Public Functions
  ****************************************************************************/
@@ -91,27 +118,28 @@ bool xMBMasterPortTimersInit(uint16_t usTimeOut50us)
 {
   /* Configure all timeout values */
 
-  ulTimeoutT35 = usTimeOut50us / 20U;
-  if (ulTimeoutT35 == 0)
+  ulTimeoutT35 = usTimeOut50us * 50U;
+  if (ulTimeoutT35 < MB_MASTER_TIMER_MIN_US)
     {
-      ulTimeoutT35 = 1;
+      ulTimeoutT35 = MB_MASTER_TIMER_MIN_US;
     }
 
-  ulTimeoutConvertDelay = MB_MASTER_DELAY_MS_CONVERT;
+  ulTimeoutConvertDelay = MB_MASTER_DELAY_MS_CONVERT * 1000U;
   if (ulTimeoutConvertDelay == 0)
     {
-      ulTimeoutConvertDelay = 1;
+      ulTimeoutConvertDelay = 1000;
     }
 
-  ulTimeoutResponse = MB_MASTER_TIMEOUT_MS_RESPOND;
+  ulTimeoutResponse = MB_MASTER_TIMEOUT_MS_RESPOND * 1000U;
   if (ulTimeoutResponse == 0)
     {
-      ulTimeoutResponse = 1;
+      ulTimeoutResponse = 1000;
     }
 
   ulTimeOut = ulTimeoutT35;
+  bTimeoutEnable = false;
 
-  return xMBMasterPortSerialSetTimeout(ulTimeOut);
+  return true;
 }
 
 void xMBMasterPortTimersClose()
@@ -121,53 +149,65 @@ void xMBMasterPortTimersClose()
 
 INLINE void vMBMasterPortTimersT35Enable( void )
 {
-  vMBMasterPortTimersEnable();
+  prvvMBMasterPortTimersEnable();
   ulTimeOut = ulTimeoutT35;
   vMBMasterSetCurTimerMode(MB_TMODE_T35);
 }
 
 INLINE void vMBMasterPortTimersConvertDelayEnable( void )
 {
-  vMBMasterPortTimersEnable();
+  prvvMBMasterPortTimersEnable();
   ulTimeOut = ulTimeoutConvertDelay;
   vMBMasterSetCurTimerMode(MB_TMODE_CONVERT_DELAY);
 }
 
 INLINE void vMBMasterPortTimersRespondTimeoutEnable( void )
 {
-  vMBMasterPortTimersEnable();
+  prvvMBMasterPortTimersEnable();
   ulTimeOut = ulTimeoutResponse;
   vMBMasterSetCurTimerMode( MB_TMODE_RESPOND_TIMEOUT );
 }
 
-void vMBMasterPortTimerPoll( void )
-{
-  uint32_t       ulDeltaMS;
-  struct timeval xTimeCur;
+/* Shorten the serial poll timeout (in milliseconds) so that the poll
+ * returns when the running timer expires.
+ */
 
-  /* Timers are called from the serial layer because we have no high
-   * res timer in Win32.
-   */
+void vMBMasterPortTimerPollSetup(int *piTimeout)
+{
+  uint32_t ulDeltaUS;
+  int      iRemain;
 
   if (bTimeoutEnable)
     {
-      if (gettimeofday(&xTimeCur, NULL) != 0)
+      ulDeltaUS = prvulMBMasterPortTimerElapsed();
+      iRemain = ulDeltaUS >= ulTimeOut ?
+                0 : (int)((ulTimeOut - ulDeltaUS + 999) / 1000);
+
+      /* Do not poll for less than two ticks.  A shorter wait only
+       * wakes up at a tick edge before the timer can expire.
+       */
+
+      if (iRemain > 0 && iRemain < MB_MASTER_TIMER_MIN_MS)
         {
-          /* gettimeofday failed - retry next time. */
+          iRemain = MB_MASTER_TIMER_MIN_MS;
         }
-      else
+
+      if (iRemain < *piTimeout)
         {
-          ulDeltaMS = (xTimeCur.tv_sec - xTimeLast.tv_sec) * 1000L +
-                      (xTimeCur.tv_usec - xTimeLast.tv_usec) / 1000L;
-          if (ulDeltaMS > ulTimeOut)
-            {
-              bTimeoutEnable = false;
-              pxMBMasterPortCBTimerExpired();
-            }
+          *piTimeout = iRemain;
         }
     }
 }
 
+void vMBMasterPortTimerPoll( void )
+{
+  if (bTimeoutEnable && prvulMBMasterPortTimerElapsed() >= ulTimeOut)
+    {
+      bTimeoutEnable = false;
+      pxMBMasterPortCBTimerExpired();
+    }
+}
+
 void vMBMasterPortTimersDisable()
 {
   bTimeoutEnable = false;
@@ -81,11 +81,11 @@
  * Public Functions
  ****************************************************************************/
 
-eMBErrorCode eMBTCPDoInit(uint16_t ucTCPPort)
+eMBErrorCode eMBTCPDoInit(xMBInstance *pxInst, uint16_t ucTCPPort)
 {
   eMBErrorCode    eStatus = MB_ENOERR;
 
-  if (xMBTCPPortInit(ucTCPPort) == false)
+  if (xMBTCPPortInit(pxInst, ucTCPPort) == false)
     {
       eStatus = MB_EPORTERR;
     }
@@ -93,25 +93,26 @@ eMBErrorCode eMBTCPDoInit(uint16_t ucTCPPort)
    return eStatus;
 }
 
-void eMBTCPStart(void)
+void eMBTCPStart(xMBInstance *pxInst)
 {
 }
 
-void eMBTCPStop(void)
+void eMBTCPStop(xMBInstance *pxInst)
 {
    /* Make sure that no more clients are connected. */
 
-  vMBTCPPortDisable();
+  vMBTCPPortDisable(pxInst);
 }
 
-eMBErrorCode eMBTCPReceive(uint8_t *pucRcvAddress, uint8_t **ppucFrame, uint16_t *pusLength)
+eMBErrorCode eMBTCPReceive(xMBInstance *pxInst, uint8_t *pucRcvAddress,
+                           uint8_t **ppucFrame, uint16_t *pusLength)
 {
   eMBErrorCode    eStatus = MB_EIO;
   uint8_t        *pucMBTCPFrame;
   uint16_t        usLength;
   uint16_t        usPID;
 
-  if (xMBTCPPortGetRequest(&pucMBTCPFrame, &usLength) != false)
+  if (xMBTCPPortGetRequest(pxInst, &pucMBTCPFrame, &usLength) != false)
     {
       usPID = pucMBTCPFrame[MB_TCP_PID] << 8U;
       usPID |= pucMBTCPFrame[MB_TCP_PID + 1];
@@ -137,7 +138,8 @@ eMBErrorCode eMBTCPReceive(uint8_t *pucRcvAddress, uint8_t **ppucFrame, uint16_t
   return eStatus;
 }
 
-eMBErrorCode eMBTCPSend(uint8_t _unused, const uint8_t * pucFrame, uint16_t usLength)
+eMBErrorCode eMBTCPSend(xMBInstance *pxInst, uint8_t _unused,
+                        const uint8_t *pucFrame, uint16_t usLength)
 {
   eMBErrorCode    eStatus = MB_ENOERR;
   uint8_t        *pucMBTCPFrame = (uint8_t *) pucFrame - MB_TCP_FUNC;
@@ -152,7 +154,7 @@ eMBErrorCode eMBTCPSend(uint8_t _unused, const uint8_t * pucFrame, uint16_t usLe
 
   pucMBTCPFrame[MB_TCP_LEN] = (usLength + 1) >> 8U;
   pucMBTCPFrame[MB_TCP_LEN + 1] = (usLength + 1) & 0xFF;
-  if (xMBTCPPortSendResponse(pucMBTCPFrame, usTCPLength) == false)
+  if (xMBTCPPortSendResponse(pxInst, pucMBTCPFrame, usTCPLength) == false)
     {
       eStatus = MB_EIO;
     }
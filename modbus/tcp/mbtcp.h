@@ -47,13 +47,13 @@ extern "C"
  * Public Function Prototypes
  ****************************************************************************/
 
-eMBErrorCode eMBTCPDoInit(uint16_t ucTCPPort);
-void         eMBTCPStart(void);
-void         eMBTCPStop(void);
-eMBErrorCode eMBTCPReceive(uint8_t *pucRcvAddress, uint8_t **pucFrame,
-                           uint16_t *pusLength);
-eMBErrorCode eMBTCPSend(uint8_t _unused, const uint8_t *pucFrame,
-                        uint16_t usLength);
+eMBErrorCode eMBTCPDoInit(xMBInstance *pxInst, uint16_t ucTCPPort);
+void         eMBTCPStart(xMBInstance *pxInst);
+void         eMBTCPStop(xMBInstance *pxInst);
+eMBErrorCode eMBTCPReceive(xMBInstance *pxInst, uint8_t *pucRcvAddress,
+                           uint8_t **pucFrame, uint16_t *pusLength);
+eMBErrorCode eMBTCPSend(xMBInstance *pxInst, uint8_t _unused,
+                        const uint8_t *pucFrame, uint16_t usLength);
 
 #ifdef __cplusplus
 }
@@ -22,8 +22,14 @@
  * Included Files
  ****************************************************************************/
 
+#include <nuttx/config.h>
+#include <nuttx/clock.h>
+
 #include <arpa/inet.h>
 #include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
 #include <net/if.h>
 #include <netinet/in.h>
 #include <netpacket/rpmsg.h>
@@ -31,6 +37,7 @@
 #include <sched.h>
 #include <stdbool.h>
 #include <sys/prctl.h>
+#include <sys/sendfile.h>
 #include <sys/socket.h>
 #include <sys/time.h>
 #include <sys/un.h>
@@ -48,6 +55,8 @@
 #define IPERF_REPORT_TASK_NAME       "iperf_report"
 #define IPERF_REPORT_TASK_PRIORITY   100
 #define IPERF_REPORT_TASK_STACK      4096
+#define IPERF_TX_TASK_NAME           "iperf_tx"
+#define IPERF_RX_TASK_NAME           "iperf_rx"
 
 #define IPERF_UDP_TX_LEN             (1472)
 #define IPERF_UDP_RX_LEN             (16 << 10)
@@ -56,20 +65,72 @@
 
 #define IPERF_MAX_DELAY              64
 #define IPERF_SOCKET_RX_TIMEOUT      10
+#define IPERF_UDP_BIDIR_RX_TIMEOUT   1
+#define IPERF_ACCEPT_TIMEOUT         1
+#define IPERF_UDP_FIN_COUNT          3
+
+#ifdef CONFIG_LIBC_TMPDIR
+#  define IPERF_TMPDIR               CONFIG_LIBC_TMPDIR
+#else
+#  define IPERF_TMPDIR               "/tmp"
+#endif
+
+#ifdef CONFIG_SMP
+#  define IPERF_NCPUS                CONFIG_SMP_NCPUS
+#else
+#  define IPERF_NCPUS                1
+#endif
 
 /****************************************************************************
  * Private Types
  ****************************************************************************/
 
+struct iperf_udp_stats_t
+{
+  int32_t first_id;             /* First datagram id received */
+  int32_t last_id;              /* Highest datagram id received */
+  uint32_t packets;             /* Datagrams received */
+  uint32_t lost;                /* Datagrams missing */
+  uint32_t outoforder;          /* Datagrams received after a later one */
+  double transit;               /* Transit time of the last datagram */
+  double jitter;                /* Interarrival jitter in seconds */
+};
+
+struct iperf_stream_t
+{
+  FAR struct iperf_ctrl_t *ctrl;
+  int id;                       /* Stream number, from 1 */
+  int sockfd;
+  struct sockaddr_storage peer;
+  socklen_t peerlen;            /* 0 if the socket is connected */
+  volatile bool rx_done;        /* The peer has finished sending */
+  uintmax_t tx_len;
+  uintmax_t rx_len;
+  struct iperf_udp_stats_t udp;
+  pthread_t threads[2];         /* Sending and receiving threads */
+  int nthreads;
+};
+
 struct iperf_ctrl_t
 {
   FAR struct iperf_ctrl_t *flink;
   struct iperf_cfg_t cfg;
-  bool finish;
-  uintmax_t total_len;
-  uint32_t buffer_len;
-  FAR uint8_t *buffer;
-  uint32_t sockfd;
+  volatile bool finish;
+  FAR struct iperf_stream_t *streams;
+  int nstreams;                 /* Streams started so far */
+  pthread_t report;
+  bool report_started;
+  char zcpath[64];              /* RAM file sent with sendfile() */
+};
+
+/* What the previous report printed, per stream */
+
+struct iperf_report_t
+{
+  uintmax_t tx_len;
+  uintmax_t rx_len;
+  uint32_t lost;
+  int32_t last_id;
 };
 
 struct iperf_udp_pkt_t
@@ -106,12 +167,17 @@ static int iperf_get_socket_error_code(int sockfd);
 static int iperf_show_socket_error_reason(FAR const char *str, int sockfd);
 static void iperf_report_task(FAR void *arg);
 static int iperf_start_report(FAR struct iperf_ctrl_t *ctrl);
+static void iperf_tcp_tx(FAR void *arg);
+static void iperf_tcp_rx(FAR void *arg);
+static void iperf_udp_tx(FAR void *arg);
+static void iperf_udp_rx(FAR void *arg);
+static int iperf_start_stream(FAR struct iperf_stream_t *stream);
+static void iperf_wait_streams(FAR struct iperf_ctrl_t *ctrl);
 static int iperf_run_tcp_server(FAR struct iperf_ctrl_t *ctrl);
 static int iperf_run_udp_server(FAR struct iperf_ctrl_t *ctrl);
 static int iperf_run_udp_client(FAR struct iperf_ctrl_t *ctrl);
 static int iperf_run_tcp_client(FAR struct iperf_ctrl_t *ctrl);
 static void iperf_task_traffic(FAR void *arg);
-static uint32_t iperf_get_buffer_len(FAR struct iperf_ctrl_t *ctrl);
 
 /****************************************************************************
  * Private Functions
@@ -247,6 +313,48 @@ static void iperf_print_addr(FAR const char *str, FAR struct sockaddr *addr)
     }
 }
 
+/****************************************************************************
+ * Name: iperf_same_addr
+ *
+ * Description:
+ *   Check if two addresses of the same length are the same peer
+ *
+ ****************************************************************************/
+
+static bool iperf_same_addr(FAR const struct sockaddr *a,
+                            FAR const struct sockaddr *b)
+{
+  if (a->sa_family != b->sa_family)
+    {
+      return false;
+    }
+
+  switch (a->sa_family)
+    {
+      case AF_INET:
+        {
+          FAR const struct sockaddr_in *ina =
+                                        (FAR const struct sockaddr_in *)a;
+          FAR const struct sockaddr_in *inb =
+                                        (FAR const struct sockaddr_in *)b;
+          return ina->sin_port == inb->sin_port &&
+                 ina->sin_addr.s_addr == inb->sin_addr.s_addr;
+        }
+
+      case AF_LOCAL:
+        {
+          FAR const struct sockaddr_un *una =
+                                        (FAR const struct sockaddr_un *)a;
+          FAR const struct sockaddr_un *unb =
+                                        (FAR const struct sockaddr_un *)b;
+          return strcmp(una->sun_path, unb->sun_path) == 0;
+        }
+
+      default:
+        return memcmp(a, b, sizeof(struct sockaddr)) == 0;
+    }
+}
+
 /****************************************************************************
  * Name: ts_sec
  *
@@ -273,6 +381,296 @@ static double ts_diff(const struct timespec *a, const struct timespec *b)
   return ts_sec(a) - ts_sec(b);
 }
 
+/****************************************************************************
+ * Name: iperf_udp_account
+ *
+ * Description:
+ *   Account a received datagram: count the datagrams lost or received out
+ *   of order from the gaps in the ids, and update the interarrival jitter
+ *   as described in RFC 1889, section 6.3.1.
+ *
+ ****************************************************************************/
+
+static void iperf_udp_account(FAR struct iperf_stream_t *stream,
+                              FAR const uint8_t *buffer, ssize_t len)
+{
+  FAR const struct iperf_udp_pkt_t *udp =
+                                  (FAR const struct iperf_udp_pkt_t *)buffer;
+  FAR struct iperf_udp_stats_t *stats = &stream->udp;
+  struct timespec now;
+  double transit;
+  double d;
+  int32_t id;
+
+  if (len < sizeof(*udp))
+    {
+      stream->rx_len += len;
+      return;
+    }
+
+  /* A negative id marks the end of the stream */
+
+  id = (int32_t)ntohl(udp->id);
+  if (id < 0)
+    {
+      stream->rx_done = true;
+      return;
+    }
+
+  stream->rx_len += len;
+
+  /* The count starts at the first datagram received, the datagrams sent
+   * before are not counted as lost.
+   */
+
+  if (stats->packets == 0)
+    {
+      stats->first_id = id;
+      stats->last_id  = id - 1;
+    }
+
+  stats->packets++;
+
+  if (id > stats->last_id + 1)
+    {
+      stats->lost += id - stats->last_id - 1;
+    }
+  else if (id <= stats->last_id)
+    {
+      /* Counted as lost when the gap was seen */
+
+      stats->outoforder++;
+      if (stats->lost > 0)
+        {
+          stats->lost--;
+        }
+    }
+
+  if (id > stats->last_id)
+    {
+      stats->last_id = id;
+    }
+
+  /* The clocks of the peers need not be synchronized, only the variation
+   * of the transit time matters.
+   */
+
+  clock_gettime(CLOCK_REALTIME, &now);
+  transit = ts_sec(&now) - ((double)ntohl(udp->sec) +
+                            (double)ntohl(udp->usec) / 1e6);
+  if (stats->packets > 1)
+    {
+      d = transit - stats->transit;
+      if (d < 0)
+        {
+          d = -d;
+        }
+
+      stats->jitter += (d - stats->jitter) / 16;
+    }
+
+  stats->transit = transit;
+}
+
+/****************************************************************************
+ * Name: iperf_print_line
+ *
+ * Description:
+ *   Print the transfer of one stream, or the sum of all streams if id is
+ *   negative, in one direction.
+ *
+ ****************************************************************************/
+
+static void iperf_print_line(int id, FAR const char *dir,
+                             FAR const struct timespec *from,
+                             FAR const struct timespec *to,
+                             FAR const struct timespec *start,
+                             uintmax_t len)
+{
+  if (id > 0)
+    {
+      printf("[%3d] %s ", id, dir);
+    }
+  else if (id < 0)
+    {
+      printf("[SUM] %s ", dir);
+    }
+
+  printf("%7.2lf-%7.2lf sec %10ju Bytes %7.2f Mbits/sec",
+         ts_diff(from, start),
+         ts_diff(to, start),
+         len,
+         ((len * 8) / 1000000.0) / ts_diff(to, from));
+}
+
+/****************************************************************************
+ * Name: iperf_print_report
+ *
+ * Description:
+ *   Print the transfer of every stream since the last report, and their
+ *   sum when there are parallel streams.
+ *
+ * Returned Value:
+ *   The bytes transferred in both directions by all streams.
+ *
+ ****************************************************************************/
+
+static uintmax_t iperf_print_report(FAR struct iperf_ctrl_t *ctrl,
+                                    FAR struct iperf_report_t *last,
+                                    FAR const struct timespec *from,
+                                    FAR const struct timespec *to,
+                                    FAR const struct timespec *start)
+{
+  bool bidir = (ctrl->cfg.flag & IPERF_FLAG_BIDIR) != 0;
+  bool udp = (ctrl->cfg.flag & IPERF_FLAG_UDP) != 0;
+  bool label = bidir || ctrl->cfg.streams > 1;
+  int nstreams = ctrl->nstreams;
+  FAR struct iperf_stream_t *stream;
+  uintmax_t bytes = 0;
+  uintmax_t sum;
+  uintmax_t len;
+  uint32_t total;
+  int32_t first;
+  int32_t lost;
+  int rx;
+  int i;
+
+  if (ts_diff(to, from) <= 0)
+    {
+      return 0;
+    }
+
+  for (rx = 0; rx < 2; rx++)
+    {
+      if ((rx && !bidir && !(ctrl->cfg.flag & IPERF_FLAG_SERVER)) ||
+          (!rx && !bidir && !(ctrl->cfg.flag & IPERF_FLAG_CLIENT)))
+        {
+          continue;
+        }
+
+      sum = 0;
+      for (i = 0; i < nstreams; i++)
+        {
+          stream = &ctrl->streams[i];
+          if (rx)
+            {
+              len = stream->rx_len - last[i].rx_len;
+            }
+          else
+            {
+              len = stream->tx_len - last[i].tx_len;
+            }
+
+          sum += len;
+          iperf_print_line(label ? stream->id : 0, rx ? "RX" : "TX",
+                           from, to, start, len);
+
+          if (rx && udp)
+            {
+              /* Datagrams from the first id received on */
+
+              first = stream->udp.packets > 0 ?
+                      stream->udp.first_id - 1 : stream->udp.last_id;
+              if (first < last[i].last_id)
+                {
+                  first = last[i].last_id;
+                }
+
+              lost  = (int32_t)(stream->udp.lost - last[i].lost);
+              total = stream->udp.last_id - first;
+              if (lost < 0)
+                {
+                  lost = 0;
+                }
+
+              printf(" %7.3f ms %5" PRId32 "/%5" PRIu32 " (%.2g%%)",
+                     stream->udp.jitter * 1000, lost, total,
+                     total != 0 ? lost * 100.0 / total : 0.0);
+            }
+
+          printf("\n");
+        }
+
+      if (nstreams > 1)
+        {
+          iperf_print_line(-1, rx ? "RX" : "TX", from, to, start, sum);
+          printf("\n");
+        }
+
+      bytes += sum;
+    }
+
+  for (i = 0; i < nstreams; i++)
+    {
+      stream = &ctrl->streams[i];
+      last[i].tx_len  = stream->tx_len;
+      last[i].rx_len  = stream->rx_len;
+      last[i].lost    = stream->udp.lost;
+      last[i].last_id = stream->udp.last_id;
+    }
+
+  return bytes;
+}
+
+#ifdef IPERF_HAVE_CPULOAD
+/****************************************************************************
+ * Name: iperf_print_cpuload
+ *
+ * Description:
+ *   Print the load of every CPU, taken from the load of its idle thread
+ *   like ps does, and the bytes transferred per busy CPU cycle.
+ *
+ * Returned Value:
+ *   The busy CPU cycles of the interval.
+ *
+ ****************************************************************************/
+
+static double iperf_print_cpuload(uintmax_t bytes, double secs)
+{
+  double cycles = 0;
+  char path[32];
+  char buf[16];
+  double load;
+  ssize_t n;
+  int cpu;
+  int fd;
+
+  printf("[CPU] load");
+  for (cpu = 0; cpu < IPERF_NCPUS; cpu++)
+    {
+      /* The idle thread of a CPU has the PID of the CPU */
+
+      snprintf(path, sizeof(path), "/proc/%d/loadavg", cpu);
+      n  = -1;
+      fd = open(path, O_RDONLY);
+      if (fd >= 0)
+        {
+          n = read(fd, buf, sizeof(buf) - 1);
+          close(fd);
+        }
+
+      if (n <= 0)
+        {
+          printf(" %6s", "-");
+          continue;
+        }
+
+      buf[n] = '\0';
+      load = 100.0 - strtod(buf, NULL);
+      printf(" %5.1f%%", load);
+      cycles += load / 100 * perf_getfreq() * secs;
+    }
+
+  if (cycles > 0)
+    {
+      printf(" %10.3f Bytes/cycle", bytes / cycles);
+    }
+
+  printf("\n");
+  return cycles;
+}
+#endif
+
 /****************************************************************************
  * Name: iperf_report_task
  *
@@ -286,14 +684,22 @@ static void iperf_report_task(FAR void *arg)
   FAR struct iperf_ctrl_t *ctrl = arg;
   uint32_t interval = ctrl->cfg.interval;
   uint32_t time = ctrl->cfg.time;
+  FAR struct iperf_report_t *last;
   struct timespec now;
   struct timespec start;
-  uintmax_t now_len;
+  double cycles = 0;
+  uintmax_t bytes;
   int ret;
 
   prctl(PR_SET_NAME, IPERF_REPORT_TASK_NAME);
 
-  now_len = ctrl->total_len;
+  last = calloc(ctrl->cfg.streams, sizeof(struct iperf_report_t));
+  if (last == NULL)
+    {
+      printf("create report: not enough memory\n");
+      pthread_exit(NULL);
+    }
+
   ret = clock_gettime(CLOCK_MONOTONIC, &now);
   if (ret != 0)
     {
@@ -302,16 +708,20 @@ static void iperf_report_task(FAR void *arg)
     }
 
   start = now;
-  printf("\n%19s %16s %18s\n", "Interval", "Transfer", "Bandwidth\n");
+  printf("\n%s%19s %16s %18s%s\n\n",
+         ctrl->cfg.streams > 1 || (ctrl->cfg.flag & IPERF_FLAG_BIDIR) ?
+         "[ ID] Dir " : "", "Interval", "Transfer", "Bandwidth",
+         (ctrl->cfg.flag & IPERF_FLAG_UDP) &&
+         ((ctrl->cfg.flag & IPERF_FLAG_SERVER) ||
+          (ctrl->cfg.flag & IPERF_FLAG_BIDIR)) ?
+         "     Jitter    Lost/Total" : "");
+
   while (!ctrl->finish)
     {
-      uintmax_t last_len;
-      struct timespec last;
+      struct timespec last_ts;
 
       sleep(interval);
-      last_len = now_len;
-      last = now;
-      now_len = ctrl->total_len;
+      last_ts = now;
       ret = clock_gettime(CLOCK_MONOTONIC, &now);
       if (ret != 0)
         {
@@ -319,67 +729,515 @@ static void iperf_report_task(FAR void *arg)
           exit(EXIT_FAILURE);
         }
 
-      printf("%7.2lf-%7.2lf sec %10ju Bytes %7.2f Mbits/sec\n",
-             ts_diff(&last, &start),
-             ts_diff(&now, &start),
-             now_len -last_len,
-             (((now_len - last_len) * 8) / 1000000.0) /
-             ts_diff(&now, &last)
-             );
+      bytes = iperf_print_report(ctrl, last, &last_ts, &now, &start);
+#ifdef IPERF_HAVE_CPULOAD
+      if (ctrl->cfg.flag & IPERF_FLAG_CPULOAD)
+        {
+          cycles += iperf_print_cpuload(bytes, ts_diff(&now, &last_ts));
+        }
+#endif
+
       if (time != 0 && ts_diff(&now, &start) >= time)
         {
           break;
         }
     }
 
-  if (ts_diff(&now, &start) > 0)
+  /* The summary is the report of the whole test */
+
+  memset(last, 0, ctrl->cfg.streams * sizeof(struct iperf_report_t));
+  bytes = iperf_print_report(ctrl, last, &start, &now, &start);
+  if (cycles > 0)
     {
-      printf("%7.2lf-%7.2lf sec %10ju Bytes %7.2f Mbits/sec\n",
-             ts_diff(&start, &start),
-             ts_diff(&now, &start),
-             now_len,
-             ((now_len * 8) / 1000000.0) /
-             ts_diff(&now, &start)
-             );
+      printf("[CPU] %10.3f Bytes/cycle in total\n", bytes / cycles);
     }
 
+  free(last);
+
   ctrl->finish = true;
 
-  pthread_exit(NULL);
+  pthread_exit(NULL);
+}
+
+/****************************************************************************
+ * Name: iperf_start_report
+ *
+ * Description:
+ *   Start iperf report
+ *
+ ****************************************************************************/
+
+static int iperf_start_report(FAR struct iperf_ctrl_t *ctrl)
+{
+  struct sched_param param;
+  pthread_attr_t attr;
+  int ret;
+
+  pthread_attr_init(&attr);
+  param.sched_priority = IPERF_REPORT_TASK_PRIORITY;
+  pthread_attr_setschedparam(&attr, &param);
+  pthread_attr_setstacksize(&attr, IPERF_REPORT_TASK_STACK);
+
+  ret = pthread_create(&ctrl->report, &attr, (FAR void *)iperf_report_task,
+                       ctrl);
+  if (ret != 0)
+    {
+      printf("iperf_thread: pthread_create failed: %d, %s\n",
+             ret, IPERF_REPORT_TASK_NAME);
+      return -1;
+    }
+
+  ctrl->report_started = true;
+
+  return 0;
+}
+
+/****************************************************************************
+ * Name: iperf_tcp_send
+ *
+ * Description:
+ *   Send on a tcp stream from a buffer until the test ends
+ *
+ ****************************************************************************/
+
+static void iperf_tcp_send(FAR struct iperf_stream_t *stream)
+{
+  FAR struct iperf_ctrl_t *ctrl = stream->ctrl;
+  int actual_send = 0;
+  FAR uint8_t *buffer;
+
+  buffer = zalloc(IPERF_TCP_TX_LEN);
+  if (buffer == NULL)
+    {
+      printf("create buffer: not enough memory\n");
+      return;
+    }
+
+  while (!ctrl->finish && !stream->rx_done)
+    {
+      actual_send = send(stream->sockfd, buffer, IPERF_TCP_TX_LEN, 0);
+      if (actual_send <= 0)
+        {
+          iperf_show_socket_error_reason("tcp send", stream->sockfd);
+          break;
+        }
+      else
+        {
+          stream->tx_len += actual_send;
+        }
+    }
+
+  free(buffer);
+}
+
+/****************************************************************************
+ * Name: iperf_tcp_sendfile
+ *
+ * Description:
+ *   Send on a tcp stream with sendfile() from a RAM file until the test
+ *   ends.  The stack takes the data from the file without a copy through
+ *   a user buffer.
+ *
+ ****************************************************************************/
+
+static void iperf_tcp_sendfile(FAR struct iperf_stream_t *stream)
+{
+  FAR struct iperf_ctrl_t *ctrl = stream->ctrl;
+  ssize_t actual_send = 0;
+  off_t offset;
+  int fd;
+
+  /* Every stream has its own descriptor of the file */
+
+  fd = open(ctrl->zcpath, O_RDONLY);
+  if (fd < 0)
+    {
+      printf("open %s failed: %d\n", ctrl->zcpath, errno);
+      return;
+    }
+
+  while (!ctrl->finish && !stream->rx_done)
+    {
+      offset = 0;
+      actual_send = sendfile(stream->sockfd, fd, &offset, IPERF_TCP_TX_LEN);
+      if (actual_send <= 0)
+        {
+          iperf_show_socket_error_reason("tcp sendfile", stream->sockfd);
+          break;
+        }
+      else
+        {
+          stream->tx_len += actual_send;
+        }
+    }
+
+  close(fd);
+}
+
+/****************************************************************************
+ * Name: iperf_tcp_tx
+ *
+ * Description:
+ *   Send on a tcp stream until the test ends
+ *
+ ****************************************************************************/
+
+static void iperf_tcp_tx(FAR void *arg)
+{
+  FAR struct iperf_stream_t *stream = arg;
+  FAR struct iperf_ctrl_t *ctrl = stream->ctrl;
+
+  prctl(PR_SET_NAME, IPERF_TX_TASK_NAME);
+
+  if (ctrl->zcpath[0] != '\0')
+    {
+      iperf_tcp_sendfile(stream);
+    }
+  else
+    {
+      iperf_tcp_send(stream);
+    }
+
+  /* Let the peer see the end of the data while still receiving */
+
+  if (ctrl->cfg.flag & IPERF_FLAG_BIDIR)
+    {
+      shutdown(stream->sockfd, SHUT_WR);
+    }
+
+  pthread_exit(NULL);
+}
+
+/****************************************************************************
+ * Name: iperf_tcp_rx
+ *
+ * Description:
+ *   Receive on a tcp stream until the peer closes it
+ *
+ ****************************************************************************/
+
+static void iperf_tcp_rx(FAR void *arg)
+{
+  FAR struct iperf_stream_t *stream = arg;
+  FAR struct iperf_ctrl_t *ctrl = stream->ctrl;
+  int actual_recv = 0;
+  FAR uint8_t *buffer;
+  struct timeval t;
+
+  prctl(PR_SET_NAME, IPERF_RX_TASK_NAME);
+
+  buffer = malloc(IPERF_TCP_RX_LEN);
+  if (buffer == NULL)
+    {
+      printf("create buffer: not enough memory\n");
+      stream->rx_done = true;
+      pthread_exit(NULL);
+    }
+
+  t.tv_sec = IPERF_SOCKET_RX_TIMEOUT;
+  t.tv_usec = 0;
+  setsockopt(stream->sockfd, SOL_SOCKET, SO_RCVTIMEO, &t, sizeof(t));
+
+  /* In the bidirectional mode the data sent by the peer is drained after
+   * the local end of the test too.
+   */
+
+  while (!ctrl->finish || (ctrl->cfg.flag & IPERF_FLAG_BIDIR))
+    {
+      actual_recv = recv(stream->sockfd, buffer, IPERF_TCP_RX_LEN, 0);
+      if (actual_recv == 0)
+        {
+          iperf_print_addr("closed by the peer",
+                           (FAR struct sockaddr *)&stream->peer);
+          break;
+        }
+      else if (actual_recv < 0)
+        {
+          iperf_show_socket_error_reason("tcp recv", stream->sockfd);
+          break;
+        }
+      else
+        {
+          stream->rx_len += actual_recv;
+        }
+    }
+
+  stream->rx_done = true;
+  free(buffer);
+  pthread_exit(NULL);
+}
+
+/****************************************************************************
+ * Name: iperf_udp_tx
+ *
+ * Description:
+ *   Send on a udp stream until the test ends
+ *
+ ****************************************************************************/
+
+static void iperf_udp_tx(FAR void *arg)
+{
+  FAR struct iperf_stream_t *stream = arg;
+  FAR struct iperf_ctrl_t *ctrl = stream->ctrl;
+  FAR struct iperf_udp_pkt_t *udp;
+  FAR struct sockaddr *peer = NULL;
+  int actual_send = 0;
+  bool retry = false;
+  uint32_t delay = 1;
+  FAR uint8_t *buffer;
+  struct timeval tv;
+  int err;
+  int id;
+  int i;
+
+  prctl(PR_SET_NAME, IPERF_TX_TASK_NAME);
+
+  buffer = zalloc(IPERF_UDP_TX_LEN);
+  if (buffer == NULL)
+    {
+      printf("create buffer: not enough memory\n");
+      pthread_exit(NULL);
+    }
+
+  /* The client sockets are connected, the server sends to each peer */
+
+  if (stream->peerlen != 0)
+    {
+      peer = (FAR struct sockaddr *)&stream->peer;
+    }
+
+  udp = (FAR struct iperf_udp_pkt_t *)buffer;
+  id = 0;
+
+  while (!ctrl->finish && !stream->rx_done)
+    {
+      if (false == retry)
+        {
+          id++;
+          gettimeofday(&tv, NULL);
+          udp->id = htonl(id);
+          udp->sec = htonl(tv.tv_sec);
+          udp->usec = htonl(tv.tv_usec);
+          delay = 1;
+        }
+
+      retry = false;
+      actual_send = sendto(stream->sockfd, buffer, IPERF_UDP_TX_LEN, 0,
+                           peer, stream->peerlen);
+
+      if (actual_send != IPERF_UDP_TX_LEN)
+        {
+          err = iperf_get_socket_error_code(stream->sockfd);
+          if (err == ENOMEM)
+            {
+              usleep(delay * 10000);
+              if (delay < IPERF_MAX_DELAY)
+                {
+                  delay <<= 1;
+                }
+
+              retry = true;
+              continue;
+            }
+          else
+            {
+              printf("udp send abort: err=%d\n", err);
+              break;
+            }
+        }
+      else
+        {
+          stream->tx_len += actual_send;
+        }
+    }
+
+  /* Tell the receiver that the stream has ended, as iperf 2 does */
+
+  udp->id = htonl(-(id + 1));
+  for (i = 0; i < IPERF_UDP_FIN_COUNT; i++)
+    {
+      sendto(stream->sockfd, buffer, sizeof(*udp), 0,
+             peer, stream->peerlen);
+    }
+
+  free(buffer);
+  pthread_exit(NULL);
+}
+
+/****************************************************************************
+ * Name: iperf_udp_rx
+ *
+ * Description:
+ *   Receive on the udp stream of a bidirectional client until the peer
+ *   ends it
+ *
+ ****************************************************************************/
+
+static void iperf_udp_rx(FAR void *arg)
+{
+  FAR struct iperf_stream_t *stream = arg;
+  FAR struct iperf_ctrl_t *ctrl = stream->ctrl;
+  int actual_recv = 0;
+  FAR uint8_t *buffer;
+  struct timeval t;
+
+  prctl(PR_SET_NAME, IPERF_RX_TASK_NAME);
+
+  buffer = malloc(IPERF_UDP_RX_LEN);
+  if (buffer == NULL)
+    {
+      printf("create buffer: not enough memory\n");
+      stream->rx_done = true;
+      pthread_exit(NULL);
+    }
+
+  /* There is no end of the connection, check for the end of the test
+   * regularly.
+   */
+
+  t.tv_sec = IPERF_UDP_BIDIR_RX_TIMEOUT;
+  t.tv_usec = 0;
+  setsockopt(stream->sockfd, SOL_SOCKET, SO_RCVTIMEO, &t, sizeof(t));
+
+  while (!stream->rx_done)
+    {
+      actual_recv = recv(stream->sockfd, buffer, IPERF_UDP_RX_LEN, 0);
+      if (actual_recv < 0)
+        {
+          if (ctrl->finish)
+            {
+              break;
+            }
+
+          if (errno != EAGAIN)
+            {
+              iperf_show_socket_error_reason("udp recv", stream->sockfd);
+            }
+        }
+      else
+        {
+          iperf_udp_account(stream, buffer, actual_recv);
+        }
+    }
+
+  stream->rx_done = true;
+  free(buffer);
+  pthread_exit(NULL);
+}
+
+/****************************************************************************
+ * Name: iperf_start_thread
+ *
+ * Description:
+ *   Start a traffic thread of a stream, pinned to a CPU if requested
+ *
+ ****************************************************************************/
+
+static int iperf_start_thread(FAR struct iperf_stream_t *stream,
+                              CODE void (*entry)(FAR void *))
+{
+  struct sched_param param;
+  pthread_attr_t attr;
+  int ret;
+
+  pthread_attr_init(&attr);
+  param.sched_priority = IPERF_TRAFFIC_TASK_PRIORITY;
+  pthread_attr_setschedparam(&attr, &param);
+  pthread_attr_setstacksize(&attr, IPERF_TRAFFIC_TASK_STACK);
+
+#ifdef CONFIG_SMP
+  if (stream->ctrl->cfg.flag & IPERF_FLAG_AFFINITY)
+    {
+      cpu_set_t cpuset;
+
+      CPU_ZERO(&cpuset);
+      CPU_SET((stream->id - 1) % CONFIG_SMP_NCPUS, &cpuset);
+      pthread_attr_setaffinity_np(&attr, sizeof(cpuset), &cpuset);
+    }
+#endif
+
+  ret = pthread_create(&stream->threads[stream->nthreads], &attr,
+                       (FAR void *)entry, stream);
+  if (ret != 0)
+    {
+      printf("iperf_thread: pthread_create failed: %d, stream %d\n",
+             ret, stream->id);
+      return -1;
+    }
+
+  stream->nthreads++;
+
+  return 0;
+}
+
+/****************************************************************************
+ * Name: iperf_start_stream
+ *
+ * Description:
+ *   Start the threads of a connected stream: the sending one on the client,
+ *   the receiving one on the server and both in the bidirectional mode.
+ *
+ ****************************************************************************/
+
+static int iperf_start_stream(FAR struct iperf_stream_t *stream)
+{
+  FAR struct iperf_ctrl_t *ctrl = stream->ctrl;
+  bool bidir = (ctrl->cfg.flag & IPERF_FLAG_BIDIR) != 0;
+  bool udp = (ctrl->cfg.flag & IPERF_FLAG_UDP) != 0;
+  int ret = 0;
+
+  if (bidir || (ctrl->cfg.flag & IPERF_FLAG_CLIENT))
+    {
+      ret = iperf_start_thread(stream, udp ? iperf_udp_tx : iperf_tcp_tx);
+    }
+
+  /* The udp server receives all streams on one socket itself */
+
+  if (ret == 0 && (bidir || (ctrl->cfg.flag & IPERF_FLAG_SERVER)) &&
+      !iperf_is_udp_server(ctrl))
+    {
+      ret = iperf_start_thread(stream, udp ? iperf_udp_rx : iperf_tcp_rx);
+    }
+
+  return ret;
 }
 
 /****************************************************************************
- * Name: iperf_start_report
+ * Name: iperf_wait_streams
  *
  * Description:
- *   Start iperf report
+ *   Wait for the threads of all streams, close their sockets and wait for
+ *   the final report.
  *
  ****************************************************************************/
 
-static int iperf_start_report(FAR struct iperf_ctrl_t *ctrl)
+static void iperf_wait_streams(FAR struct iperf_ctrl_t *ctrl)
 {
-  struct sched_param param;
-  pthread_attr_t attr;
-  pthread_t thread;
-  int ret;
-
-  pthread_attr_init(&attr);
-  param.sched_priority = IPERF_REPORT_TASK_PRIORITY;
-  pthread_attr_setschedparam(&attr, &param);
-  pthread_attr_setstacksize(&attr, IPERF_REPORT_TASK_STACK);
+  FAR struct iperf_stream_t *stream;
+  int i;
+  int j;
 
-  ret = pthread_create(&thread, &attr, (FAR void *)iperf_report_task,
-                       ctrl);
-  if (ret != 0)
+  for (i = 0; i < ctrl->nstreams; i++)
     {
-      printf("iperf_thread: pthread_create failed: %d, %s\n",
-             ret, IPERF_REPORT_TASK_NAME);
-      return -1;
-    }
+      stream = &ctrl->streams[i];
+      for (j = 0; j < stream->nthreads; j++)
+        {
+          pthread_join(stream->threads[j], NULL);
+        }
 
-  pthread_detach(thread);
+      if (stream->sockfd >= 0 && !iperf_is_udp_server(ctrl))
+        {
+          close(stream->sockfd);
+          stream->sockfd = -1;
+        }
+    }
 
-  return 0;
+  ctrl->finish = true;
+  if (ctrl->report_started)
+    {
+      pthread_join(ctrl->report, NULL);
+      ctrl->report_started = false;
+    }
 }
 
 /****************************************************************************
@@ -484,13 +1342,12 @@ static int iperf_tcp_server(FAR struct iperf_ctrl_t *ctrl,
                             FAR struct sockaddr *addr, socklen_t addrlen,
                             FAR struct sockaddr *remote_addr)
 {
-  int actual_recv = 0;
-  int want_recv = 0;
-  FAR uint8_t *buffer;
+  FAR struct iperf_stream_t *stream;
+  socklen_t remote_len;
   int listen_socket;
   struct timeval t;
   int sockfd;
-  int opt;
+  int opt = 1;
 
   listen_socket = socket(addr->sa_family, SOCK_STREAM, IPPROTO_TCP);
   if (listen_socket < 0)
@@ -514,61 +1371,56 @@ static int iperf_tcp_server(FAR struct iperf_ctrl_t *ctrl,
       return -1;
     }
 
-  buffer = ctrl->buffer;
-  want_recv = ctrl->buffer_len;
-  while (!ctrl->finish)
+  /* Note: unlike the original iperf, this implementation exits after
+   * finishing the connections of a single test: one per parallel stream.
+   */
+
+  while (!ctrl->finish && ctrl->nstreams < ctrl->cfg.streams)
     {
       /* TODO need to change to non-block mode */
 
-      sockfd = accept(listen_socket, remote_addr, &addrlen);
+      remote_len = addrlen;
+      sockfd = accept(listen_socket, remote_addr, &remote_len);
       if (sockfd < 0)
         {
+          if (ctrl->nstreams > 0)
+            {
+              /* The client runs fewer parallel streams */
+
+              break;
+            }
+
           iperf_show_socket_error_reason("tcp server listen", listen_socket);
           close(listen_socket);
           return -1;
         }
-      else
+
+      iperf_print_addr("accept", remote_addr);
+      if (ctrl->nstreams == 0)
         {
-          iperf_print_addr("accept", remote_addr);
           iperf_start_report(ctrl);
 
-          t.tv_sec = IPERF_SOCKET_RX_TIMEOUT;
+          /* The parallel streams of the client connect all at once */
+
+          t.tv_sec = IPERF_ACCEPT_TIMEOUT;
           t.tv_usec = 0;
-          setsockopt(sockfd, SOL_SOCKET, SO_RCVTIMEO, &t, sizeof(t));
+          setsockopt(listen_socket, SOL_SOCKET, SO_RCVTIMEO, &t, sizeof(t));
         }
 
-      while (!ctrl->finish)
-        {
-          actual_recv = recv(sockfd, buffer, want_recv, 0);
-          if (actual_recv == 0)
-            {
-              iperf_print_addr("closed by the peer", remote_addr);
-
-              /* Note: unlike the original iperf, this implementation
-               * exits after finishing a single connection.
-               */
+      stream = &ctrl->streams[ctrl->nstreams];
+      stream->sockfd = sockfd;
+      memcpy(&stream->peer, remote_addr, remote_len);
+      stream->peerlen = remote_len;
+      ctrl->nstreams++;
 
-              ctrl->finish = true;
-              break;
-            }
-          else if (actual_recv < 0)
-            {
-              iperf_show_socket_error_reason("tcp server recv",
-                                             listen_socket);
-              ctrl->finish = true;
-              break;
-            }
-          else
-            {
-              ctrl->total_len += actual_recv;
-            }
+      if (iperf_start_stream(stream) < 0)
+        {
+          ctrl->finish = true;
         }
-
-      close(sockfd);
     }
 
-  ctrl->finish = true;
   close(listen_socket);
+  iperf_wait_streams(ctrl);
 
   return 0;
 }
@@ -586,6 +1438,60 @@ static int iperf_run_tcp_server(FAR struct iperf_ctrl_t *ctrl)
   return iperf_run_server(ctrl, iperf_tcp_server);
 }
 
+/****************************************************************************
+ * Name: iperf_udp_find_stream
+ *
+ * Description:
+ *   Find the stream of the sender of a datagram, or start a new one.
+ *
+ ****************************************************************************/
+
+static FAR struct iperf_stream_t *
+iperf_udp_find_stream(FAR struct iperf_ctrl_t *ctrl, int sockfd,
+                      FAR struct sockaddr *remote_addr, socklen_t addrlen)
+{
+  FAR struct iperf_stream_t *stream;
+  int i;
+
+  for (i = 0; i < ctrl->nstreams; i++)
+    {
+      stream = &ctrl->streams[i];
+      if (stream->peerlen == addrlen &&
+          iperf_same_addr((FAR struct sockaddr *)&stream->peer, remote_addr))
+        {
+          return stream;
+        }
+    }
+
+  if (ctrl->nstreams == ctrl->cfg.streams)
+    {
+      return NULL;
+    }
+
+  iperf_print_addr("accept", remote_addr);
+
+  stream = &ctrl->streams[ctrl->nstreams];
+  memcpy(&stream->peer, remote_addr, addrlen);
+  stream->peerlen = addrlen;
+
+  /* All streams share the socket of the server */
+
+  stream->sockfd = sockfd;
+  ctrl->nstreams++;
+
+  if (ctrl->nstreams == 1)
+    {
+      iperf_start_report(ctrl);
+    }
+
+  if ((ctrl->cfg.flag & IPERF_FLAG_BIDIR) && iperf_start_stream(stream) < 0)
+    {
+      ctrl->finish = true;
+    }
+
+  return stream;
+}
+
 /****************************************************************************
  * Name: iperf_udp_server
  *
@@ -598,13 +1504,15 @@ static int iperf_udp_server(FAR struct iperf_ctrl_t *ctrl,
                             FAR struct sockaddr *addr, socklen_t addrlen,
                             FAR struct sockaddr *remote_addr)
 {
+  FAR struct iperf_stream_t *stream;
   int actual_recv = 0;
-  struct timeval t;
-  int want_recv = 0;
+  socklen_t remote_len;
   FAR uint8_t *buffer;
+  struct timeval t;
+  int ndone = 0;
   int sockfd;
-  int opt;
-  bool udp_recv_start = true;
+  int opt = 1;
+  int i;
 
   sockfd = socket(addr->sa_family, SOCK_DGRAM, IPPROTO_UDP);
   if (sockfd < 0)
@@ -618,39 +1526,60 @@ static int iperf_udp_server(FAR struct iperf_ctrl_t *ctrl,
   if (bind(sockfd, addr, addrlen) != 0)
     {
       iperf_show_socket_error_reason("udp server bind", sockfd);
+      close(sockfd);
+      return -1;
+    }
+
+  buffer = malloc(IPERF_UDP_RX_LEN);
+  if (buffer == NULL)
+    {
+      printf("create buffer: not enough memory\n");
+      close(sockfd);
       return -1;
     }
 
-  buffer = ctrl->buffer;
-  want_recv = ctrl->buffer_len;
-  printf("want recv=%d\n", want_recv);
+  printf("want recv=%d\n", IPERF_UDP_RX_LEN);
 
   t.tv_sec = IPERF_SOCKET_RX_TIMEOUT;
   t.tv_usec = 0;
   setsockopt(sockfd, SOL_SOCKET, SO_RCVTIMEO, &t, sizeof(t));
 
-  while (!ctrl->finish)
+  /* The test ends when every stream has sent its end mark */
+
+  while (!ctrl->finish && (ctrl->nstreams == 0 || ndone < ctrl->nstreams))
     {
-      actual_recv = recvfrom(sockfd, buffer, want_recv, 0,
-                             remote_addr, &addrlen);
+      remote_len = addrlen;
+      actual_recv = recvfrom(sockfd, buffer, IPERF_UDP_RX_LEN, 0,
+                             remote_addr, &remote_len);
       if (actual_recv < 0)
         {
           iperf_show_socket_error_reason("udp server recv", sockfd);
+          continue;
         }
-      else
+
+      stream = iperf_udp_find_stream(ctrl, sockfd, remote_addr, remote_len);
+      if (stream == NULL || stream->rx_done)
         {
-          if (udp_recv_start == true)
-            {
-              iperf_print_addr("accept", remote_addr);
-              iperf_start_report(ctrl);
-              udp_recv_start = false;
-            }
+          continue;
+        }
 
-          ctrl->total_len += actual_recv;
+      iperf_udp_account(stream, buffer, actual_recv);
+      if (stream->rx_done)
+        {
+          ndone++;
         }
     }
 
-  ctrl->finish = true;
+  free(buffer);
+
+  /* The socket is closed once the sending threads are done with it */
+
+  for (i = 0; i < ctrl->nstreams; i++)
+    {
+      ctrl->streams[i].rx_done = true;
+    }
+
+  iperf_wait_streams(ctrl);
   close(sockfd);
 
   return 0;
@@ -670,150 +1599,153 @@ static int iperf_run_udp_server(FAR struct iperf_ctrl_t *ctrl)
 }
 
 /****************************************************************************
- * Name: iperf_udp_client
+ * Name: iperf_create_zcfile
  *
  * Description:
- *   The main udp client logic
+ *   Create the RAM file that the tcp streams send with sendfile().
  *
  ****************************************************************************/
 
-static int iperf_udp_client(FAR struct iperf_ctrl_t *ctrl,
-                            FAR struct sockaddr *addr, socklen_t addrlen)
+static int iperf_create_zcfile(FAR struct iperf_ctrl_t *ctrl)
 {
-  FAR struct iperf_udp_pkt_t *udp;
-  int actual_send = 0;
-  bool retry = false;
-  uint32_t delay = 1;
-  int want_send = 0;
-  uint8_t *buffer;
-  int sockfd;
-  int opt;
-  int err;
-  int id;
+  FAR uint8_t *buffer;
+  ssize_t ret = -1;
+  int fd;
 
-  sockfd = socket(addr->sa_family, SOCK_DGRAM, IPPROTO_UDP);
-  if (sockfd < 0)
+  snprintf(ctrl->zcpath, sizeof(ctrl->zcpath), "%s/iperfXXXXXX",
+           IPERF_TMPDIR);
+  fd = mkstemp(ctrl->zcpath);
+  if (fd < 0)
     {
-      iperf_show_socket_error_reason("udp client create", sockfd);
+      printf("create %s failed: %d\n", ctrl->zcpath, errno);
+      ctrl->zcpath[0] = '\0';
       return -1;
     }
 
-  setsockopt(sockfd, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
-
-  iperf_start_report(ctrl);
-  buffer = ctrl->buffer;
-  udp = (FAR struct iperf_udp_pkt_t *)buffer;
-  want_send = ctrl->buffer_len;
-  id = 0;
-
-  while (!ctrl->finish)
+  buffer = zalloc(IPERF_TCP_TX_LEN);
+  if (buffer != NULL)
     {
-      if (false == retry)
-        {
-          id++;
-          udp->id = htonl(id);
-          delay = 1;
-        }
-
-      retry = false;
-      actual_send = sendto(sockfd, buffer, want_send, 0, addr, addrlen);
-
-      if (actual_send != want_send)
-        {
-          err = iperf_get_socket_error_code(sockfd);
-          if (err == ENOMEM)
-            {
-              usleep(delay * 10000);
-              if (delay < IPERF_MAX_DELAY)
-                {
-                  delay <<= 1;
-                }
-
-              retry = true;
-              continue;
-            }
-          else
-            {
-              printf("udp client send abort: err=%d\n", err);
-              break;
-            }
-        }
-      else
-        {
-          ctrl->total_len += actual_send;
-        }
+      ret = write(fd, buffer, IPERF_TCP_TX_LEN);
+      free(buffer);
     }
 
-  ctrl->finish = true;
-  close(sockfd);
+  close(fd);
+  if (ret != IPERF_TCP_TX_LEN)
+    {
+      printf("write %s failed\n", ctrl->zcpath);
+      unlink(ctrl->zcpath);
+      ctrl->zcpath[0] = '\0';
+      return -1;
+    }
 
   return 0;
 }
 
 /****************************************************************************
- * Name: iperf_run_udp_client
- *
- * Description:
- *   Start udp client
- *
- ****************************************************************************/
-
-static int iperf_run_udp_client(FAR struct iperf_ctrl_t *ctrl)
-{
-  return iperf_run_client(ctrl, iperf_udp_client);
-}
-
-/****************************************************************************
- * Name: iperf_tcp_client
+ * Name: iperf_client
  *
  * Description:
- *   The main tcp client logic
+ *   The main client logic: connect a socket for every parallel stream,
+ *   then run the streams until the test ends.
  *
  ****************************************************************************/
 
-static int iperf_tcp_client(FAR struct iperf_ctrl_t *ctrl,
-                            FAR struct sockaddr *addr, socklen_t addrlen)
+static int iperf_client(FAR struct iperf_ctrl_t *ctrl,
+                        FAR struct sockaddr *addr, socklen_t addrlen)
 {
-  FAR uint8_t *buffer;
-  int actual_send = 0;
-  int want_send = 0;
+  bool udp = (ctrl->cfg.flag & IPERF_FLAG_UDP) != 0;
+  FAR struct iperf_stream_t *stream;
+  int ret = 0;
   int sockfd;
+  int opt = 1;
+  int i;
 
-  sockfd = socket(addr->sa_family, SOCK_STREAM, IPPROTO_TCP);
-  if (sockfd < 0)
+  for (i = 0; i < ctrl->cfg.streams; i++)
     {
-      iperf_show_socket_error_reason("tcp client create", sockfd);
-      return -1;
-    }
+      if (udp)
+        {
+          sockfd = socket(addr->sa_family, SOCK_DGRAM, IPPROTO_UDP);
+        }
+      else
+        {
+          sockfd = socket(addr->sa_family, SOCK_STREAM, IPPROTO_TCP);
+        }
 
-  if (connect(sockfd, addr, addrlen) < 0)
-    {
-      iperf_show_socket_error_reason("tcp client connect", sockfd);
-      return -1;
-    }
+      if (sockfd < 0)
+        {
+          iperf_show_socket_error_reason("client create", sockfd);
+          ret = -1;
+          break;
+        }
 
-  iperf_start_report(ctrl);
-  buffer = ctrl->buffer;
-  want_send = ctrl->buffer_len;
+      if (udp)
+        {
+          setsockopt(sockfd, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
+        }
 
-  while (!ctrl->finish)
-    {
-      actual_send = send(sockfd, buffer, want_send, 0);
-      if (actual_send <= 0)
+      /* A connected udp socket receives what the peer sends back in the
+       * bidirectional mode.
+       */
+
+      if (connect(sockfd, addr, addrlen) < 0)
         {
-          iperf_show_socket_error_reason("tcp client send", sockfd);
+          iperf_show_socket_error_reason("client connect", sockfd);
+          close(sockfd);
+          ret = -1;
           break;
         }
-      else
+
+      stream = &ctrl->streams[ctrl->nstreams++];
+      stream->sockfd = sockfd;
+      memcpy(&stream->peer, addr, addrlen);
+      if (!udp)
         {
-          ctrl->total_len += actual_send;
+          stream->peerlen = addrlen;
         }
     }
 
-  ctrl->finish = true;
-  close(sockfd);
+  /* Datagrams carry their own header, only tcp sends from the file */
 
-  return 0;
+  if (ret == 0 && !udp && (ctrl->cfg.flag & IPERF_FLAG_ZEROCOPY) &&
+      iperf_create_zcfile(ctrl) < 0)
+    {
+      printf("zero-copy send not available, sending from a buffer\n");
+    }
+
+  if (ret == 0)
+    {
+      iperf_start_report(ctrl);
+      for (i = 0; i < ctrl->nstreams; i++)
+        {
+          if (iperf_start_stream(&ctrl->streams[i]) < 0)
+            {
+              ctrl->finish = true;
+              break;
+            }
+        }
+    }
+
+  iperf_wait_streams(ctrl);
+
+  if (ctrl->zcpath[0] != '\0')
+    {
+      unlink(ctrl->zcpath);
+    }
+
+  return ret;
+}
+
+/****************************************************************************
+ * Name: iperf_run_udp_client
+ *
+ * Description:
+ *   Start udp client
+ *
+ ****************************************************************************/
+
+static int iperf_run_udp_client(FAR struct iperf_ctrl_t *ctrl)
+{
+  return iperf_run_client(ctrl, iperf_client);
 }
 
 /****************************************************************************
@@ -826,7 +1758,7 @@ static int iperf_tcp_client(FAR struct iperf_ctrl_t *ctrl,
 
 static int iperf_run_tcp_client(FAR struct iperf_ctrl_t *ctrl)
 {
-  return iperf_run_client(ctrl, iperf_tcp_client);
+  return iperf_run_client(ctrl, iperf_client);
 }
 
 /****************************************************************************
@@ -866,39 +1798,11 @@ static void iperf_task_traffic(FAR void *arg)
       assert(false);
     }
 
-  if (ctrl->buffer)
-    {
-      free(ctrl->buffer);
-      ctrl->buffer = NULL;
-    }
-
   printf("iperf exit\n");
 
   pthread_exit(NULL);
 }
 
-static uint32_t iperf_get_buffer_len(FAR struct iperf_ctrl_t *ctrl)
-{
-  if (iperf_is_udp_client(ctrl))
-    {
-      return IPERF_UDP_TX_LEN;
-    }
-  else if (iperf_is_udp_server(ctrl))
-    {
-      return IPERF_UDP_RX_LEN;
-    }
-  else if (iperf_is_tcp_client(ctrl))
-    {
-      return IPERF_TCP_TX_LEN;
-    }
-  else
-    {
-      return IPERF_TCP_RX_LEN;
-    }
-
-  return 0;
-}
-
 /****************************************************************************
  * Public Functions
  ****************************************************************************/
@@ -919,6 +1823,7 @@ int iperf_start(FAR struct iperf_cfg_t *cfg)
   pthread_t thread;
   FAR void *retval;
   int ret;
+  int i;
 
   if (!cfg)
     {
@@ -928,15 +1833,25 @@ int iperf_start(FAR struct iperf_cfg_t *cfg)
   memset(&ctrl, 0, sizeof(ctrl));
   memcpy(&ctrl.cfg, cfg, sizeof(*cfg));
   ctrl.finish = false;
-  ctrl.buffer_len = iperf_get_buffer_len(&ctrl);
-  ctrl.buffer = (FAR uint8_t *)malloc(ctrl.buffer_len);
-  if (ctrl.buffer == NULL)
+  if (ctrl.cfg.streams == 0)
     {
-      printf("create buffer: not enough memory\n");
+      ctrl.cfg.streams = 1;
+    }
+
+  ctrl.streams = calloc(ctrl.cfg.streams, sizeof(struct iperf_stream_t));
+  if (ctrl.streams == NULL)
+    {
+      printf("create streams: not enough memory\n");
       return -1;
     }
 
-  memset(ctrl.buffer, 0, ctrl.buffer_len);
+  for (i = 0; i < ctrl.cfg.streams; i++)
+    {
+      ctrl.streams[i].ctrl = &ctrl;
+      ctrl.streams[i].id = i + 1;
+      ctrl.streams[i].sockfd = -1;
+    }
+
   pthread_attr_init(&attr);
   param.sched_priority = IPERF_TRAFFIC_TASK_PRIORITY;
   pthread_attr_setschedparam(&attr, &param);
@@ -947,8 +1862,7 @@ int iperf_start(FAR struct iperf_cfg_t *cfg)
   if (ret != 0)
     {
       printf("iperf_task_traffic: create task failed: %d\n", ret);
-      free(ctrl.buffer);
-      ctrl.buffer = NULL;
+      free(ctrl.streams);
       return -1;
     }
 
@@ -962,6 +1876,8 @@ int iperf_start(FAR struct iperf_cfg_t *cfg)
   sq_rem((FAR sq_entry_t *)&ctrl, &g_iperf_ctrl_list);
   pthread_mutex_unlock(&g_iperf_ctrl_mutex);
 
+  free(ctrl.streams);
+
   return 0;
 }
 
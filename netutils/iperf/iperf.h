@@ -25,6 +25,8 @@
  * Included Files
  ****************************************************************************/
 
+#include <nuttx/config.h>
+
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
@@ -50,6 +52,24 @@ extern "C"
 #define IPERF_FLAG_UDP    (1 << 3)
 #define IPERF_FLAG_LOCAL  (1 << 4)
 #define IPERF_FLAG_RPMSG  (1 << 5)
+#define IPERF_FLAG_BIDIR  (1 << 6)  /* Send and receive at the same time */
+#define IPERF_FLAG_AFFINITY (1 << 7) /* Pin each stream to a CPU */
+#define IPERF_FLAG_ZEROCOPY (1 << 8) /* Send with sendfile() */
+#define IPERF_FLAG_CPULOAD  (1 << 9) /* Report CPU load and bytes/cycle */
+
+#ifdef CONFIG_NETUTILS_IPERF_MAX_STREAMS
+#  define IPERF_MAX_STREAMS CONFIG_NETUTILS_IPERF_MAX_STREAMS
+#else
+#  define IPERF_MAX_STREAMS 8
+#endif
+
+/* The CPU load is the load of the idle threads in procfs */
+
+#if defined(CONFIG_FS_PROCFS) && \
+    !defined(CONFIG_FS_PROCFS_EXCLUDE_PROCESS) && \
+    !defined(CONFIG_SCHED_CPULOAD_NONE)
+#  define IPERF_HAVE_CPULOAD 1
+#endif
 
 /****************************************************************************
  * Public Types
@@ -64,6 +84,7 @@ struct iperf_cfg_t
   uint16_t sport;
   uint32_t interval;
   uint32_t time;
+  uint16_t streams;     /* number of parallel streams */
   FAR const char *host; /* host name (dip) or rpmsg cpu */
   FAR const char *path; /* local path or rpmsg name */
 };
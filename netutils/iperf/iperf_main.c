@@ -62,6 +62,11 @@ struct wifi_iperf_t
   FAR struct arg_int *port;
   FAR struct arg_int *interval;
   FAR struct arg_int *time;
+  FAR struct arg_int *parallel;
+  FAR struct arg_lit *bidir;
+  FAR struct arg_lit *affinity;
+  FAR struct arg_lit *zerocopy;
+  FAR struct arg_lit *cpuload;
   FAR struct arg_lit *abort;
   FAR struct arg_end *end;
 };
@@ -81,8 +86,9 @@ struct wifi_iperf_t
 static void iperf_showusage(FAR const char *progname,
                             FAR struct wifi_iperf_t *args, int exitcode)
 {
-  printf("USAGE: %s [-sua] [-c <ip|cpu>] [-p <port>] [-i <interval>] "
-         "[-t <time>] [--local <path>] [--rpmsg <name>]\n", progname);
+  printf("USAGE: %s [-suaA] [-c <ip|cpu>] [-p <port>] [-i <interval>] "
+         "[-t <time>] [-P <n>] [-Z] [--bidir] [--cpuload] "
+         "[--local <path>] [--rpmsg <name>]\n", progname);
   printf("iperf command:\n");
   arg_print_glossary(stdout, (FAR void **)args, NULL);
 
@@ -124,8 +130,12 @@ static void iperf_printcfg(FAR struct iperf_cfg_t *cfg)
              (cfg->dip >> 16) & 0xff, (cfg->dip >> 24) & 0xff, cfg->dport);
     }
 
-  printf("interval=%" PRId32 ", time=%" PRId32 "\n",
-         cfg->interval, cfg->time);
+  printf("interval=%" PRId32 ", time=%" PRId32 ", streams=%d%s%s%s%s\n",
+         cfg->interval, cfg->time, cfg->streams,
+         cfg->flag & IPERF_FLAG_BIDIR ? ", bidir" : "",
+         cfg->flag & IPERF_FLAG_AFFINITY ? ", affinity" : "",
+         cfg->flag & IPERF_FLAG_ZEROCOPY ? ", zerocopy" : "",
+         cfg->flag & IPERF_FLAG_CPULOAD ? ", cpuload" : "");
 }
 
 /****************************************************************************
@@ -156,6 +166,16 @@ int main(int argc, FAR char *argv[])
                             "seconds between periodic bandwidth reports");
   iperf_args.time = arg_int0("t", "time", "<time>",
                         "time in seconds to transmit for (default 10 secs)");
+  iperf_args.parallel = arg_int0("P", "parallel", "<n>",
+                                 "number of parallel streams to run");
+  iperf_args.bidir = arg_lit0(NULL, "bidir",
+                              "send and receive at the same time");
+  iperf_args.affinity = arg_lit0("A", "affinity",
+                                 "pin each stream to a CPU");
+  iperf_args.zerocopy = arg_lit0("Z", "zerocopy",
+                                 "send with sendfile() from a RAM file");
+  iperf_args.cpuload = arg_lit0(NULL, "cpuload",
+                                "report CPU load and bytes per cycle");
   iperf_args.abort = arg_lit0("a", "abort", "abort running iperf");
   iperf_args.end = arg_end(1);
 
@@ -311,6 +331,44 @@ int main(int argc, FAR char *argv[])
         }
     }
 
+  cfg.streams = 1;
+  if (iperf_args.parallel->count != 0)
+    {
+      if (iperf_args.parallel->ival[0] < 1 ||
+          iperf_args.parallel->ival[0] > IPERF_MAX_STREAMS)
+        {
+          printf("ERROR: parallel streams should be 1..%d\n",
+                 IPERF_MAX_STREAMS);
+          goto out;
+        }
+
+      cfg.streams = iperf_args.parallel->ival[0];
+    }
+
+  if (iperf_args.bidir->count != 0)
+    {
+      cfg.flag |= IPERF_FLAG_BIDIR;
+    }
+
+  if (iperf_args.affinity->count != 0)
+    {
+      cfg.flag |= IPERF_FLAG_AFFINITY;
+    }
+
+  if (iperf_args.zerocopy->count != 0)
+    {
+      cfg.flag |= IPERF_FLAG_ZEROCOPY;
+    }
+
+  if (iperf_args.cpuload->count != 0)
+    {
+#ifdef IPERF_HAVE_CPULOAD
+      cfg.flag |= IPERF_FLAG_CPULOAD;
+#else
+      printf("WARNING: CPU load needs procfs and CPU load measurement\n");
+#endif
+    }
+
   iperf_printcfg(&cfg);
   iperf_start(&cfg);
 
@@ -213,6 +213,48 @@
 #    define CONFIG_THTTPD_IDLE_SEND_LIMIT_SEC 300
 #  endif
 
+/* How many bytes to send to one connection before servicing the others.
+ */
+
+#  ifndef CONFIG_THTTPD_SEND_BUDGET
+#    define CONFIG_THTTPD_SEND_BUDGET 2048
+#  endif
+
+/* Timing wheel geometry.
+ */
+
+#  ifndef CONFIG_THTTPD_TIMER_SLOTS
+#    define CONFIG_THTTPD_TIMER_SLOTS 64
+#  endif
+
+#  ifndef CONFIG_THTTPD_TIMER_TICK
+#    define CONFIG_THTTPD_TIMER_TICK 100
+#  endif
+
+/* Response cache size limits and status URL.
+ */
+
+#  ifdef CONFIG_THTTPD_CACHE
+#    ifndef CONFIG_THTTPD_CACHE_ENTRIES
+#      define CONFIG_THTTPD_CACHE_ENTRIES 16
+#    endif
+
+#    ifndef CONFIG_THTTPD_CACHE_MAXFILE
+#      define CONFIG_THTTPD_CACHE_MAXFILE 4096
+#    endif
+
+#    ifndef CONFIG_THTTPD_CACHE_SIZE
+#      define CONFIG_THTTPD_CACHE_SIZE 32768
+#    endif
+
+#    if defined(CONFIG_THTTPD_CACHE_STATUS) && \
+       !defined(CONFIG_THTTPD_CACHE_STATUS_URL)
+#      define CONFIG_THTTPD_CACHE_STATUS_URL "/cache-status"
+#    endif
+#  else
+#    undef CONFIG_THTTPD_CACHE_STATUS
+#  endif
+
 /* Memory debug instrumentation depends on other debug options
  */
 
@@ -55,10 +55,31 @@
 #  define INFTIM -1
 #endif
 
+/* What to watch a descriptor for, see fdwatch_add_fd() */
+
+#define FDW_READ  0
+#define FDW_WRITE 1
+
 /****************************************************************************
  * Public Types
  ****************************************************************************/
 
+#ifdef CONFIG_THTTPD_FDWATCH_EPOLL
+struct epoll_event;
+
+struct fdwatch_s
+{
+  int                 epfd;        /* The epoll instance */
+  struct epoll_event *events;      /* Ready events (allocated) */
+  void              **client;      /* Client data by fd (allocated) */
+  uint32_t           *revents;     /* Ready events by fd (allocated) */
+  int                 maxfd;       /* Size of the tables indexed by fd */
+  int                 nfds;        /* The configured maximum number of fds */
+  int                 nwatched;    /* The number of fds currently watched */
+  int                 nactive;     /* The number of fds with activity */
+  int                 next;        /* The index to the next ready event */
+};
+#else
 struct fdwatch_s
 {
   struct pollfd *pollfds;          /* Poll data (allocated) */
@@ -69,6 +90,7 @@ struct fdwatch_s
   uint8_t        nactive;          /* The number of fds with activity */
   uint8_t        next;             /* The index to the next client data */
 };
+#endif
 
 /****************************************************************************
  * Public Function Prototypes
@@ -82,9 +104,10 @@ extern struct fdwatch_s *fdwatch_initialize(int nfds);
 
 extern void fdwatch_uninitialize(struct fdwatch_s *fw);
 
-/* Add a descriptor to the watch list */
+/* Add a descriptor to the watch list.  rw is either FDW_READ or FDW_WRITE */
 
-extern void fdwatch_add_fd(struct fdwatch_s *fw, int fd, void *client_data);
+extern void fdwatch_add_fd(struct fdwatch_s *fw, int fd, void *client_data,
+                           int rw);
 
 /* Delete a descriptor from the watch list. */
 
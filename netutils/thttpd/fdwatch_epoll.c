@@ -0,0 +1,310 @@
+/****************************************************************************
+ * apps/netutils/thttpd/fdwatch_epoll.c
+ * FD watcher routines for epoll()
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <sys/epoll.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <debug.h>
+
+#include "config.h"
+#include "thttpd_alloc.h"
+#include "fdwatch.h"
+
+#ifdef CONFIG_THTTPD
+
+/****************************************************************************
+ * Pre-Processor Definitions
+ ****************************************************************************/
+
+/* Debug output from this file is normally suppressed.  If enabled, be aware
+ * that output to stdout will interfere with CGI programs.
+ */
+
+#ifdef CONFIG_THTTPD_FDWATCH_DEBUG
+#  define fwerr    nerr
+#  define fwinfo   ninfo
+#else
+#  define fwerr    _none
+#  define fwinfo   _none
+#endif
+
+/* Growth increment of the tables indexed by file descriptor */
+
+#define FDWATCH_FDINCR 16
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/* Make sure that the tables indexed by descriptor can hold fd */
+
+static int fdwatch_grow(FAR struct fdwatch_s *fw, int fd)
+{
+  FAR uint32_t *revents;
+  FAR void **client;
+  int maxfd;
+
+  if (fd < fw->maxfd)
+    {
+      return 0;
+    }
+
+  maxfd  = fd + FDWATCH_FDINCR;
+  client = RENEW(fw->client, void *, fw->maxfd, maxfd);
+  if (client == NULL)
+    {
+      return -1;
+    }
+
+  fw->client = client;
+
+  revents = RENEW(fw->revents, uint32_t, fw->maxfd, maxfd);
+  if (revents == NULL)
+    {
+      return -1;
+    }
+
+  fw->revents = revents;
+
+  memset(&fw->client[fw->maxfd], 0, (maxfd - fw->maxfd) * sizeof(void *));
+  memset(&fw->revents[fw->maxfd], 0,
+         (maxfd - fw->maxfd) * sizeof(uint32_t));
+  fw->maxfd = maxfd;
+  return 0;
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/* Initialize the fdwatch data structures.  Returns -1 on failure. */
+
+struct fdwatch_s *fdwatch_initialize(int nfds)
+{
+  FAR struct fdwatch_s *fw;
+
+  /* Allocate the fdwatch data structure */
+
+  fw = (struct fdwatch_s *)zalloc(sizeof(struct fdwatch_s));
+  if (!fw)
+    {
+      fwerr("ERROR: Failed to allocate fdwatch\n");
+      return NULL;
+    }
+
+  fw->nfds = nfds;
+  fw->epfd = epoll_create1(EPOLL_CLOEXEC);
+  if (fw->epfd < 0)
+    {
+      fwerr("ERROR: epoll_create1 failed: %d\n", errno);
+      goto errout_with_allocations;
+    }
+
+  fw->events = NEW(struct epoll_event, nfds);
+  if (!fw->events)
+    {
+      goto errout_with_allocations;
+    }
+
+  if (fdwatch_grow(fw, nfds) < 0)
+    {
+      goto errout_with_allocations;
+    }
+
+  return fw;
+
+errout_with_allocations:
+  fdwatch_uninitialize(fw);
+  return NULL;
+}
+
+/* Uninitialize the fwdatch data structure */
+
+void fdwatch_uninitialize(struct fdwatch_s *fw)
+{
+  if (fw)
+    {
+      if (fw->epfd >= 0)
+        {
+          close(fw->epfd);
+        }
+
+      if (fw->events)
+        {
+          httpd_free(fw->events);
+        }
+
+      if (fw->client)
+        {
+          httpd_free(fw->client);
+        }
+
+      if (fw->revents)
+        {
+          httpd_free(fw->revents);
+        }
+
+      httpd_free(fw);
+    }
+}
+
+/* Add a descriptor to the watch list. rw is either FDW_READ or FDW_WRITE. */
+
+void fdwatch_add_fd(struct fdwatch_s *fw, int fd, void *client_data,
+                    int rw)
+{
+  struct epoll_event ev;
+
+  fwinfo("fd: %d client_data: %p rw: %d\n", fd, client_data, rw);
+
+  if (fw->nwatched >= fw->nfds || fdwatch_grow(fw, fd) < 0)
+    {
+      fwerr("ERROR: too many fds\n");
+      return;
+    }
+
+  memset(&ev, 0, sizeof(ev));
+  ev.events  = rw == FDW_WRITE ? EPOLLOUT : EPOLLIN;
+  ev.data.fd = fd;
+
+  if (epoll_ctl(fw->epfd, EPOLL_CTL_ADD, fd, &ev) < 0)
+    {
+      fwerr("ERROR: epoll_ctl(ADD) fd %d failed: %d\n", fd, errno);
+      return;
+    }
+
+  fw->client[fd]  = client_data;
+  fw->revents[fd] = 0;
+  fw->nwatched++;
+}
+
+/* Remove a descriptor from the watch list. */
+
+void fdwatch_del_fd(struct fdwatch_s *fw, int fd)
+{
+  fwinfo("fd: %d\n", fd);
+
+  if (fd < 0 || fd >= fw->maxfd ||
+      epoll_ctl(fw->epfd, EPOLL_CTL_DEL, fd, NULL) < 0)
+    {
+      fwerr("ERROR: fd %d not watched\n", fd);
+      return;
+    }
+
+  /* Forget any event of this round, the descriptor may be closed and
+   * reused before fdwatch_get_next_client_data() gets to it.
+   */
+
+  fw->client[fd]  = NULL;
+  fw->revents[fd] = 0;
+  fw->nwatched--;
+}
+
+/* Do the watch.  Return value is the number of descriptors that are ready,
+ * or 0 if the timeout expired, or -1 on errors.  A timeout of INFTIM means
+ * wait indefinitely.
+ */
+
+int fdwatch(struct fdwatch_s *fw, long timeout_msecs)
+{
+  int ret;
+  int fd;
+  int i;
+
+  /* Clear the events of the previous round */
+
+  for (i = 0; i < fw->nactive; i++)
+    {
+      fw->revents[fw->events[i].data.fd] = 0;
+    }
+
+  fwinfo("Waiting... (timeout %ld)\n", timeout_msecs);
+  fw->nactive = 0;
+  fw->next    = 0;
+  ret         = epoll_wait(fw->epfd, fw->events, fw->nfds,
+                           (int)timeout_msecs);
+  fwinfo("Awakened: %d\n", ret);
+
+  if (ret > 0)
+    {
+      /* Only the ready descriptors are returned, no need to scan all of
+       * the watched ones.
+       */
+
+      for (i = 0; i < ret; i++)
+        {
+          fd              = fw->events[i].data.fd;
+          fw->revents[fd] = fw->events[i].events;
+        }
+
+      fw->nactive = ret;
+    }
+
+  return ret;
+}
+
+/* Check if a descriptor was ready. */
+
+int fdwatch_check_fd(struct fdwatch_s *fw, int fd)
+{
+  fwinfo("fd: %d\n", fd);
+
+  if (fd >= 0 && fd < fw->maxfd && (fw->revents[fd] & EPOLLERR) == 0)
+    {
+      return fw->revents[fd] & (EPOLLIN | EPOLLOUT | EPOLLHUP);
+    }
+
+  fwinfo("EPOLLERR fd: %d\n", fd);
+  return 0;
+}
+
+void *fdwatch_get_next_client_data(struct fdwatch_s *fw)
+{
+  int fd;
+
+  /* Return the client data of the ready descriptors that are still
+   * watched.
+   */
+
+  while (fw->next < fw->nactive)
+    {
+      fd = fw->events[fw->next++].data.fd;
+      if (fw->revents[fd] != 0)
+        {
+          fwinfo("client_data[%d]: %p\n", fd, fw->client[fd]);
+          return fw->client[fd];
+        }
+    }
+
+  fwinfo("All client data returned: %d\n", fw->next);
+  return (void *)(uintptr_t)-1;
+}
+
+#endif /* CONFIG_THTTPD */
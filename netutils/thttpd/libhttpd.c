@@ -70,6 +70,7 @@
 #include "thttpd_alloc.h"
 #include "thttpd_strings.h"
 #include "thttpd_cgi.h"
+#include "thttpd_cache.h"
 #include "tdate_parse.h"
 #include "fdwatch.h"
 
@@ -153,6 +154,14 @@ static char *bufgets(httpd_conn *hc);
 static void de_dotdot(char *file);
 static void init_mime(void);
 static void figure_mime(httpd_conn *hc);
+static void figure_etag(httpd_conn *hc, char *etag, size_t len);
+static bool not_modified(httpd_conn *hc, const char *etag);
+#ifdef CONFIG_THTTPD_CACHE
+static struct httpd_cache_s *cache_file(httpd_conn *hc, const char *etag);
+#endif
+#ifdef CONFIG_THTTPD_CACHE_STATUS
+static int cache_status(httpd_conn *hc);
+#endif
 #ifdef CONFIG_THTTPD_GENERATE_INDICES
 static void ls_child(int argc, char **argv);
 static int  ls(httpd_conn *hc);
@@ -305,6 +314,11 @@ static void add_response(httpd_conn *hc, const char *str)
   hc->buflen = resplen;
 }
 
+/* Queue the response headers.  A NULL type means that extraheads already
+ * holds the Content-Type, Last-Modified and Content-Encoding headers, as
+ * prebuilt by the response cache.
+ */
+
 static void send_mime(httpd_conn *hc, int status, const char *title,
                       const char *encodings, const char *extraheads,
                       const char *type, off_t length, time_t mod)
@@ -346,20 +360,26 @@ static void send_mime(httpd_conn *hc, int status, const char *title,
           mod = now.tv_sec;
         }
 
-      snprintf(fixed_type, sizeof(fixed_type), type, CONFIG_THTTPD_CHARSET);
       snprintf(buf, sizeof(buf), "%.20s %d %s\r\n",
                hc->protocol, status, title);
       add_response(hc, buf);
       snprintf(buf, sizeof(buf), "Server: %s\r\n", "thttpd");
       add_response(hc, buf);
-      snprintf(buf, sizeof(buf), "Content-Type: %s\r\n", fixed_type);
-      add_response(hc, buf);
       strftime(tmbuf, sizeof(tmbuf), rfc1123fmt, gmtime(&now.tv_sec));
       snprintf(buf, sizeof(buf), "Date: %s\r\n", tmbuf);
       add_response(hc, buf);
-      strftime(tmbuf, sizeof(tmbuf), rfc1123fmt, gmtime(&mod));
-      snprintf(buf, sizeof(buf), "Last-Modified: %s\r\n", tmbuf);
-      add_response(hc, buf);
+
+      if (type != NULL)
+        {
+          snprintf(fixed_type, sizeof(fixed_type), type,
+                   CONFIG_THTTPD_CHARSET);
+          snprintf(buf, sizeof(buf), "Content-Type: %s\r\n", fixed_type);
+          add_response(hc, buf);
+          strftime(tmbuf, sizeof(tmbuf), rfc1123fmt, gmtime(&mod));
+          snprintf(buf, sizeof(buf), "Last-Modified: %s\r\n", tmbuf);
+          add_response(hc, buf);
+        }
+
       add_response(hc, "Accept-Ranges: bytes\r\n");
       add_response(hc, "Connection: close\r\n");
 
@@ -370,7 +390,7 @@ static void send_mime(httpd_conn *hc, int status, const char *title,
           add_response(hc, buf);
         }
 
-      if (encodings[0] != '\0')
+      if (type != NULL && encodings[0] != '\0')
         {
           snprintf(buf, sizeof(buf), "Content-Encoding: %s\r\n", encodings);
           add_response(hc, buf);
@@ -1577,6 +1597,94 @@ done:
     }
 }
 
+/* Make the entity tag of a file from its modification time and size. */
+
+static void figure_etag(httpd_conn *hc, char *etag, size_t len)
+{
+  snprintf(etag, len, "\"%lx-%lx\"",
+           (unsigned long)hc->sb.st_mtime, (unsigned long)hc->sb.st_size);
+}
+
+/* Check the conditional request headers.  If-None-Match takes precedence
+ * over If-Modified-Since.
+ */
+
+static bool not_modified(httpd_conn *hc, const char *etag)
+{
+  if (hc->if_none_match[0] != '\0')
+    {
+      return hc->if_none_match[0] == '*' ||
+             strstr(hc->if_none_match, etag) != NULL;
+    }
+
+  return hc->if_modified_since != (time_t)-1 &&
+         hc->if_modified_since >= hc->sb.st_mtime;
+}
+
+#ifdef CONFIG_THTTPD_CACHE
+/* Format the headers that only depend on the file once and keep them,
+ * with the data of small files, in the response cache.
+ */
+
+static struct httpd_cache_s *cache_file(httpd_conn *hc, const char *etag)
+{
+  char headers[256];
+  char fixed_type[72];
+  char tmbuf[72];
+  time_t mod;
+  int len;
+
+  mod = hc->sb.st_mtime;
+  if (mod == (time_t)0)
+    {
+      mod = time(NULL);
+    }
+
+  snprintf(fixed_type, sizeof(fixed_type), hc->type, CONFIG_THTTPD_CHARSET);
+  strftime(tmbuf, sizeof(tmbuf), rfc1123fmtstring, gmtime(&mod));
+  len = snprintf(headers, sizeof(headers),
+                 "Content-Type: %s\r\nLast-Modified: %s\r\nETag: %s\r\n",
+                 fixed_type, tmbuf, etag);
+
+  if (hc->encodings[0] != '\0' && (size_t)len < sizeof(headers))
+    {
+      snprintf(&headers[len], sizeof(headers) - len,
+               "Content-Encoding: %s\r\n", hc->encodings);
+    }
+
+  return httpd_cache_add(hc->expnfilename, &hc->sb, headers, etag);
+}
+#endif
+
+#ifdef CONFIG_THTTPD_CACHE_STATUS
+/* Report the response cache counters as plain text */
+
+static int cache_status(httpd_conn *hc)
+{
+  struct httpd_cache_stats_s stats;
+  char buf[128];
+  int len;
+
+  httpd_cache_stats(&stats);
+  len = snprintf(buf, sizeof(buf),
+                 "hits %lu\nmisses %lu\nevictions %lu\n"
+                 "entries %u/%d\nbytes %lu/%d\n",
+                 (unsigned long)stats.hits, (unsigned long)stats.misses,
+                 (unsigned long)stats.evictions, stats.entries,
+                 CONFIG_THTTPD_CACHE_ENTRIES, (unsigned long)stats.bytes,
+                 CONFIG_THTTPD_CACHE_SIZE);
+
+  send_mime(hc, 200, ok200title, "", "", "text/plain; charset=%s",
+            len, (time_t)0);
+  if (hc->method != METHOD_HEAD)
+    {
+      add_response(hc, buf);
+    }
+
+  return 0;
+}
+#endif
+
 /* qsort comparison routine. */
 
 #ifdef CONFIG_THTTPD_GENERATE_INDICES
@@ -2406,6 +2514,7 @@ int httpd_get_conn(httpd_server *hs, int listen_fd, httpd_conn *hc)
   hc->hostdir[0]        = '\0';
   hc->authorization     = "";
   hc->remoteuser[0]     = '\0';
+  hc->if_none_match     = "";
   hc->buffer[0]         = '\0';
 #ifdef CONFIG_THTTPD_TILDE_MAP2
   hc->altdir[0]         = '\0';
@@ -2427,6 +2536,10 @@ int httpd_get_conn(httpd_server *hs, int listen_fd, httpd_conn *hc)
   hc->keep_alive        = false;
   hc->should_linger     = false;
   hc->file_fd           = -1;
+  hc->body              = NULL;
+#ifdef CONFIG_THTTPD_CACHE
+  hc->cache             = NULL;
+#endif
 
   ninfo("New connection accepted on %d\n", hc->conn_fd);
   return GC_OK;
@@ -2921,6 +3034,12 @@ int httpd_parse_request(httpd_conn *hc)
                   nerr("ERROR: unparsable time: %s\n", cp);
                 }
             }
+          else if (strncasecmp(buf, "If-None-Match:", 14) == 0)
+            {
+              cp = &buf[14];
+              cp += strspn(cp, " \t");
+              hc->if_none_match = cp;
+            }
           else if (strncasecmp(buf, "Cookie:", 7) == 0)
             {
               cp = &buf[7];
@@ -3168,6 +3287,15 @@ int httpd_parse_request(httpd_conn *hc)
 
 void httpd_close_conn(httpd_conn *hc)
 {
+#ifdef CONFIG_THTTPD_CACHE
+  if (hc->cache != NULL)
+    {
+      httpd_cache_release(hc->cache);
+      hc->cache = NULL;
+    }
+#endif
+
+  hc->body = NULL;
   if (hc->file_fd >= 0)
     {
       close(hc->file_fd);
@@ -3212,6 +3340,11 @@ int httpd_start_request(httpd_conn *hc, struct timeval *nowp)
   static char *dirname;
   static size_t maxdirname = 0;
 #endif /* CONFIG_THTTPD_AUTH_FILE */
+  const char *extraheads;
+  const char *etag;
+  const char *type;
+  char etagbuf[ETAG_SIZE];
+  char etaghead[ETAG_SIZE + 10];
   size_t expnlen;
   size_t indxlen;
   char *cp;
@@ -3230,6 +3363,13 @@ int httpd_start_request(httpd_conn *hc, struct timeval *nowp)
       return -1;
     }
 
+#ifdef CONFIG_THTTPD_CACHE_STATUS
+  if (strcmp(hc->origfilename, &CONFIG_THTTPD_CACHE_STATUS_URL[1]) == 0)
+    {
+      return cache_status(hc);
+    }
+#endif
+
   /* Stat the file. */
 
   if (stat(hc->expnfilename, &hc->sb) < 0)
@@ -3504,19 +3644,55 @@ int httpd_start_request(httpd_conn *hc, struct timeval *nowp)
       hc->range_end = hc->sb.st_size - 1;
     }
 
-  figure_mime(hc);
+  /* Use the prebuilt headers of the response cache if the file is there,
+   * otherwise figure them out now.
+   */
+
+#ifdef CONFIG_THTTPD_CACHE
+  hc->cache = httpd_cache_lookup(hc->expnfilename, &hc->sb);
+  if (hc->cache == NULL)
+#endif
+    {
+      figure_mime(hc);
+      figure_etag(hc, etagbuf, sizeof(etagbuf));
+      snprintf(etaghead, sizeof(etaghead), "ETag: %s\r\n", etagbuf);
+      extraheads = etaghead;
+      etag       = etagbuf;
+      type       = hc->type;
+#ifdef CONFIG_THTTPD_CACHE
+      hc->cache  = cache_file(hc, etagbuf);
+#endif
+    }
+
+#ifdef CONFIG_THTTPD_CACHE
+  if (hc->cache != NULL)
+    {
+      extraheads = hc->cache->headers;
+      etag       = hc->cache->etag;
+      type       = NULL;
+    }
+#endif
 
   if (hc->method == METHOD_HEAD)
     {
-      send_mime(hc, 200, ok200title, hc->encodings, "", hc->type,
+      send_mime(hc, 200, ok200title, hc->encodings, extraheads, type,
                 hc->sb.st_size, hc->sb.st_mtime);
     }
-  else if (hc->if_modified_since != (time_t) - 1 &&
-           hc->if_modified_since >= hc->sb.st_mtime)
+  else if (not_modified(hc, etag))
     {
-      send_mime(hc, 304, err304title, hc->encodings, "",
-                hc->type, (off_t) - 1, hc->sb.st_mtime);
+      send_mime(hc, 304, err304title, hc->encodings, extraheads,
+                type, (off_t) - 1, hc->sb.st_mtime);
     }
+#ifdef CONFIG_THTTPD_CACHE
+  else if (hc->cache != NULL && hc->cache->body != NULL)
+    {
+      /* The file data is in the cache too */
+
+      hc->body = hc->cache->body;
+      send_mime(hc, 200, ok200title, hc->encodings, extraheads, type,
+                hc->sb.st_size, hc->sb.st_mtime);
+    }
+#endif
   else
     {
       hc->file_fd = open(hc->expnfilename, O_RDONLY);
@@ -3528,7 +3704,7 @@ int httpd_start_request(httpd_conn *hc, struct timeval *nowp)
           return -1;
         }
 
-      send_mime(hc, 200, ok200title, hc->encodings, "", hc->type,
+      send_mime(hc, 200, ok200title, hc->encodings, extraheads, type,
                 hc->sb.st_size, hc->sb.st_mtime);
     }
 
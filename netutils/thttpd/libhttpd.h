@@ -148,6 +148,10 @@
 #define GR_GOT_REQUEST 1
 #define GR_BAD_REQUEST 2
 
+/* Size of an entity tag: quoted modification time and size in hex */
+
+#define ETAG_SIZE 40
+
 /****************************************************************************
  * Public Type Definitions
  ****************************************************************************/
@@ -160,6 +164,8 @@ typedef struct sockaddr_in6 httpd_sockaddr;
 typedef struct sockaddr_in httpd_sockaddr;
 #endif
 
+struct httpd_cache_s;
+
 /* A server. */
 
 typedef struct
@@ -204,6 +210,7 @@ typedef struct
   char *hostdir;
   char *authorization;
   char *remoteuser;
+  char *if_none_match;
   size_t maxdecodedurl;
   size_t maxorigfilename;
   size_t maxexpnfilename;
@@ -238,6 +245,10 @@ typedef struct
   off_t range_start;           /* File range start from Range= */
   off_t range_end;             /* File range end from Range= */
   struct stat sb;
+  const uint8_t *body;         /* File data in memory, no file_fd needed */
+#ifdef CONFIG_THTTPD_CACHE
+  struct httpd_cache_s *cache; /* Response cache entry of the file */
+#endif
 
   /* This is the I/O buffer that is used to buffer portions of
    * outgoing files
@@ -40,9 +40,18 @@
 
 #include <nuttx/config.h>
 #include <sys/types.h>
+#include <sys/param.h>
 #include <sys/stat.h>
 #include <sys/time.h>
 
+#ifdef CONFIG_THTTPD_MMAP
+#  include <sys/mman.h>
+#endif
+
+#ifdef CONFIG_THTTPD_SENDFILE
+#  include <sys/sendfile.h>
+#endif
+
 #include <stdbool.h>
 #include <stdint.h>
 #include <stdio.h>
@@ -86,6 +95,16 @@
 #define SPARE_FDS      2
 #define AVAILABLE_FDS  (CONFIG_THTTPD_NFILE_DESCRIPTORS - SPARE_FDS)
 
+/* File data can be sent without copying it to the connection buffer */
+
+#if defined(CONFIG_THTTPD_SENDFILE) || defined(CONFIG_THTTPD_MMAP) || \
+    defined(CONFIG_THTTPD_CACHE)
+#  define HAVE_ZEROCOPY 1
+#  define CONN_ZEROCOPY(c) ((c)->zerocopy)
+#else
+#  define CONN_ZEROCOPY(c) false
+#endif
+
 /****************************************************************************
  * Private Types
  ****************************************************************************/
@@ -99,8 +118,17 @@ struct connect_s
   Timer *wakeup_timer;
   Timer *linger_timer;
   off_t end_offset;            /* The final offset+1 of the file to send */
-  off_t offset;                /* The current offset into the file to send */
+  off_t offset;                /* The current offset into the file to read */
+  uint16_t buf_idx;            /* Next byte of hc->buffer to send */
   bool eof;                    /* Set true when length==0 read from file */
+#ifdef HAVE_ZEROCOPY
+  bool zerocopy;               /* Send file data without hc->buffer */
+  FAR const uint8_t *map;      /* File data in memory or NULL */
+  size_t maplen;               /* Length of the file data in memory */
+#endif
+#ifdef CONFIG_THTTPD_MMAP
+  bool mapped;                 /* map is from mmap() */
+#endif
 };
 
 /****************************************************************************
@@ -128,6 +156,11 @@ static void handle_linger(struct connect_s *conn, struct timeval *tv);
 static void finish_connection(struct connect_s *conn, struct timeval *tv);
 static void clear_connection(struct connect_s *conn, struct timeval *tv);
 static void really_clear_connection(struct connect_s *conn);
+#ifdef HAVE_ZEROCOPY
+static void setup_zerocopy(struct connect_s *conn);
+static ssize_t send_zerocopy(struct connect_s *conn, size_t len);
+static void release_zerocopy(struct connect_s *conn);
+#endif
 static void idle(ClientData client_data, struct timeval *nowp);
 static void linger_clear_connection(ClientData client_data,
                                     struct timeval *nowp);
@@ -248,11 +281,18 @@ static int handle_newconnect(FAR struct timeval *tv, int listen_fd)
       conn->wakeup_timer      = NULL;
       conn->linger_timer      = NULL;
       conn->offset            = 0;
+#ifdef HAVE_ZEROCOPY
+      conn->zerocopy          = false;
+      conn->map               = NULL;
+#endif
+#ifdef CONFIG_THTTPD_MMAP
+      conn->mapped            = false;
+#endif
 
       /* Set the connection file descriptor to no-delay mode */
 
       httpd_set_ndelay(conn->hc->conn_fd);
-      fdwatch_add_fd(fw, conn->hc->conn_fd, conn);
+      fdwatch_add_fd(fw, conn->hc->conn_fd, conn, FDW_READ);
     }
 }
 
@@ -357,7 +397,7 @@ static void handle_read(struct connect_s *conn, struct timeval *tv)
 
   /* Check if it's already handled */
 
-  if (hc->file_fd < 0)
+  if (hc->file_fd < 0 && hc->body == NULL)
     {
       /* No file descriptor means someone else is handling it */
 
@@ -374,7 +414,12 @@ static void handle_read(struct connect_s *conn, struct timeval *tv)
 
   /* Seek to the offset of the next byte to send */
 
-  actual = lseek(hc->file_fd, conn->offset, SEEK_SET);
+  actual = conn->offset;
+  if (hc->file_fd >= 0)
+    {
+      actual = lseek(hc->file_fd, conn->offset, SEEK_SET);
+    }
+
   if (actual != conn->offset)
     {
        nerr("ERROR: fseek to %jd failed: offset=%jd errno=%d\n",
@@ -383,10 +428,17 @@ static void handle_read(struct connect_s *conn, struct timeval *tv)
        goto errout_with_400;
     }
 
-  /* We have a valid connection and a file to send to it */
+  /* We have a valid connection and a file to send to it.  From now on
+   * watch the connection for the socket becoming writable.
+   */
 
   conn->conn_state = CNST_SENDING;
+  conn->buf_idx    = 0;
+#ifdef HAVE_ZEROCOPY
+  setup_zerocopy(conn);
+#endif
   fdwatch_del_fd(fw, hc->conn_fd);
+  fdwatch_add_fd(fw, hc->conn_fd, conn, FDW_WRITE);
   return;
 
 errout_with_400:
@@ -401,11 +453,19 @@ static inline int read_buffer(struct connect_s *conn)
 {
   httpd_conn *hc = conn->hc;
   ssize_t nread = 0;
+  size_t len;
+
+  /* Do not read beyond the end of the requested range */
+
+  len = CONFIG_THTTPD_IOBUFFERSIZE - hc->buflen;
+  if (len > (size_t)(conn->end_offset - conn->offset))
+    {
+      len = conn->end_offset - conn->offset;
+    }
 
-  if (hc->buflen < CONFIG_THTTPD_IOBUFFERSIZE && !conn->eof)
+  if (len > 0 && !conn->eof)
     {
-      nread = read(hc->file_fd, &hc->buffer[hc->buflen],
-                   CONFIG_THTTPD_IOBUFFERSIZE - hc->buflen);
+      nread = read(hc->file_fd, &hc->buffer[hc->buflen], len);
       if (nread == 0)
         {
           /* Reading zero bytes means we are at the end of file */
@@ -416,74 +476,239 @@ static inline int read_buffer(struct connect_s *conn)
       else if (nread > 0)
         {
           hc->buflen      += nread;
+          conn->offset    += nread;
         }
     }
 
   return nread;
 }
 
+#ifdef HAVE_ZEROCOPY
+static void setup_zerocopy(struct connect_s *conn)
+{
+  httpd_conn *hc = conn->hc;
+
+  if (hc->body != NULL)
+    {
+      /* The file data is in the response cache */
+
+      conn->map      = hc->body;
+      conn->maplen   = hc->sb.st_size;
+      conn->zerocopy = true;
+      return;
+    }
+
+#ifdef CONFIG_THTTPD_MMAP
+  /* Map the file if the file system supports it.  For files in XIP memory
+   * (e.g. ROMFS in FLASH) this gives the file data itself.
+   */
+
+  conn->maplen = MIN(conn->end_offset, hc->sb.st_size);
+  if (conn->maplen > 0)
+    {
+      conn->map = mmap(NULL, conn->maplen, PROT_READ, MAP_SHARED | MAP_FILE,
+                       hc->file_fd, 0);
+      if (conn->map != MAP_FAILED)
+        {
+          conn->mapped   = true;
+          conn->zerocopy = true;
+          return;
+        }
+
+      ninfo("mmap failed: %d, no zero-copy\n", errno);
+      conn->map = NULL;
+    }
+#endif
+
+#ifdef CONFIG_THTTPD_SENDFILE
+  /* Let the network stack read the file */
+
+  conn->zerocopy = true;
+#endif
+}
+
+static ssize_t send_zerocopy(struct connect_s *conn, size_t len)
+{
+  httpd_conn *hc = conn->hc;
+  ssize_t nwritten;
+
+  if (conn->map != NULL)
+    {
+      if (conn->offset >= (off_t)conn->maplen)
+        {
+          /* The file is shorter than the requested range */
+
+          conn->end_offset = conn->offset;
+          return 0;
+        }
+
+      len      = MIN(len, conn->maplen - conn->offset);
+      nwritten = write(hc->conn_fd, &conn->map[conn->offset], len);
+    }
+  else
+    {
+#ifdef CONFIG_THTTPD_SENDFILE
+      off_t offset = conn->offset;
+
+      nwritten = sendfile(hc->conn_fd, hc->file_fd, &offset, len);
+      if (nwritten == 0)
+        {
+          /* End of file */
+
+          conn->end_offset = conn->offset;
+        }
+#else
+      errno    = EINVAL;
+      nwritten = -1;
+#endif
+    }
+
+  if (nwritten > 0)
+    {
+      conn->offset += nwritten;
+    }
+
+  return nwritten;
+}
+
+static void release_zerocopy(struct connect_s *conn)
+{
+#ifdef CONFIG_THTTPD_MMAP
+  if (conn->mapped)
+    {
+      munmap((FAR void *)conn->map, conn->maplen);
+      conn->mapped = false;
+    }
+#endif
+
+  conn->map      = NULL;
+  conn->zerocopy = false;
+}
+#endif
+
 static void handle_send(struct connect_s *conn, struct timeval *tv)
 {
   httpd_conn *hc = conn->hc;
-  int nwritten;
+  size_t budget = CONFIG_THTTPD_SEND_BUDGET;
+  bool zerocopy = false;
+  ssize_t nwritten;
+  size_t len;
   int nread;
 
-  /* Read until the entire file is sent -- this could take awhile!! */
+  /* Send at most CONFIG_THTTPD_SEND_BUDGET bytes, then return to the main
+   * loop so that the other connections are serviced too.  The socket is
+   * in non-blocking mode: if it cannot take more data now, return and let
+   * fdwatch() tell when it becomes writable again.
+   */
 
-  while (conn->offset < conn->end_offset)
+  for (; ; )
     {
       ninfo("offset: %jd end_offset: %jd bytes_sent: %jd\n",
             (intmax_t)conn->offset,
             (intmax_t)conn->end_offset,
             (intmax_t)conn->hc->bytes_sent);
 
-      /* Fill the rest of the response buffer with file data */
+      /* Fill the rest of the response buffer with file data once all of
+       * the buffer has been sent.
+       */
 
-      nread = read_buffer(conn);
-      if (nread < 0)
+      if (conn->buf_idx >= hc->buflen)
         {
-          nerr("ERROR: File read error: %d\n", errno);
-          goto errout_clear_connection;
+          hc->buflen    = 0;
+          conn->buf_idx = 0;
         }
 
-      ninfo("Read %d bytes, buflen %d\n", nread, hc->buflen);
+      /* Without a copy only the response headers are in the buffer, the
+       * file data goes to the socket straight from the file.
+       */
 
-      /* Send the buffer */
+      zerocopy = CONN_ZEROCOPY(conn) && hc->buflen == 0 &&
+                 conn->offset < conn->end_offset;
 
-      if (hc->buflen > 0)
+      if (conn->buf_idx == 0 && !CONN_ZEROCOPY(conn))
         {
-          /* httpd_write does not return until all bytes have been sent
-           * (or an error occurs).
-           */
-
-          nwritten = httpd_write(hc->conn_fd, hc->buffer, hc->buflen);
-          if (nwritten < 0)
+          nread = read_buffer(conn);
+          if (nread < 0)
             {
-              nerr("ERROR: Error sending %s: %d\n",
-                   hc->encodedurl, errno);
+              nerr("ERROR: File read error: %d\n", errno);
               goto errout_clear_connection;
             }
 
-          /* We wrote one full buffer of data (httpd_write does not
-           * return until the full buffer is written (or an error occurs).
-           */
+          ninfo("Read %d bytes, buflen %d\n", nread, hc->buflen);
+        }
+
+      if (hc->buflen == 0 && !zerocopy)
+        {
+          /* The file transfer is complete -- finish the connection */
 
-          conn->active_at       = tv->tv_sec;
-          hc->buflen            = 0;
+          ninfo("Finish connection\n");
+          finish_connection(conn, tv);
+          return;
+        }
 
-          /* And update how much of the file we wrote */
+      if (budget == 0)
+        {
+          /* Our share is used up, continue on the next loop */
 
-          conn->offset         += nwritten;
-          conn->hc->bytes_sent += nwritten;
-          ninfo("Wrote %d bytes\n", nwritten);
+          return;
         }
-    }
 
-  /* The file transfer is complete -- finish the connection */
+#ifdef HAVE_ZEROCOPY
+      if (zerocopy)
+        {
+          len      = MIN(conn->end_offset - conn->offset, budget);
+          nwritten = send_zerocopy(conn, len);
+        }
+      else
+#endif
+        {
+          len      = MIN(hc->buflen - conn->buf_idx, budget);
+          nwritten = write(hc->conn_fd, &hc->buffer[conn->buf_idx], len);
+          if (nwritten > 0)
+            {
+              conn->buf_idx += nwritten;
+            }
+        }
 
-  ninfo("Finish connection\n");
-  finish_connection(conn, tv);
-  return;
+      if (nwritten < 0)
+        {
+          if (errno == EINTR)
+            {
+              continue;
+            }
+
+          if (errno == EAGAIN || errno == EWOULDBLOCK)
+            {
+              /* The socket send buffer is full, wait for POLLOUT */
+
+              return;
+            }
+
+#ifdef HAVE_ZEROCOPY
+          if (zerocopy && (errno == ENOSYS || errno == EINVAL ||
+                           errno == EOPNOTSUPP))
+            {
+              /* Not supported for this file or socket, copy the rest */
+
+              ninfo("No zero-copy: %d\n", errno);
+              release_zerocopy(conn);
+              if (lseek(hc->file_fd, conn->offset, SEEK_SET) ==
+                  conn->offset)
+                {
+                  continue;
+                }
+            }
+#endif
+
+          nerr("ERROR: Error sending %s: %d\n", hc->encodedurl, errno);
+          goto errout_clear_connection;
+        }
+
+      conn->active_at       = tv->tv_sec;
+      conn->hc->bytes_sent += nwritten;
+      budget               -= nwritten;
+      ninfo("Wrote %zd bytes\n", nwritten);
+    }
 
 errout_clear_connection:
   ninfo("Clear connection\n");
@@ -526,6 +751,10 @@ static void clear_connection(struct connect_s *conn, struct timeval *tv)
 {
   ClientData client_data;
 
+#ifdef HAVE_ZEROCOPY
+  release_zerocopy(conn);
+#endif
+
   if (conn->wakeup_timer != NULL)
     {
       tmr_cancel(conn->wakeup_timer);
@@ -556,7 +785,7 @@ static void clear_connection(struct connect_s *conn, struct timeval *tv)
     {
       fdwatch_del_fd(fw, conn->hc->conn_fd);
       conn->conn_state = CNST_LINGERING;
-      fdwatch_add_fd(fw, conn->hc->conn_fd, conn);
+      fdwatch_add_fd(fw, conn->hc->conn_fd, conn, FDW_READ);
       client_data.p = conn;
 
       conn->linger_timer = tmr_create(tv, linger_clear_connection,
@@ -579,6 +808,10 @@ static void clear_connection(struct connect_s *conn, struct timeval *tv)
 
 static void really_clear_connection(struct connect_s *conn)
 {
+#ifdef HAVE_ZEROCOPY
+  release_zerocopy(conn);
+#endif
+
   fdwatch_del_fd(fw, conn->hc->conn_fd);
   httpd_close_conn(conn->hc);
   if (conn->linger_timer != NULL)
@@ -756,6 +989,14 @@ int thttpd_main(int argc, char **argv)
       connects[cnum].conn_state  = CNST_FREE;
       connects[cnum].next        = &connects[cnum + 1];
       connects[cnum].hc          = NULL;
+#ifdef HAVE_ZEROCOPY
+      connects[cnum].zerocopy    = false;
+      connects[cnum].map         = NULL;
+      connects[cnum].maplen      = 0;
+#endif
+#ifdef CONFIG_THTTPD_MMAP
+      connects[cnum].mapped      = false;
+#endif
     }
 
   connects[AVAILABLE_FDS - 1].next = NULL;      /* End of link list */
@@ -765,7 +1006,7 @@ int thttpd_main(int argc, char **argv)
     {
       if (hs->listen_fd != -1)
         {
-          fdwatch_add_fd(fw, hs->listen_fd, NULL);
+          fdwatch_add_fd(fw, hs->listen_fd, NULL, FDW_READ);
         }
     }
 
@@ -846,9 +1087,9 @@ int thttpd_main(int argc, char **argv)
 
                       case CNST_SENDING:
                         {
-                          /* Send a file -- this really should be performed
-                           * on a separate thread to keep the serve from
-                           * locking up during the write.
+                          /* Send the next part of a file.  This does not
+                           * block, the rest is sent when the connection is
+                           * writable again.
                            */
 
                           handle_send(conn, &tv);
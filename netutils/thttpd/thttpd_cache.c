@@ -0,0 +1,271 @@
+/****************************************************************************
+ * apps/netutils/thttpd/thttpd_cache.c
+ * Response cache for small static files
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <assert.h>
+#include <debug.h>
+
+#include "config.h"
+#include "libhttpd.h"
+#include "thttpd_alloc.h"
+#include "thttpd_cache.h"
+
+#if defined(CONFIG_THTTPD) && defined(CONFIG_THTTPD_CACHE)
+
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+static struct httpd_cache_s g_cache[CONFIG_THTTPD_CACHE_ENTRIES];
+static struct httpd_cache_stats_s g_cache_stats;
+static uint32_t g_cache_clock;
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+static void cache_free(FAR struct httpd_cache_s *entry)
+{
+  DEBUGASSERT(entry->refs == 0);
+
+  if (entry->body != NULL)
+    {
+      g_cache_stats.bytes -= entry->size;
+      httpd_free(entry->body);
+      entry->body = NULL;
+    }
+
+  if (entry->path != NULL)
+    {
+      g_cache_stats.entries--;
+      httpd_free(entry->path);
+      entry->path = NULL;
+    }
+
+  httpd_free(entry->headers);
+  entry->headers = NULL;
+}
+
+/* Find the least recently used entry that no connection is using.  Free
+ * entries are used first and with them no entry is evicted.
+ */
+
+static FAR struct httpd_cache_s *cache_victim(bool withbody)
+{
+  FAR struct httpd_cache_s *victim = NULL;
+  FAR struct httpd_cache_s *entry;
+  int i;
+
+  for (i = 0; i < CONFIG_THTTPD_CACHE_ENTRIES; i++)
+    {
+      entry = &g_cache[i];
+      if (entry->path == NULL && !withbody)
+        {
+          return entry;
+        }
+
+      if (entry->refs > 0 || (withbody && entry->body == NULL))
+        {
+          continue;
+        }
+
+      if (victim == NULL ||
+          g_cache_clock - entry->lastused > g_cache_clock - victim->lastused)
+        {
+          victim = entry;
+        }
+    }
+
+  return victim;
+}
+
+static FAR uint8_t *cache_read(FAR const char *path, off_t size)
+{
+  FAR uint8_t *body;
+  int fd;
+  int ret;
+
+  body = httpd_malloc(size > 0 ? size : 1);
+  if (body == NULL)
+    {
+      return NULL;
+    }
+
+  fd = open(path, O_RDONLY);
+  if (fd < 0)
+    {
+      httpd_free(body);
+      return NULL;
+    }
+
+  ret = httpd_read(fd, body, size);
+  close(fd);
+
+  if (ret != size)
+    {
+      nwarn("WARNING: short read of %s: %d\n", path, ret);
+      httpd_free(body);
+      return NULL;
+    }
+
+  return body;
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+FAR struct httpd_cache_s *
+httpd_cache_lookup(FAR const char *path, FAR const struct stat *sb)
+{
+  FAR struct httpd_cache_s *entry;
+  int i;
+
+  for (i = 0; i < CONFIG_THTTPD_CACHE_ENTRIES; i++)
+    {
+      entry = &g_cache[i];
+      if (entry->path != NULL && entry->mtime == sb->st_mtime &&
+          entry->size == sb->st_size && strcmp(entry->path, path) == 0)
+        {
+          g_cache_stats.hits++;
+          entry->lastused = ++g_cache_clock;
+          entry->refs++;
+          return entry;
+        }
+    }
+
+  g_cache_stats.misses++;
+  return NULL;
+}
+
+FAR struct httpd_cache_s *
+httpd_cache_add(FAR const char *path, FAR const struct stat *sb,
+                FAR const char *headers, FAR const char *etag)
+{
+  FAR struct httpd_cache_s *entry;
+  FAR struct httpd_cache_s *victim;
+  int i;
+
+  /* An old version of the same file is replaced first */
+
+  entry = NULL;
+  for (i = 0; i < CONFIG_THTTPD_CACHE_ENTRIES; i++)
+    {
+      if (g_cache[i].path != NULL && g_cache[i].refs == 0 &&
+          strcmp(g_cache[i].path, path) == 0)
+        {
+          entry = &g_cache[i];
+          cache_free(entry);
+          break;
+        }
+    }
+
+  if (entry == NULL)
+    {
+      entry = cache_victim(false);
+      if (entry == NULL)
+        {
+          /* All entries are being sent */
+
+          return NULL;
+        }
+
+      if (entry->path != NULL)
+        {
+          g_cache_stats.evictions++;
+          cache_free(entry);
+        }
+    }
+
+  entry->path    = httpd_strdup(path);
+  entry->headers = httpd_strdup(headers);
+  if (entry->path == NULL || entry->headers == NULL)
+    {
+      httpd_free(entry->path);
+      httpd_free(entry->headers);
+      entry->path    = NULL;
+      entry->headers = NULL;
+      return NULL;
+    }
+
+  g_cache_stats.entries++;
+  entry->mtime    = sb->st_mtime;
+  entry->size     = sb->st_size;
+  entry->lastused = ++g_cache_clock;
+  entry->refs     = 1;
+  strlcpy(entry->etag, etag, sizeof(entry->etag));
+
+  /* Keep the file data of small files too, as long as the total stays
+   * within CONFIG_THTTPD_CACHE_SIZE.
+   */
+
+  if (sb->st_size > CONFIG_THTTPD_CACHE_MAXFILE ||
+      sb->st_size > CONFIG_THTTPD_CACHE_SIZE)
+    {
+      return entry;
+    }
+
+  while (g_cache_stats.bytes + sb->st_size > CONFIG_THTTPD_CACHE_SIZE)
+    {
+      victim = cache_victim(true);
+      if (victim == NULL)
+        {
+          return entry;
+        }
+
+      g_cache_stats.bytes -= victim->size;
+      httpd_free(victim->body);
+      victim->body = NULL;
+    }
+
+  entry->body = cache_read(path, sb->st_size);
+  if (entry->body != NULL)
+    {
+      g_cache_stats.bytes += sb->st_size;
+    }
+
+  return entry;
+}
+
+void httpd_cache_release(FAR struct httpd_cache_s *entry)
+{
+  DEBUGASSERT(entry != NULL && entry->refs > 0);
+  entry->refs--;
+}
+
+void httpd_cache_stats(FAR struct httpd_cache_stats_s *stats)
+{
+  memcpy(stats, &g_cache_stats, sizeof(*stats));
+}
+
+#endif /* CONFIG_THTTPD && CONFIG_THTTPD_CACHE */
@@ -0,0 +1,98 @@
+/****************************************************************************
+ * apps/netutils/thttpd/thttpd_cache.h
+ * Response cache for small static files
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+#ifndef __APPS_NETUTILS_THTTPD_THTTPD_CACHE_H
+#define __APPS_NETUTILS_THTTPD_THTTPD_CACHE_H
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <stdint.h>
+#include <time.h>
+
+#include "config.h"
+#include "libhttpd.h"
+
+#if defined(CONFIG_THTTPD) && defined(CONFIG_THTTPD_CACHE)
+
+/****************************************************************************
+ * Public Type Definitions
+ ****************************************************************************/
+
+/* One cached file.  An entry is found by the expanded file name and stays
+ * valid as long as the modification time and the size of the file do not
+ * change.
+ */
+
+struct httpd_cache_s
+{
+  FAR char *path;              /* Expanded file name, NULL if unused */
+  time_t mtime;                /* Modification time of the file */
+  off_t size;                  /* Size of the file */
+  FAR char *headers;           /* Prebuilt headers that depend on the file */
+  FAR uint8_t *body;           /* File data or NULL if the file is big */
+  uint32_t lastused;           /* Age for least recently used replacement */
+  uint16_t refs;               /* Connections using the entry */
+  char etag[ETAG_SIZE];        /* Quoted entity tag */
+};
+
+struct httpd_cache_stats_s
+{
+  uint32_t hits;               /* Requests served from the cache */
+  uint32_t misses;             /* Requests not found in the cache */
+  uint32_t evictions;          /* Entries replaced by other files */
+  uint16_t entries;            /* Entries in use */
+  size_t bytes;                /* File data held in the cache */
+};
+
+/****************************************************************************
+ * Public Function Prototypes
+ ****************************************************************************/
+
+/* Find the entry of a file.  Returns a referenced entry or NULL on a miss */
+
+extern FAR struct httpd_cache_s *
+httpd_cache_lookup(FAR const char *path, FAR const struct stat *sb);
+
+/* Add a file with its prebuilt headers.  Files not bigger than
+ * CONFIG_THTTPD_CACHE_MAXFILE are read into the cache too.  Returns a
+ * referenced entry or NULL if there is no room.
+ */
+
+extern FAR struct httpd_cache_s *
+httpd_cache_add(FAR const char *path, FAR const struct stat *sb,
+                FAR const char *headers, FAR const char *etag);
+
+/* Drop a reference returned by httpd_cache_lookup() or httpd_cache_add() */
+
+extern void httpd_cache_release(FAR struct httpd_cache_s *entry);
+
+/* Get the cache counters */
+
+extern void httpd_cache_stats(FAR struct httpd_cache_stats_s *stats);
+
+#endif /* CONFIG_THTTPD && CONFIG_THTTPD_CACHE */
+#endif /* __APPS_NETUTILS_THTTPD_THTTPD_CACHE_H */
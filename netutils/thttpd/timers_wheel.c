@@ -0,0 +1,354 @@
+/****************************************************************************
+ * apps/netutils/thttpd/timers_wheel.c
+ * Timer routines on a hashed timing wheel
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <sys/time.h>
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <debug.h>
+
+#include "config.h"
+#include "thttpd_alloc.h"
+#include "timers.h"
+
+#ifdef CONFIG_THTTPD
+
+/****************************************************************************
+ * Pre-Processor Definitions
+ ****************************************************************************/
+
+/* The wheel has WHEEL_SLOTS slots of WHEEL_TICK milliseconds each.  A timer
+ * is kept unsorted in the slot of its expiration tick, so adding and
+ * cancelling a timer is O(1).  Timers that expire more than one turn of the
+ * wheel ahead share the slot with the nearer ones and are skipped until
+ * their turn comes.
+ */
+
+#define WHEEL_SLOTS CONFIG_THTTPD_TIMER_SLOTS
+#define WHEEL_TICK  CONFIG_THTTPD_TIMER_TICK
+
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+static Timer *wheel[WHEEL_SLOTS];
+static Timer *free_timers;
+static uint32_t cur_tick;      /* Oldest tick that may hold pending timers */
+
+/****************************************************************************
+ * Public Data
+ ****************************************************************************/
+
+ClientData JunkClientData;
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/* Map a time to a wheel tick.  The mapping only has to be monotonic, the
+ * exact expiration time of a timer is still checked before it runs.
+ */
+
+static uint32_t tv2tick(const struct timeval *tv)
+{
+  return (uint32_t)tv->tv_sec * (1000 / WHEEL_TICK) +
+         (uint32_t)(tv->tv_usec / 1000) / WHEEL_TICK;
+}
+
+static int tv_after(const struct timeval *a, const struct timeval *b)
+{
+  return a->tv_sec > b->tv_sec ||
+         (a->tv_sec == b->tv_sec && a->tv_usec > b->tv_usec);
+}
+
+static void w_add(Timer *tmr)
+{
+  uint32_t tick = tv2tick(&tmr->time);
+
+  /* A timer that is already due goes to the slot that is checked next */
+
+  if ((int32_t)(tick - cur_tick) < 0)
+    {
+      tick = cur_tick;
+    }
+
+  tmr->hash = tick % WHEEL_SLOTS;
+  tmr->prev = NULL;
+  tmr->next = wheel[tmr->hash];
+  if (tmr->next != NULL)
+    {
+      tmr->next->prev = tmr;
+    }
+
+  wheel[tmr->hash] = tmr;
+}
+
+static void w_remove(Timer *tmr)
+{
+  if (tmr->prev == NULL)
+    {
+      wheel[tmr->hash] = tmr->next;
+    }
+  else
+    {
+      tmr->prev->next = tmr->next;
+    }
+
+  if (tmr->next != NULL)
+    {
+      tmr->next->prev = tmr->prev;
+    }
+}
+
+static void tv_add_msecs(struct timeval *tv, long msecs)
+{
+  tv->tv_sec  += msecs / 1000L;
+  tv->tv_usec += (msecs % 1000L) * 1000L;
+  if (tv->tv_usec >= 1000000L)
+    {
+      tv->tv_sec  += tv->tv_usec / 1000000L;
+      tv->tv_usec %= 1000000L;
+    }
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+void tmr_init(void)
+{
+  struct timeval now;
+  int h;
+
+  for (h = 0; h < WHEEL_SLOTS; ++h)
+    {
+      wheel[h] = NULL;
+    }
+
+  free_timers = NULL;
+
+  gettimeofday(&now, NULL);
+  cur_tick = tv2tick(&now);
+}
+
+Timer *tmr_create(struct timeval *now, TimerProc *timer_proc,
+                  ClientData client_data, long msecs, int periodic)
+{
+  Timer *tmr;
+
+  if (free_timers != NULL)
+    {
+      tmr = free_timers;
+      free_timers = tmr->next;
+    }
+  else
+    {
+      tmr = (Timer *)httpd_malloc(sizeof(Timer));
+      if (!tmr)
+        {
+          return NULL;
+        }
+    }
+
+  tmr->timer_proc  = timer_proc;
+  tmr->client_data = client_data;
+  tmr->msecs       = msecs;
+  tmr->periodic    = periodic;
+
+  if (now != NULL)
+    {
+      tmr->time = *now;
+    }
+  else
+    {
+      gettimeofday(&tmr->time, NULL);
+    }
+
+  tv_add_msecs(&tmr->time, msecs);
+  w_add(tmr);
+  return tmr;
+}
+
+long tmr_mstimeout(struct timeval *now)
+{
+  Timer *first = NULL;
+  Timer *tmr;
+  uint32_t tick;
+  long msecs;
+  int h;
+
+  /* Walk the wheel from the current tick.  The first slot with a timer of
+   * its own turn holds the next timer to expire.
+   */
+
+  for (h = 0; h < WHEEL_SLOTS && first == NULL; ++h)
+    {
+      tick = cur_tick + h;
+      for (tmr = wheel[tick % WHEEL_SLOTS]; tmr != NULL; tmr = tmr->next)
+        {
+          if ((int32_t)(tv2tick(&tmr->time) - tick) <= 0 &&
+              (first == NULL || tv_after(&first->time, &tmr->time)))
+            {
+              first = tmr;
+            }
+        }
+    }
+
+  /* All timers, if any, are more than one turn ahead */
+
+  for (h = 0; h < WHEEL_SLOTS && first == NULL; ++h)
+    {
+      for (tmr = wheel[h]; tmr != NULL; tmr = tmr->next)
+        {
+          if (first == NULL || tv_after(&first->time, &tmr->time))
+            {
+              first = tmr;
+            }
+        }
+    }
+
+  if (first == NULL)
+    {
+      return INFTIM;
+    }
+
+  msecs = (first->time.tv_sec - now->tv_sec) * 1000L +
+          (first->time.tv_usec - now->tv_usec) / 1000L;
+  if (msecs <= 0)
+    {
+      msecs = 0;
+    }
+
+  return msecs;
+}
+
+void tmr_run(struct timeval *now)
+{
+  uint32_t tick = tv2tick(now);
+  uint32_t first = cur_tick;
+  uint32_t nslots;
+  uint32_t i;
+  Timer *tmr;
+  Timer *next;
+
+  /* Check the slots of all ticks since the last run, at most one turn.
+   * The slot of the current tick is checked again next time because it
+   * may still hold timers that expire later within the tick.
+   */
+
+  if ((int32_t)(tick - first) < 0)
+    {
+      nslots = 1;
+    }
+  else
+    {
+      nslots = tick - first + 1;
+      if (nslots > WHEEL_SLOTS)
+        {
+          nslots = WHEEL_SLOTS;
+        }
+
+      /* Advance before running the timers so that the timers they create
+       * are not put behind the current tick.
+       */
+
+      cur_tick = tick;
+    }
+
+  for (i = 0; i < nslots; i++)
+    {
+      for (tmr = wheel[(first + i) % WHEEL_SLOTS]; tmr != NULL; tmr = next)
+        {
+          next = tmr->next;
+
+          /* The slot is not sorted and holds the timers of later turns
+           * too.
+           */
+
+          if (tv_after(&tmr->time, now))
+            {
+              continue;
+            }
+
+          (tmr->timer_proc)(tmr->client_data, now);
+          if (tmr->periodic)
+            {
+              /* Reschedule. */
+
+              w_remove(tmr);
+              tv_add_msecs(&tmr->time, tmr->msecs);
+              w_add(tmr);
+            }
+          else
+            {
+              tmr_cancel(tmr);
+            }
+        }
+    }
+}
+
+void tmr_cancel(Timer *tmr)
+{
+  /* Remove it from its slot. */
+
+  w_remove(tmr);
+
+  /* And put it on the free list. */
+
+  tmr->next   = free_timers;
+  free_timers = tmr;
+  tmr->prev   = NULL;
+}
+
+void tmr_cleanup(void)
+{
+  Timer *tmr;
+
+  while (free_timers != NULL)
+    {
+      tmr = free_timers;
+      free_timers = tmr->next;
+      httpd_free((void *)tmr);
+    }
+}
+
+void tmr_destroy(void)
+{
+  int h;
+
+  for (h = 0; h < WHEEL_SLOTS; ++h)
+    {
+      while (wheel[h] != NULL)
+        {
+          tmr_cancel(wheel[h]);
+        }
+    }
+
+  tmr_cleanup();
+}
+
+#endif /* CONFIG_THTTPD */
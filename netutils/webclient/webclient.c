@@ -67,6 +67,8 @@
 #include <stdlib.h>
 #include <errno.h>
 #include <inttypes.h>
+#include <limits.h>
+#include <time.h>
 
 #include <arpa/inet.h>
 #include <netinet/in.h>
@@ -79,6 +81,13 @@
 #include "netutils/netlib.h"
 #include "netutils/webclient.h"
 
+#ifdef WGET_USE_STATS
+#  include <pthread.h>
+#endif
+#ifdef CONFIG_WEBCLIENT_KEEPALIVE
+#  include <poll.h>
+#endif
+
 #if defined(CONFIG_NETUTILS_CODECS)
 #  if defined(CONFIG_CODECS_URLCODE)
 #    include "netutils/urldecode.h"
@@ -109,6 +118,10 @@
 #  define CONFIG_WEBCLIENT_TIMEOUT 10
 #endif
 
+#ifndef CONFIG_WEBCLIENT_RCVBUF_SIZE
+#  define CONFIG_WEBCLIENT_RCVBUF_SIZE 0
+#endif
+
 #ifndef CONFIG_WEBCLIENT_MAX_REDIRECT
 /* The default value 50 is taken from curl's --max-redirs option. */
 #  define CONFIG_WEBCLIENT_MAX_REDIRECT 50
@@ -132,6 +145,12 @@
 #define CONN_WANT_READ  WEBCLIENT_POLL_INFO_WANT_READ
 #define CONN_WANT_WRITE WEBCLIENT_POLL_INFO_WANT_WRITE
 
+#ifdef CONFIG_WEBCLIENT_KEEPALIVE
+#  define WGET_KEEPALIVE(ws) ((ws)->keepalive)
+#else
+#  define WGET_KEEPALIVE(ws) false
+#endif
+
 #ifdef CONFIG_DEBUG_ASSERTIONS
 #define _CHECK_STATE(ctx, s) DEBUGASSERT((ctx)->state == (s))
 #define _SET_STATE(ctx, s)   ctx->state = (s)
@@ -164,11 +183,14 @@ enum webclient_state_e
     WEBCLIENT_STATE_TUNNEL_ESTABLISHED,
   };
 
+struct wget_pipeline_s;
+
 /* flags for wget_s::internal_flags */
 
 #define WGET_FLAG_GOT_CONTENT_LENGTH 1U
 #define WGET_FLAG_CHUNKED            2U
 #define WGET_FLAG_GOT_LOCATION       4U
+#define WGET_FLAG_CONN_CLOSE         8U /* The server will close the conn */
 
 struct wget_target_s
 {
@@ -225,7 +247,56 @@ struct wget_s
   size_t data_len;
 
   FAR struct webclient_context *tunnel;
+
+#ifdef CONFIG_WEBCLIENT_KEEPALIVE
+  bool keepalive;    /* Keep the connection if the response allows it */
+  bool reused;       /* The connection was used by an earlier request */
+  bool reusable;     /* The response has ended, the connection can stay */
+  bool retried;      /* Already retried on a new connection */
+#endif
+#ifdef CONFIG_WEBCLIENT_PIPELINE
+  FAR struct wget_pipeline_s *pipeline;
+#endif
+};
+
+#ifdef CONFIG_WEBCLIENT_KEEPALIVE
+/* An idle connection of the pool.  A free entry has an empty hostname. */
+
+struct wget_poolentry_s
+{
+  char hostname[CONFIG_WEBCLIENT_MAXHOSTNAME];
+  uint16_t port;
+  time_t since;      /* When the connection became idle */
+  struct webclient_conn_s conn;
+};
+#endif
+
+#ifdef CONFIG_WEBCLIENT_PIPELINE
+/* The connection shared by the requests of webclient_perform_pipeline() */
+
+struct wget_pipeline_s
+{
+  struct webclient_conn_s conn;
+  char hostname[CONFIG_WEBCLIENT_MAXHOSTNAME];
+  uint16_t port;
+  bool connected;    /* conn is open */
+  bool sending;      /* Send the requests, don't wait for the responses */
+  unsigned int pending;         /* Responses not read yet */
+  FAR const char *leftover;     /* Received part of the next response */
+  int nleftover;
+};
+#endif
+
+#ifdef CONFIG_WEBCLIENT_DNS_CACHE
+/* A cached host name lookup.  A free entry has an empty hostname. */
+
+struct wget_dnsentry_s
+{
+  char hostname[CONFIG_WEBCLIENT_MAXHOSTNAME];
+  struct in_addr addr;
+  time_t expire;
 };
+#endif
 
 /****************************************************************************
  * Private Data
@@ -237,6 +308,9 @@ static const char g_http11[]               = "HTTP/1.1";
 static const char g_httpcontenttype[]      = "content-type: ";
 #endif
 static const char g_httphost[]             = "host: ";
+#ifdef CONFIG_WEBCLIENT_KEEPALIVE
+static const char g_httpconnection[]       = "connection: ";
+#endif
 static const char g_httplocation[]         = "location: ";
 static const char g_httptransferencoding[] = "transfer-encoding: ";
 
@@ -256,6 +330,24 @@ static const char g_httpconn[]       = "Connection: Keep-Alive";
 static const char g_httpcache[]      = "Cache-Control: no-cache";
 #endif
 
+#ifdef WGET_USE_STATS
+/* g_webclient_lock protects the statistics, the connection pool and the
+ * DNS cache.
+ */
+
+static pthread_mutex_t g_webclient_lock = PTHREAD_MUTEX_INITIALIZER;
+static struct webclient_stats_s g_webclient_stats;
+#endif
+
+#ifdef CONFIG_WEBCLIENT_KEEPALIVE
+static struct wget_poolentry_s g_webclient_pool[CONFIG_WEBCLIENT_POOL_SIZE];
+#endif
+
+#ifdef CONFIG_WEBCLIENT_DNS_CACHE
+static struct wget_dnsentry_s
+  g_webclient_dns[CONFIG_WEBCLIENT_DNS_CACHE_ENTRIES];
+#endif
+
 /****************************************************************************
  * Private Functions
  ****************************************************************************/
@@ -378,6 +470,64 @@ static int wget_parseint(const char *cp, uintmax_t *resultp, int base)
   return 0;
 }
 
+/****************************************************************************
+ * Name: wget_now
+ *
+ * Description:
+ *   Return the monotonic time in seconds, for the pool and cache timeouts.
+ *
+ ****************************************************************************/
+
+#ifdef WGET_USE_STATS
+static time_t wget_now(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec;
+}
+#endif
+
+/****************************************************************************
+ * Name: wget_count
+ ****************************************************************************/
+
+#ifdef WGET_USE_STATS
+static void wget_count(FAR uint32_t *counter)
+{
+  pthread_mutex_lock(&g_webclient_lock);
+  (*counter)++;
+  pthread_mutex_unlock(&g_webclient_lock);
+}
+#endif
+
+/****************************************************************************
+ * Name: wget_count_request
+ ****************************************************************************/
+
+#ifdef WGET_USE_STATS
+static void wget_count_request(FAR struct wget_s *ws)
+{
+  pthread_mutex_lock(&g_webclient_lock);
+  g_webclient_stats.requests++;
+#ifdef CONFIG_WEBCLIENT_KEEPALIVE
+  if (ws->reused)
+    {
+      g_webclient_stats.reused++;
+    }
+#endif
+
+#ifdef CONFIG_WEBCLIENT_PIPELINE
+  if (ws->pipeline != NULL && ws->pipeline->pending > 0)
+    {
+      g_webclient_stats.pipelined++;
+    }
+#endif
+
+  pthread_mutex_unlock(&g_webclient_lock);
+}
+#endif
+
 /****************************************************************************
  * Name: wget_parsestatus
  ****************************************************************************/
@@ -496,7 +646,16 @@ static inline int wget_parsestatus(struct webclient_context *ctx,
           ws->state = WEBCLIENT_STATE_HEADERS;
           ws->internal_flags &= ~(WGET_FLAG_GOT_CONTENT_LENGTH |
                                   WGET_FLAG_CHUNKED |
-                                  WGET_FLAG_GOT_LOCATION);
+                                  WGET_FLAG_GOT_LOCATION |
+                                  WGET_FLAG_CONN_CLOSE);
+
+          /* An HTTP/1.0 server closes the connection after the response */
+
+          if (strncmp(ws->line, g_http10, strlen(g_http10)) == 0)
+            {
+              ws->internal_flags |= WGET_FLAG_CONN_CLOSE;
+            }
+
           ndx = 0;
           break;
         }
@@ -611,6 +770,19 @@ static inline int wget_parseheaders(struct webclient_context *ctx,
                    * actual data.
                    */
 
+                  /* The response to a HEAD request and 204 and 304
+                   * responses never have a body, whatever the headers say.
+                   * (RFC 7230, section 3.3.3)
+                   */
+
+                  if (strcmp(ctx->method, "HEAD") == 0 ||
+                      ctx->http_status == 204 || ctx->http_status == 304)
+                    {
+                      ws->internal_flags &= ~WGET_FLAG_CHUNKED;
+                      ws->internal_flags |= WGET_FLAG_GOT_CONTENT_LENGTH;
+                      ws->expected_resp_body_len = 0;
+                    }
+
                   if ((ws->internal_flags & WGET_FLAG_CHUNKED) != 0)
                     {
                       ws->state = WEBCLIENT_STATE_CHUNKED_HEADER;
@@ -752,6 +924,17 @@ static inline int wget_parseheaders(struct webclient_context *ctx,
                   ninfo("transfer encodings: '%s'\n", encodings);
                   ws->internal_flags |= WGET_FLAG_CHUNKED;
                 }
+#ifdef CONFIG_WEBCLIENT_KEEPALIVE
+              else if (strncasecmp(ws->line, g_httpconnection,
+                                   strlen(g_httpconnection)) == 0)
+                {
+                  if (strcasestr(ws->line + strlen(g_httpconnection),
+                                 "close") != NULL)
+                    {
+                      ws->internal_flags |= WGET_FLAG_CONN_CLOSE;
+                    }
+                }
+#endif
             }
 
           if (found && !got_nl)
@@ -1012,6 +1195,92 @@ static inline int wget_parsechunktrailer(struct webclient_context *ctx,
   return ret;
 }
 
+/****************************************************************************
+ * Name: wget_dns_lookup
+ *
+ * Description:
+ *   Look up a host name in the DNS cache.  Returns true if a live entry
+ *   was found.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_WEBCLIENT_DNS_CACHE
+static bool wget_dns_lookup(FAR const char *hostname,
+                            FAR struct in_addr *dest)
+{
+  FAR struct wget_dnsentry_s *entry;
+  time_t now = wget_now();
+  bool found = false;
+  int i;
+
+  pthread_mutex_lock(&g_webclient_lock);
+  for (i = 0; i < CONFIG_WEBCLIENT_DNS_CACHE_ENTRIES; i++)
+    {
+      entry = &g_webclient_dns[i];
+      if (entry->hostname[0] != '\0' && entry->expire - now > 0 &&
+          strcmp(entry->hostname, hostname) == 0)
+        {
+          *dest = entry->addr;
+          found = true;
+          break;
+        }
+    }
+
+  if (found)
+    {
+      g_webclient_stats.dns_hits++;
+    }
+  else
+    {
+      g_webclient_stats.dns_misses++;
+    }
+
+  pthread_mutex_unlock(&g_webclient_lock);
+  return found;
+}
+#endif
+
+/****************************************************************************
+ * Name: wget_dns_add
+ *
+ * Description:
+ *   Add a resolved host name to the DNS cache, replacing the entry of the
+ *   same name, an expired entry or the one which expires first.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_WEBCLIENT_DNS_CACHE
+static void wget_dns_add(FAR const char *hostname,
+                         FAR const struct in_addr *addr)
+{
+  FAR struct wget_dnsentry_s *victim = &g_webclient_dns[0];
+  FAR struct wget_dnsentry_s *entry;
+  time_t now = wget_now();
+  int i;
+
+  pthread_mutex_lock(&g_webclient_lock);
+  for (i = 0; i < CONFIG_WEBCLIENT_DNS_CACHE_ENTRIES; i++)
+    {
+      entry = &g_webclient_dns[i];
+      if (strcmp(entry->hostname, hostname) == 0)
+        {
+          victim = entry;
+          break;
+        }
+
+      if (entry->expire - victim->expire < 0)
+        {
+          victim = entry;
+        }
+    }
+
+  strlcpy(victim->hostname, hostname, sizeof(victim->hostname));
+  victim->addr   = *addr;
+  victim->expire = now + CONFIG_WEBCLIENT_DNS_CACHE_TTL;
+  pthread_mutex_unlock(&g_webclient_lock);
+}
+#endif
+
 /****************************************************************************
  * Name: wget_gethostip
  *
@@ -1021,49 +1290,534 @@ static inline int wget_parsechunktrailer(struct webclient_context *ctx,
  * Input Parameters
  *   hostname - The host name to use in the nslookup.
  *
- * Output Parameters
- *   dest     - The location to return the IPv4 address.
+ * Output Parameters
+ *   dest     - The location to return the IPv4 address.
+ *
+ * Returned Value:
+ *   Zero (OK) on success; ERROR on failure.
+ *
+ ****************************************************************************/
+
+static int wget_gethostip(FAR char *hostname, FAR struct in_addr *dest)
+{
+#ifdef CONFIG_LIBC_NETDB
+  FAR struct addrinfo hint;
+  FAR struct addrinfo *info;
+  FAR struct sockaddr_in *addr;
+
+#ifdef CONFIG_WEBCLIENT_DNS_CACHE
+  if (wget_dns_lookup(hostname, dest))
+    {
+      return OK;
+    }
+#endif
+
+  memset(&hint, 0, sizeof(hint));
+  hint.ai_family = AF_INET;
+
+  if (getaddrinfo(hostname, NULL, &hint, &info) != OK)
+    {
+      return ERROR;
+    }
+
+  addr = (FAR struct sockaddr_in *)info->ai_addr;
+  memcpy(dest, &addr->sin_addr, sizeof(struct in_addr));
+
+  freeaddrinfo(info);
+
+#ifdef CONFIG_WEBCLIENT_DNS_CACHE
+  wget_dns_add(hostname, dest);
+#endif
+
+  return OK;
+#else
+  /* No host name support */
+
+  /* Convert strings to numeric IPv4 address */
+
+  int ret = inet_pton(AF_INET, hostname, dest);
+
+  /* The inet_pton() function returns 1 if the conversion succeeds. It will
+   * return 0 if the input is not a valid IPv4 dotted-decimal string or -1
+   * with errno set to EAFNOSUPPORT if the address family argument is
+   * unsupported.
+   */
+
+  return (ret > 0) ? OK : ERROR;
+#endif
+}
+
+/****************************************************************************
+ * Name: wget_sockopts
+ *
+ * Description:
+ *   Set up the blocking mode and the timeouts of a socket for the context.
+ *   A socket taken from the pool may have been set up for another context.
+ *
+ * Returned Value:
+ *   Zero (OK) on success; a negated errno value on failure.
+ *
+ ****************************************************************************/
+
+static int wget_sockopts(FAR struct webclient_context *ctx, int sockfd)
+{
+  struct timeval tv;
+  int flags;
+  int ret;
+
+  flags = fcntl(sockfd, F_GETFL, 0);
+  if ((ctx->flags & WEBCLIENT_FLAG_NON_BLOCKING) != 0)
+    {
+      ret = fcntl(sockfd, F_SETFL, flags | O_NONBLOCK);
+      if (ret == -1)
+        {
+          ret = -errno;
+          nerr("ERROR: F_SETFL failed: %d\n", ret);
+        }
+
+      return ret;
+    }
+
+  if (flags != -1 && (flags & O_NONBLOCK) != 0)
+    {
+      ret = fcntl(sockfd, F_SETFL, flags & ~O_NONBLOCK);
+      if (ret == -1)
+        {
+          ret = -errno;
+          nerr("ERROR: F_SETFL failed: %d\n", ret);
+          return ret;
+        }
+    }
+
+  /* Set send and receive timeout values */
+
+  tv.tv_sec  = ctx->timeout_sec;
+  tv.tv_usec = 0;
+
+  /* Check return value one by one */
+
+  ret = setsockopt(sockfd, SOL_SOCKET, SO_RCVTIMEO,
+                   &tv, sizeof(struct timeval));
+  if (ret != 0)
+    {
+      ret = -errno;
+      nerr("ERROR: setsockopt failed: %d\n", ret);
+      return ret;
+    }
+
+  ret = setsockopt(sockfd, SOL_SOCKET, SO_SNDTIMEO,
+                   &tv, sizeof(struct timeval));
+  if (ret != 0)
+    {
+      ret = -errno;
+      nerr("ERROR: setsockopt failed: %d\n", ret);
+      return ret;
+    }
+
+  return OK;
+}
+
+/****************************************************************************
+ * Name: wget_keepalive
+ *
+ * Description:
+ *   Check whether the connection of the request may be kept open.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_WEBCLIENT_KEEPALIVE
+static bool wget_keepalive(FAR struct webclient_context *ctx)
+{
+#if defined(CONFIG_WEBCLIENT_NET_LOCAL)
+  if (ctx->unix_socket_path != NULL)
+    {
+      return false;
+    }
+#endif
+
+  return (ctx->flags & (WEBCLIENT_FLAG_KEEP_ALIVE |
+                        WEBCLIENT_FLAG_TUNNEL)) ==
+         WEBCLIENT_FLAG_KEEP_ALIVE &&
+         ctx->protocol_version == WEBCLIENT_PROTOCOL_VERSION_HTTP_1_1 &&
+         ctx->proxy == NULL;
+}
+#endif
+
+/****************************************************************************
+ * Name: wget_pool_get
+ *
+ * Description:
+ *   Take an idle connection to the target of the request from the pool.
+ *   Expired connections and the ones the server has closed meanwhile are
+ *   closed on the way.
+ *
+ * Returned Value:
+ *   true if conn has been set to a pooled connection.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_WEBCLIENT_KEEPALIVE
+static bool wget_pool_get(FAR struct wget_s *ws,
+                          FAR struct webclient_conn_s *conn)
+{
+  struct webclient_conn_s stale[CONFIG_WEBCLIENT_POOL_SIZE];
+  FAR struct wget_poolentry_s *entry;
+  struct pollfd pfd;
+  time_t now;
+  bool found;
+  int nstale;
+  int i;
+
+  do
+    {
+      now    = wget_now();
+      found  = false;
+      nstale = 0;
+
+      pthread_mutex_lock(&g_webclient_lock);
+      for (i = 0; i < CONFIG_WEBCLIENT_POOL_SIZE; i++)
+        {
+          entry = &g_webclient_pool[i];
+          if (entry->hostname[0] == '\0')
+            {
+              continue;
+            }
+
+          if (now - entry->since >= CONFIG_WEBCLIENT_POOL_IDLE_TIMEOUT)
+            {
+              stale[nstale++] = entry->conn;
+              entry->hostname[0] = '\0';
+            }
+          else if (!found && entry->port == ws->target.port &&
+                   entry->conn.tls == conn->tls &&
+                   (!conn->tls ||
+                    (entry->conn.tls_ops == conn->tls_ops &&
+                     entry->conn.tls_ctx == conn->tls_ctx)) &&
+                   strcmp(entry->hostname, ws->target.hostname) == 0)
+            {
+              *conn = entry->conn;
+              entry->hostname[0] = '\0';
+              found = true;
+            }
+        }
+
+      pthread_mutex_unlock(&g_webclient_lock);
+
+      for (i = 0; i < nstale; i++)
+        {
+          webclient_conn_close(&stale[i]);
+        }
+
+      if (!found || conn->tls)
+        {
+          break;
+        }
+
+      /* An idle connection must not be readable.  If it is, the server
+       * has closed it or sent something unexpected.
+       */
+
+      pfd.fd      = conn->sockfd;
+      pfd.events  = POLLIN;
+      pfd.revents = 0;
+      if (poll(&pfd, 1, 0) == 0)
+        {
+          break;
+        }
+
+      ninfo("Pooled connection %d is closed\n", conn->sockfd);
+      webclient_conn_close(conn);
+    }
+  while (true);
+
+  return found;
+}
+#endif
+
+/****************************************************************************
+ * Name: wget_pool_put
+ *
+ * Description:
+ *   Put an idle connection into the pool.  If the pool is full, the
+ *   connection idle for the longest time is closed.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_WEBCLIENT_KEEPALIVE
+static void wget_pool_put(FAR struct wget_s *ws,
+                          FAR struct webclient_conn_s *conn)
+{
+  FAR struct wget_poolentry_s *victim = &g_webclient_pool[0];
+  FAR struct wget_poolentry_s *entry;
+  struct webclient_conn_s evicted;
+  bool evict;
+  int i;
+
+  pthread_mutex_lock(&g_webclient_lock);
+  for (i = 0; i < CONFIG_WEBCLIENT_POOL_SIZE; i++)
+    {
+      entry = &g_webclient_pool[i];
+      if (entry->hostname[0] == '\0')
+        {
+          victim = entry;
+          break;
+        }
+
+      if (entry->since - victim->since < 0)
+        {
+          victim = entry;
+        }
+    }
+
+  evict = victim->hostname[0] != '\0';
+  if (evict)
+    {
+      evicted = victim->conn;
+    }
+
+  strlcpy(victim->hostname, ws->target.hostname, sizeof(victim->hostname));
+  victim->port  = ws->target.port;
+  victim->since = wget_now();
+  victim->conn  = *conn;
+  pthread_mutex_unlock(&g_webclient_lock);
+
+  if (evict)
+    {
+      webclient_conn_close(&evicted);
+    }
+}
+#endif
+
+/****************************************************************************
+ * Name: wget_response_done
+ *
+ * Description:
+ *   Check whether the whole response has been received, without waiting
+ *   for the server to close the connection.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_WEBCLIENT_KEEPALIVE
+static bool wget_response_done(FAR struct wget_s *ws)
+{
+  if (ws->state == WEBCLIENT_STATE_WAIT_CLOSE)
+    {
+      return true;
+    }
+
+  return ws->state == WEBCLIENT_STATE_DATA &&
+         ws->httpstatus != HTTPSTATUS_MOVED &&
+         (ws->internal_flags & WGET_FLAG_GOT_CONTENT_LENGTH) != 0 &&
+         ws->received_body_len == ws->expected_resp_body_len;
+}
+#endif
+
+/****************************************************************************
+ * Name: wget_may_retry
+ *
+ * Description:
+ *   Check whether a request failed because the server had closed the
+ *   reused connection before the request arrived.  Such a request can
+ *   be sent again on a new connection.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_WEBCLIENT_KEEPALIVE
+static bool wget_may_retry(FAR struct webclient_context *ctx,
+                           FAR struct wget_s *ws, int ret)
+{
+  if (!ws->reused || ws->retried || ret == -EAGAIN || ret == -ETIMEDOUT)
+    {
+      return false;
+    }
+
+#ifdef CONFIG_WEBCLIENT_PIPELINE
+  if (ws->pipeline != NULL)
+    {
+      return false;
+    }
+#endif
+
+  switch (ws->state)
+    {
+      case WEBCLIENT_STATE_SEND_REQUEST:
+        return true;
+
+      case WEBCLIENT_STATE_SEND_REQUEST_BODY:
+
+        /* Only a static body can be provided again */
+
+        return ctx->bodylen == 0 ||
+               ctx->body_callback == webclient_static_body_func;
+
+      case WEBCLIENT_STATE_STATUSLINE:
+
+        /* Nothing of the response has been received */
+
+        return ws->datend == 0;
+
+      default:
+        return false;
+    }
+}
+#endif
+
+/****************************************************************************
+ * Name: wget_conn_release
+ *
+ * Description:
+ *   Release the connection after the response: keep it for the next
+ *   pipelined response, put it into the pool or close it.
+ *
+ ****************************************************************************/
+
+static void wget_conn_release(FAR struct wget_s *ws,
+                              FAR struct webclient_conn_s *conn)
+{
+#ifdef CONFIG_WEBCLIENT_PIPELINE
+  FAR struct wget_pipeline_s *pipeline = ws->pipeline;
+
+  if (pipeline != NULL)
+    {
+      ws->pipeline = NULL;
+      pipeline->pending--;
+      if (ws->reusable && pipeline->pending > 0)
+        {
+          /* The rest of the buffer is the start of the next response */
+
+          pipeline->leftover  = ws->buffer + ws->offset;
+          pipeline->nleftover = ws->datend - ws->offset;
+          return;
+        }
+
+      pipeline->connected = false;
+    }
+#endif
+
+#ifdef CONFIG_WEBCLIENT_KEEPALIVE
+  if (ws->reusable && ws->offset == ws->datend)
+    {
+      wget_pool_put(ws, conn);
+      return;
+    }
+#endif
+
+  webclient_conn_close(conn);
+}
+
+/****************************************************************************
+ * Name: wget_direct_len
+ *
+ * Description:
+ *   Return how many bytes of the response body may be received into the
+ *   buffer of recv_buffer_callback, or zero if the next bytes have to go
+ *   to ws->buffer.
+ *
+ ****************************************************************************/
+
+static uintmax_t wget_direct_len(FAR struct webclient_context *ctx,
+                                 FAR struct wget_s *ws)
+{
+  if (ctx->recv_buffer_callback == NULL ||
+      ws->httpstatus == HTTPSTATUS_MOVED)
+    {
+      return 0;
+    }
+
+  if (ws->state == WEBCLIENT_STATE_CHUNKED_DATA)
+    {
+      return ws->chunk_len - ws->chunk_received;
+    }
+
+  if (ws->state != WEBCLIENT_STATE_DATA)
+    {
+      return 0;
+    }
+
+  if ((ws->internal_flags & WGET_FLAG_GOT_CONTENT_LENGTH) != 0)
+    {
+      return ws->expected_resp_body_len - ws->received_body_len;
+    }
+
+  return UINTMAX_MAX;
+}
+
+/****************************************************************************
+ * Name: wget_recv_direct
+ *
+ * Description:
+ *   Receive up to len bytes of the response body into the buffer provided
+ *   by recv_buffer_callback and pass them to the sink callback.
  *
  * Returned Value:
- *   Zero (OK) on success; ERROR on failure.
+ *   The number of bytes received, zero if the connection has been closed,
+ *   or a negated errno value on failure.
  *
  ****************************************************************************/
 
-static int wget_gethostip(FAR char *hostname, FAR struct in_addr *dest)
+static ssize_t wget_recv_direct(FAR struct webclient_context *ctx,
+                                FAR struct wget_s *ws,
+                                FAR struct webclient_conn_s *conn,
+                                uintmax_t len)
 {
-#ifdef CONFIG_LIBC_NETDB
-  FAR struct addrinfo hint;
-  FAR struct addrinfo *info;
-  FAR struct sockaddr_in *addr;
+  FAR char *buffer;
+  size_t size;
+  ssize_t ssz;
+  int buflen;
+  int ret;
 
-  memset(&hint, 0, sizeof(hint));
-  hint.ai_family = AF_INET;
+  ret = ctx->recv_buffer_callback(&buffer, &size, ctx->sink_callback_arg);
+  if (ret < 0)
+    {
+      nerr("ERROR: recv_buffer_callback failed: %d\n", -ret);
+      return ret;
+    }
 
-  if (getaddrinfo(hostname, NULL, &hint, &info) != OK)
+  if (size > len)
     {
-      return ERROR;
+      size = len;
     }
 
-  addr = (FAR struct sockaddr_in *)info->ai_addr;
-  memcpy(dest, &addr->sin_addr, sizeof(struct in_addr));
+  if (size > INT_MAX)
+    {
+      size = INT_MAX;
+    }
 
-  freeaddrinfo(info);
-  return OK;
-#else
-  /* No host name support */
+  ssz = webclient_conn_recv(conn, buffer, size);
+  if (ssz <= 0)
+    {
+      return ssz;
+    }
 
-  /* Convert strings to numeric IPv4 address */
+  ninfo("Got %zd bytes resp body at %ju\n", ssz, ws->received_body_len);
+  ws->received_body_len += ssz;
 
-  int ret = inet_pton(AF_INET, hostname, dest);
+  buflen = size;
+  if (ctx->sink_callback)
+    {
+      ret = ctx->sink_callback(&buffer, 0, ssz, &buflen,
+                               ctx->sink_callback_arg);
+      if (ret != 0)
+        {
+          return ret;
+        }
+    }
+  else if (ctx->callback)
+    {
+      ctx->callback(&buffer, 0, ssz, &buflen, ctx->sink_callback_arg);
+    }
 
-  /* The inet_pton() function returns 1 if the conversion succeeds. It will
-   * return 0 if the input is not a valid IPv4 dotted-decimal string or -1
-   * with errno set to EAFNOSUPPORT if the address family argument is
-   * unsupported.
-   */
+  if (ws->state == WEBCLIENT_STATE_CHUNKED_DATA)
+    {
+      ws->chunk_received += ssz;
+      if (ws->chunk_len == ws->chunk_received)
+        {
+          ws->state = WEBCLIENT_STATE_CHUNKED_ENDDATA;
+          ws->ndx = 0;
+        }
+    }
 
-  return (ret > 0) ? OK : ERROR;
-#endif
+  return ssz;
 }
 
 /****************************************************************************
@@ -1165,7 +1919,12 @@ void webclient_conn_free(FAR struct webclient_conn_s *conn)
 }
 
 /****************************************************************************
- * Name: webclient_perform
+ * Name: wget_perform
+ *
+ * Description:
+ *   The body of webclient_perform().  pipeline is the shared connection of
+ *   webclient_perform_pipeline(), or NULL.  It's only looked at when the
+ *   state structure is created.
  *
  * Returned Value:
  *               0: if the operation completed successfully;
@@ -1173,10 +1932,10 @@ void webclient_conn_free(FAR struct webclient_conn_s *conn)
  *
  ****************************************************************************/
 
-int webclient_perform(FAR struct webclient_context *ctx)
+static int wget_perform(FAR struct webclient_context *ctx,
+                        FAR struct wget_pipeline_s *pipeline)
 {
   struct wget_s *ws;
-  struct timeval tv;
   char *dest;
   char *ep;
   struct webclient_conn_s *conn;
@@ -1267,6 +2026,12 @@ int webclient_perform(FAR struct webclient_context *ctx)
             }
         }
 
+#ifdef CONFIG_WEBCLIENT_PIPELINE
+      ws->pipeline = pipeline;
+#else
+      UNUSED(pipeline);
+#endif
+
       ws->state = WEBCLIENT_STATE_SOCKET;
       ctx->ws = ws;
     }
@@ -1316,6 +2081,50 @@ int webclient_perform(FAR struct webclient_context *ctx)
           ws->ndx        = 0;
           ws->redirected = 0;
 
+#ifdef CONFIG_WEBCLIENT_KEEPALIVE
+          ws->keepalive  = wget_keepalive(ctx);
+          ws->reused     = false;
+          ws->reusable   = false;
+#endif
+
+#ifdef CONFIG_WEBCLIENT_PIPELINE
+          if (ws->pipeline != NULL && ws->pipeline->connected)
+            {
+              /* Send the request on the connection of the previous one */
+
+              if (ws->pipeline->port != ws->target.port ||
+                  ws->pipeline->conn.tls != conn->tls ||
+                  strcmp(ws->pipeline->hostname, ws->target.hostname))
+                {
+                  nerr("ERROR: pipelined requests to different servers\n");
+                  ret = -EINVAL;
+                  goto errout_with_errno;
+                }
+
+              *conn = ws->pipeline->conn;
+              ws->need_conn_close = true;
+              ws->reused = true;
+            }
+          else
+#endif
+#ifdef CONFIG_WEBCLIENT_KEEPALIVE
+          if (ws->keepalive && !ws->retried && wget_pool_get(ws, conn))
+            {
+              ninfo("Reusing a connection to %s:%u\n",
+                    ws->target.hostname, ws->target.port);
+              ws->need_conn_close = true;
+              ws->reused = true;
+              if (!conn->tls)
+                {
+                  ret = wget_sockopts(ctx, conn->sockfd);
+                  if (ret < 0)
+                    {
+                      goto errout_with_errno;
+                    }
+                }
+            }
+          else
+#endif
           if (conn->tls)
             {
 #if defined(CONFIG_WEBCLIENT_NET_LOCAL)
@@ -1380,6 +2189,9 @@ int webclient_perform(FAR struct webclient_context *ctx)
             }
           else
             {
+#if CONFIG_WEBCLIENT_RCVBUF_SIZE > 0
+              int rcvbuf = CONFIG_WEBCLIENT_RCVBUF_SIZE;
+#endif
               int domain;
 
 #if defined(CONFIG_WEBCLIENT_NET_LOCAL)
@@ -1405,44 +2217,23 @@ int webclient_perform(FAR struct webclient_context *ctx)
 
               ws->need_conn_close = true;
 
-              if ((ctx->flags & WEBCLIENT_FLAG_NON_BLOCKING) != 0)
+              ret = wget_sockopts(ctx, conn->sockfd);
+              if (ret < 0)
                 {
-                  int flags = fcntl(conn->sockfd, F_GETFL, 0);
-                  ret = fcntl(conn->sockfd, F_SETFL, flags | O_NONBLOCK);
-                  if (ret == -1)
-                    {
-                      ret = -errno;
-                      nerr("ERROR: F_SETFL failed: %d\n", ret);
-                      goto errout_with_errno;
-                    }
+                  goto errout_with_errno;
                 }
-              else
-                {
-                  /* Set send and receive timeout values */
-
-                  tv.tv_sec  = ctx->timeout_sec;
-                  tv.tv_usec = 0;
 
-                  /* Check return value one by one */
-
-                  ret = setsockopt(conn->sockfd, SOL_SOCKET, SO_RCVTIMEO,
-                                   &tv, sizeof(struct timeval));
-                  if (ret != 0)
-                    {
-                      ret = -errno;
-                      nerr("ERROR: setsockopt failed: %d\n", ret);
-                      goto errout_with_errno;
-                    }
+#if CONFIG_WEBCLIENT_RCVBUF_SIZE > 0
+              /* Set before connecting, the receive window is announced
+               * with the connection.
+               */
 
-                  ret = setsockopt(conn->sockfd, SOL_SOCKET, SO_SNDTIMEO,
-                                   &tv, sizeof(struct timeval));
-                  if (ret != 0)
-                    {
-                      ret = -errno;
-                      nerr("ERROR: setsockopt failed: %d\n", ret);
-                      goto errout_with_errno;
-                    }
+              if (setsockopt(conn->sockfd, SOL_SOCKET, SO_RCVBUF,
+                             &rcvbuf, sizeof(rcvbuf)) != 0)
+                {
+                  nwarn("WARNING: SO_RCVBUF failed: %d\n", errno);
                 }
+#endif
             }
 
           ws->state = WEBCLIENT_STATE_CONNECT;
@@ -1450,6 +2241,15 @@ int webclient_perform(FAR struct webclient_context *ctx)
 
       if (ws->state == WEBCLIENT_STATE_CONNECT)
         {
+#ifdef CONFIG_WEBCLIENT_KEEPALIVE
+          if (ws->reused)
+            {
+              /* Already connected */
+
+              ret = 0;
+            }
+          else
+#endif
           if (ws->tunnel != NULL)
             {
               ret = webclient_perform(ws->tunnel);
@@ -1638,6 +2438,15 @@ int webclient_perform(FAR struct webclient_context *ctx)
               goto errout_with_errno;
             }
 
+#ifdef WGET_USE_STATS
+#  ifdef CONFIG_WEBCLIENT_KEEPALIVE
+          if (!ws->reused)
+#  endif
+            {
+              wget_count(&g_webclient_stats.connects);
+            }
+#endif
+
           ws->state = WEBCLIENT_STATE_PREPARE_REQUEST;
         }
 
@@ -1774,9 +2583,10 @@ int webclient_perform(FAR struct webclient_context *ctx)
               dest = append(dest, ep, g_httpcrnl);
             }
 
-          if (ctx->protocol_version == WEBCLIENT_PROTOCOL_VERSION_HTTP_1_1)
+          if (ctx->protocol_version == WEBCLIENT_PROTOCOL_VERSION_HTTP_1_1 &&
+              !WGET_KEEPALIVE(ws))
             {
-              /* We don't implement persistect connections. */
+              /* HTTP/1.1 connections are persistent by default */
 
               dest = append(dest, ep, g_httpconn_close);
               dest = append(dest, ep, g_httpcrnl);
@@ -1792,6 +2602,10 @@ int webclient_perform(FAR struct webclient_context *ctx)
 
           len = dest - ws->buffer;
 
+#ifdef WGET_USE_STATS
+          wget_count_request(ws);
+#endif
+
           ws->state = WEBCLIENT_STATE_SEND_REQUEST;
           ws->state_offset = 0;
           ws->state_len = len;
@@ -1904,6 +2718,25 @@ int webclient_perform(FAR struct webclient_context *ctx)
             }
         }
 
+#ifdef CONFIG_WEBCLIENT_PIPELINE
+      if (ws->state == WEBCLIENT_STATE_STATUSLINE &&
+          ws->pipeline != NULL && ws->pipeline->sending)
+        {
+          /* The response is read after the following requests have been
+           * sent.  The pipeline owns the connection meanwhile.
+           */
+
+          ws->pipeline->conn = *conn;
+          ws->pipeline->connected = true;
+          ws->pipeline->pending++;
+          strlcpy(ws->pipeline->hostname, ws->target.hostname,
+                  sizeof(ws->pipeline->hostname));
+          ws->pipeline->port = ws->target.port;
+          ws->need_conn_close = false;
+          return OK;
+        }
+#endif
+
       /* Now loop to get the file sent in response to the GET.  This
        * loop continues until either we read the end of file (nbytes == 0)
        * or until we detect that we have been redirected.
@@ -1917,9 +2750,22 @@ int webclient_perform(FAR struct webclient_context *ctx)
         {
           for (; ; )
             {
+#ifdef CONFIG_WEBCLIENT_KEEPALIVE
+              if (ws->keepalive && wget_response_done(ws))
+                {
+                  ninfo("Response complete\n");
+                  ws->state = WEBCLIENT_STATE_CLOSE;
+                  ws->redirected = 0;
+                  ws->reusable =
+                    (ws->internal_flags & WGET_FLAG_CONN_CLOSE) == 0;
+                  break;
+                }
+#endif
+
               if (ws->datend - ws->offset == 0)
                 {
                   size_t want = ws->buflen;
+                  uintmax_t direct;
                   ssize_t ssz;
 
                   ninfo("Reading new data\n");
@@ -1934,7 +2780,16 @@ int webclient_perform(FAR struct webclient_context *ctx)
                       want = 1;
                     }
 
-                  ssz = webclient_conn_recv(conn, ws->buffer, want);
+                  direct = wget_direct_len(ctx, ws);
+                  if (direct > 0)
+                    {
+                      ssz = wget_recv_direct(ctx, ws, conn, direct);
+                    }
+                  else
+                    {
+                      ssz = webclient_conn_recv(conn, ws->buffer, want);
+                    }
+
                   if (ssz < 0)
                     {
                       ret = ssz;
@@ -1970,6 +2825,13 @@ int webclient_perform(FAR struct webclient_context *ctx)
                       break;
                     }
 
+                  if (direct > 0)
+                    {
+                      /* Already passed to the sink callback */
+
+                      continue;
+                    }
+
                   ninfo("Got %zd bytes data\n", ssz);
                   ws->offset = 0;
                   ws->datend = ssz;
@@ -2026,7 +2888,12 @@ int webclient_perform(FAR struct webclient_context *ctx)
                     }
                 }
 
-              if (ws->state == WEBCLIENT_STATE_WAIT_CLOSE)
+              /* On a kept-alive connection, the data after the response
+               * belongs to the next pipelined one.
+               */
+
+              if (ws->state == WEBCLIENT_STATE_WAIT_CLOSE &&
+                  !WGET_KEEPALIVE(ws))
                 {
                   uintmax_t received = ws->datend - ws->offset;
                   if (received != 0)
@@ -2065,6 +2932,15 @@ int webclient_perform(FAR struct webclient_context *ctx)
 
                           ws->chunk_received += received;
                         }
+                      else if (WGET_KEEPALIVE(ws) &&
+                               (ws->internal_flags &
+                                WGET_FLAG_GOT_CONTENT_LENGTH) != 0 &&
+                               received > ws->expected_resp_body_len -
+                                          ws->received_body_len)
+                        {
+                          received = ws->expected_resp_body_len -
+                                     ws->received_body_len;
+                        }
 
                       ninfo("Processing resp body %ju - %ju\n",
                             ws->received_body_len,
@@ -2157,7 +3033,7 @@ int webclient_perform(FAR struct webclient_context *ctx)
 
       if (ws->state == WEBCLIENT_STATE_CLOSE)
         {
-          webclient_conn_close(conn);
+          wget_conn_release(ws, conn);
           ws->need_conn_close = false;
           if (ws->redirected)
             {
@@ -2200,13 +3076,48 @@ errout_with_errno:
   if (ws->need_conn_close)
     {
       webclient_conn_close(conn);
+#ifdef CONFIG_WEBCLIENT_PIPELINE
+      if (ws->pipeline != NULL)
+        {
+          ws->pipeline->connected = false;
+        }
+#endif
+    }
+
+#ifdef CONFIG_WEBCLIENT_KEEPALIVE
+  if (wget_may_retry(ctx, ws, ret))
+    {
+      /* The server has closed the idle connection before it got the
+       * request.  Send the request again on a new connection.
+       */
+
+      nwarn("WARNING: reused connection failed: %d, retrying\n", ret);
+      ws->need_conn_close = false;
+      ws->retried = true;
+      ws->state = WEBCLIENT_STATE_SOCKET;
+      return wget_perform(ctx, NULL);
     }
+#endif
 
   free_ws(ws);
   _SET_STATE(ctx, WEBCLIENT_CONTEXT_STATE_DONE);
   return ret;
 }
 
+/****************************************************************************
+ * Name: webclient_perform
+ *
+ * Returned Value:
+ *               0: if the operation completed successfully;
+ *  Negative errno: On a failure
+ *
+ ****************************************************************************/
+
+int webclient_perform(FAR struct webclient_context *ctx)
+{
+  return wget_perform(ctx, NULL);
+}
+
 /****************************************************************************
  * Name: webclient_abort
  *
@@ -2555,3 +3466,172 @@ void webclient_get_tunnel(FAR struct webclient_context *ctx,
   free_ws(ws);
   _SET_STATE(ctx, WEBCLIENT_CONTEXT_STATE_DONE);
 }
+
+/****************************************************************************
+ * Name: webclient_perform_pipeline
+ *
+ * Description:
+ *   Perform the requests of several contexts on one connection, sending
+ *   all of them before reading the first response (HTTP/1.1 pipelining).
+ *   The contexts are set up as for webclient_perform() and must be
+ *   blocking HTTP/1.1 requests to the same server, without a proxy.
+ *   WEBCLIENT_FLAG_KEEP_ALIVE is implied.
+ *
+ *   Only idempotent requests should be pipelined: if the server closes
+ *   the connection early, the requests after the last response received
+ *   fail with -ECONNRESET, although the server may have processed them.
+ *
+ * Returned Value:
+ *   0 if all requests completed; otherwise the negated errno value of
+ *   the first failure.  All contexts are in the DONE state on return.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_WEBCLIENT_PIPELINE
+int webclient_perform_pipeline(FAR struct webclient_context * FAR *ctxs,
+                               unsigned int nctxs)
+{
+  struct wget_pipeline_s pipeline;
+  FAR struct webclient_context *ctx;
+  FAR struct wget_s *ws;
+  unsigned int nsent;
+  unsigned int i;
+  int ret = OK;
+
+  for (i = 0; i < nctxs; i++)
+    {
+      ctx = ctxs[i];
+      _CHECK_STATE(ctx, WEBCLIENT_CONTEXT_STATE_INITIALIZED);
+
+      if ((ctx->flags & (WEBCLIENT_FLAG_NON_BLOCKING |
+                         WEBCLIENT_FLAG_TUNNEL)) != 0 ||
+          ctx->protocol_version != WEBCLIENT_PROTOCOL_VERSION_HTTP_1_1 ||
+          ctx->proxy != NULL)
+        {
+          return -EINVAL;
+        }
+
+#if defined(CONFIG_WEBCLIENT_NET_LOCAL)
+      if (ctx->unix_socket_path != NULL)
+        {
+          return -EINVAL;
+        }
+#endif
+
+      ctx->flags |= WEBCLIENT_FLAG_KEEP_ALIVE;
+    }
+
+  memset(&pipeline, 0, sizeof(pipeline));
+
+  /* Send all requests.  Each of them stops before its response. */
+
+  pipeline.sending = true;
+  for (nsent = 0; nsent < nctxs; nsent++)
+    {
+      ret = wget_perform(ctxs[nsent], &pipeline);
+      if (ret < 0)
+        {
+          break;
+        }
+    }
+
+  pipeline.sending = false;
+
+  /* Read the responses in order.  The part of the next response which
+   * has been received with a response is handed over to the next context.
+   */
+
+  for (i = 0; i < nsent; i++)
+    {
+      ctx = ctxs[i];
+      ws  = ctx->ws;
+
+      if (ret == OK && !pipeline.connected)
+        {
+          ret = -ECONNRESET;
+        }
+
+      if (ret == OK && pipeline.nleftover > ws->buflen)
+        {
+          ret = -E2BIG;
+        }
+
+      if (ret == OK)
+        {
+          memmove(ws->buffer, pipeline.leftover, pipeline.nleftover);
+          ws->offset = 0;
+          ws->datend = pipeline.nleftover;
+          pipeline.nleftover = 0;
+          ws->need_conn_close = true;
+
+          ret = wget_perform(ctx, &pipeline);
+          continue;
+        }
+
+      /* Drop the requests whose responses won't be read */
+
+      free_ws(ws);
+      ctx->ws = NULL;
+      _SET_STATE(ctx, WEBCLIENT_CONTEXT_STATE_DONE);
+    }
+
+  if (pipeline.connected)
+    {
+      webclient_conn_close(&pipeline.conn);
+    }
+
+  return ret;
+}
+#endif
+
+/****************************************************************************
+ * Name: webclient_pool_flush
+ *
+ * Description:
+ *   Close all idle connections of the pool.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_WEBCLIENT_KEEPALIVE
+void webclient_pool_flush(void)
+{
+  struct webclient_conn_s conns[CONFIG_WEBCLIENT_POOL_SIZE];
+  int nconns = 0;
+  int i;
+
+  pthread_mutex_lock(&g_webclient_lock);
+  for (i = 0; i < CONFIG_WEBCLIENT_POOL_SIZE; i++)
+    {
+      if (g_webclient_pool[i].hostname[0] != '\0')
+        {
+          conns[nconns++] = g_webclient_pool[i].conn;
+          g_webclient_pool[i].hostname[0] = '\0';
+        }
+    }
+
+  pthread_mutex_unlock(&g_webclient_lock);
+
+  for (i = 0; i < nconns; i++)
+    {
+      webclient_conn_close(&conns[i]);
+    }
+}
+#endif
+
+/****************************************************************************
+ * Name: webclient_get_stats
+ *
+ * Description:
+ *   Return the counters of the requests, connections and name lookups
+ *   made by all contexts.
+ *
+ ****************************************************************************/
+
+#ifdef WGET_USE_STATS
+void webclient_get_stats(FAR struct webclient_stats_s *stats)
+{
+  pthread_mutex_lock(&g_webclient_lock);
+  *stats = g_webclient_stats;
+  pthread_mutex_unlock(&g_webclient_lock);
+}
+#endif
@@ -65,6 +65,12 @@
 #  include <pthread.h>
 #endif
 
+#ifdef CONFIG_NETUTILS_HTTPD_THREADPOOL
+#  include <fcntl.h>
+#  include <poll.h>
+#  include <time.h>
+#endif
+
 #include <arpa/inet.h>
 
 #include "netutils/netlib.h"
@@ -131,10 +137,60 @@
 #  endif
 #endif
 
+#ifdef CONFIG_NETUTILS_HTTPD_THREADPOOL
+#  ifndef CONFIG_NETUTILS_HTTPD_NWORKERS
+#    define CONFIG_NETUTILS_HTTPD_NWORKERS 4
+#  endif
+
+#  ifndef CONFIG_NETUTILS_HTTPD_QUEUESIZE
+#    define CONFIG_NETUTILS_HTTPD_QUEUESIZE 8
+#  endif
+
+#  ifndef CONFIG_NETUTILS_HTTPD_IDLECONNS
+#    define CONFIG_NETUTILS_HTTPD_IDLECONNS 8
+#  endif
+#endif
+
+/****************************************************************************
+ * Private Types
+ ****************************************************************************/
+
+#ifdef CONFIG_NETUTILS_HTTPD_THREADPOOL
+#ifndef CONFIG_NETUTILS_HTTPD_KEEPALIVE_DISABLE
+/* A new or kept alive connection waiting for its next request */
+
+struct httpd_parked_s
+{
+  int sockfd;                           /* The socket descriptor */
+  time_t since;                         /* When the connection became idle */
+};
+#endif
+
+/* The worker thread pool */
+
+struct httpd_pool_s
+{
+  pthread_mutex_t lock;                 /* Protects the fields below */
+  pthread_cond_t ready;                 /* Signaled when work is queued */
+  int queue[CONFIG_NETUTILS_HTTPD_QUEUESIZE]; /* Connections to serve */
+  int head;                             /* Oldest queued connection */
+  int count;                            /* Number of queued connections */
+#ifndef CONFIG_NETUTILS_HTTPD_KEEPALIVE_DISABLE
+  struct httpd_parked_s parked[CONFIG_NETUTILS_HTTPD_IDLECONNS];
+  int nparked;                          /* Number of idle connections */
+#endif
+  int wakeup[2];                        /* Wakes up the server thread */
+};
+#endif
+
 /****************************************************************************
  * Private Data
  ****************************************************************************/
 
+#ifdef CONFIG_NETUTILS_HTTPD_THREADPOOL
+static struct httpd_pool_s g_pool;
+#endif
+
 /****************************************************************************
  * Private Functions
  ****************************************************************************/
@@ -679,6 +735,47 @@ static inline int httpd_parse(struct httpd_state *pstate)
   return 200;
 }
 
+/****************************************************************************
+ * Name: httpd_request
+ *
+ * Description:
+ *   Read one request from the connection and send the response.  Returns
+ *   true if the connection is kept alive for another request.
+ *
+ ****************************************************************************/
+
+static bool httpd_request(FAR struct httpd_state *pstate)
+{
+  int status;
+
+#ifndef CONFIG_NETUTILS_HTTPD_KEEPALIVE_DISABLE
+  pstate->ht_keepalive = false;
+#endif
+
+  status = httpd_parse(pstate);
+  if (status < 0)
+    {
+      /* The connection was lost, there is no one to respond to */
+
+      return false;
+    }
+  else if (status >= 400)
+    {
+      httpd_senderror(pstate, status);
+    }
+  else
+    {
+      httpd_sendfile(pstate);
+    }
+
+#ifndef CONFIG_NETUTILS_HTTPD_KEEPALIVE_DISABLE
+  return pstate->ht_keepalive;
+#else
+  return false;
+#endif
+}
+
+#ifndef CONFIG_NETUTILS_HTTPD_THREADPOOL
 /****************************************************************************
  * Name: httpd_handler
  *
@@ -701,34 +798,14 @@ static void *httpd_handler(void *arg)
 
   if (pstate)
     {
-      int status;
-
       /* Re-initialize the thread state structure */
 
       memset(pstate, 0, sizeof(struct httpd_state));
       pstate->ht_sockfd = sockfd;
 
-#ifndef CONFIG_NETUTILS_HTTPD_KEEPALIVE_DISABLE
-      do
-        {
-          pstate->ht_keepalive = false;
-#endif
-          /* Then handle the next httpd command */
-
-          status = httpd_parse(pstate);
-          if (status >= 400)
-            {
-              httpd_senderror(pstate, status);
-            }
-          else
-            {
-              httpd_sendfile(pstate);
-            }
+      /* Then handle the httpd commands until the connection is closed */
 
-#ifndef CONFIG_NETUTILS_HTTPD_KEEPALIVE_DISABLE
-        }
-      while (pstate->ht_keepalive);
-#endif
+      while (httpd_request(pstate));
 
       /* End of command processing -- Clean up and exit */
 
@@ -741,6 +818,59 @@ static void *httpd_handler(void *arg)
   close(sockfd);
   return NULL;
 }
+#endif
+
+#if defined(CONFIG_NETUTILS_HTTPD_SINGLECONNECT) || \
+    defined(CONFIG_NETUTILS_HTTPD_THREADPOOL)
+/****************************************************************************
+ * Name: httpd_sockopts
+ *
+ * Description:
+ *   Configure an accepted connection of a server that does not create a
+ *   thread per connection.
+ *
+ ****************************************************************************/
+
+static int httpd_sockopts(int sockfd)
+{
+#ifdef CONFIG_NET_SOLINGER
+  struct linger ling;
+#endif
+#if CONFIG_NETUTILS_HTTPD_TIMEOUT > 0
+  struct timeval tv;
+#endif
+
+  /* Configure to "linger" until all data is sent
+   * when the socket is closed
+   */
+
+#ifdef CONFIG_NET_SOLINGER
+  ling.l_onoff  = 1;
+  ling.l_linger = 30;     /* timeout is seconds */
+  if (setsockopt(sockfd, SOL_SOCKET, SO_LINGER, &ling,
+                 sizeof(struct linger)) < 0)
+    {
+      nerr("ERROR: setsockopt SO_LINGER failure: %d\n", errno);
+      return ERROR;
+    }
+#endif
+
+#if CONFIG_NETUTILS_HTTPD_TIMEOUT > 0
+  /* Set up a receive timeout */
+
+  tv.tv_sec  = CONFIG_NETUTILS_HTTPD_TIMEOUT;
+  tv.tv_usec = 0;
+  if (setsockopt(sockfd, SOL_SOCKET, SO_RCVTIMEO, &tv,
+                 sizeof(struct timeval)) < 0)
+    {
+      nerr("ERROR: setsockopt SO_RCVTIMEO failure: %d\n", errno);
+      return ERROR;
+    }
+#endif
+
+  return OK;
+}
+#endif
 
 #ifdef CONFIG_NETUTILS_HTTPD_SINGLECONNECT
 static void single_server(uint16_t portno, pthread_startroutine_t handler,
@@ -750,12 +880,6 @@ static void single_server(uint16_t portno, pthread_startroutine_t handler,
   socklen_t addrlen;
   int listensd;
   int acceptsd;
-#ifdef CONFIG_NET_SOLINGER
-  struct linger ling;
-#endif
-#if CONFIG_NETUTILS_HTTPD_TIMEOUT > 0
-  struct timeval tv;
-#endif
 
   listensd = netlib_listenon(portno);
   if (listensd < 0)
@@ -778,47 +902,408 @@ static void single_server(uint16_t portno, pthread_startroutine_t handler,
 
       ninfo("Connection accepted -- serving sd=%d\n", acceptsd);
 
-      /* Configure to "linger" until all data is sent
-       * when the socket is closed
-       */
-
-#ifdef CONFIG_NET_SOLINGER
-      ling.l_onoff  = 1;
-      ling.l_linger = 30;     /* timeout is seconds */
-      if (setsockopt(acceptsd, SOL_SOCKET, SO_LINGER, &ling,
-                     sizeof(struct linger)) < 0)
+      if (httpd_sockopts(acceptsd) < 0)
         {
           close(acceptsd);
-          nerr("ERROR: setsockopt SO_LINGER failure: %d\n", errno);
           break;
         }
+
+      /* Handle the request. This blocks until complete. */
+
+      handler((FAR void *)acceptsd);
+    }
+
+  /* Close the sockets */
+
+  close(acceptsd);
+  close(listensd);
+}
 #endif
 
-#if CONFIG_NETUTILS_HTTPD_TIMEOUT > 0
-      /* Set up a receive timeout */
+#ifdef CONFIG_NETUTILS_HTTPD_THREADPOOL
+/****************************************************************************
+ * Name: httpd_pool_wakeup
+ *
+ * Description:
+ *   Make the server thread poll() again with the current pool state.
+ *
+ ****************************************************************************/
+
+static void httpd_pool_wakeup(void)
+{
+  char ch = 0;
+
+  /* The pipe is non-blocking, if it is full a wakeup is pending anyway */
+
+  write(g_pool.wakeup[1], &ch, 1);
+}
+
+/****************************************************************************
+ * Name: httpd_pool_enqueue
+ *
+ * Description:
+ *   Hand a connection with a pending request to the workers.  Called by
+ *   the server thread with the pool locked and room in the queue.
+ *
+ ****************************************************************************/
+
+static void httpd_pool_enqueue(int sockfd)
+{
+  DEBUGASSERT(g_pool.count < CONFIG_NETUTILS_HTTPD_QUEUESIZE);
+
+  g_pool.queue[(g_pool.head + g_pool.count) %
+               CONFIG_NETUTILS_HTTPD_QUEUESIZE] = sockfd;
+  g_pool.count++;
+  pthread_cond_signal(&g_pool.ready);
+}
+
+/****************************************************************************
+ * Name: httpd_pool_dequeue
+ ****************************************************************************/
+
+static int httpd_pool_dequeue(void)
+{
+  int sockfd;
+
+  pthread_mutex_lock(&g_pool.lock);
+  while (g_pool.count == 0)
+    {
+      pthread_cond_wait(&g_pool.ready, &g_pool.lock);
+    }
+
+  sockfd = g_pool.queue[g_pool.head];
+  g_pool.head = (g_pool.head + 1) % CONFIG_NETUTILS_HTTPD_QUEUESIZE;
+
+  /* The server thread stops accepting while the queue is full */
+
+  if (g_pool.count-- == CONFIG_NETUTILS_HTTPD_QUEUESIZE)
+    {
+      httpd_pool_wakeup();
+    }
+
+  pthread_mutex_unlock(&g_pool.lock);
+  return sockfd;
+}
+
+#ifndef CONFIG_NETUTILS_HTTPD_KEEPALIVE_DISABLE
+/****************************************************************************
+ * Name: httpd_pool_now
+ ****************************************************************************/
+
+static time_t httpd_pool_now(void)
+{
+  struct timespec ts;
 
-      tv.tv_sec  = CONFIG_NETUTILS_HTTPD_TIMEOUT;
-      tv.tv_usec = 0;
-      if (setsockopt(acceptsd, SOL_SOCKET, SO_RCVTIMEO, &tv,
-                     sizeof(struct timeval)) < 0)
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec;
+}
+
+/****************************************************************************
+ * Name: httpd_pool_park
+ *
+ * Description:
+ *   Return a kept alive connection to the server thread, which waits for
+ *   its next request.  The connection is closed if too many are idle.
+ *
+ ****************************************************************************/
+
+static void httpd_pool_park(int sockfd)
+{
+  pthread_mutex_lock(&g_pool.lock);
+  if (g_pool.nparked < CONFIG_NETUTILS_HTTPD_IDLECONNS)
+    {
+      g_pool.parked[g_pool.nparked].sockfd = sockfd;
+      g_pool.parked[g_pool.nparked].since  = httpd_pool_now();
+      g_pool.nparked++;
+      pthread_mutex_unlock(&g_pool.lock);
+
+      httpd_pool_wakeup();
+      return;
+    }
+
+  pthread_mutex_unlock(&g_pool.lock);
+
+  ninfo("[%d] Too many idle connections\n", sockfd);
+  close(sockfd);
+}
+#endif
+
+/****************************************************************************
+ * Name: httpd_pool_worker
+ *
+ * Description:
+ *   Worker thread entry point.  Each worker serves one request at a time
+ *   with its own, preallocated state structure.
+ *
+ ****************************************************************************/
+
+static FAR void *httpd_pool_worker(FAR void *arg)
+{
+  FAR struct httpd_state *pstate = (FAR struct httpd_state *)arg;
+  int sockfd;
+
+  for (; ; )
+    {
+      sockfd = httpd_pool_dequeue();
+      ninfo("[%d] Serving\n", sockfd);
+
+      memset(pstate, 0, sizeof(struct httpd_state));
+      pstate->ht_sockfd = sockfd;
+
+#ifndef CONFIG_NETUTILS_HTTPD_KEEPALIVE_DISABLE
+      if (httpd_request(pstate))
         {
-          close(acceptsd);
-          nerr("ERROR: setsockopt SO_RCVTIMEO failure: %d\n", errno);
+          httpd_pool_park(sockfd);
+          continue;
+        }
+#else
+      httpd_request(pstate);
+#endif
+
+      close(sockfd);
+    }
+
+  return NULL;
+}
+
+/****************************************************************************
+ * Name: httpd_pool_server
+ *
+ * Description:
+ *   Start the worker threads, then accept the connections and wait for the
+ *   requests of the new and the kept alive connections.  Connections with
+ *   a pending request are queued to the workers.  While the queue is full,
+ *   nothing is accepted and the connections wait in the listen backlog.
+ *
+ ****************************************************************************/
+
+static void httpd_pool_server(uint16_t portno)
+{
+#ifndef CONFIG_NETUTILS_HTTPD_KEEPALIVE_DISABLE
+  struct pollfd fds[2 + CONFIG_NETUTILS_HTTPD_IDLECONNS];
+  time_t now;
+  int npolled;
+  int j;
+#else
+  struct pollfd fds[2];
+#endif
+  FAR struct httpd_state *states;
+  struct sockaddr_in myaddr;
+  pthread_attr_t attr;
+  pthread_t worker;
+  socklen_t addrlen;
+  char drain[8];
+  int listensd;
+  int acceptsd;
+  int timeout;
+  int nfds;
+  int i;
+
+  listensd = netlib_listenon(portno);
+  if (listensd < 0)
+    {
+      return;
+    }
+
+  if (pipe(g_pool.wakeup) < 0)
+    {
+      nerr("ERROR: pipe failure: %d\n", errno);
+      goto errout_with_listensd;
+    }
+
+  fcntl(g_pool.wakeup[0], F_SETFL, O_NONBLOCK);
+  fcntl(g_pool.wakeup[1], F_SETFL, O_NONBLOCK);
+
+  /* All memory for the requests is allocated up front */
+
+  states = calloc(CONFIG_NETUTILS_HTTPD_NWORKERS,
+                  sizeof(struct httpd_state));
+  if (states == NULL)
+    {
+      nerr("ERROR: Failed to allocate the worker states\n");
+      goto errout_with_pipe;
+    }
+
+  pthread_mutex_init(&g_pool.lock, NULL);
+  pthread_cond_init(&g_pool.ready, NULL);
+
+  pthread_attr_init(&attr);
+  pthread_attr_setstacksize(&attr, CONFIG_NETUTILS_HTTPDSTACKSIZE);
+
+  for (i = 0; i < CONFIG_NETUTILS_HTTPD_NWORKERS; i++)
+    {
+      if (pthread_create(&worker, &attr, httpd_pool_worker,
+                         &states[i]) != 0)
+        {
+          nerr("ERROR: pthread_create failed\n");
           break;
         }
+
+      pthread_detach(worker);
+    }
+
+  pthread_attr_destroy(&attr);
+
+  if (i == 0)
+    {
+      /* Without any worker no request can be served */
+
+      goto errout_with_states;
+    }
+
+  /* Begin serving connections */
+
+  for (; ; )
+    {
+      fds[0].fd      = g_pool.wakeup[0];
+      fds[0].events  = POLLIN;
+      fds[0].revents = 0;
+      nfds           = 1;
+
+      /* Look for new work only if there is room to queue it */
+
+      pthread_mutex_lock(&g_pool.lock);
+      if (g_pool.count < CONFIG_NETUTILS_HTTPD_QUEUESIZE)
+        {
+          fds[1].fd      = listensd;
+          fds[1].events  = POLLIN;
+          fds[1].revents = 0;
+          nfds++;
+
+#ifndef CONFIG_NETUTILS_HTTPD_KEEPALIVE_DISABLE
+          for (i = 0; i < g_pool.nparked; i++)
+            {
+              fds[nfds].fd      = g_pool.parked[i].sockfd;
+              fds[nfds].events  = POLLIN;
+              fds[nfds].revents = 0;
+              nfds++;
+            }
 #endif
+        }
 
-      /* Handle the request. This blocks until complete. */
+#ifndef CONFIG_NETUTILS_HTTPD_KEEPALIVE_DISABLE
+      npolled = nfds > 2 ? nfds - 2 : 0;
+      timeout = g_pool.nparked > 0 ? 1000 : -1;
+#else
+      timeout = -1;
+#endif
+      pthread_mutex_unlock(&g_pool.lock);
 
-      handler((FAR void *)acceptsd);
+      /* Wake up once per second while idle connections may time out */
+
+      if (poll(fds, nfds, timeout) < 0)
+        {
+          if (errno == EINTR)
+            {
+              continue;
+            }
+
+          nerr("ERROR: poll failure: %d\n", errno);
+          break;
+        }
+
+      if (fds[0].revents != 0)
+        {
+          while (read(g_pool.wakeup[0], drain, sizeof(drain)) > 0);
+        }
+
+      /* Workers only remove from the queue, so there is still room for the
+       * new connection.
+       */
+
+      if (nfds > 1 && fds[1].revents != 0)
+        {
+          addrlen  = sizeof(struct sockaddr_in);
+          acceptsd = accept(listensd, (FAR struct sockaddr *)&myaddr,
+                            &addrlen);
+          if (acceptsd < 0)
+            {
+              nerr("ERROR: accept failure: %d\n", errno);
+              break;
+            }
+
+          ninfo("Connection accepted -- queueing sd=%d\n", acceptsd);
+
+          if (httpd_sockopts(acceptsd) < 0)
+            {
+              close(acceptsd);
+              break;
+            }
+
+          /* Wait for the request here, so that a client that connects
+           * but does not send anything does not hold a worker.
+           */
+
+          pthread_mutex_lock(&g_pool.lock);
+#ifndef CONFIG_NETUTILS_HTTPD_KEEPALIVE_DISABLE
+          if (g_pool.nparked < CONFIG_NETUTILS_HTTPD_IDLECONNS)
+            {
+              g_pool.parked[g_pool.nparked].sockfd = acceptsd;
+              g_pool.parked[g_pool.nparked].since  = httpd_pool_now();
+              g_pool.nparked++;
+            }
+          else
+#endif
+            {
+              httpd_pool_enqueue(acceptsd);
+            }
+
+          pthread_mutex_unlock(&g_pool.lock);
+        }
+
+#ifndef CONFIG_NETUTILS_HTTPD_KEEPALIVE_DISABLE
+      /* Queue the idle connections with a new request and close the ones
+       * that were idle too long.  More connections may have been added
+       * behind the polled ones meanwhile.
+       */
+
+      now = httpd_pool_now();
+
+      pthread_mutex_lock(&g_pool.lock);
+      for (i = 0, j = 0; i < g_pool.nparked; i++)
+        {
+          int sockfd = g_pool.parked[i].sockfd;
+
+          if (i < npolled && fds[2 + i].revents != 0 &&
+              g_pool.count < CONFIG_NETUTILS_HTTPD_QUEUESIZE)
+            {
+              httpd_pool_enqueue(sockfd);
+            }
+          else if (now - g_pool.parked[i].since >
+                   CONFIG_NETUTILS_HTTPD_TIMEOUT)
+            {
+              ninfo("[%d] Idle timeout\n", sockfd);
+              close(sockfd);
+            }
+          else
+            {
+              g_pool.parked[j++] = g_pool.parked[i];
+            }
+        }
+
+      g_pool.nparked = j;
+      pthread_mutex_unlock(&g_pool.lock);
+#endif
     }
 
-  /* Close the sockets */
+  /* The workers stay blocked on the empty queue */
 
-  close(acceptsd);
+  close(listensd);
+  return;
+
+errout_with_states:
+  pthread_cond_destroy(&g_pool.ready);
+  pthread_mutex_destroy(&g_pool.lock);
+  free(states);
+
+errout_with_pipe:
+  close(g_pool.wakeup[0]);
+  close(g_pool.wakeup[1]);
+
+errout_with_listensd:
   close(listensd);
 }
-#endif
+#endif /* CONFIG_NETUTILS_HTTPD_THREADPOOL */
 
 /****************************************************************************
  * Public Functions
@@ -845,6 +1330,8 @@ int httpd_listen(void)
 
 #ifdef CONFIG_NETUTILS_HTTPD_SINGLECONNECT
   single_server(HTONS(80), httpd_handler, CONFIG_NETUTILS_HTTPDSTACKSIZE);
+#elif defined(CONFIG_NETUTILS_HTTPD_THREADPOOL)
+  httpd_pool_server(HTONS(80));
 #else
   netlib_server(HTONS(80), httpd_handler, CONFIG_NETUTILS_HTTPDSTACKSIZE);
 #endif
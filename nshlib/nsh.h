@@ -33,6 +33,7 @@
 #include <stdbool.h>
 #include <unistd.h>
 #include <errno.h>
+#include <time.h>
 
 #ifdef CONFIG_NSH_STRERROR
 #  include <string.h>
@@ -390,6 +391,31 @@
 #  define CONFIG_NSH_NESTDEPTH 3
 #endif
 
+/* Pipelines need background commands, waitpid() and pipes */
+
+#if defined(CONFIG_NSH_DISABLEBG) || !defined(CONFIG_SCHED_WAITPID) || \
+    !defined(CONFIG_PIPES)
+#  undef CONFIG_NSH_PIPELINE
+#endif
+
+#ifndef CONFIG_NSH_PIPELINE_MAXCMDS
+#  define CONFIG_NSH_PIPELINE_MAXCMDS 4
+#endif
+
+/* True if the output of the command being executed goes to the next
+ * command of a pipeline.  Output re-direction with '>' takes precedence.
+ */
+
+#ifdef CONFIG_NSH_PIPELINE
+#  define NSH_PIPE_OUT(v) ((v)->np.np_pipeout >= 0 && !(v)->np.np_redirect)
+#else
+#  define NSH_PIPE_OUT(v) false
+#endif
+
+/* The number of background commands remembered for the wait command */
+
+#define NSH_MAX_JOBS 8
+
 /* Define to enable dumping of all input/output buffers */
 
 #undef CONFIG_NSH_TELNETD_DUMPBUFFER
@@ -508,6 +534,7 @@
 /* Suppress unused file utilities */
 
 #define NSH_HAVE_CATFILE          1
+#define NSH_HAVE_COPYFD           1
 #define NSH_HAVE_WRITEFILE        1
 #define NSH_HAVE_READFILE         1
 #define NSH_HAVE_FOREACH_DIRENTRY 1
@@ -536,6 +563,12 @@
 #  undef NSH_HAVE_CATFILE
 #endif
 
+/* nsh_copyfd used by nsh_catfile and cp */
+
+#if !defined(NSH_HAVE_CATFILE) && defined(CONFIG_NSH_DISABLE_CP)
+#  undef NSH_HAVE_COPYFD
+#endif
+
 /* nsh_readfile used by ps command */
 
 #if defined(CONFIG_NSH_DISABLE_PS)
@@ -664,6 +697,18 @@ struct nsh_parser_s
 #ifndef CONFIG_NSH_DISABLEBG
   int      np_nice;     /* "nice" value applied to last background cmd */
 #endif
+#ifdef CONFIG_NSH_PIPELINE
+  int      np_pipein;   /* Read end of the pipe from the previous command */
+  int      np_pipeout;  /* Write end of the pipe to the next command */
+  uint8_t  np_npipe;    /* Number of commands in np_pipepid[] */
+
+  /* Commands before the last one of the current pipeline */
+
+  pid_t    np_pipepid[CONFIG_NSH_PIPELINE_MAXCMDS - 1];
+#endif
+#ifndef CONFIG_NSH_DISABLE_WAIT
+  pid_t    np_jobs[NSH_MAX_JOBS]; /* Background commands for wait */
+#endif
 
 #ifndef CONFIG_NSH_DISABLESCRIPT
   int      np_fd;       /* Stream of current script */
@@ -818,6 +863,13 @@ int nsh_loginscript(FAR struct nsh_vtbl_s *vtbl);
 #  define CONFIG_NSH_DISABLE_MKRD 1
 #endif
 
+/* The wait command waits for background commands */
+
+#ifdef CONFIG_NSH_DISABLEBG
+#  undef CONFIG_NSH_DISABLE_WAIT
+#  define CONFIG_NSH_DISABLE_WAIT 1
+#endif
+
 /* Basic session and message handling */
 
 struct console_stdio_s;
@@ -856,6 +908,18 @@ int nsh_fileapp(FAR struct nsh_vtbl_s *vtbl, FAR const char *cmd,
                 FAR char **argv, FAR const char *redirfile, int oflags);
 #endif
 
+/* Background command and pipeline support */
+
+#if defined(CONFIG_NSH_PIPELINE) || !defined(CONFIG_NSH_DISABLE_WAIT)
+int nsh_waitpid(pid_t pid);
+#endif
+
+#ifndef CONFIG_NSH_DISABLE_WAIT
+void nsh_addjob(FAR struct nsh_vtbl_s *vtbl, pid_t pid);
+#else
+#  define nsh_addjob(v,p)
+#endif
+
 #ifndef CONFIG_DISABLE_ENVIRON
 /* Working directory support */
 
@@ -1171,6 +1235,9 @@ int cmd_switchboot(FAR struct nsh_vtbl_s *vtbl, int argc, FAR char **argv);
 #ifndef CONFIG_NSH_DISABLE_USLEEP
   int cmd_usleep(FAR struct nsh_vtbl_s *vtbl, int argc, FAR char **argv);
 #endif
+#ifndef CONFIG_NSH_DISABLE_WAIT
+  int cmd_wait(FAR struct nsh_vtbl_s *vtbl, int argc, FAR char **argv);
+#endif
 
 #ifndef CONFIG_NSH_DISABLE_UPTIME
   int cmd_uptime(FAR struct nsh_vtbl_s *vtbl, int argc, FAR char **argv);
@@ -1273,6 +1340,42 @@ int nsh_catfile(FAR struct nsh_vtbl_s *vtbl, FAR const char *cmd,
                 FAR const char *filepath);
 #endif
 
+/****************************************************************************
+ * Name: nsh_copyfd
+ *
+ * Description:
+ *   Copy everything from one open file to another, with sendfile() if
+ *   enabled and supported, else through the copy buffer.
+ *
+ * Input Paratemets:
+ *   vtbl    - The console vtable
+ *   cmd     - NSH command name to use in error reporting
+ *   infd    - The file descriptor to copy from
+ *   outfd   - The file descriptor to copy to
+ *   ncopied - If not NULL, the number of bytes copied is added here
+ *
+ * Returned Value:
+ *   Zero (OK) on success; -1 (ERROR) on failure.
+ *
+ ****************************************************************************/
+
+#ifdef NSH_HAVE_COPYFD
+int nsh_copyfd(FAR struct nsh_vtbl_s *vtbl, FAR const char *cmd,
+               int infd, int outfd, FAR off_t *ncopied);
+
+/****************************************************************************
+ * Name: nsh_copystats
+ *
+ * Description:
+ *   Print the size and throughput of a copy that started at 'start' on
+ *   stderr, so that it does not mix with the output of cat.
+ *
+ ****************************************************************************/
+
+void nsh_copystats(FAR struct nsh_vtbl_s *vtbl, FAR const char *cmd,
+                   off_t nbytes, FAR const struct timespec *start);
+#endif
+
 /****************************************************************************
  * Name: nsh_readfile
  *
@@ -31,6 +31,7 @@
 
 #include <stdbool.h>
 #include <errno.h>
+#include <fcntl.h>
 #include <sched.h>
 #include <signal.h>
 #include <string.h>
@@ -43,6 +44,67 @@
 
 #ifdef CONFIG_NSH_BUILTIN_APPS
 
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: nsh_pipeswap
+ *
+ * Description:
+ *   Connect stdfd of NSH to a pipe of a pipeline so that the application
+ *   inherits it.  A copy of the original stdfd is returned in save for
+ *   nsh_piperestore(), or -1 if NSH had no descriptor there.
+ *
+ * Returned Value:
+ *   OK on success, a negated errno value on failure.  stdfd is left
+ *   untouched on failure.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_NSH_PIPELINE
+static int nsh_pipeswap(int pipefd, int stdfd, FAR int *save)
+{
+  int errcode;
+
+  *save = fcntl(stdfd, F_DUPFD_CLOEXEC, 0);
+  if (*save < 0 && errno != EBADF)
+    {
+      return -errno;
+    }
+
+  if (dup2(pipefd, stdfd) < 0)
+    {
+      errcode = errno;
+      if (*save >= 0)
+        {
+          close(*save);
+        }
+
+      return -errcode;
+    }
+
+  return OK;
+}
+
+/****************************************************************************
+ * Name: nsh_piperestore
+ ****************************************************************************/
+
+static void nsh_piperestore(int stdfd, int save)
+{
+  if (save >= 0)
+    {
+      dup2(save, stdfd);
+      close(save);
+    }
+  else
+    {
+      close(stdfd);
+    }
+}
+#endif
+
 /****************************************************************************
  * Public Functions
  ****************************************************************************/
@@ -74,9 +136,22 @@ int nsh_builtin(FAR struct nsh_vtbl_s *vtbl, FAR const char *cmd,
 #if !defined(CONFIG_NSH_DISABLEBG) && defined(CONFIG_SCHED_CHILD_STATUS)
   struct sigaction act;
   struct sigaction old;
+#endif
+#ifdef CONFIG_NSH_PIPELINE
+  int savein = -1;
+  int saveout = -1;
 #endif
   int ret = OK;
 
+  /* Most commands are not builtin applications, check that before paying
+   * for the scheduler lock and the signal setup below.
+   */
+
+  if (builtin_find(cmd) < 0)
+    {
+      return ERROR;
+    }
+
   /* Lock the scheduler in an attempt to prevent the application from
    * running until waitpid() has been called.
    */
@@ -101,7 +176,46 @@ int nsh_builtin(FAR struct nsh_vtbl_s *vtbl, FAR const char *cmd,
    * applications.
    */
 
+#ifdef CONFIG_NSH_PIPELINE
+  /* The application inherits stdin and stdout of NSH, connect these to the
+   * pipes of the pipeline while it is started.
+   */
+
+  if (vtbl->np.np_pipein >= 0)
+    {
+      ret = nsh_pipeswap(vtbl->np.np_pipein, STDIN_FILENO, &savein);
+    }
+
+  if (ret >= 0 && NSH_PIPE_OUT(vtbl))
+    {
+      ret = nsh_pipeswap(vtbl->np.np_pipeout, STDOUT_FILENO, &saveout);
+      if (ret < 0 && vtbl->np.np_pipein >= 0)
+        {
+          nsh_piperestore(STDIN_FILENO, savein);
+        }
+    }
+
+  if (ret < 0)
+    {
+      nsh_error(vtbl, g_fmtcmdfailed, cmd, "dup2", NSH_ERRNO_OF(-ret));
+      goto errout_with_lock;
+    }
+#endif
+
   ret = exec_builtin(cmd, argv, redirfile, oflags);
+
+#ifdef CONFIG_NSH_PIPELINE
+  if (vtbl->np.np_pipein >= 0)
+    {
+      nsh_piperestore(STDIN_FILENO, savein);
+    }
+
+  if (NSH_PIPE_OUT(vtbl))
+    {
+      nsh_piperestore(STDOUT_FILENO, saveout);
+    }
+#endif
+
   if (ret >= 0)
     {
       /* The application was successfully started with pre-emption disabled.
@@ -127,6 +241,19 @@ int nsh_builtin(FAR struct nsh_vtbl_s *vtbl, FAR const char *cmd,
        * in background (and running commands in background is enabled).
        */
 
+#  ifdef CONFIG_NSH_PIPELINE
+      if (NSH_PIPE_OUT(vtbl))
+        {
+          /* Not the last command of a pipeline.  It keeps running while
+           * the next commands are started and is waited for at the end of
+           * the pipeline.
+           */
+
+          vtbl->np.np_pipepid[vtbl->np.np_npipe++] = ret;
+          ret = OK;
+        }
+      else
+#  endif /* CONFIG_NSH_PIPELINE */
 #  ifndef CONFIG_NSH_DISABLEBG
       if (vtbl->np.np_bg == false)
 #  endif /* CONFIG_NSH_DISABLEBG */
@@ -235,6 +362,7 @@ int nsh_builtin(FAR struct nsh_vtbl_s *vtbl, FAR const char *cmd,
           struct sched_param param;
           sched_getparam(ret, &param);
           nsh_output(vtbl, "%s [%d:%d]\n", cmd, ret, param.sched_priority);
+          nsh_addjob(vtbl, ret);
 
           /* Backgrounded commands always 'succeed' as long as we can start
            * them.
@@ -245,6 +373,9 @@ int nsh_builtin(FAR struct nsh_vtbl_s *vtbl, FAR const char *cmd,
 #endif /* !CONFIG_SCHED_WAITPID || !CONFIG_NSH_DISABLEBG */
     }
 
+#ifdef CONFIG_NSH_PIPELINE
+errout_with_lock:
+#endif
   sched_unlock();
 
   /* If exec_builtin() or waitpid() failed, then return -1 (ERROR) with the
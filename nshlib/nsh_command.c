@@ -103,21 +103,26 @@ static int  cmd_unrecognized(FAR struct nsh_vtbl_s *vtbl, int argc,
  * Private Data
  ****************************************************************************/
 
+/* The command table is sorted by command name (strcmp() order) so that it
+ * can be searched with a binary search.  Keep it sorted when adding new
+ * commands.
+ */
+
 static const struct cmdmap_s g_cmdmap[] =
 {
 #if !defined(CONFIG_NSH_DISABLESCRIPT) && !defined(CONFIG_NSH_DISABLE_SOURCE)
   CMD_MAP(".",        cmd_source,   2, 2, "<script-path>"),
 #endif
 
+#ifndef CONFIG_NSH_DISABLE_HELP
+  CMD_MAP("?",        cmd_help,     1, 1, NULL),
+#endif
+
 #if !defined(CONFIG_NSH_DISABLESCRIPT) && !defined(CONFIG_NSH_DISABLE_TEST)
   CMD_MAP("[",        cmd_lbracket,
           4, CONFIG_NSH_MAXARGUMENTS, "<expression> ]"),
 #endif
 
-#ifndef CONFIG_NSH_DISABLE_HELP
-  CMD_MAP("?",        cmd_help,     1, 1, NULL),
-#endif
-
 #if defined(CONFIG_NET) && defined(CONFIG_NET_ROUTE) && !defined(CONFIG_NSH_DISABLE_ADDROUTE)
   CMD_MAP("addroute", cmd_addroute, 3, 4, "<target> [<netmask>] <router>"),
 #endif
@@ -125,8 +130,6 @@ static const struct cmdmap_s g_cmdmap[] =
 #ifdef CONFIG_NSH_ALIAS
   CMD_MAP("alias",    cmd_alias,    1, CONFIG_NSH_MAXARGUMENTS,
     "[name[=value] ... ]"),
-  CMD_MAP("unalias",  cmd_unalias,  1, CONFIG_NSH_MAXARGUMENTS,
-    "[-a] name [name ... ]"),
 #endif
 
 #if defined(CONFIG_NET) && defined(CONFIG_NET_ARP) && !defined(CONFIG_NSH_DISABLE_ARP)
@@ -159,7 +162,7 @@ static const struct cmdmap_s g_cmdmap[] =
 
 #ifndef CONFIG_NSH_DISABLE_CAT
   CMD_MAP("cat",      cmd_cat,      2, CONFIG_NSH_MAXARGUMENTS,
-    "<path> [<path> [<path> ...]]"),
+    "[-v] <path> [<path> [<path> ...]]"),
 #endif
 
 #ifndef CONFIG_DISABLE_ENVIRON
@@ -168,16 +171,13 @@ static const struct cmdmap_s g_cmdmap[] =
 #  endif
 #endif
 
-#ifndef CONFIG_NSH_DISABLE_CP
-  CMD_MAP("cp",       cmd_cp,       3, 3, "<source-path> <dest-path>"),
-#endif
-
 #ifndef CONFIG_NSH_DISABLE_CMP
   CMD_MAP("cmp",      cmd_cmp,      3, 3, "<path1> <path2>"),
 #endif
 
-#ifndef CONFIG_NSH_DISABLE_DIRNAME
-  CMD_MAP("dirname",  cmd_dirname,  2, 2, "<path>"),
+#ifndef CONFIG_NSH_DISABLE_CP
+  CMD_MAP("cp",       cmd_cp,       3, 4,
+    "[-v] <source-path> <dest-path>"),
 #endif
 
 #ifndef CONFIG_NSH_DISABLE_DATE
@@ -205,6 +205,10 @@ static const struct cmdmap_s g_cmdmap[] =
 #endif
 #endif
 
+#ifndef CONFIG_NSH_DISABLE_DIRNAME
+  CMD_MAP("dirname",  cmd_dirname,  2, 2, "<path>"),
+#endif
+
 #if defined(CONFIG_SYSLOG_DEVPATH) && !defined(CONFIG_NSH_DISABLE_DMESG)
   CMD_MAP("dmesg",    cmd_dmesg,    1, 2, "[-c,--clear |-C,--read-clear]"),
 #endif
@@ -231,15 +235,15 @@ static const struct cmdmap_s g_cmdmap[] =
   CMD_MAP("exit",     cmd_exit,     1, 1, NULL),
 #endif
 
+#ifndef CONFIG_NSH_DISABLE_EXPORT
+  CMD_MAP("export",   cmd_export,   2, 3, "[<name> [<value>]]"),
+#endif
+
 #ifndef CONFIG_NSH_DISABLE_EXPR
   CMD_MAP("expr",     cmd_expr,     4, 4,
     "<operand1> <operator> <operand2>"),
 #endif
 
-#ifndef CONFIG_NSH_DISABLE_EXPORT
-  CMD_MAP("export",   cmd_export,   2, 3, "[<name> [<value>]]"),
-#endif
-
 #ifndef CONFIG_NSH_DISABLESCRIPT
   CMD_MAP("false",    cmd_false,    1, 1, NULL),
 #endif
@@ -254,13 +258,6 @@ static const struct cmdmap_s g_cmdmap[] =
   CMD_MAP("free",     cmd_free,     1, 1, NULL),
 #endif
 
-#ifdef CONFIG_DEBUG_MM
-#  ifndef CONFIG_NSH_DISABLE_MEMDUMP
-  CMD_MAP("memdump",  cmd_memdump,
-          1, 4, "[pid/used/free/on/off]" " <minseq> <maxseq>"),
-#  endif
-#endif
-
 #ifdef CONFIG_NET_UDP
 #  ifndef CONFIG_NSH_DISABLE_GET
   CMD_MAP("get",      cmd_get,      4, 7,
@@ -310,6 +307,18 @@ static const struct cmdmap_s g_cmdmap[] =
   CMD_MAP("kill",     cmd_kill,     2, 3, "[-<signal>] <pid>"),
 #endif
 
+#if !defined(CONFIG_NSH_DISABLE_LN) && defined(CONFIG_PSEUDOFS_SOFTLINKS)
+  CMD_MAP("ln",       cmd_ln,       3, 4, "[-s] <target> <link>"),
+#endif
+
+#ifndef CONFIG_DISABLE_MOUNTPOINT
+#  if defined(CONFIG_MTD_LOOP) && !defined(CONFIG_NSH_DISABLE_LOMTD)
+  CMD_MAP("lomtd",    cmd_lomtd,    3, 9,
+    "[-d <dev-path>] | [[-o <offset>] [-e <erase-size>] "
+    "[-b <sect-size>] <dev-path> <file-path>]]"),
+#  endif
+#endif
+
 #ifndef CONFIG_DISABLE_MOUNTPOINT
 #  if defined(CONFIG_DEV_LOOP) && !defined(CONFIG_NSH_DISABLE_LOSETUP)
   CMD_MAP("losetup",  cmd_losetup,  3, 6,
@@ -326,18 +335,6 @@ static const struct cmdmap_s g_cmdmap[] =
 #  endif
 #endif
 
-#ifndef CONFIG_DISABLE_MOUNTPOINT
-#  if defined(CONFIG_MTD_LOOP) && !defined(CONFIG_NSH_DISABLE_LOMTD)
-  CMD_MAP("lomtd",    cmd_lomtd,    3, 9,
-    "[-d <dev-path>] | [[-o <offset>] [-e <erase-size>] "
-    "[-b <sect-size>] <dev-path> <file-path>]]"),
-#  endif
-#endif
-
-#if !defined(CONFIG_NSH_DISABLE_LN) && defined(CONFIG_PSEUDOFS_SOFTLINKS)
-  CMD_MAP("ln",       cmd_ln,       3, 4, "[-s] <target> <link>"),
-#endif
-
 #ifndef CONFIG_NSH_DISABLE_LS
   CMD_MAP("ls",       cmd_ls,       1, 5, "[-lRsh] <dir-path>"),
 #endif
@@ -359,6 +356,18 @@ static const struct cmdmap_s g_cmdmap[] =
 #  endif
 #endif
 
+#ifdef CONFIG_DEBUG_MM
+#  ifndef CONFIG_NSH_DISABLE_MEMDUMP
+  CMD_MAP("memdump",  cmd_memdump,
+          1, 4, "[pid/used/free/on/off]" " <minseq> <maxseq>"),
+#  endif
+#endif
+
+#ifndef CONFIG_NSH_DISABLE_MH
+  CMD_MAP("mh",       cmd_mh,       2, 3,
+    "<hex-address>[=<hex-value>] [<hex-byte-count>]"),
+#endif
+
 #ifdef NSH_HAVE_DIROPTS
 #  ifndef CONFIG_NSH_DISABLE_MKDIR
   CMD_MAP("mkdir",    cmd_mkdir,    2, 3, "[-p] <path>"),
@@ -397,11 +406,6 @@ static const struct cmdmap_s g_cmdmap[] =
 #  endif
 #endif
 
-#ifndef CONFIG_NSH_DISABLE_MH
-  CMD_MAP("mh",       cmd_mh,       2, 3,
-    "<hex-address>[=<hex-value>] [<hex-byte-count>]"),
-#endif
-
 #if !defined(CONFIG_DISABLE_MOUNTPOINT)
 #  ifndef CONFIG_NSH_DISABLE_MOUNT
 #    if defined(NSH_HAVE_CATFILE) && defined(HAVE_MOUNT_LIST)
@@ -596,6 +600,17 @@ static const struct cmdmap_s g_cmdmap[] =
 #  endif
 #endif
 
+#if !defined(CONFIG_DISABLE_MOUNTPOINT)
+#  ifndef CONFIG_NSH_DISABLE_UMOUNT
+  CMD_MAP("umount",   cmd_umount,   2, 2, "<dir-path>"),
+#  endif
+#endif
+
+#ifdef CONFIG_NSH_ALIAS
+  CMD_MAP("unalias",  cmd_unalias,  1, CONFIG_NSH_MAXARGUMENTS,
+    "[-a] name [name ... ]"),
+#endif
+
 #ifndef CONFIG_NSH_DISABLE_UNAME
 #  ifdef CONFIG_NET
   CMD_MAP("uname",    cmd_uname,    1, 7, "[-a | -imnoprsv]"),
@@ -604,12 +619,6 @@ static const struct cmdmap_s g_cmdmap[] =
 #  endif
 #endif
 
-#if !defined(CONFIG_DISABLE_MOUNTPOINT)
-#  ifndef CONFIG_NSH_DISABLE_UMOUNT
-  CMD_MAP("umount",   cmd_umount,   2, 2, "<dir-path>"),
-#  endif
-#endif
-
 #ifndef CONFIG_NSH_DISABLE_UNSET
   CMD_MAP("unset",    cmd_unset,    2, 2, "<name>"),
 #endif
@@ -642,6 +651,11 @@ static const struct cmdmap_s g_cmdmap[] =
   CMD_MAP("usleep",   cmd_usleep,   2, 2, "<usec>"),
 #endif
 
+#ifndef CONFIG_NSH_DISABLE_WAIT
+  CMD_MAP("wait",     cmd_wait,     1, CONFIG_NSH_MAXARGUMENTS,
+    "[<pid> [<pid> ...]]"),
+#endif
+
 #ifdef CONFIG_NET_TCP
 #  ifndef CONFIG_NSH_DISABLE_WGET
   CMD_MAP("wget",     cmd_wget,     2, 4, "[-o <local-path>] <url>"),
@@ -658,6 +672,75 @@ static const struct cmdmap_s g_cmdmap[] =
  * Private Functions
  ****************************************************************************/
 
+/****************************************************************************
+ * Name: nsh_cmdmap_lower
+ *
+ * Description:
+ *   Return the index of the first entry in the sorted command table whose
+ *   first namelen characters are not less than those of name, or NUM_CMDS
+ *   if there is no such entry.
+ *
+ ****************************************************************************/
+
+static int nsh_cmdmap_lower(FAR const char *name, size_t namelen)
+{
+  int lower = 0;
+  int upper = NUM_CMDS;
+  int mid;
+
+#ifdef CONFIG_DEBUG_ASSERTIONS
+  static bool checked;
+
+  if (!checked)
+    {
+      for (mid = 1; mid < (int)NUM_CMDS; mid++)
+        {
+          DEBUGASSERT(strcmp(g_cmdmap[mid - 1].cmd, g_cmdmap[mid].cmd) < 0);
+        }
+
+      checked = true;
+    }
+#endif
+
+  while (lower < upper)
+    {
+      mid = (lower + upper) >> 1;
+      if (strncmp(g_cmdmap[mid].cmd, name, namelen) < 0)
+        {
+          lower = mid + 1;
+        }
+      else
+        {
+          upper = mid;
+        }
+    }
+
+  return lower;
+}
+
+/****************************************************************************
+ * Name: nsh_cmdmap_find
+ *
+ * Description:
+ *   Find a command in the command table.  Returns NULL if not found.
+ *
+ ****************************************************************************/
+
+static FAR const struct cmdmap_s *nsh_cmdmap_find(FAR const char *cmd)
+{
+  int index;
+
+  /* Compare the terminating NUL too, so only an exact match can be found */
+
+  index = nsh_cmdmap_lower(cmd, strlen(cmd) + 1);
+  if (index < (int)NUM_CMDS && strcmp(g_cmdmap[index].cmd, cmd) == 0)
+    {
+      return &g_cmdmap[index];
+    }
+
+  return NULL;
+}
+
 /****************************************************************************
  * Name: help_cmdlist
  ****************************************************************************/
@@ -812,18 +895,12 @@ static int help_cmd(FAR struct nsh_vtbl_s *vtbl, FAR const char *cmd)
 
   /* Find the command in the command table */
 
-  for (cmdmap = g_cmdmap; cmdmap->cmd; cmdmap++)
+  cmdmap = nsh_cmdmap_find(cmd);
+  if (cmdmap != NULL)
     {
-      /* Is this the one we are looking for? */
-
-      if (strcmp(cmdmap->cmd, cmd) == 0)
-        {
-          /* Yes... show it */
-
-          nsh_output(vtbl, "%s usage:", cmd);
-          help_showcmd(vtbl, cmdmap);
-          return OK;
-        }
+      nsh_output(vtbl, "%s usage:", cmd);
+      help_showcmd(vtbl, cmdmap);
+      return OK;
     }
 
   nsh_error(vtbl, g_fmtcmdnotfound, cmd);
@@ -1204,38 +1281,35 @@ int nsh_command(FAR struct nsh_vtbl_s *vtbl, int argc, FAR char *argv[])
 
   /* See if the command is one that we understand */
 
-  for (cmdmap = g_cmdmap; cmdmap->cmd; cmdmap++)
+  cmdmap = nsh_cmdmap_find(cmd);
+  if (cmdmap != NULL)
     {
-      if (strcmp(cmdmap->cmd, cmd) == 0)
-        {
-          /* Check if a valid number of arguments was provided.  We
-           * do this simple, imperfect checking here so that it does
-           * not have to be performed in each command.
-           */
+      /* Check if a valid number of arguments was provided.  We
+       * do this simple, imperfect checking here so that it does
+       * not have to be performed in each command.
+       */
 
-          if (argc < cmdmap->minargs)
-            {
-              /* Fewer than the minimum number were provided */
+      if (argc < cmdmap->minargs)
+        {
+          /* Fewer than the minimum number were provided */
 
-              nsh_error(vtbl, g_fmtargrequired, cmd);
-              return ERROR;
-            }
-          else if (argc > cmdmap->maxargs)
-            {
-              /* More than the maximum number were provided */
+          nsh_error(vtbl, g_fmtargrequired, cmd);
+          return ERROR;
+        }
+      else if (argc > cmdmap->maxargs)
+        {
+          /* More than the maximum number were provided */
 
-              nsh_error(vtbl, g_fmttoomanyargs, cmd);
-              return ERROR;
-            }
-          else
-            {
-              /* A valid number of arguments were provided (this does
-               * not mean they are right).
-               */
+          nsh_error(vtbl, g_fmttoomanyargs, cmd);
+          return ERROR;
+        }
+      else
+        {
+          /* A valid number of arguments were provided (this does
+           * not mean they are right).
+           */
 
-              handler = cmdmap->handler;
-              break;
-            }
+          handler = cmdmap->handler;
         }
     }
 
@@ -1269,17 +1343,18 @@ int nsh_extmatch_count(FAR char *name, FAR int *matches, int namelen)
   int nr_matches = 0;
   int i;
 
-  for (i = 0; i < (int)NUM_CMDS; i++)
+  /* All matching commands follow each other in the sorted table */
+
+  for (i = nsh_cmdmap_lower(name, namelen);
+       i < (int)NUM_CMDS && strncmp(name, g_cmdmap[i].cmd, namelen) == 0;
+       i++)
     {
-      if (strncmp(name, g_cmdmap[i].cmd, namelen) == 0)
-        {
-          matches[nr_matches] = i;
-          nr_matches++;
+      matches[nr_matches] = i;
+      nr_matches++;
 
-          if (nr_matches >= CONFIG_READLINE_MAX_EXTCMDS)
-            {
-              break;
-            }
+      if (nr_matches >= CONFIG_READLINE_MAX_EXTCMDS)
+        {
+          break;
         }
     }
 
@@ -1307,7 +1382,7 @@ int nsh_extmatch_count(FAR char *name, FAR int *matches, int namelen)
     defined(CONFIG_READLINE_HAVE_EXTMATCH)
 FAR const char *nsh_extmatch_getname(int index)
 {
-  DEBUGASSERT(index > 0 && index <= (int)NUM_CMDS);
+  DEBUGASSERT(index >= 0 && index < (int)NUM_CMDS);
   return  g_cmdmap[index].cmd;
 }
 #endif
@@ -385,6 +385,13 @@ FAR struct console_stdio_s *nsh_newconsole(bool isctty)
       pstate->cn_vtbl.np.np_flags = NSH_NP_SET_OPTIONS_INIT;
 #endif
 
+#ifdef CONFIG_NSH_PIPELINE
+      /* No pipeline is running */
+
+      pstate->cn_vtbl.np.np_pipein  = -1;
+      pstate->cn_vtbl.np.np_pipeout = -1;
+#endif
+
       pstate->cn_vtbl.redirect    = nsh_consoleredirect;
       pstate->cn_vtbl.undirect    = nsh_consoleundirect;
 
@@ -37,6 +37,8 @@
 #include <libgen.h>
 #include <nuttx/lib/builtin.h>
 
+#include "builtin/builtin.h"
+
 #include "nsh.h"
 #include "nsh_console.h"
 
@@ -123,11 +125,41 @@ int nsh_fileapp(FAR struct nsh_vtbl_s *vtbl, FAR const char *cmd,
         }
     }
 
+#ifdef CONFIG_NSH_PIPELINE
+  /* Connect stdin and stdout to the pipes of a pipeline */
+
+  if (vtbl->np.np_pipein >= 0)
+    {
+      ret = posix_spawn_file_actions_adddup2(&file_actions,
+                                             vtbl->np.np_pipein, 0);
+      if (ret != 0)
+        {
+          nsh_error(vtbl, g_fmtcmdfailed, cmd,
+                    "posix_spawn_file_actions_adddup2",
+                    NSH_ERRNO_OF(ret));
+          goto errout_with_actions;
+        }
+    }
+
+  if (NSH_PIPE_OUT(vtbl))
+    {
+      ret = posix_spawn_file_actions_adddup2(&file_actions,
+                                             vtbl->np.np_pipeout, 1);
+      if (ret != 0)
+        {
+          nsh_error(vtbl, g_fmtcmdfailed, cmd,
+                    "posix_spawn_file_actions_adddup2",
+                    NSH_ERRNO_OF(ret));
+          goto errout_with_actions;
+        }
+    }
+#endif
+
 #ifdef CONFIG_BUILTIN
   /* Check if a builtin application with this name exists */
 
   appname = basename((FAR char *)cmd);
-  index = builtin_isavail(appname);
+  index = builtin_find(appname);
   if (index >= 0)
     {
       FAR const struct builtin_s *builtin;
@@ -188,6 +220,18 @@ int nsh_fileapp(FAR struct nsh_vtbl_s *vtbl, FAR const char *cmd,
        * in background (and running commands in background is enabled).
        */
 
+#  ifdef CONFIG_NSH_PIPELINE
+      if (NSH_PIPE_OUT(vtbl))
+        {
+          /* Not the last command of a pipeline.  It keeps running while
+           * the next commands are started and is waited for at the end of
+           * the pipeline.
+           */
+
+          vtbl->np.np_pipepid[vtbl->np.np_npipe++] = pid;
+        }
+      else
+#  endif /* CONFIG_NSH_PIPELINE */
 #  ifndef CONFIG_NSH_DISABLEBG
       if (vtbl->np.np_bg == false)
 #  endif /* CONFIG_NSH_DISABLEBG */
@@ -278,8 +322,9 @@ int nsh_fileapp(FAR struct nsh_vtbl_s *vtbl, FAR const char *cmd,
 #if !defined(CONFIG_SCHED_WAITPID) || !defined(CONFIG_NSH_DISABLEBG)
         {
           struct sched_param param;
-          sched_getparam(ret, &param);
-          nsh_output(vtbl, "%s [%d:%d]\n", cmd, ret, param.sched_priority);
+          sched_getparam(pid, &param);
+          nsh_output(vtbl, "%s [%d:%d]\n", cmd, pid, param.sched_priority);
+          nsh_addjob(vtbl, pid);
 
           /* Backgrounded commands always 'succeed' as long as we can start
            * them.
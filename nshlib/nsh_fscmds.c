@@ -532,13 +532,41 @@ int cmd_dirname(FAR struct nsh_vtbl_s *vtbl, int argc, FAR char **argv)
 #ifndef CONFIG_NSH_DISABLE_CAT
 int cmd_cat(FAR struct nsh_vtbl_s *vtbl, int argc, FAR char **argv)
 {
+  FAR struct console_stdio_s *pstate = (FAR struct console_stdio_s *)vtbl;
+  struct timespec start;
   FAR char *fullpath;
+  bool verbose = false;
+  off_t total = 0;
+  int option;
+  int fd;
   int i;
   int ret = OK;
 
+  while ((option = getopt(argc, argv, "v")) != ERROR)
+    {
+      switch (option)
+        {
+          case 'v':
+            verbose = true;
+            break;
+
+          default:
+            nsh_error(vtbl, g_fmtarginvalid, argv[0]);
+            return ERROR;
+        }
+    }
+
+  if (optind >= argc)
+    {
+      nsh_error(vtbl, g_fmtargrequired, argv[0]);
+      return ERROR;
+    }
+
+  clock_gettime(CLOCK_MONOTONIC, &start);
+
   /* Loop for each file name on the command line */
 
-  for (i = 1; i < argc && ret == OK; i++)
+  for (i = optind; i < argc && ret == OK; i++)
     {
       /* Get the fullpath to the file */
 
@@ -552,7 +580,28 @@ int cmd_cat(FAR struct nsh_vtbl_s *vtbl, int argc, FAR char **argv)
         {
           /* Dump the file to the console */
 
-          ret = nsh_catfile(vtbl, argv[0], fullpath);
+          fd = open(fullpath, O_RDONLY);
+          if (fd < 0)
+            {
+#if defined(CONFIG_NSH_PROC_MOUNTPOINT)
+              if (strncmp(fullpath, CONFIG_NSH_PROC_MOUNTPOINT,
+                          sizeof(CONFIG_NSH_PROC_MOUNTPOINT) - 1) == 0)
+                {
+                  nsh_error(vtbl,
+                            "nsh: %s: Could not open %s "
+                            "(is procfs mounted?)\n",
+                            argv[0], fullpath);
+                }
+#endif
+
+              nsh_error(vtbl, g_fmtcmdfailed, argv[0], "open", NSH_ERRNO);
+              ret = ERROR;
+            }
+          else
+            {
+              ret = nsh_copyfd(vtbl, argv[0], fd, OUTFD(pstate), &total);
+              close(fd);
+            }
 
           /* Free the allocated full path */
 
@@ -560,6 +609,11 @@ int cmd_cat(FAR struct nsh_vtbl_s *vtbl, int argc, FAR char **argv)
         }
     }
 
+  if (verbose)
+    {
+      nsh_copystats(vtbl, argv[0], total, &start);
+    }
+
   return ret;
 }
 #endif
@@ -618,20 +672,43 @@ int cmd_dmesg(FAR struct nsh_vtbl_s *vtbl, int argc, FAR char **argv)
 #ifndef CONFIG_NSH_DISABLE_CP
 int cmd_cp(FAR struct nsh_vtbl_s *vtbl, int argc, FAR char **argv)
 {
-  UNUSED(argc);
-
+  struct timespec start;
   struct stat buf;
   FAR char *srcpath  = NULL;
   FAR char *destpath = NULL;
   FAR char *allocpath = NULL;
+  bool verbose = false;
+  off_t total = 0;
   int oflags = O_WRONLY | O_CREAT | O_TRUNC;
+  int option;
   int rdfd;
   int wrfd;
   int ret = ERROR;
 
+  while ((option = getopt(argc, argv, "v")) != ERROR)
+    {
+      switch (option)
+        {
+          case 'v':
+            verbose = true;
+            break;
+
+          default:
+            nsh_error(vtbl, g_fmtarginvalid, argv[0]);
+            return ERROR;
+        }
+    }
+
+  if (optind + 2 != argc)
+    {
+      nsh_error(vtbl, optind + 2 > argc ? g_fmtargrequired :
+                g_fmttoomanyargs, argv[0]);
+      return ERROR;
+    }
+
   /* Get the full path to the source file */
 
-  srcpath = nsh_getfullpath(vtbl, argv[1]);
+  srcpath = nsh_getfullpath(vtbl, argv[optind]);
   if (srcpath == NULL)
     {
       nsh_error(vtbl, g_fmtcmdoutofmemory, argv[0]);
@@ -649,7 +726,7 @@ int cmd_cp(FAR struct nsh_vtbl_s *vtbl, int argc, FAR char **argv)
 
   /* Get the full path to the destination file or directory */
 
-  destpath = nsh_getfullpath(vtbl, argv[2]);
+  destpath = nsh_getfullpath(vtbl, argv[optind + 1]);
   if (destpath == NULL)
     {
       nsh_error(vtbl, g_fmtcmdoutofmemory, argv[0]);
@@ -673,7 +750,8 @@ int cmd_cp(FAR struct nsh_vtbl_s *vtbl, int argc, FAR char **argv)
 
           /* Construct the full path to the new file */
 
-          allocpath = nsh_getdirpath(vtbl, destpath, basename(argv[1]));
+          allocpath = nsh_getdirpath(vtbl, destpath,
+                                     basename(argv[optind]));
           if (!allocpath)
             {
               nsh_error(vtbl, g_fmtcmdoutofmemory, argv[0]);
@@ -712,74 +790,14 @@ int cmd_cp(FAR struct nsh_vtbl_s *vtbl, int argc, FAR char **argv)
 
   /* Now copy the file */
 
-  for (; ; )
-    {
-      int nbytesread;
-      int nbyteswritten;
-      FAR char *iobuffer = vtbl->iobuffer;
-
-      do
-        {
-          nbytesread = read(rdfd, iobuffer, IOBUFFERSIZE);
-          if (nbytesread == 0)
-            {
-              /* End of file */
-
-              ret = OK;
-              goto errout_with_wrfd;
-            }
-          else if (nbytesread < 0)
-            {
-              /* EINTR is not an error (but will still stop the copy) */
-
-              if (errno == EINTR)
-                {
-                  nsh_error(vtbl, g_fmtsignalrecvd, argv[0]);
-                }
-              else
-                {
-                  /* Read error */
+  clock_gettime(CLOCK_MONOTONIC, &start);
 
-                  nsh_error(vtbl, g_fmtcmdfailed, argv[0], "read",
-                            NSH_ERRNO);
-                }
-
-              goto errout_with_wrfd;
-            }
-        }
-      while (nbytesread <= 0);
-
-      do
-        {
-          nbyteswritten = write(wrfd, iobuffer, nbytesread);
-          if (nbyteswritten >= 0)
-            {
-              nbytesread -= nbyteswritten;
-              iobuffer += nbyteswritten;
-            }
-          else
-            {
-              /* EINTR is not an error (but will still stop the copy) */
-
-              if (errno == EINTR)
-                {
-                  nsh_error(vtbl, g_fmtsignalrecvd, argv[0]);
-                }
-              else
-                {
-                  /* Read error */
-
-                  nsh_error(vtbl, g_fmtcmdfailed, argv[0], "write",
-                            NSH_ERRNO);
-                }
-
-              goto errout_with_wrfd;
-            }
-        }
-      while (nbytesread > 0);
+  ret = nsh_copyfd(vtbl, argv[0], rdfd, wrfd, &total);
+  if (ret == OK && verbose)
+    {
+      nsh_copystats(vtbl, argv[0], total, &start);
     }
 
-errout_with_wrfd:
   close(wrfd);
 
 errout_with_allocpath:
@@ -24,7 +24,10 @@
 
 #include <nuttx/config.h>
 
+#include <nuttx/clock.h>
+
 #include <sys/types.h>
+#include <sys/stat.h>
 #include <stdint.h>
 #include <stdbool.h>
 #include <stdio.h>
@@ -35,10 +38,41 @@
 #include <dirent.h>
 #include <assert.h>
 #include <unistd.h>
+#include <malloc.h>
+
+#ifdef CONFIG_NSH_CMDOPT_COPY_SENDFILE
+#  include <sys/sendfile.h>
+#endif
+
+#ifdef CONFIG_FS_AIO
+#  include <aio.h>
+#endif
 
 #include "nsh.h"
 #include "nsh_console.h"
 
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#ifdef CONFIG_NSH_CMDOPT_COPY_BUFSIZE
+#  define NSH_COPY_BUFSIZE    CONFIG_NSH_CMDOPT_COPY_BUFSIZE
+#else
+#  define NSH_COPY_BUFSIZE    IOBUFFERSIZE
+#endif
+
+/* Cache line friendly alignment of the copy buffers, which also lets
+ * drivers DMA directly from/to them.
+ */
+
+#define NSH_COPY_ALIGN        64
+
+/* Maximum number of bytes for a single sendfile() call, so that a signal
+ * can stop the copy in a reasonable time.
+ */
+
+#define NSH_SENDFILE_CHUNK    (64 * 1024)
+
 /****************************************************************************
  * Private Types
  ****************************************************************************/
@@ -108,132 +142,419 @@ static int getpid_callback(FAR struct nsh_vtbl_s *vtbl,
 #endif
 
 /****************************************************************************
- * Public Functions
+ * Name: nsh_copyerror
  ****************************************************************************/
 
+#ifdef NSH_HAVE_COPYFD
+static void nsh_copyerror(FAR struct nsh_vtbl_s *vtbl, FAR const char *cmd,
+                          FAR const char *op, int errcode)
+{
+  /* EINTR is not an error (but will stop the copy) */
+
+  if (errcode == EINTR)
+    {
+      nsh_error(vtbl, g_fmtsignalrecvd, cmd);
+    }
+  else
+    {
+      nsh_error(vtbl, g_fmtcmdfailed, cmd, op, NSH_ERRNO_OF(errcode));
+    }
+}
+#endif
+
 /****************************************************************************
- * Name: nsh_catfile
+ * Name: nsh_copywrite
  *
  * Description:
- *   Dump the contents of a file to the current NSH terminal.
+ *   Write the whole buffer, retrying partial writes.
  *
- * Input Paratemets:
- *   vtbl     - session vtbl
- *   cmd      - NSH command name to use in error reporting
- *   filepath - The full path to the file to be dumped
+ ****************************************************************************/
+
+#ifdef NSH_HAVE_COPYFD
+static int nsh_copywrite(FAR struct nsh_vtbl_s *vtbl, FAR const char *cmd,
+                         int fd, FAR const char *buffer, size_t nbytes)
+{
+  ssize_t n;
+
+  while (nbytes > 0)
+    {
+      n = write(fd, buffer, nbytes);
+      if (n < 0)
+        {
+          nsh_copyerror(vtbl, cmd, "write", errno);
+          return ERROR;
+        }
+
+      buffer += n;
+      nbytes -= n;
+    }
+
+  return OK;
+}
+#endif
+
+/****************************************************************************
+ * Name: nsh_copysendfile
  *
- * Returned Value:
- *   Zero (OK) on success; -1 (ERROR) on failure.
+ * Description:
+ *   Copy with sendfile().  Returns -ENOSYS if sendfile() failed before
+ *   anything was copied, in which case the caller should fall back to
+ *   read() and write().
  *
  ****************************************************************************/
 
-#ifdef NSH_HAVE_CATFILE
-int nsh_catfile(FAR struct nsh_vtbl_s *vtbl, FAR const char *cmd,
-                FAR const char *filepath)
+#if defined(NSH_HAVE_COPYFD) && defined(CONFIG_NSH_CMDOPT_COPY_SENDFILE)
+static int nsh_copysendfile(FAR struct nsh_vtbl_s *vtbl,
+                            FAR const char *cmd, int infd, int outfd,
+                            FAR off_t *total)
 {
-  FAR char *buffer;
-  int fd;
-  int ret = OK;
-
-  /* Open the file for reading */
+  ssize_t n;
 
-  fd = open(filepath, O_RDONLY);
-  if (fd < 0)
+  for (; ; )
     {
-#if defined(CONFIG_NSH_PROC_MOUNTPOINT)
-      if (strncmp(filepath, CONFIG_NSH_PROC_MOUNTPOINT,
-                  sizeof(CONFIG_NSH_PROC_MOUNTPOINT) - 1) == 0)
+      n = sendfile(outfd, infd, NULL, NSH_SENDFILE_CHUNK);
+      if (n > 0)
         {
-          nsh_error(vtbl,
-                    "nsh: %s: Could not open %s (is procfs mounted?)\n",
-                    cmd, filepath);
+          *total += n;
         }
+      else if (n == 0)
+        {
+          return OK;
+        }
+      else if (*total == 0 && errno != EINTR)
+        {
+          /* Not supported by the file systems or drivers involved */
+
+          return -ENOSYS;
+        }
+      else
+        {
+          nsh_copyerror(vtbl, cmd, "sendfile", errno);
+          return ERROR;
+        }
+    }
+}
 #endif
 
-      nsh_error(vtbl, g_fmtcmdfailed, cmd, "open", NSH_ERRNO);
-      return ERROR;
+/****************************************************************************
+ * Name: nsh_copyaiowait
+ *
+ * Description:
+ *   Wait for the pending asynchronous write to complete.
+ *
+ ****************************************************************************/
+
+#if defined(NSH_HAVE_COPYFD) && defined(CONFIG_FS_AIO)
+static int nsh_copyaiowait(FAR struct nsh_vtbl_s *vtbl,
+                           FAR const char *cmd, FAR struct aiocb *aiocbp)
+{
+  FAR const struct aiocb *list[1];
+  ssize_t ret;
+
+  list[0] = aiocbp;
+  while (aio_error(aiocbp) == EINPROGRESS)
+    {
+      aio_suspend(list, 1, NULL);
     }
 
-  buffer = (FAR char *)malloc(IOBUFFERSIZE);
-  if (buffer == NULL)
+  ret = aio_return(aiocbp);
+  if (ret < 0)
     {
-      close(fd);
-      nsh_error(vtbl, g_fmtcmdfailed, cmd, "malloc", NSH_ERRNO);
+      nsh_copyerror(vtbl, cmd, "aio_write", errno);
+      return ERROR;
+    }
+  else if ((size_t)ret != aiocbp->aio_nbytes)
+    {
+      nsh_copyerror(vtbl, cmd, "aio_write", ENOSPC);
       return ERROR;
     }
 
-  /* And just dump it byte for byte into stdout */
+  return OK;
+}
+#endif
 
-  for (; ; )
-    {
-      int nbytesread = read(fd, buffer, IOBUFFERSIZE);
+/****************************************************************************
+ * Name: nsh_copyaio
+ *
+ * Description:
+ *   Double buffered copy to a seekable output:  the next chunk is read
+ *   into one buffer while the previous chunk is written from the other
+ *   one with aio_write().
+ *
+ ****************************************************************************/
+
+#if defined(NSH_HAVE_COPYFD) && defined(CONFIG_FS_AIO)
+static int nsh_copyaio(FAR struct nsh_vtbl_s *vtbl, FAR const char *cmd,
+                       int infd, int outfd, FAR char *buffer,
+                       off_t offset, FAR off_t *total)
+{
+  struct aiocb aiocb;
+  bool busy = false;
+  ssize_t nbytesread;
+  int ret = OK;
+  int i = 0;
 
-      /* Check for read errors */
+  memset(&aiocb, 0, sizeof(aiocb));
+  aiocb.aio_fildes = outfd;
+  aiocb.aio_sigevent.sigev_notify = SIGEV_NONE;
 
+  for (; ; )
+    {
+      nbytesread = read(infd, &buffer[i * NSH_COPY_BUFSIZE],
+                        NSH_COPY_BUFSIZE);
       if (nbytesread < 0)
         {
-          int errval = errno;
+          nsh_copyerror(vtbl, cmd, "read", errno);
+          ret = ERROR;
+          break;
+        }
 
-          /* EINTR is not an error (but will stop stop the cat) */
+      /* The other buffer is free once the previous write is done */
 
-          if (errval == EINTR)
-            {
-              nsh_error(vtbl, g_fmtsignalrecvd, cmd);
-            }
-          else
+      if (busy)
+        {
+          busy = false;
+          ret  = nsh_copyaiowait(vtbl, cmd, &aiocb);
+          if (ret < 0)
             {
-              nsh_error(vtbl, g_fmtcmdfailed, cmd, "read",
-                        NSH_ERRNO_OF(errval));
+              break;
             }
 
+          offset += aiocb.aio_nbytes;
+          *total += aiocb.aio_nbytes;
+        }
+
+      if (nbytesread == 0)
+        {
+          break;
+        }
+
+      aiocb.aio_buf    = &buffer[i * NSH_COPY_BUFSIZE];
+      aiocb.aio_nbytes = nbytesread;
+      aiocb.aio_offset = offset;
+
+      if (aio_write(&aiocb) < 0)
+        {
+          nsh_copyerror(vtbl, cmd, "aio_write", errno);
           ret = ERROR;
           break;
         }
 
-      /* Check for data successfully read */
+      busy = true;
+      i ^= 1;
+    }
+
+  if (busy)
+    {
+      nsh_copyaiowait(vtbl, cmd, &aiocb);
+    }
+
+  /* aio_write() does not move the file position, move it past the data
+   * written for the next user of the file descriptor.
+   */
+
+  lseek(outfd, offset, SEEK_SET);
+  return ret;
+}
+#endif
+
+/****************************************************************************
+ * Name: nsh_copybuffer
+ *
+ * Description:
+ *   Copy through the copy buffer(s) with read() and write().
+ *
+ ****************************************************************************/
 
-      else if (nbytesread > 0)
+#ifdef NSH_HAVE_COPYFD
+static int nsh_copybuffer(FAR struct nsh_vtbl_s *vtbl, FAR const char *cmd,
+                          int infd, int outfd, FAR off_t *total)
+{
+  FAR char *buffer;
+  ssize_t nbytesread;
+  int ret = OK;
+#ifdef CONFIG_FS_AIO
+  struct stat buf;
+  off_t offset;
+
+  /* Overlap reads and writes if the output is seekable and not appended
+   * to.
+   */
+
+  if (fstat(outfd, &buf) == 0 &&
+      (S_ISREG(buf.st_mode) || S_ISBLK(buf.st_mode)) &&
+      (fcntl(outfd, F_GETFL) & O_APPEND) == 0 &&
+      (offset = lseek(outfd, 0, SEEK_CUR)) >= 0)
+    {
+      buffer = memalign(NSH_COPY_ALIGN, 2 * NSH_COPY_BUFSIZE);
+      if (buffer != NULL)
         {
-          int nbyteswritten = 0;
+          ret = nsh_copyaio(vtbl, cmd, infd, outfd, buffer, offset, total);
+          free(buffer);
+          return ret;
+        }
+    }
+#endif
 
-          while (nbyteswritten < nbytesread)
-            {
-              ssize_t n = nsh_write(vtbl, buffer + nbyteswritten,
-                                    nbytesread - nbyteswritten);
-              if (n < 0)
-                {
-                  int errcode = errno;
-
-                  /* EINTR is not an error (but will stop stop the cat) */
-
-                  if (errcode == EINTR)
-                    {
-                      nsh_error(vtbl, g_fmtsignalrecvd, cmd);
-                    }
-                  else
-                    {
-                      nsh_error(vtbl, g_fmtcmdfailed, cmd, "write",
-                                 NSH_ERRNO_OF(errcode));
-                    }
-
-                  ret = ERROR;
-                  break;
-                }
-              else
-                {
-                  nbyteswritten += n;
-                }
-            }
+  buffer = memalign(NSH_COPY_ALIGN, NSH_COPY_BUFSIZE);
+  if (buffer == NULL)
+    {
+      nsh_error(vtbl, g_fmtcmdfailed, cmd, "malloc", NSH_ERRNO);
+      return ERROR;
+    }
+
+  for (; ; )
+    {
+      nbytesread = read(infd, buffer, NSH_COPY_BUFSIZE);
+      if (nbytesread < 0)
+        {
+          nsh_copyerror(vtbl, cmd, "read", errno);
+          ret = ERROR;
+          break;
         }
+      else if (nbytesread == 0)
+        {
+          /* End of file */
 
-      /* Otherwise, it is the end of file */
+          break;
+        }
 
-      else
+      ret = nsh_copywrite(vtbl, cmd, outfd, buffer, nbytesread);
+      if (ret < 0)
         {
           break;
         }
+
+      *total += nbytesread;
+    }
+
+  free(buffer);
+  return ret;
+}
+#endif
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: nsh_copyfd
+ *
+ * Description:
+ *   Copy everything from one open file to another, with sendfile() if
+ *   enabled and supported, else through the copy buffer.
+ *
+ * Input Paratemets:
+ *   vtbl    - session vtbl
+ *   cmd     - NSH command name to use in error reporting
+ *   infd    - The file descriptor to copy from
+ *   outfd   - The file descriptor to copy to
+ *   ncopied - If not NULL, the number of bytes copied is added here
+ *
+ * Returned Value:
+ *   Zero (OK) on success; -1 (ERROR) on failure.
+ *
+ ****************************************************************************/
+
+#ifdef NSH_HAVE_COPYFD
+int nsh_copyfd(FAR struct nsh_vtbl_s *vtbl, FAR const char *cmd,
+               int infd, int outfd, FAR off_t *ncopied)
+{
+  off_t total = 0;
+  int ret = -ENOSYS;
+
+#ifdef CONFIG_NSH_CMDOPT_COPY_SENDFILE
+  ret = nsh_copysendfile(vtbl, cmd, infd, outfd, &total);
+#endif
+
+  if (ret == -ENOSYS)
+    {
+      ret = nsh_copybuffer(vtbl, cmd, infd, outfd, &total);
     }
 
+  if (ncopied != NULL)
+    {
+      *ncopied += total;
+    }
+
+  return ret;
+}
+
+/****************************************************************************
+ * Name: nsh_copystats
+ *
+ * Description:
+ *   Print the size and throughput of a copy that started at 'start' on
+ *   stderr, so that it does not mix with the output of cat.
+ *
+ ****************************************************************************/
+
+void nsh_copystats(FAR struct nsh_vtbl_s *vtbl, FAR const char *cmd,
+                   off_t nbytes, FAR const struct timespec *start)
+{
+  struct timespec now;
+  uint64_t elapsed;
+
+  clock_gettime(CLOCK_MONOTONIC, &now);
+
+  elapsed  = (((uint64_t)now.tv_sec * NSEC_PER_SEC) + now.tv_nsec);
+  elapsed -= (((uint64_t)start->tv_sec * NSEC_PER_SEC) + start->tv_nsec);
+  elapsed /= NSEC_PER_USEC; /* usec */
+
+  nsh_error(vtbl, "%s: %llu bytes copied, %llu usec, %llu KB/s\n", cmd,
+            (unsigned long long)nbytes, (unsigned long long)elapsed,
+            elapsed > 0 ? (unsigned long long)nbytes * USEC_PER_SEC /
+                          1024 / elapsed : 0ull);
+}
+#endif
+
+/****************************************************************************
+ * Name: nsh_catfile
+ *
+ * Description:
+ *   Dump the contents of a file to the current NSH terminal.
+ *
+ * Input Paratemets:
+ *   vtbl     - session vtbl
+ *   cmd      - NSH command name to use in error reporting
+ *   filepath - The full path to the file to be dumped
+ *
+ * Returned Value:
+ *   Zero (OK) on success; -1 (ERROR) on failure.
+ *
+ ****************************************************************************/
+
+#ifdef NSH_HAVE_CATFILE
+int nsh_catfile(FAR struct nsh_vtbl_s *vtbl, FAR const char *cmd,
+                FAR const char *filepath)
+{
+  FAR struct console_stdio_s *pstate = (FAR struct console_stdio_s *)vtbl;
+  int fd;
+  int ret;
+
+  /* Open the file for reading */
+
+  fd = open(filepath, O_RDONLY);
+  if (fd < 0)
+    {
+#if defined(CONFIG_NSH_PROC_MOUNTPOINT)
+      if (strncmp(filepath, CONFIG_NSH_PROC_MOUNTPOINT,
+                  sizeof(CONFIG_NSH_PROC_MOUNTPOINT) - 1) == 0)
+        {
+          nsh_error(vtbl,
+                    "nsh: %s: Could not open %s (is procfs mounted?)\n",
+                    cmd, filepath);
+        }
+#endif
+
+      nsh_error(vtbl, g_fmtcmdfailed, cmd, "open", NSH_ERRNO);
+      return ERROR;
+    }
+
+  /* And just dump it byte for byte into stdout */
+
+  ret = nsh_copyfd(vtbl, cmd, fd, OUTFD(pstate), NULL);
+
   /* NOTE that the following NSH prompt may appear on the same line as file
    * content.  The IEEE Std requires that "The standard output shall
    * contain the sequence of bytes read from the input files. Nothing else
@@ -244,7 +565,6 @@ int nsh_catfile(FAR struct nsh_vtbl_s *vtbl, FAR const char *cmd,
   /* Close the input file and return the result */
 
   close(fd);
-  free(buffer);
   return ret;
 }
 #endif
@@ -263,6 +263,11 @@ static int nsh_parse_cmdparm(FAR struct nsh_vtbl_s *vtbl, FAR char *cmdline,
 
 static int nsh_parse_command(FAR struct nsh_vtbl_s *vtbl, FAR char *cmdline);
 
+#ifdef CONFIG_NSH_PIPELINE
+static int nsh_pipeline(FAR struct nsh_vtbl_s *vtbl, FAR char *cmdline);
+static int nsh_pipeline_end(FAR struct nsh_vtbl_s *vtbl, int ret);
+#endif
+
 /****************************************************************************
  * Private Data
  ****************************************************************************/
@@ -270,8 +275,12 @@ static int nsh_parse_command(FAR struct nsh_vtbl_s *vtbl, FAR char *cmdline);
 static const char g_token_separator[] = " \t\n";
 static const char g_quote_separator[] = "'\"`";
 #ifndef NSH_DISABLE_SEMICOLON
+#ifdef CONFIG_NSH_PIPELINE
+static const char g_line_separator[]  = "\"'#;|\n";
+#else
 static const char g_line_separator[]  = "\"'#;\n";
 #endif
+#endif
 #ifdef CONFIG_NSH_ARGCAT
 static const char g_arg_separator[]   = "`$";
 #endif
@@ -715,10 +724,13 @@ static int nsh_execute(FAR struct nsh_vtbl_s *vtbl,
   /* Handle the case where the command is executed in background.
    * However is app is to be started as built-in new process will
    * be created anyway, so skip this step.
+   *
+   * A command that is not the last one of a pipeline is executed in
+   * background too, otherwise it would block once the pipe is full.
    */
 
 #ifndef CONFIG_NSH_DISABLEBG
-  if (vtbl->np.np_bg)
+  if (vtbl->np.np_bg || NSH_PIPE_OUT(vtbl))
     {
       struct sched_param param;
       struct nsh_vtbl_s *bkgvtbl;
@@ -753,6 +765,25 @@ static int nsh_execute(FAR struct nsh_vtbl_s *vtbl,
           nsh_redirect(bkgvtbl, fd, NULL);
         }
 
+#ifdef CONFIG_NSH_PIPELINE
+      /* Or to an own copy of the pipe to the next command, closed by
+       * nsh_release() when the command completes.
+       */
+
+      else if (NSH_PIPE_OUT(vtbl))
+        {
+          fd = fcntl(vtbl->np.np_pipeout, F_DUPFD_CLOEXEC, 0);
+          if (fd < 0)
+            {
+              nsh_error(vtbl, g_fmtcmdfailed, argv[0], "fcntl", NSH_ERRNO);
+              nsh_releaseargs(args);
+              goto errout;
+            }
+
+          nsh_redirect(bkgvtbl, fd, NULL);
+        }
+#endif
+
       /* Get the execution priority of this task */
 
       ret = sched_getparam(0, &param);
@@ -820,8 +851,18 @@ static int nsh_execute(FAR struct nsh_vtbl_s *vtbl,
 
       pthread_detach(thread);
 
-      nsh_output(vtbl, "%s [%d:%d]\n", argv[0], thread,
-                 param.sched_priority);
+#ifdef CONFIG_NSH_PIPELINE
+      if (NSH_PIPE_OUT(vtbl))
+        {
+          vtbl->np.np_pipepid[vtbl->np.np_npipe++] = thread;
+        }
+      else
+#endif
+        {
+          nsh_output(vtbl, "%s [%d:%d]\n", argv[0], thread,
+                     param.sched_priority);
+          nsh_addjob(vtbl, thread);
+        }
     }
   else
 #endif
@@ -2759,6 +2800,107 @@ dynlist_free:
   return ret;
 }
 
+/****************************************************************************
+ * Name: nsh_pipeline
+ *
+ * Description:
+ *   Execute a command whose output is piped to the next command on the
+ *   command line.  The read end of the pipe is left in np_pipein for the
+ *   next command.
+ *
+ * Returned Value:
+ *   OK if the command was started (even if it failed) or ERROR if the pipe
+ *   could not be created.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_NSH_PIPELINE
+static int nsh_pipeline(FAR struct nsh_vtbl_s *vtbl, FAR char *cmdline)
+{
+  FAR struct nsh_parser_s *np = &vtbl->np;
+  int fds[2];
+
+  if (np->np_npipe >= CONFIG_NSH_PIPELINE_MAXCMDS - 1)
+    {
+      nsh_error(vtbl, g_fmttoomanyargs, "|");
+      return ERROR;
+    }
+
+  /* Both ends are close-on-exec, applications only inherit the copies on
+   * their stdin and stdout.
+   */
+
+  if (pipe2(fds, O_CLOEXEC) < 0)
+    {
+      nsh_error(vtbl, g_fmtcmdfailed, "|", "pipe", NSH_ERRNO);
+      return ERROR;
+    }
+
+  /* Like in other shells, the pipeline goes on even if the command cannot
+   * be started.  The next command then reads end-of-file.
+   */
+
+  np->np_pipeout = fds[1];
+  nsh_parse_command(vtbl, cmdline);
+  np->np_pipeout = -1;
+  close(fds[1]);
+
+  if (np->np_pipein >= 0)
+    {
+      close(np->np_pipein);
+    }
+
+  np->np_pipein = fds[0];
+  return OK;
+}
+
+/****************************************************************************
+ * Name: nsh_pipeline_end
+ *
+ * Description:
+ *   Called after the last command of the command line or before a ';'.  If
+ *   that was the last command of a pipeline, wait for the commands before
+ *   it or, if the pipeline runs in background, remember them for wait.
+ *
+ * Returned Value:
+ *   The result of the last command, ret.
+ *
+ ****************************************************************************/
+
+static int nsh_pipeline_end(FAR struct nsh_vtbl_s *vtbl, int ret)
+{
+  FAR struct nsh_parser_s *np = &vtbl->np;
+  int i;
+
+  if (np->np_pipein < 0)
+    {
+      return ret;
+    }
+
+  /* Close the read end first: a command still writing gets EPIPE if the
+   * last command exited without reading everything.
+   */
+
+  close(np->np_pipein);
+  np->np_pipein = -1;
+
+  for (i = 0; i < np->np_npipe; i++)
+    {
+      if (np->np_bg)
+        {
+          nsh_addjob(vtbl, np->np_pipepid[i]);
+        }
+      else
+        {
+          nsh_waitpid(np->np_pipepid[i]);
+        }
+    }
+
+  np->np_npipe = 0;
+  return ret;
+}
+#endif
+
 /****************************************************************************
  * Public Functions
  ****************************************************************************/
@@ -2769,7 +2911,8 @@ dynlist_free:
  * Description:
  *   This function parses and executes the line of text received from the
  *   user.  This may consist of one or more NSH commands.  Multiple NSH
- *   commands are separated by semi-colons.
+ *   commands are separated by semi-colons.  With CONFIG_NSH_PIPELINE the
+ *   output of a command can be piped to the next one with '|'.
  *
  ****************************************************************************/
 
@@ -2825,7 +2968,11 @@ int nsh_parse(FAR struct nsh_vtbl_s *vtbl, FAR char *cmdline)
         {
           /* Parse the last command on the line */
 
+#ifdef CONFIG_NSH_PIPELINE
+          return nsh_pipeline_end(vtbl, nsh_parse_command(vtbl, start));
+#else
           return nsh_parse_command(vtbl, start);
+#endif
         }
 
       /* Check for a command terminated with ';'.  There is probably another
@@ -2841,6 +2988,9 @@ int nsh_parse(FAR struct nsh_vtbl_s *vtbl, FAR char *cmdline)
           /* Parse this command */
 
           ret = nsh_parse_command(vtbl, start);
+#ifdef CONFIG_NSH_PIPELINE
+          ret = nsh_pipeline_end(vtbl, ret);
+#endif
           if (ret != OK)
             {
               /* nsh_parse_command may return (1) -1 (ERROR) meaning that the
@@ -2858,6 +3008,24 @@ int nsh_parse(FAR struct nsh_vtbl_s *vtbl, FAR char *cmdline)
           working = ptr;
         }
 
+#ifdef CONFIG_NSH_PIPELINE
+      /* Check for a command whose output goes to the next command */
+
+      else if (*ptr == '|')
+        {
+          *ptr++ = '\0';
+
+          ret = nsh_pipeline(vtbl, start);
+          if (ret != OK)
+            {
+              return nsh_pipeline_end(vtbl, ret);
+            }
+
+          start   = ptr;
+          working = ptr;
+        }
+#endif
+
       /* Check if we encountered a quoted string */
 
       else /* if (*ptr == '"' || *ptr == '\'') */
@@ -2878,7 +3046,11 @@ int nsh_parse(FAR struct nsh_vtbl_s *vtbl, FAR char *cmdline)
               nsh_error(vtbl, g_fmtnomatching, qterm, qterm);
 #endif
 
+#ifdef CONFIG_NSH_PIPELINE
+              return nsh_pipeline_end(vtbl, ERROR);
+#else
               return ERROR;
+#endif
             }
 
           /* Otherwise, continue parsing after the closing quotation mark */
@@ -2888,9 +3060,13 @@ int nsh_parse(FAR struct nsh_vtbl_s *vtbl, FAR char *cmdline)
     }
 
 #ifndef CONFIG_NSH_DISABLESCRIPT
+#ifdef CONFIG_NSH_PIPELINE
+  return nsh_pipeline_end(vtbl, OK);
+#else
   return OK;
 #endif
 #endif
+#endif
 }
 
 /****************************************************************************
@@ -35,6 +35,7 @@
 #include <signal.h>
 #include <sys/sysinfo.h>
 #include <sys/param.h>
+#include <sys/wait.h>
 #include <time.h>
 
 #include "nsh.h"
@@ -68,6 +69,10 @@
 #  endif
 #endif
 
+/* Poll interval for commands that waitpid() cannot wait for */
+
+#define NSH_WAIT_POLL_USEC (10 * 1000)
+
 /****************************************************************************
  * Private Types
  ****************************************************************************/
@@ -589,6 +594,81 @@ static int ps_callback(FAR struct nsh_vtbl_s *vtbl, FAR const char *dirpath,
  * Public Functions
  ****************************************************************************/
 
+/****************************************************************************
+ * Name: nsh_waitpid
+ *
+ * Description:
+ *   Wait for a background command or a command of a pipeline to exit.
+ *   NSH commands run on a thread and tasks whose exit status was not
+ *   retained cannot be waited for with waitpid(), these are polled until
+ *   they no longer exist.
+ *
+ * Returned Value:
+ *   0 (OK) if the command exited successfully or its exit status is not
+ *   known, 1 if it returned failure exit status and -1 (ERROR) if the wait
+ *   was interrupted by a signal.
+ *
+ ****************************************************************************/
+
+#if defined(CONFIG_NSH_PIPELINE) || !defined(CONFIG_NSH_DISABLE_WAIT)
+int nsh_waitpid(pid_t pid)
+{
+#ifdef CONFIG_SCHED_WAITPID
+  int rc = 0;
+
+  if (waitpid(pid, &rc, 0) >= 0)
+    {
+      return rc == 0 ? OK : 1;
+    }
+
+  if (errno != ECHILD)
+    {
+      return ERROR;
+    }
+#endif
+
+  while (kill(pid, 0) == 0)
+    {
+      if (usleep(NSH_WAIT_POLL_USEC) < 0 && errno == EINTR)
+        {
+          return ERROR;
+        }
+    }
+
+  return OK;
+}
+#endif
+
+/****************************************************************************
+ * Name: nsh_addjob
+ *
+ * Description:
+ *   Remember a command started in background for the wait command.  The
+ *   slot of a command that already exited is reused, if there is none the
+ *   oldest command is forgotten.
+ *
+ ****************************************************************************/
+
+#ifndef CONFIG_NSH_DISABLE_WAIT
+void nsh_addjob(FAR struct nsh_vtbl_s *vtbl, pid_t pid)
+{
+  FAR pid_t *jobs = vtbl->np.np_jobs;
+  int i;
+
+  for (i = 0; i < NSH_MAX_JOBS; i++)
+    {
+      if (jobs[i] <= 0 || kill(jobs[i], 0) < 0)
+        {
+          jobs[i] = pid;
+          return;
+        }
+    }
+
+  memmove(jobs, &jobs[1], (NSH_MAX_JOBS - 1) * sizeof(pid_t));
+  jobs[NSH_MAX_JOBS - 1] = pid;
+}
+#endif
+
 /****************************************************************************
  * Name: cmd_exec
  ****************************************************************************/
@@ -959,3 +1039,71 @@ int cmd_uptime(FAR struct nsh_vtbl_s *vtbl, int argc, FAR char **argv)
   return OK;
 }
 #endif
+
+/****************************************************************************
+ * Name: cmd_wait
+ ****************************************************************************/
+
+#ifndef CONFIG_NSH_DISABLE_WAIT
+int cmd_wait(FAR struct nsh_vtbl_s *vtbl, int argc, FAR char **argv)
+{
+  FAR pid_t *jobs = vtbl->np.np_jobs;
+  FAR char *endptr;
+  long pid;
+  int ret = OK;
+  int i;
+  int j;
+
+  /* With no arguments wait for all background commands */
+
+  if (argc == 1)
+    {
+      for (i = 0; i < NSH_MAX_JOBS; i++)
+        {
+          if (jobs[i] > 0)
+            {
+              if (nsh_waitpid(jobs[i]) < 0)
+                {
+                  nsh_error(vtbl, g_fmtsignalrecvd, argv[0]);
+                  return ERROR;
+                }
+
+              jobs[i] = 0;
+            }
+        }
+
+      return OK;
+    }
+
+  /* Otherwise wait for each given command, the exit status is the one of
+   * the last command.
+   */
+
+  for (i = 1; i < argc; i++)
+    {
+      pid = strtol(argv[i], &endptr, 0);
+      if (pid <= 0 || endptr == argv[i] || *endptr != '\0')
+        {
+          nsh_error(vtbl, g_fmtarginvalid, argv[0]);
+          return ERROR;
+        }
+
+      ret = nsh_waitpid((pid_t)pid);
+      if (ret < 0)
+        {
+          nsh_error(vtbl, g_fmtsignalrecvd, argv[0]);
+          return ERROR;
+        }
+
+      for (j = 0; j < NSH_MAX_JOBS; j++)
+        {
+          if (jobs[j] == pid)
+            {
+              jobs[j] = 0;
+            }
+        }
+    }
+
+  return ret == OK ? OK : ERROR;
+}
+#endif
@@ -44,6 +44,8 @@
 
 #define ORB_MAX_PRINT_NAME 32
 #define ORB_TOP_WAIT_TIME  1000
+#define ORB_BATCH_SAMPLES  32
+#define ORB_INDEX_SIZE     64 /* Buckets of the object index, power of 2 */
 
 /****************************************************************************
  * Private Types
@@ -52,16 +54,24 @@
 struct listen_object_s
 {
   struct list_node  node;         /* Node of object info list */
+  struct list_node  hnode;        /* Node of object index bucket */
   struct orb_object object;       /* Object id */
   orb_abstime       timestamp;    /* Time of lastest generation  */
   unsigned long     generation;   /* Latest generation */
+  unsigned          refresh;      /* Last refresh the object was seen */
+  int               fd;           /* Node opened to query state, kept
+                                   * open across refreshes
+                                   */
 };
 
 /****************************************************************************
  * Private Function Prototypes
  ****************************************************************************/
 
-static int listener_get_state(FAR struct orb_object *object,
+static unsigned listener_hash(FAR const char *name, int instance);
+static FAR struct listen_object_s *
+listener_find_object(FAR const char *name, int instance);
+static int listener_get_state(FAR struct listen_object_s *object,
                               FAR struct orb_state *state);
 static int listener_add_object(FAR struct list_node *objlist,
                                FAR struct orb_object *object);
@@ -71,7 +81,7 @@ static int listener_generate_object_list(FAR struct list_node *objlist,
 static int listener_print(FAR const struct orb_metadata *meta, int fd);
 static void listener_monitor(FAR struct list_node *objlist, int nb_objects,
                              float topic_rate, int topic_latency,
-                             int nb_msgs, int timeout);
+                             int nb_msgs, int timeout, bool measure);
 static int listener_update(FAR struct list_node *objlist,
                            FAR struct orb_object *object);
 static void listener_top(FAR struct list_node *objlist,
@@ -84,6 +94,15 @@ static void listener_top(FAR struct list_node *objlist,
 
 static bool g_should_exit = false;
 
+/* Index of the object list by name and instance, so refreshing the list
+ * costs one hash lookup per node instead of a list scan, a metadata
+ * lookup and an open() / close() per topic.
+ */
+
+static struct list_node g_object_index[ORB_INDEX_SIZE];
+static unsigned g_refresh;
+static size_t g_nobjects;
+
 /****************************************************************************
  * Private Functions
  ****************************************************************************/
@@ -119,11 +138,72 @@ listener <command> [arguments...]\n\
 \t[-b <val> ]  Subscription maximum report latency in us(unlimited if 0),\n\
 \t             default: 0\n\
 \t[-t <val> ]  Time of listener, in seconds, default: 5\n\
+\t[-m       ]  Measure rate and lost samples instead of printing\n\
 \t[-T       ]  Top, continuously print updating objects\n\
 \t[-l       ]  Top only execute once.\n\
   ");
 }
 
+/****************************************************************************
+ * Name: listener_hash
+ *
+ * Description:
+ *   Hash an object name and instance into an index bucket.
+ *
+ * Input Parameters:
+ *   name       Object name without instance.
+ *   instance   Object instance.
+ *
+ * Returned Value:
+ *   Bucket number.
+ ****************************************************************************/
+
+static unsigned listener_hash(FAR const char *name, int instance)
+{
+  unsigned hash = 5381;
+
+  while (*name)
+    {
+      hash = hash * 33 + (unsigned char)*name++;
+    }
+
+  hash = hash * 33 + instance;
+  return hash & (ORB_INDEX_SIZE - 1);
+}
+
+/****************************************************************************
+ * Name: listener_find_object
+ *
+ * Description:
+ *   Find an object of the list through the index.
+ *
+ * Input Parameters:
+ *   name       Object name without instance.
+ *   instance   Object instance.
+ *
+ * Returned Value:
+ *   The object, NULL if it isn't in the list.
+ ****************************************************************************/
+
+static FAR struct listen_object_s *
+listener_find_object(FAR const char *name, int instance)
+{
+  FAR struct list_node *bucket;
+  FAR struct listen_object_s *tmp;
+
+  bucket = &g_object_index[listener_hash(name, instance)];
+  list_for_every_entry(bucket, tmp, struct listen_object_s, hnode)
+    {
+      if (tmp->object.instance == instance &&
+          !strcmp(tmp->object.meta->o_name, name))
+        {
+          return tmp;
+        }
+    }
+
+  return NULL;
+}
+
 /****************************************************************************
  * Name: listener_get_state
  *
@@ -138,21 +218,20 @@ listener <command> [arguments...]\n\
  *   0 on success, otherwise negative errno.
  ****************************************************************************/
 
-static int listener_get_state(FAR struct orb_object *object,
+static int listener_get_state(FAR struct listen_object_s *object,
                               FAR struct orb_state *state)
 {
-  int ret;
-  int fd;
-
-  fd = orb_open(object->meta->o_name, object->instance, 0);
-  if (fd < 0)
+  if (object->fd < 0)
     {
-      return fd;
+      object->fd = orb_open(object->object.meta->o_name,
+                            object->object.instance, 0);
+      if (object->fd < 0)
+        {
+          return object->fd;
+        }
     }
 
-  ret = orb_get_state(fd, state);
-  orb_close(fd);
-  return ret;
+  return orb_get_state(object->fd, state);
 }
 
 /****************************************************************************
@@ -182,12 +261,19 @@ static int listener_add_object(FAR struct list_node *objlist,
       return -ENOMEM;
     }
 
-  ret = listener_get_state(object, &state);
   tmp->object.meta     = object->meta;
   tmp->object.instance = object->instance;
+  tmp->refresh         = g_refresh;
+  tmp->fd              = -1;
+
+  ret = listener_get_state(tmp, &state);
   tmp->timestamp       = orb_absolute_time();
   tmp->generation      = ret < 0 ? 0 : state.generation;
   list_add_tail(objlist, &tmp->node);
+  list_add_tail(&g_object_index[listener_hash(object->meta->o_name,
+                                              object->instance)],
+                &tmp->hnode);
+  g_nobjects++;
   return 0;
 }
 
@@ -208,22 +294,12 @@ static int listener_add_object(FAR struct list_node *objlist,
 static int listener_update(FAR struct list_node *objlist,
                            FAR struct orb_object *object)
 {
-  FAR struct listen_object_s *old = NULL;
-  FAR struct listen_object_s *tmp;
+  FAR struct listen_object_s *old;
   int ret;
 
   /* Check wether object already exist in old list */
 
-  list_for_every_entry(objlist, tmp, struct listen_object_s, node)
-    {
-      if (tmp->object.meta == object->meta &&
-          tmp->object.instance == object->instance)
-        {
-          old = tmp;
-          break;
-        }
-    }
-
+  old = listener_find_object(object->meta->o_name, object->instance);
   if (old)
     {
       /* If object existed in old list, print and update. */
@@ -233,8 +309,9 @@ static int listener_update(FAR struct list_node *objlist,
       unsigned long delta_time;
       unsigned long delta_generation;
 
+      old->refresh = g_refresh;
       now_time = orb_absolute_time();
-      ret = listener_get_state(object, &state);
+      ret = listener_get_state(old, &state);
       if (ret < 0)
         {
           return ret;
@@ -296,10 +373,53 @@ static void listener_delete_object_list(FAR struct list_node *objlist)
   list_for_every_entry_safe(objlist, tmp, next, struct listen_object_s, node)
     {
       list_delete(&tmp->node);
+      list_delete(&tmp->hnode);
+      if (tmp->fd >= 0)
+        {
+          orb_close(tmp->fd);
+        }
+
       free(tmp);
     }
 
   list_initialize(objlist);
+  g_nobjects = 0;
+}
+
+/****************************************************************************
+ * Name: listener_prune_object_list
+ *
+ * Description:
+ *   Free objects that were not seen by the latest refresh, their node is
+ *   gone.
+ *
+ * Input Parameters:
+ *   objlist    List to prune.
+ *
+ * Returned Value:
+ *   None.
+ ****************************************************************************/
+
+static void listener_prune_object_list(FAR struct list_node *objlist)
+{
+  FAR struct listen_object_s *tmp;
+  FAR struct listen_object_s *next;
+
+  list_for_every_entry_safe(objlist, tmp, next, struct listen_object_s, node)
+    {
+      if (tmp->refresh != g_refresh)
+        {
+          list_delete(&tmp->node);
+          list_delete(&tmp->hnode);
+          if (tmp->fd >= 0)
+            {
+              orb_close(tmp->fd);
+            }
+
+          free(tmp);
+          g_nobjects--;
+        }
+    }
 }
 
 /****************************************************************************
@@ -320,6 +440,7 @@ static void listener_delete_object_list(FAR struct list_node *objlist)
 static int listener_generate_object_list(FAR struct list_node *objlist,
                                          FAR const char *filter)
 {
+  FAR struct listen_object_s *known;
   FAR struct dirent *entry;
   struct orb_object object;
   char name[ORB_PATH_MAX];
@@ -327,6 +448,8 @@ static int listener_generate_object_list(FAR struct list_node *objlist,
   size_t len;
   int cnt = 0;
 
+  g_refresh++;
+
   /* First traverse all objects in filter */
 
   if (filter)
@@ -422,7 +545,13 @@ static int listener_generate_object_list(FAR struct list_node *objlist,
             }
         }
 
-      object.meta = orb_get_meta(entry->d_name);
+      /* Known objects reuse their metadata, only new nodes need the
+       * full metadata lookup.
+       */
+
+      known = listener_find_object(name, object.instance);
+      object.meta = known ? known->object.meta : orb_get_meta(entry->d_name);
+
       if (!object.meta)
         {
           continue;
@@ -440,6 +569,7 @@ static int listener_generate_object_list(FAR struct list_node *objlist,
     }
 
   closedir(dir);
+  listener_prune_object_list(objlist);
   return cnt;
 }
 
@@ -486,6 +616,8 @@ static int listener_print(FAR const struct orb_metadata *meta, int fd)
  *   topic_latency  Subscribe report latency.
  *   nb_msgs        Subscribe amount of messages.
  *   timeout        Maximum poll waiting time , ms.
+ *   measure        Drain queued messages in batches without printing
+ *                  them, then report rate and lost messages.
  *
  * Returned Value:
  *   None
@@ -493,11 +625,15 @@ static int listener_print(FAR const struct orb_metadata *meta, int fd)
 
 static void listener_monitor(FAR struct list_node *objlist, int nb_objects,
                              float topic_rate, int topic_latency,
-                             int nb_msgs, int timeout)
+                             int nb_msgs, int timeout, bool measure)
 {
+  FAR struct orb_batch_s *batches = NULL;
+  FAR struct listen_object_s **objs;
   FAR struct pollfd *fds;
   FAR int *recv_msgs;
+  FAR void *buffer = NULL;
   float interval = topic_rate ? (1000000 / topic_rate) : 0;
+  orb_abstime start = orb_absolute_time();
   int nb_recv_msgs = 0;
   int i = 0;
 
@@ -510,23 +646,55 @@ static void listener_monitor(FAR struct list_node *objlist, int nb_objects,
     }
 
   recv_msgs = calloc(nb_objects, sizeof(int));
-  if (!recv_msgs)
+  objs      = malloc(nb_objects * sizeof(FAR struct listen_object_s *));
+  if (!recv_msgs || !objs)
     {
+      free(recv_msgs);
+      free(objs);
       free(fds);
       return;
     }
 
-  /* Prepare pollfd for all objects */
+  if (measure && nb_msgs != 1)
+    {
+      size_t size = 0;
+
+      list_for_every_entry(objlist, tmp, struct listen_object_s, node)
+        {
+          if (tmp->object.meta->o_size > size)
+            {
+              size = tmp->object.meta->o_size;
+            }
+        }
+
+      batches = calloc(nb_objects, sizeof(struct orb_batch_s));
+      buffer  = malloc(size * ORB_BATCH_SAMPLES);
+      if (!batches || !buffer)
+        {
+          free(batches);
+          free(buffer);
+          free(objs);
+          free(fds);
+          free(recv_msgs);
+          return;
+        }
+    }
+
+  /* Prepare pollfd for all objects, objs maps a pollfd back to its object
+   * so events are dispatched without walking the object list.
+   */
 
   list_for_every_entry(objlist, tmp, struct listen_object_s, node)
     {
       int fd;
 
+      objs[i] = tmp;
       fd = orb_subscribe_multi(tmp->object.meta, tmp->object.instance);
       if (fd < 0)
         {
           fds[i].fd     = -1;
           fds[i].events = 0;
+          i++;
           continue;
         }
       else
@@ -555,6 +723,7 @@ static void listener_monitor(FAR struct list_node *objlist, int nb_objects,
 
   if (nb_msgs == 1)
     {
+      free(objs);
       free(fds);
       free(recv_msgs);
       return;
@@ -566,10 +735,28 @@ static void listener_monitor(FAR struct list_node *objlist, int nb_objects,
     {
       if (poll(&fds[0], nb_objects, timeout * 1000) > 0)
         {
-          i = 0;
-          list_for_every_entry(objlist, tmp, struct listen_object_s, node)
+          for (i = 0; i < nb_objects; i++)
             {
-              if (fds[i].revents & POLLIN)
+              tmp = objs[i];
+              if ((fds[i].revents & POLLIN) && measure)
+                {
+                  ssize_t ret;
+
+                  ret = orb_copy_batch(tmp->object.meta, fds[i].fd,
+                                       buffer, ORB_BATCH_SAMPLES, NULL,
+                                       &batches[i]);
+                  if (ret > 0)
+                    {
+                      nb_recv_msgs += ret;
+                      recv_msgs[i] += ret;
+                    }
+
+                  if (nb_msgs && nb_recv_msgs >= nb_msgs)
+                    {
+                      break;
+                    }
+                }
+              else if (fds[i].revents & POLLIN)
                 {
                   nb_recv_msgs++;
                   recv_msgs[i]++;
@@ -583,8 +770,6 @@ static void listener_monitor(FAR struct list_node *objlist, int nb_objects,
                       break;
                     }
                 }
-
-              i++;
             }
         }
       else if (errno != EINTR)
@@ -611,9 +796,23 @@ static void listener_monitor(FAR struct list_node *objlist, int nb_objects,
             }
 
           orb_unsubscribe(fds[i].fd);
-          uorbinfo_raw("Object name:%s%d, recieved:%d",
-                       tmp->object.meta->o_name, tmp->object.instance,
-                       recv_msgs[i]);
+          if (measure)
+            {
+              orb_abstime delta = orb_absolute_time() - start;
+
+              uorbinfo_raw("Object name:%s%d, recieved:%d, rate:%.1fHz, "
+                           "lost:%" PRIu32,
+                           tmp->object.meta->o_name, tmp->object.instance,
+                           recv_msgs[i],
+                           delta ? recv_msgs[i] * 1000000.0f / delta : 0,
+                           batches[i].lost);
+            }
+          else
+            {
+              uorbinfo_raw("Object name:%s%d, recieved:%d",
+                           tmp->object.meta->o_name, tmp->object.instance,
+                           recv_msgs[i]);
+            }
         }
 
       i++;
@@ -621,6 +820,9 @@ static void listener_monitor(FAR struct list_node *objlist, int nb_objects,
 
   uorbinfo_raw("Total number of received Message:%d/%d",
                nb_recv_msgs, nb_msgs ? nb_msgs : nb_recv_msgs);
+  free(batches);
+  free(buffer);
+  free(objs);
   free(fds);
   free(recv_msgs);
 }
@@ -675,7 +877,7 @@ static void listener_top(FAR struct list_node *objlist,
           uorbinfo_raw("\033[H"); /* move cursor to top left corner */
         }
 
-      uorbinfo_raw("\033[K" "current objects: %zu", list_length(objlist));
+      uorbinfo_raw("\033[K" "current objects: %zu", g_nobjects);
       uorbinfo_raw("\033[K" "%-*s INST #SUB RATE #Q SIZE",
                    ORB_MAX_PRINT_NAME - 2, "NAME");
 
@@ -712,6 +914,7 @@ int main(int argc, FAR char *argv[])
   int timeout       = 5;
   bool top          = false;
   bool only_once    = false;
+  bool measure      = false;
   FAR char *filter  = NULL;
   int ret;
   int ch;
@@ -724,7 +927,7 @@ int main(int argc, FAR char *argv[])
 
   /* Pasrse Argument */
 
-  while ((ch = getopt(argc, argv, "r:b:n:t:Tlh")) != EOF)
+  while ((ch = getopt(argc, argv, "r:b:n:t:Tlmh")) != EOF)
     {
       switch (ch)
       {
@@ -768,6 +971,10 @@ int main(int argc, FAR char *argv[])
           only_once = true;
           break;
 
+        case 'm':
+          measure = true;
+          break;
+
         case 'h':
         default:
           goto error;
@@ -782,6 +989,11 @@ int main(int argc, FAR char *argv[])
   /* Alloc list and exec command */
 
   list_initialize(&objlist);
+  for (ch = 0; ch < ORB_INDEX_SIZE; ch++)
+    {
+      list_initialize(&g_object_index[ch]);
+    }
+
   ret = listener_generate_object_list(&objlist, filter);
   if (ret <= 0)
     {
@@ -803,7 +1015,7 @@ int main(int argc, FAR char *argv[])
         }
 
       listener_monitor(&objlist, ret, topic_rate, topic_latency,
-                       nb_msgs, timeout);
+                       nb_msgs, timeout, measure);
     }
 
   listener_delete_object_list(&objlist);
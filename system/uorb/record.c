@@ -0,0 +1,619 @@
+/****************************************************************************
+ * apps/system/uorb/record.c
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/compiler.h>
+
+#include <ctype.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <limits.h>
+#include <poll.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <uORB/uORB.h>
+
+#include "record.h"
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#define RECORD_MAX_TOPICS    64
+#define RECORD_BATCH_SAMPLES 16
+
+/****************************************************************************
+ * Private Types
+ ****************************************************************************/
+
+struct record_topic_info_s
+{
+  FAR const struct orb_metadata *meta;
+  int                 instance;
+  int                 fd;
+  struct orb_batch_s  batch;    /* Samples lost in the subscriber queue */
+  uint32_t            recorded; /* Samples written to the log */
+  uint32_t            dropped;  /* Samples dropped, no room in buffers */
+  uint32_t            reported; /* Drops already logged */
+};
+
+struct record_buffer_s
+{
+  FAR uint8_t *data;
+  size_t       used;
+};
+
+struct record_s
+{
+  struct record_topic_info_s topics[RECORD_MAX_TOPICS];
+  int                        ntopics;
+  int                        fd;           /* Log file */
+  struct record_buffer_s     buffers[2];   /* Double buffer */
+  int                        active;       /* Buffer being filled */
+  bool                       pending;      /* Other buffer being written */
+  bool                       stop;         /* Writer should exit */
+  int                        error;        /* Write error of the writer */
+  pthread_mutex_t            lock;
+  pthread_cond_t             cond;
+  pthread_t                  writer;
+};
+
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+static volatile bool g_should_exit;
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+static void usage(void)
+{
+  printf("Usage: uorb_record [options] <t1,t2,...>\n"
+         "Record uORB topics to a binary log at full rate.\n"
+         "  <t1,t2,...> Topic names, a trailing instance number selects\n"
+         "              one instance, otherwise instance 0 is recorded\n"
+         "  -f <file>   Log file, default: %s\n"
+         "  -r <val>    Subscription rate in Hz (unlimited if 0)\n"
+         "  -t <val>    Recording time in seconds (until Ctrl+C if 0)\n"
+         "  -h          Show this help\n",
+         CONFIG_UORB_RECORD_FILE);
+}
+
+static void exit_handler(int signo)
+{
+  g_should_exit = true;
+}
+
+/****************************************************************************
+ * Name: record_write_all
+ ****************************************************************************/
+
+static int record_write_all(int fd, FAR const void *data, size_t len)
+{
+  FAR const uint8_t *ptr = data;
+
+  while (len > 0)
+    {
+      ssize_t ret = write(fd, ptr, len);
+      if (ret < 0)
+        {
+          if (errno == EINTR)
+            {
+              continue;
+            }
+
+          return -errno;
+        }
+
+      ptr += ret;
+      len -= ret;
+    }
+
+  return 0;
+}
+
+/****************************************************************************
+ * Name: record_writer
+ *
+ * Description:
+ *   Writer thread, flushes the full buffer to the log file while the main
+ *   thread keeps filling the other one.
+ ****************************************************************************/
+
+static FAR void *record_writer(FAR void *arg)
+{
+  FAR struct record_s *rec = arg;
+  FAR struct record_buffer_s *buf;
+
+  pthread_mutex_lock(&rec->lock);
+  for (; ; )
+    {
+      while (!rec->pending && !rec->stop)
+        {
+          pthread_cond_wait(&rec->cond, &rec->lock);
+        }
+
+      if (!rec->pending)
+        {
+          break;
+        }
+
+      buf = &rec->buffers[!rec->active];
+      pthread_mutex_unlock(&rec->lock);
+
+      if (rec->error == 0)
+        {
+          rec->error = record_write_all(rec->fd, buf->data, buf->used);
+        }
+
+      pthread_mutex_lock(&rec->lock);
+      buf->used    = 0;
+      rec->pending = false;
+      pthread_cond_broadcast(&rec->cond);
+    }
+
+  pthread_mutex_unlock(&rec->lock);
+  return NULL;
+}
+
+/****************************************************************************
+ * Name: record_swap
+ *
+ * Description:
+ *   Hand the active buffer over to the writer thread and continue filling
+ *   the other one. Fails if the writer is still busy with the other
+ *   buffer, unless wait is true.
+ ****************************************************************************/
+
+static bool record_swap(FAR struct record_s *rec, bool wait)
+{
+  bool swapped = false;
+
+  pthread_mutex_lock(&rec->lock);
+  while (wait && rec->pending)
+    {
+      pthread_cond_wait(&rec->cond, &rec->lock);
+    }
+
+  if (!rec->pending)
+    {
+      rec->active  = !rec->active;
+      rec->pending = true;
+      swapped      = true;
+      pthread_cond_broadcast(&rec->cond);
+    }
+
+  pthread_mutex_unlock(&rec->lock);
+  return swapped;
+}
+
+/****************************************************************************
+ * Name: record_reserve
+ *
+ * Description:
+ *   Reserve len bytes in the active buffer, swapping buffers if it is
+ *   full. Returns NULL if both buffers are full or the record is larger
+ *   than a buffer, the caller then drops the record instead of blocking
+ *   the subscriptions.
+ ****************************************************************************/
+
+static FAR uint8_t *record_reserve(FAR struct record_s *rec, size_t len)
+{
+  FAR struct record_buffer_s *buf = &rec->buffers[rec->active];
+  FAR uint8_t *ptr;
+
+  /* A record that does not even fit an empty buffer is always dropped */
+
+  if (len > CONFIG_UORB_RECORD_BUFSIZE)
+    {
+      return NULL;
+    }
+
+  if (buf->used + len > CONFIG_UORB_RECORD_BUFSIZE)
+    {
+      if (!record_swap(rec, false))
+        {
+          return NULL;
+        }
+
+      buf = &rec->buffers[rec->active];
+    }
+
+  ptr = buf->data + buf->used;
+  buf->used += len;
+  return ptr;
+}
+
+/****************************************************************************
+ * Name: record_add_topics
+ ****************************************************************************/
+
+static int record_add_topics(FAR struct record_s *rec,
+                             FAR const char *filter)
+{
+  char name[ORB_PATH_MAX];
+  FAR const char *member = filter;
+  FAR const char *tmp;
+  size_t digits;
+  size_t len;
+
+  do
+    {
+      FAR struct record_topic_info_s *topic;
+
+      while (*member == ',')
+        {
+          member++;
+        }
+
+      tmp = strchr(member, ',');
+      len = tmp ? tmp - member : strlen(member);
+      if (len == 0)
+        {
+          break;
+        }
+
+      if (len >= sizeof(name) || rec->ntopics >= RECORD_MAX_TOPICS)
+        {
+          return -EINVAL;
+        }
+
+      strlcpy(name, member, len + 1);
+      member = tmp;
+
+      topic = &rec->topics[rec->ntopics];
+      topic->meta = orb_get_meta(name);
+      if (topic->meta == NULL)
+        {
+          printf("uorb_record: unknown topic %s\n", name);
+          return -ENOENT;
+        }
+
+      /* All trailing digits are the instance number */
+
+      digits = len;
+      while (digits > 0 && isdigit(name[digits - 1]))
+        {
+          digits--;
+        }
+
+      topic->instance = digits < len ? strtoul(&name[digits], NULL, 10) : 0;
+      topic->fd = orb_subscribe_multi(topic->meta, topic->instance);
+      if (topic->fd < 0)
+        {
+          printf("uorb_record: subscribe %s failed %d\n", name, errno);
+          return -errno;
+        }
+
+      rec->ntopics++;
+    }
+  while (tmp);
+
+  return rec->ntopics > 0 ? 0 : -EINVAL;
+}
+
+/****************************************************************************
+ * Name: record_write_header
+ ****************************************************************************/
+
+static int record_write_header(FAR struct record_s *rec)
+{
+  struct record_header_s header;
+  int ret;
+  int i;
+
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, RECORD_MAGIC, sizeof(RECORD_MAGIC));
+  header.version = RECORD_VERSION;
+  header.ntopics = rec->ntopics;
+  header.start   = orb_absolute_time();
+
+  ret = record_write_all(rec->fd, &header, sizeof(header));
+
+  for (i = 0; ret == 0 && i < rec->ntopics; i++)
+    {
+      FAR struct record_topic_info_s *topic = &rec->topics[i];
+      struct record_topic_s info;
+
+      info.type     = RECORD_TYPE_TOPIC;
+      info.id       = i;
+      info.size     = topic->meta->o_size;
+      info.instance = topic->instance;
+      info.namelen  = strlen(topic->meta->o_name);
+
+      ret = record_write_all(rec->fd, &info, sizeof(info));
+      if (ret == 0)
+        {
+          ret = record_write_all(rec->fd, topic->meta->o_name,
+                                 info.namelen);
+        }
+    }
+
+  return ret;
+}
+
+/****************************************************************************
+ * Name: record_topic
+ *
+ * Description:
+ *   Drain the queue of one topic into the active buffer.
+ ****************************************************************************/
+
+static void record_topic(FAR struct record_s *rec, int id,
+                         FAR uint8_t *scratch)
+{
+  FAR struct record_topic_info_s *topic = &rec->topics[id];
+  FAR struct record_data_s *data;
+  size_t size = topic->meta->o_size;
+  ssize_t nsamples;
+  ssize_t i;
+
+  do
+    {
+      nsamples = orb_copy_batch(topic->meta, topic->fd, scratch,
+                                RECORD_BATCH_SAMPLES, NULL, &topic->batch);
+      for (i = 0; i < nsamples; i++)
+        {
+          data = (FAR struct record_data_s *)
+                 record_reserve(rec, sizeof(*data) + size);
+          if (data == NULL)
+            {
+              topic->dropped++;
+              continue;
+            }
+
+          data->type = RECORD_TYPE_DATA;
+          data->id   = id;
+          data->size = size;
+          memcpy(data + 1, scratch + i * size, size);
+          topic->recorded++;
+        }
+    }
+  while (nsamples == RECORD_BATCH_SAMPLES);
+
+  /* Log the drops, so the decoder can tell gaps from quiet topics */
+
+  if (topic->dropped + topic->batch.lost != topic->reported)
+    {
+      uint32_t count = topic->dropped + topic->batch.lost;
+
+      data = (FAR struct record_data_s *)
+             record_reserve(rec, sizeof(*data) + sizeof(count));
+      if (data != NULL)
+        {
+          data->type = RECORD_TYPE_DROPPED;
+          data->id   = id;
+          data->size = sizeof(count);
+          memcpy(data + 1, &count, sizeof(count));
+          topic->reported = count;
+        }
+    }
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+int main(int argc, FAR char *argv[])
+{
+  FAR const char *file = CONFIG_UORB_RECORD_FILE;
+  FAR struct record_s *rec;
+  FAR struct pollfd *fds;
+  FAR uint8_t *scratch;
+  orb_abstime start;
+  size_t size = 0;
+  float rate = 0;
+  int duration = 0;
+  int ret = -ENOMEM;
+  int ch;
+  int i;
+
+  while ((ch = getopt(argc, argv, "f:r:t:h")) != EOF)
+    {
+      switch (ch)
+        {
+          case 'f':
+            file = optarg;
+            break;
+
+          case 'r':
+            rate = atof(optarg);
+            break;
+
+          case 't':
+            duration = strtol(optarg, NULL, 0);
+            break;
+
+          case 'h':
+          default:
+            usage();
+            return 1;
+        }
+    }
+
+  if (optind >= argc)
+    {
+      usage();
+      return 1;
+    }
+
+  rec = zalloc(sizeof(struct record_s));
+  if (rec == NULL)
+    {
+      return 1;
+    }
+
+  rec->fd = -1;
+  fds     = NULL;
+  scratch = NULL;
+
+  ret = record_add_topics(rec, argv[optind]);
+  if (ret < 0)
+    {
+      goto out;
+    }
+
+  fds = malloc(rec->ntopics * sizeof(struct pollfd));
+  if (fds == NULL)
+    {
+      ret = -ENOMEM;
+      goto out;
+    }
+
+  for (i = 0; i < rec->ntopics; i++)
+    {
+      if (rec->topics[i].meta->o_size > size)
+        {
+          size = rec->topics[i].meta->o_size;
+        }
+
+      if (rate > 0)
+        {
+          orb_set_frequency(rec->topics[i].fd, rate);
+        }
+
+      fds[i].fd     = rec->topics[i].fd;
+      fds[i].events = POLLIN;
+    }
+
+  scratch = malloc(size * RECORD_BATCH_SAMPLES);
+  rec->buffers[0].data = malloc(CONFIG_UORB_RECORD_BUFSIZE);
+  rec->buffers[1].data = malloc(CONFIG_UORB_RECORD_BUFSIZE);
+  if (scratch == NULL || rec->buffers[0].data == NULL ||
+      rec->buffers[1].data == NULL)
+    {
+      ret = -ENOMEM;
+      goto out;
+    }
+
+  rec->fd = open(file, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0666);
+  if (rec->fd < 0)
+    {
+      ret = -errno;
+      printf("uorb_record: open %s failed %d\n", file, ret);
+      goto out;
+    }
+
+  ret = record_write_header(rec);
+  if (ret < 0)
+    {
+      goto out;
+    }
+
+  pthread_mutex_init(&rec->lock, NULL);
+  pthread_cond_init(&rec->cond, NULL);
+  ret = pthread_create(&rec->writer, NULL, record_writer, rec);
+  if (ret != 0)
+    {
+      ret = -ret;
+      goto out_sync;
+    }
+
+  g_should_exit = false;
+  signal(SIGINT, exit_handler);
+
+  printf("uorb_record: recording %d topics to %s\n", rec->ntopics, file);
+
+  start = orb_absolute_time();
+  while (!g_should_exit && rec->error == 0)
+    {
+      if (duration > 0 &&
+          orb_absolute_time() - start >= duration * 1000000ull)
+        {
+          break;
+        }
+
+      ret = poll(fds, rec->ntopics, 1000);
+      if (ret < 0 && errno != EINTR)
+        {
+          break;
+        }
+
+      for (i = 0; ret > 0 && i < rec->ntopics; i++)
+        {
+          if (fds[i].revents & POLLIN)
+            {
+              record_topic(rec, i, scratch);
+            }
+        }
+    }
+
+  /* Flush what is left in the active buffer */
+
+  if (rec->buffers[rec->active].used > 0)
+    {
+      record_swap(rec, true);
+    }
+
+  pthread_mutex_lock(&rec->lock);
+  rec->stop = true;
+  pthread_cond_broadcast(&rec->cond);
+  pthread_mutex_unlock(&rec->lock);
+  pthread_join(rec->writer, NULL);
+
+  for (i = 0; i < rec->ntopics; i++)
+    {
+      FAR struct record_topic_info_s *topic = &rec->topics[i];
+
+      printf("%s%d: recorded %" PRIu32 ", lost %" PRIu32
+             ", dropped %" PRIu32 "\n",
+             topic->meta->o_name, topic->instance, topic->recorded,
+             topic->batch.lost, topic->dropped);
+    }
+
+  ret = rec->error;
+  if (ret < 0)
+    {
+      printf("uorb_record: write failed %d\n", ret);
+    }
+
+out_sync:
+  pthread_cond_destroy(&rec->cond);
+  pthread_mutex_destroy(&rec->lock);
+
+out:
+  if (rec->fd >= 0)
+    {
+      close(rec->fd);
+    }
+
+  for (i = 0; i < rec->ntopics; i++)
+    {
+      orb_unsubscribe(rec->topics[i].fd);
+    }
+
+  free(rec->buffers[0].data);
+  free(rec->buffers[1].data);
+  free(scratch);
+  free(fds);
+  free(rec);
+  return ret < 0 ? 1 : 0;
+}
@@ -0,0 +1,83 @@
+/****************************************************************************
+ * apps/system/uorb/record.h
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one or more
+ * contributor license agreements.  See the NOTICE file distributed with
+ * this work for additional information regarding copyright ownership.  The
+ * ASF licenses this file to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance with the
+ * License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+ * License for the specific language governing permissions and limitations
+ * under the License.
+ *
+ ****************************************************************************/
+
+#ifndef __APP_SYSTEM_UORB_RECORD_H
+#define __APP_SYSTEM_UORB_RECORD_H
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/compiler.h>
+
+#include <stdint.h>
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+/* Log layout of uorb_record, all fields in target byte order:
+ *
+ *   struct record_header_s                    File header
+ *   struct record_topic_s + name              One per recorded topic
+ *   struct record_data_s + sample             One per recorded sample
+ *   struct record_data_s + uint32_t count     Dropped samples of a topic
+ *
+ * The sample is stored raw, its leading orb_abstime is the timestamp.
+ * uorb_decode.py in this directory decodes the log on the host.
+ */
+
+#define RECORD_MAGIC         "UORBLOG"
+#define RECORD_VERSION       1
+
+#define RECORD_TYPE_TOPIC    'T'
+#define RECORD_TYPE_DATA     'D'
+#define RECORD_TYPE_DROPPED  'L'
+
+/****************************************************************************
+ * Public Types
+ ****************************************************************************/
+
+begin_packed_struct struct record_header_s
+{
+  char     magic[8];            /* RECORD_MAGIC */
+  uint8_t  version;             /* RECORD_VERSION */
+  uint8_t  ntopics;             /* Number of topic records that follow */
+  uint16_t reserved;
+  uint64_t start;               /* orb_absolute_time() at start */
+} end_packed_struct;
+
+begin_packed_struct struct record_topic_s
+{
+  uint8_t  type;                /* RECORD_TYPE_TOPIC */
+  uint8_t  id;                  /* Topic id used by data records */
+  uint16_t size;                /* Sample size */
+  uint8_t  instance;            /* Topic instance */
+  uint8_t  namelen;             /* Length of the name that follows */
+} end_packed_struct;
+
+begin_packed_struct struct record_data_s
+{
+  uint8_t  type;                /* RECORD_TYPE_DATA / RECORD_TYPE_DROPPED */
+  uint8_t  id;                  /* Topic id */
+  uint16_t size;                /* Payload size */
+} end_packed_struct;
+
+#endif /* __APP_SYSTEM_UORB_RECORD_H */
@@ -23,17 +23,29 @@
  ****************************************************************************/
 
 #include <errno.h>
+#include <fcntl.h>
 #include <math.h>
 #include <poll.h>
+#include <spawn.h>
 #include <string.h>
 #include <stdarg.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <unistd.h>
+#include <sys/mman.h>
 #include <sys/param.h>
+#include <sys/wait.h>
 
+#include "record.h"
 #include "utility.h"
 
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#define RECORD_TEST_FILE     CONFIG_UORB_SRORAGE_DIR"/uorb_record_test.log"
+#define RECORD_TEST_SAMPLES  32
+
 /****************************************************************************
  * Private Data
  ****************************************************************************/
@@ -873,6 +885,94 @@ int test_queue(void)
   return test_note("PASS orb queuing");
 }
 
+static int test_copy_batch(void)
+{
+  const int queue_size  = 8;
+  const int overflow_by = 3;
+  struct orb_test_medium_s samples[8];
+  struct orb_test_medium_s sample;
+  struct orb_batch_s batch;
+  orb_abstime timestamps[8];
+  int instance = 0;
+  ssize_t ret;
+  int ptopic;
+  int sfd;
+  int i;
+
+  test_note("Testing orb batch copy");
+
+  memset(&batch, 0, sizeof(batch));
+
+  sample.timestamp = orb_absolute_time();
+  sample.val       = -1;
+  ptopic = orb_advertise_multi_queue(ORB_ID(orb_test_medium_batch),
+                                     &sample, &instance, queue_size);
+  if (ptopic < 0)
+    {
+      return test_fail("advertise failed: %d", errno);
+    }
+
+  sfd = orb_subscribe(ORB_ID(orb_test_medium_batch));
+  if (sfd < 0)
+    {
+      return test_fail("subscribe failed: %d", errno);
+    }
+
+  /* Drain the initial sample, this starts the overrun accounting */
+
+  ret = orb_copy_batch(ORB_ID(orb_test_medium_batch), sfd, samples,
+                       queue_size, NULL, &batch);
+  if (ret < 0)
+    {
+      return test_fail("batch copy(1) failed: %d", errno);
+    }
+
+  for (i = 0; i < queue_size + overflow_by; i++)
+    {
+      sample.timestamp = orb_absolute_time();
+      sample.val       = i;
+      orb_publish(ORB_ID(orb_test_medium_batch), ptopic, &sample);
+    }
+
+  ret = orb_copy_batch(ORB_ID(orb_test_medium_batch), sfd, samples,
+                       queue_size, timestamps, &batch);
+  if (ret != queue_size)
+    {
+      return test_fail("batch copy(2) got %zd, expected %d",
+                       ret, queue_size);
+    }
+
+  for (i = 0; i < queue_size; i++)
+    {
+      if (samples[i].val != i + overflow_by ||
+          timestamps[i] != samples[i].timestamp)
+        {
+          return test_fail("batch copy(2) mismatch at %d: %d", i,
+                           samples[i].val);
+        }
+    }
+
+  /* The queue is now empty, the overrun must be accounted */
+
+  ret = orb_copy_batch(ORB_ID(orb_test_medium_batch), sfd, samples,
+                       queue_size, NULL, &batch);
+  if (ret != 0)
+    {
+      return test_fail("batch copy(3) got %zd, expected 0", ret);
+    }
+
+  if (batch.lost != overflow_by)
+    {
+      return test_fail("batch lost %" PRIu32 ", expected %d",
+                       batch.lost, overflow_by);
+    }
+
+  orb_unadvertise(ptopic);
+  orb_unsubscribe(sfd);
+
+  return test_note("PASS orb batch copy");
+}
+
 static int pub_test_queue_entry(int argc, char *argv[])
 {
   const int queue_size = 50;
@@ -1009,6 +1109,295 @@ static int test_queue_poll_notify(void)
   return OK;
 }
 
+#ifdef CONFIG_UORB_LOAN
+static int test_loan(void)
+{
+  FAR struct orb_test_medium_s *sample;
+  FAR const struct orb_test_medium_s *borrowed;
+  struct orb_test_medium_s sub_sample;
+  struct orb_state state;
+  struct orb_loan_s pub;
+  struct orb_loan_s sub;
+  uint64_t generation;
+  int instance = 0;
+  int afd;
+  int sfd;
+  int bfd;
+  int i;
+
+  test_note("Testing loaned messages");
+
+  afd = orb_advertise_multi_queue(ORB_ID(orb_test_loan), NULL,
+                                  &instance, 1);
+  if (afd < 0)
+    {
+      return test_fail("advertise failed: %d", errno);
+    }
+
+  bfd = orb_subscribe(ORB_ID(orb_test_loan));
+  if (bfd < 0)
+    {
+      return test_fail("subscribe failed: %d", errno);
+    }
+
+  if (orb_loan_init(&pub, ORB_ID(orb_test_loan), 0, afd, false) < 0 ||
+      orb_loan_init(&sub, ORB_ID(orb_test_loan), 0, bfd, true) < 0)
+    {
+      return test_fail("loan init failed: %d", errno);
+    }
+
+  if (orb_borrow(&sub) != NULL || errno != EAGAIN)
+    {
+      return test_fail("borrowed before publish");
+    }
+
+  /* With borrowers only, a loaned publish must not write to the driver */
+
+  if (orb_get_state(afd, &state) < 0)
+    {
+      return test_fail("get state failed: %d", errno);
+    }
+
+  generation = state.generation;
+
+  sample = orb_loan(&pub);
+  if (sample == NULL)
+    {
+      return test_fail("loan failed: %d", errno);
+    }
+
+  sample->timestamp = orb_absolute_time();
+  sample->val       = -1;
+
+  if (orb_publish_loaned(&pub, sample) < 0)
+    {
+      return test_fail("publish loaned failed: %d", errno);
+    }
+
+  borrowed = orb_borrow(&sub);
+  if (borrowed == NULL || borrowed->val != -1 ||
+      orb_release(&sub, borrowed) < 0)
+    {
+      return test_fail("borrow without fd subscribers failed");
+    }
+
+  if (orb_get_state(afd, &state) < 0 || state.generation != generation)
+    {
+      return test_fail("loaned publish wrote to the driver");
+    }
+
+  sfd = orb_subscribe(ORB_ID(orb_test_loan));
+  if (sfd < 0)
+    {
+      return test_fail("subscribe failed: %d", errno);
+    }
+
+  for (i = 0; i < 3; i++)
+    {
+      sample = orb_loan(&pub);
+      if (sample == NULL)
+        {
+          return test_fail("loan(%d) failed: %d", i, errno);
+        }
+
+      sample->timestamp = orb_absolute_time();
+      sample->val       = i;
+
+      if (orb_publish_loaned(&pub, sample) < 0)
+        {
+          return test_fail("publish loaned(%d) failed: %d", i, errno);
+        }
+
+      if (orb_borrow_wait(&sub, 100) < 0)
+        {
+          return test_fail("borrow wait(%d) failed: %d", i, errno);
+        }
+
+      borrowed = orb_borrow(&sub);
+      if (borrowed == NULL)
+        {
+          return test_fail("borrow(%d) failed: %d", i, errno);
+        }
+
+      if (borrowed->val != i)
+        {
+          return test_fail("borrow(%d) mismatch: %d", i, borrowed->val);
+        }
+
+      if (orb_release(&sub, borrowed) < 0)
+        {
+          return test_fail("release(%d) failed: %d", i, errno);
+        }
+
+      /* Subscribers on the fd path must still see every sample */
+
+      if (OK != orb_copy(ORB_ID(orb_test_loan), sfd, &sub_sample))
+        {
+          return test_fail("copy(%d) failed: %d", i, errno);
+        }
+
+      if (sub_sample.val != i)
+        {
+          return test_fail("copy(%d) mismatch: %d", i, sub_sample.val);
+        }
+    }
+
+  orb_loan_deinit(&sub);
+  orb_loan_deinit(&pub);
+
+  /* The last user removes the shared ring */
+
+  if (shm_open("/uorb_orb_test_loan0", O_RDONLY, 0) >= 0 ||
+      errno != ENOENT)
+    {
+      return test_fail("loan ring not unlinked");
+    }
+
+  orb_unsubscribe(bfd);
+  orb_unsubscribe(sfd);
+  orb_unadvertise(afd);
+
+  return test_note("PASS loaned messages");
+}
+#endif
+
+#if defined(CONFIG_UORB_RECORD) && defined(CONFIG_SCHED_WAITPID)
+static int test_record(void)
+{
+  FAR char *argv[] =
+    {
+      "uorb_record", "-t", "1", "-f", RECORD_TEST_FILE, "orb_test_record",
+      NULL
+    };
+
+  struct orb_test_medium_s sample;
+  struct record_header_s header;
+  struct record_topic_s topic;
+  struct record_data_s data;
+  struct orb_state state;
+  char name[ORB_PATH_MAX];
+  int instance = 0;
+  int status;
+  pid_t pid;
+  int afd;
+  int ret;
+  int fd;
+  int i;
+
+  test_note("Testing record and replay");
+
+  afd = orb_advertise_multi_queue(ORB_ID(orb_test_record), NULL,
+                                  &instance, RECORD_TEST_SAMPLES);
+  if (afd < 0)
+    {
+      return test_fail("advertise failed: %d", errno);
+    }
+
+  ret = posix_spawnp(&pid, argv[0], NULL, NULL, argv, NULL);
+  if (ret != 0)
+    {
+      return test_fail("spawn uorb_record failed: %d", ret);
+    }
+
+  /* Publish only once the recorder is subscribed */
+
+  for (i = 0; i < 100; i++)
+    {
+      if (orb_get_state(afd, &state) == 0 && state.nsubscribers > 0)
+        {
+          break;
+        }
+
+      usleep(10000);
+    }
+
+  if (i == 100)
+    {
+      return test_fail("uorb_record did not subscribe");
+    }
+
+  for (i = 0; i < RECORD_TEST_SAMPLES; i++)
+    {
+      sample.timestamp = orb_absolute_time();
+      sample.val       = i;
+
+      if (OK != orb_publish(ORB_ID(orb_test_record), afd, &sample))
+        {
+          return test_fail("publish(%d) failed: %d", i, errno);
+        }
+
+      usleep(1000);
+    }
+
+  if (waitpid(pid, &status, 0) < 0 || !WIFEXITED(status) ||
+      WEXITSTATUS(status) != 0)
+    {
+      return test_fail("uorb_record failed");
+    }
+
+  orb_unadvertise(afd);
+
+  /* Replay the log, every sample must come back once and in order */
+
+  fd = open(RECORD_TEST_FILE, O_RDONLY);
+  if (fd < 0)
+    {
+      return test_fail("open %s failed: %d", RECORD_TEST_FILE, errno);
+    }
+
+  if (read(fd, &header, sizeof(header)) != sizeof(header) ||
+      memcmp(header.magic, RECORD_MAGIC, sizeof(RECORD_MAGIC)) != 0 ||
+      header.version != RECORD_VERSION || header.ntopics != 1)
+    {
+      close(fd);
+      return test_fail("bad log header");
+    }
+
+  if (read(fd, &topic, sizeof(topic)) != sizeof(topic) ||
+      topic.type != RECORD_TYPE_TOPIC || topic.size != sizeof(sample) ||
+      topic.namelen >= sizeof(name) ||
+      read(fd, name, topic.namelen) != topic.namelen)
+    {
+      close(fd);
+      return test_fail("bad topic record");
+    }
+
+  name[topic.namelen] = '\0';
+  if (strcmp(name, "orb_test_record") != 0)
+    {
+      close(fd);
+      return test_fail("topic mismatch: %s", name);
+    }
+
+  for (i = 0; read(fd, &data, sizeof(data)) == sizeof(data); i++)
+    {
+      if (data.type != RECORD_TYPE_DATA || data.id != topic.id ||
+          data.size != sizeof(sample) ||
+          read(fd, &sample, sizeof(sample)) != sizeof(sample))
+        {
+          close(fd);
+          return test_fail("bad data record %d, type %c", i, data.type);
+        }
+
+      if (sample.val != i)
+        {
+          close(fd);
+          return test_fail("replay(%d) mismatch: %" PRId32, i, sample.val);
+        }
+    }
+
+  close(fd);
+  unlink(RECORD_TEST_FILE);
+
+  if (i != RECORD_TEST_SAMPLES)
+    {
+      return test_fail("replayed %d of %d samples", i, RECORD_TEST_SAMPLES);
+    }
+
+  return test_note("PASS record and replay");
+}
+#endif
+
 static int test(void)
 {
   int afds[4];
@@ -1057,6 +1446,28 @@ static int test(void)
       return ret;
     }
 
+  ret = test_copy_batch();
+  if (ret != OK)
+    {
+      return ret;
+    }
+
+#ifdef CONFIG_UORB_LOAN
+  ret = test_loan();
+  if (ret != OK)
+    {
+      return ret;
+    }
+#endif
+
+#if defined(CONFIG_UORB_RECORD) && defined(CONFIG_SCHED_WAITPID)
+  ret = test_record();
+  if (ret != OK)
+    {
+      return ret;
+    }
+#endif
+
   return test_queue_poll_notify();
 }
 
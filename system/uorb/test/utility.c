@@ -82,6 +82,16 @@ ORB_DEFINE(orb_test_medium_queue, struct orb_test_medium_s,
            print_orb_test_medium_msg);
 ORB_DEFINE(orb_test_medium_queue_poll, struct orb_test_medium_s,
            print_orb_test_medium_msg);
+ORB_DEFINE(orb_test_medium_batch, struct orb_test_medium_s,
+           print_orb_test_medium_msg);
+#ifdef CONFIG_UORB_LOAN
+ORB_DEFINE(orb_test_loan, struct orb_test_medium_s,
+           print_orb_test_medium_msg);
+#endif
+#ifdef CONFIG_UORB_RECORD
+ORB_DEFINE(orb_test_record, struct orb_test_medium_s,
+           print_orb_test_medium_msg);
+#endif
 ORB_DEFINE(orb_test_large, struct orb_test_large_s,
            print_orb_test_large_msg);
 
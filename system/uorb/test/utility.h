@@ -63,6 +63,13 @@ ORB_DECLARE(orb_test_medium_multi);
 ORB_DECLARE(orb_test_medium_wrap_around);
 ORB_DECLARE(orb_test_medium_queue);
 ORB_DECLARE(orb_test_medium_queue_poll);
+ORB_DECLARE(orb_test_medium_batch);
+#ifdef CONFIG_UORB_LOAN
+ORB_DECLARE(orb_test_loan);
+#endif
+#ifdef CONFIG_UORB_RECORD
+ORB_DECLARE(orb_test_record);
+#endif
 
 /****************************************************************************
  * Public Function Prototypes
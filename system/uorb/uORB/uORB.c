@@ -26,11 +26,68 @@
 #include <fcntl.h>
 #include <limits.h>
 #include <stdio.h>
+#include <string.h>
 #include <sys/ioctl.h>
 #include <unistd.h>
 
+#ifdef CONFIG_UORB_LOAN
+#  include <poll.h>
+#  include <semaphore.h>
+#  include <stdatomic.h>
+#  include <stdlib.h>
+#  include <sys/mman.h>
+#  include <time.h>
+#endif
+
 #include <uORB/uORB.h>
 
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#ifdef CONFIG_UORB_LOAN
+#  define ORB_LOAN_PATH        "/uorb_"
+#  define ORB_RING_MAGIC       0x4f524252 /* "ORBR" */
+#  define ORB_RING_NSLOTS      CONFIG_UORB_LOAN_NSLOTS
+#  define ORB_RING_ALIGN(x)    (((x) + 7) & ~7)
+
+#  if ORB_RING_NSLOTS < 2 || (ORB_RING_NSLOTS & (ORB_RING_NSLOTS - 1)) != 0
+#    error CONFIG_UORB_LOAN_NSLOTS must be a power of two of at least 2
+#  endif
+#endif
+
+/****************************************************************************
+ * Private Types
+ ****************************************************************************/
+
+#ifdef CONFIG_UORB_LOAN
+
+/* The shared ring of a topic instance is laid out as one orb_ring_s
+ * header followed by ORB_RING_NSLOTS slots. Each slot is protected by a
+ * sequence lock: the slot sequence is odd while the publisher writes the
+ * sample and 2 * (sequence + 1) once the sample is committed.
+ */
+
+struct orb_ring_s
+{
+  uint32_t    magic;            /* ORB_RING_MAGIC once initialized */
+  uint32_t    esize;            /* Aligned size of one sample */
+  uint32_t    nslots;           /* Number of slots */
+  atomic_uint head;             /* Sequence of the next committed sample */
+  atomic_uint nusers;           /* Loan handles that mapped the ring */
+  atomic_uint nborrowers;       /* Subscribers served from the ring */
+  atomic_uint nwaiters;         /* Subscribers blocked in orb_borrow_wait */
+  sem_t       sem;              /* Wakes up orb_borrow_wait() */
+};
+
+struct orb_slot_s
+{
+  atomic_uint seq;              /* Slot sequence lock */
+  uint32_t    reserved;         /* Keep the sample 8 bytes aligned */
+};
+
+#endif
+
 /****************************************************************************
  * Private Functions
  ****************************************************************************/
@@ -151,6 +208,121 @@ orb_advertise_multi_queue_flags(FAR const struct orb_metadata *meta,
   return fd;
 }
 
+#ifdef CONFIG_UORB_LOAN
+static FAR struct orb_slot_s *orb_ring_slot(FAR struct orb_ring_s *ring,
+                                            uint32_t seq)
+{
+  FAR uint8_t *base = (FAR uint8_t *)(ring + 1);
+
+  return (FAR struct orb_slot_s *)
+    (base + (seq & (ring->nslots - 1)) *
+     (sizeof(struct orb_slot_s) + ring->esize));
+}
+
+/****************************************************************************
+ * Name: orb_ring_name
+ ****************************************************************************/
+
+static void orb_ring_name(FAR const struct orb_metadata *meta, int instance,
+                          FAR char *name)
+{
+  snprintf(name, ORB_PATH_MAX, ORB_LOAN_PATH"%s%d", meta->o_name,
+           instance);
+}
+
+/****************************************************************************
+ * Name: orb_ring_map
+ *
+ * Description:
+ *   Map the shared ring of a topic instance, creating and initializing it
+ *   if this is the first user.
+ ****************************************************************************/
+
+static FAR struct orb_ring_s *
+orb_ring_map(FAR const struct orb_metadata *meta, int instance,
+             FAR size_t *size)
+{
+  FAR struct orb_ring_s *ring;
+  char name[ORB_PATH_MAX];
+  bool creator = true;
+  unsigned users;
+  size_t esize;
+  int fd;
+
+  esize = ORB_RING_ALIGN(meta->o_size);
+  *size = sizeof(struct orb_ring_s) +
+          ORB_RING_NSLOTS * (sizeof(struct orb_slot_s) + esize);
+
+  orb_ring_name(meta, instance, name);
+
+  fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0666);
+  if (fd < 0 && errno == EEXIST)
+    {
+      creator = false;
+      fd = shm_open(name, O_RDWR, 0666);
+    }
+
+  if (fd < 0)
+    {
+      return NULL;
+    }
+
+  if (creator && ftruncate(fd, *size) < 0)
+    {
+      close(fd);
+      shm_unlink(name);
+      return NULL;
+    }
+
+  ring = mmap(NULL, *size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+  if (ring == MAP_FAILED)
+    {
+      return NULL;
+    }
+
+  if (creator)
+    {
+      memset(ring, 0, *size);
+      ring->esize  = esize;
+      ring->nslots = ORB_RING_NSLOTS;
+      sem_init(&ring->sem, 1, 0);
+      atomic_store(&ring->nusers, 1);
+      atomic_thread_fence(memory_order_release);
+      ring->magic  = ORB_RING_MAGIC;
+    }
+  else if (ring->magic != ORB_RING_MAGIC || ring->esize != esize)
+    {
+      /* Not initialized yet by its creator, or created by an incompatible
+       * topic definition.
+       */
+
+      munmap(ring, *size);
+      errno = EAGAIN;
+      return NULL;
+    }
+  else
+    {
+      /* Join the ring unless its last user is tearing it down */
+
+      users = atomic_load(&ring->nusers);
+      do
+        {
+          if (users == 0)
+            {
+              munmap(ring, *size);
+              errno = EAGAIN;
+              return NULL;
+            }
+        }
+      while (!atomic_compare_exchange_weak(&ring->nusers, &users,
+                                           users + 1));
+    }
+
+  return ring;
+}
+#endif
+
 /****************************************************************************
  * Public Functions
  ****************************************************************************/
@@ -201,6 +373,80 @@ ssize_t orb_copy_multi(int fd, FAR void *buffer, size_t len)
   return read(fd, buffer, len);
 }
 
+ssize_t orb_copy_batch(FAR const struct orb_metadata *meta, int fd,
+                       FAR void *buffer, size_t nsamples,
+                       FAR orb_abstime *timestamps,
+                       FAR struct orb_batch_s *batch)
+{
+  struct orb_state state;
+  bool updated;
+  ssize_t ret;
+  size_t i;
+
+  if (nsamples == 0)
+    {
+      return 0;
+    }
+
+  /* The driver hands out the latest sample again if nothing new has been
+   * published, so check first to report an empty queue as 0 samples.
+   */
+
+  ret = orb_check(fd, &updated);
+  if (ret < 0)
+    {
+      return ret;
+    }
+
+  if (updated)
+    {
+      ret = read(fd, buffer, nsamples * meta->o_size);
+      if (ret < 0)
+        {
+          return ret;
+        }
+
+      ret /= meta->o_size;
+    }
+
+  if (timestamps != NULL && meta->o_size >= sizeof(orb_abstime))
+    {
+      FAR const uint8_t *sample = buffer;
+
+      for (i = 0; i < ret; i++, sample += meta->o_size)
+        {
+          memcpy(&timestamps[i], sample, sizeof(orb_abstime));
+        }
+    }
+
+  if (batch == NULL || orb_get_state(fd, &state) < 0)
+    {
+      return ret;
+    }
+
+  if (!batch->started)
+    {
+      batch->generation = state.generation - ret;
+      batch->started    = true;
+    }
+
+  batch->delivered += ret;
+
+  /* Only account losses once the queue is known to be drained, otherwise
+   * samples still queued would be counted as lost.
+   */
+
+  if (ret < nsamples)
+    {
+      uint64_t published = state.generation - batch->generation;
+
+      batch->lost = published > batch->delivered ?
+                    published - batch->delivered : 0;
+    }
+
+  return ret;
+}
+
 int orb_get_state(int fd, FAR struct orb_state *state)
 {
   struct sensor_state_s tmp;
@@ -322,3 +568,295 @@ int orb_group_count(FAR const struct orb_metadata *meta)
 
   return instance;
 }
+
+#ifdef CONFIG_UORB_LOAN
+int orb_loan_init(FAR struct orb_loan_s *loan,
+                  FAR const struct orb_metadata *meta, int instance,
+                  int fd, bool subscriber)
+{
+  FAR struct orb_ring_s *ring;
+
+  memset(loan, 0, sizeof(*loan));
+  loan->meta       = meta;
+  loan->instance   = instance;
+  loan->fd         = fd;
+  loan->subscriber = subscriber;
+
+  ring = orb_ring_map(meta, instance, &loan->ringsize);
+  if (ring == NULL)
+    {
+      /* Fall back to the fd path with a private bounce buffer */
+
+      uorbwarn("%s%d loan ring unavailable (%d), using fd path",
+               meta->o_name, instance, errno);
+
+      loan->buffer = malloc(meta->o_size);
+      if (loan->buffer == NULL)
+        {
+          errno = ENOMEM;
+          return -1;
+        }
+
+      return 0;
+    }
+
+  loan->ring = ring;
+  if (subscriber)
+    {
+      atomic_fetch_add(&ring->nborrowers, 1);
+
+      /* Only samples published after attaching are borrowed */
+
+      loan->seq = atomic_load_explicit(&ring->head, memory_order_acquire);
+    }
+
+  return 0;
+}
+
+void orb_loan_deinit(FAR struct orb_loan_s *loan)
+{
+  FAR struct orb_ring_s *ring = loan->ring;
+  char name[ORB_PATH_MAX];
+
+  if (ring != NULL)
+    {
+      if (loan->subscriber)
+        {
+          atomic_fetch_sub(&ring->nborrowers, 1);
+        }
+
+      /* The last user removes the shared memory object, a handle that
+       * still tries to join sees the invalid magic and falls back to the
+       * fd path.
+       */
+
+      if (atomic_fetch_sub(&ring->nusers, 1) == 1)
+        {
+          ring->magic = 0;
+          orb_ring_name(loan->meta, loan->instance, name);
+          shm_unlink(name);
+        }
+
+      munmap(ring, loan->ringsize);
+      loan->ring = NULL;
+    }
+
+  free(loan->buffer);
+  loan->buffer = NULL;
+}
+
+FAR void *orb_loan(FAR struct orb_loan_s *loan)
+{
+  FAR struct orb_ring_s *ring = loan->ring;
+  FAR struct orb_slot_s *slot;
+
+  if (ring == NULL)
+    {
+      return loan->buffer;
+    }
+
+  /* Single publisher: the head can only be advanced by this handle */
+
+  loan->seq = atomic_load_explicit(&ring->head, memory_order_relaxed);
+  slot = orb_ring_slot(ring, loan->seq);
+
+  atomic_store_explicit(&slot->seq, 2 * loan->seq + 1,
+                        memory_order_relaxed);
+  atomic_thread_fence(memory_order_release);
+
+  return slot + 1;
+}
+
+int orb_publish_loaned(FAR struct orb_loan_s *loan, FAR void *data)
+{
+  FAR struct orb_ring_s *ring = loan->ring;
+  FAR struct orb_slot_s *slot;
+  struct orb_state state;
+  unsigned nwaiters;
+
+  if (ring == NULL)
+    {
+      return orb_publish(loan->meta, loan->fd, data);
+    }
+
+  slot = orb_ring_slot(ring, loan->seq);
+  if (data != (FAR void *)(slot + 1))
+    {
+      errno = EINVAL;
+      return -1;
+    }
+
+  atomic_store_explicit(&slot->seq, 2 * (loan->seq + 1),
+                        memory_order_release);
+  atomic_store_explicit(&ring->head, loan->seq + 1, memory_order_release);
+
+  nwaiters = atomic_load(&ring->nwaiters);
+  while (nwaiters-- > 0)
+    {
+      sem_post(&ring->sem);
+    }
+
+  /* The ring is the source of truth. The sample is only copied into the
+   * driver while subscribers on the plain fd path are attached, borrowers
+   * are served from the ring alone.
+   */
+
+  if (orb_get_state(loan->fd, &state) < 0 ||
+      state.nsubscribers > atomic_load(&ring->nborrowers))
+    {
+      return orb_publish(loan->meta, loan->fd, data);
+    }
+
+  return 0;
+}
+
+FAR const void *orb_borrow(FAR struct orb_loan_s *loan)
+{
+  FAR struct orb_ring_s *ring = loan->ring;
+  FAR struct orb_slot_s *slot;
+  uint32_t head;
+  uint32_t seq;
+
+  if (ring == NULL)
+    {
+      bool updated = false;
+
+      if (orb_check(loan->fd, &updated) < 0 || !updated)
+        {
+          errno = EAGAIN;
+          return NULL;
+        }
+
+      if (orb_copy(loan->meta, loan->fd, loan->buffer) < 0)
+        {
+          return NULL;
+        }
+
+      return loan->buffer;
+    }
+
+  for (; ; )
+    {
+      head = atomic_load_explicit(&ring->head, memory_order_acquire);
+      if (head == loan->seq)
+        {
+          errno = EAGAIN;
+          return NULL;
+        }
+
+      slot = orb_ring_slot(ring, head - 1);
+      seq  = atomic_load_explicit(&slot->seq, memory_order_acquire);
+      if (seq == 2 * head)
+        {
+          break;
+        }
+
+      if (seq & 1)
+        {
+          /* The publisher lapped us and is rewriting the slot right now */
+
+          errno = EAGAIN;
+          return NULL;
+        }
+
+      /* The slot already holds a newer sample, follow the new head */
+    }
+
+  loan->seq     = head;
+  loan->slotseq = seq;
+
+  return slot + 1;
+}
+
+int orb_borrow_wait(FAR struct orb_loan_s *loan, int timeout)
+{
+  FAR struct orb_ring_s *ring = loan->ring;
+  struct timespec abstime;
+  int ret;
+
+  if (ring == NULL)
+    {
+      struct pollfd fds;
+
+      fds.fd     = loan->fd;
+      fds.events = POLLIN;
+      ret = poll(&fds, 1, timeout);
+      if (ret == 0)
+        {
+          errno = ETIMEDOUT;
+          return -1;
+        }
+
+      return ret < 0 ? ret : 0;
+    }
+
+  if (timeout >= 0)
+    {
+      clock_gettime(CLOCK_MONOTONIC, &abstime);
+      abstime.tv_sec  += timeout / 1000;
+      abstime.tv_nsec += (timeout % 1000) * 1000000;
+      if (abstime.tv_nsec >= 1000000000)
+        {
+          abstime.tv_sec++;
+          abstime.tv_nsec -= 1000000000;
+        }
+    }
+
+  /* Register as waiter once before checking the head, so a publish
+   * between the check and the wait still posts the semaphore. Stale posts
+   * only cause a spurious wake-up and another turn of the loop.
+   */
+
+  atomic_fetch_add(&ring->nwaiters, 1);
+
+  for (; ; )
+    {
+      if (atomic_load_explicit(&ring->head, memory_order_acquire) !=
+          loan->seq)
+        {
+          ret = 0;
+          break;
+        }
+
+      if (timeout >= 0)
+        {
+          ret = sem_clockwait(&ring->sem, CLOCK_MONOTONIC, &abstime);
+        }
+      else
+        {
+          ret = sem_wait(&ring->sem);
+        }
+
+      if (ret < 0 && errno != EINTR)
+        {
+          break;
+        }
+    }
+
+  atomic_fetch_sub(&ring->nwaiters, 1);
+  return ret;
+}
+
+int orb_release(FAR struct orb_loan_s *loan, FAR const void *data)
+{
+  FAR struct orb_ring_s *ring = loan->ring;
+  FAR struct orb_slot_s *slot;
+
+  if (ring == NULL)
+    {
+      return 0;
+    }
+
+  slot = (FAR struct orb_slot_s *)data - 1;
+
+  atomic_thread_fence(memory_order_acquire);
+  if (atomic_load_explicit(&slot->seq, memory_order_relaxed) !=
+      loan->slotseq)
+    {
+      errno = ESTALE;
+      return -1;
+    }
+
+  return 0;
+}
+#endif
@@ -72,6 +72,37 @@ struct orb_object
 
 typedef uint64_t orb_abstime;
 
+struct orb_batch_s
+{
+  uint64_t generation;          /* Mainline generation when accounting
+                                 * started
+                                 */
+  uint64_t delivered;           /* Samples delivered since then */
+  uint32_t lost;                /* Samples published but never delivered,
+                                 * updated whenever the queue is drained
+                                 */
+  bool     started;             /* Accounting started by a first batch */
+};
+
+#ifdef CONFIG_UORB_LOAN
+struct orb_loan_s
+{
+  FAR const struct orb_metadata *meta; /* The metadata of topic object */
+  int               instance;   /* Topic instance */
+  int               fd;         /* Advertiser / subscriber fd, used by the
+                                 * fallback path and for notification
+                                 */
+  FAR void         *ring;       /* Shared sample ring, NULL if the ring
+                                 * could not be mapped
+                                 */
+  size_t            ringsize;   /* Size of the mapped ring */
+  FAR void         *buffer;     /* Bounce buffer of the fallback path */
+  uint32_t          seq;        /* Last loaned / borrowed sequence */
+  uint32_t          slotseq;    /* Slot sequence seen by orb_borrow() */
+  bool              subscriber; /* True if the handle borrows samples */
+};
+#endif
+
 /****************************************************************************
  * Pre-processor Definitions
  ****************************************************************************/
@@ -451,6 +482,44 @@ static inline int orb_copy(FAR const struct orb_metadata *meta,
   return ret == meta->o_size ? 0 : -1;
 }
 
+/****************************************************************************
+ * Name: orb_copy_batch
+ *
+ * Description:
+ *   Fetch up to nsamples queued samples from a topic in one call.
+ *
+ *   This drains the subscriber queue with a single read(), which is much
+ *   cheaper than one orb_copy() per sample when the subscriber wakes up
+ *   less often than the topic is published.
+ *
+ *   If timestamps is not NULL, it receives the timestamp of each sample,
+ *   which by uORB convention is the leading orb_abstime of the topic
+ *   structure.
+ *
+ *   If batch is not NULL, it keeps track of the samples published to the
+ *   topic that were never delivered to this subscriber (queue overruns or
+ *   interval downsampling). The structure must be zeroed before the first
+ *   call and then passed back unchanged.
+ *
+ * Input Parameters:
+ *   meta         The uORB metadata (usually from the ORB_ID() macro)
+ *   fd           A fd returned from orb_subscribe.
+ *   buffer       Pointer to the buffer receiving nsamples * meta->o_size
+ *                bytes.
+ *   nsamples     Maximum number of samples to fetch.
+ *   timestamps   Buffer receiving nsamples timestamps, or NULL.
+ *   batch        Overrun accounting state, or NULL.
+ *
+ * Returned Value:
+ *   Number of samples fetched on success (0 if none is queued),
+ *   -1 otherwise with errno set accordingly.
+ ****************************************************************************/
+
+ssize_t orb_copy_batch(FAR const struct orb_metadata *meta, int fd,
+                       FAR void *buffer, size_t nsamples,
+                       FAR orb_abstime *timestamps,
+                       FAR struct orb_batch_s *batch);
+
 /****************************************************************************
  * Name: orb_get_state
  *
@@ -721,6 +790,140 @@ int orb_group_count(FAR const struct orb_metadata *meta);
 
 FAR const struct orb_metadata *orb_get_meta(FAR const char *name);
 
+#ifdef CONFIG_UORB_LOAN
+
+/****************************************************************************
+ * Name: orb_loan_init
+ *
+ * Description:
+ *   Attach a loan handle to the shared sample ring of a topic instance.
+ *
+ *   The ring lives in a shared memory object named after the topic and is
+ *   created by whichever side attaches first. If the ring can not be
+ *   mapped, the handle falls back to the regular fd path, so the loan API
+ *   can always be used in place of orb_publish() / orb_copy().
+ *
+ *   Only one publisher per topic instance may use the loan API.
+ *
+ * Input Parameters:
+ *   loan         The loan handle to initialize.
+ *   meta         The uORB metadata (usually from the ORB_ID() macro)
+ *   instance     The instance of the topic.
+ *   fd           A fd returned from orb_advertise / orb_subscribe.
+ *   subscriber   True to borrow samples, false to loan and publish them.
+ *
+ * Returned Value:
+ *   0 on success, -1 otherwise with errno set accordingly.
+ ****************************************************************************/
+
+int orb_loan_init(FAR struct orb_loan_s *loan,
+                  FAR const struct orb_metadata *meta, int instance,
+                  int fd, bool subscriber);
+
+/****************************************************************************
+ * Name: orb_loan_deinit
+ *
+ * Description:
+ *   Detach a loan handle from the shared sample ring. The fd passed to
+ *   orb_loan_init() is not closed.
+ *
+ * Input Parameters:
+ *   loan     The loan handle.
+ ****************************************************************************/
+
+void orb_loan_deinit(FAR struct orb_loan_s *loan);
+
+/****************************************************************************
+ * Name: orb_loan
+ *
+ * Description:
+ *   Get a sample buffer that the publisher can fill in place. The sample
+ *   becomes visible to subscribers only after orb_publish_loaned().
+ *
+ * Input Parameters:
+ *   loan     The loan handle of a publisher.
+ *
+ * Returned Value:
+ *   Pointer to meta->o_size bytes on success, NULL otherwise.
+ ****************************************************************************/
+
+FAR void *orb_loan(FAR struct orb_loan_s *loan);
+
+/****************************************************************************
+ * Name: orb_publish_loaned
+ *
+ * Description:
+ *   Commit a sample obtained by orb_loan(). The sample is written in place
+ *   and borrowers read it from the ring. It is only copied into the
+ *   driver while subscribers on the plain fd path are attached, so the
+ *   fd of a borrower must not be used with orb_copy() or poll(), and a
+ *   subscriber attaching on the fd path gets its first new sample with
+ *   the next publish.
+ *
+ * Input Parameters:
+ *   loan     The loan handle of a publisher.
+ *   data     The buffer returned by orb_loan().
+ *
+ * Returned Value:
+ *   0 on success, -1 otherwise with errno set accordingly.
+ ****************************************************************************/
+
+int orb_publish_loaned(FAR struct orb_loan_s *loan, FAR void *data);
+
+/****************************************************************************
+ * Name: orb_borrow
+ *
+ * Description:
+ *   Borrow the latest sample published since the last orb_borrow() without
+ *   copying it. The sample must be handed back with orb_release(), which
+ *   reports whether the publisher overwrote the slot in the meantime.
+ *
+ * Input Parameters:
+ *   loan     The loan handle of a subscriber.
+ *
+ * Returned Value:
+ *   Pointer to the sample on success, NULL otherwise with errno set to
+ *   EAGAIN if no new sample is available.
+ ****************************************************************************/
+
+FAR const void *orb_borrow(FAR struct orb_loan_s *loan);
+
+/****************************************************************************
+ * Name: orb_borrow_wait
+ *
+ * Description:
+ *   Wait until a sample newer than the last borrowed one is published.
+ *
+ * Input Parameters:
+ *   loan     The loan handle of a subscriber.
+ *   timeout  Timeout in ms, negative to wait forever.
+ *
+ * Returned Value:
+ *   0 if a new sample is available, -1 otherwise with errno set to
+ *   ETIMEDOUT on timeout.
+ ****************************************************************************/
+
+int orb_borrow_wait(FAR struct orb_loan_s *loan, int timeout);
+
+/****************************************************************************
+ * Name: orb_release
+ *
+ * Description:
+ *   Release a sample obtained by orb_borrow().
+ *
+ * Input Parameters:
+ *   loan     The loan handle of a subscriber.
+ *   data     The pointer returned by orb_borrow().
+ *
+ * Returned Value:
+ *   0 if the sample was stable while borrowed, -1 with errno set to ESTALE
+ *   if it was overwritten and must be discarded.
+ ****************************************************************************/
+
+int orb_release(FAR struct orb_loan_s *loan, FAR const void *data);
+
+#endif /* CONFIG_UORB_LOAN */
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,159 @@
+#!/usr/bin/env python3
+# apps/system/uorb/uorb_decode.py
+#
+# Licensed to the Apache Software Foundation (ASF) under one or more
+# contributor license agreements.  See the NOTICE file distributed with
+# this work for additional information regarding copyright ownership.  The
+# ASF licenses this file to you under the Apache License, Version 2.0 (the
+# "License"); you may not use this file except in compliance with the
+# License.  You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+# WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+# License for the specific language governing permissions and limitations
+# under the License.
+#
+"""Decode binary logs written by uorb_record.
+
+By default every sample is printed as one CSV line:
+
+    topic,instance,timestamp,hex payload
+
+With --stats only per topic sample counts, rates and drops are printed.
+"""
+
+import argparse
+import struct
+import sys
+
+MAGIC = b"UORBLOG\0"
+VERSION = 1
+
+TYPE_TOPIC = ord("T")
+TYPE_DATA = ord("D")
+TYPE_DROPPED = ord("L")
+
+
+class Topic:
+    def __init__(self, name, instance, size):
+        self.name = name
+        self.instance = instance
+        self.size = size
+        self.count = 0
+        self.dropped = 0
+        self.first = None
+        self.last = None
+
+
+def decode(stream, endian):
+    header = struct.Struct(endian + "8sBBHQ")
+    topic_hdr = struct.Struct(endian + "BBHBB")
+    data_hdr = struct.Struct(endian + "BBH")
+
+    raw = stream.read(header.size)
+    if len(raw) < header.size:
+        raise ValueError("truncated file header")
+
+    magic, version, ntopics, _, start = header.unpack(raw)
+    if magic != MAGIC:
+        raise ValueError("not a uorb_record log")
+
+    if version != VERSION:
+        raise ValueError("unsupported log version %d" % version)
+
+    topics = {}
+    for _ in range(ntopics):
+        raw = stream.read(topic_hdr.size)
+        kind, tid, size, instance, namelen = topic_hdr.unpack(raw)
+        if kind != TYPE_TOPIC:
+            raise ValueError("bad topic record")
+
+        name = stream.read(namelen).decode("ascii")
+        topics[tid] = Topic(name, instance, size)
+
+    yield ("start", start, topics)
+
+    while True:
+        raw = stream.read(data_hdr.size)
+        if len(raw) < data_hdr.size:
+            break
+
+        kind, tid, size = data_hdr.unpack(raw)
+        payload = stream.read(size)
+        if len(payload) < size:
+            break
+
+        topic = topics.get(tid)
+        if topic is None:
+            raise ValueError("sample of unknown topic %d" % tid)
+
+        if kind == TYPE_DATA:
+            timestamp = None
+            if size >= 8:
+                timestamp = struct.unpack(endian + "Q", payload[:8])[0]
+
+            yield ("data", topic, timestamp, payload)
+        elif kind == TYPE_DROPPED:
+            topic.dropped = struct.unpack(endian + "I", payload)[0]
+        else:
+            raise ValueError("unknown record type %d" % kind)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__)
+    parser.add_argument("log", help="log file written by uorb_record")
+    parser.add_argument(
+        "--big-endian", action="store_true", help="target is big endian"
+    )
+    parser.add_argument(
+        "--stats", action="store_true", help="only print per topic statistics"
+    )
+    parser.add_argument(
+        "--topic", action="append", help="only print the given topic(s)"
+    )
+    args = parser.parse_args()
+
+    endian = ">" if args.big_endian else "<"
+    topics = {}
+
+    with open(args.log, "rb") as stream:
+        for record in decode(stream, endian):
+            if record[0] == "start":
+                topics = record[2]
+                continue
+
+            _, topic, timestamp, payload = record
+            topic.count += 1
+            if timestamp is not None:
+                if topic.first is None:
+                    topic.first = timestamp
+                topic.last = timestamp
+
+            if args.stats:
+                continue
+
+            if args.topic and topic.name not in args.topic:
+                continue
+
+            sys.stdout.write(
+                "%s,%d,%s,%s\n"
+                % (topic.name, topic.instance, timestamp, payload.hex())
+            )
+
+    if args.stats:
+        for topic in topics.values():
+            rate = 0.0
+            if topic.count > 1 and topic.last > topic.first:
+                rate = (topic.count - 1) * 1e6 / (topic.last - topic.first)
+
+            print(
+                "%s%d: samples %d, rate %.1f Hz, dropped %d"
+                % (topic.name, topic.instance, topic.count, rate, topic.dropped)
+            )
+
+
+if __name__ == "__main__":
+    main()